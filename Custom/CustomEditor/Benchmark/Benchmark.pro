@@ -0,0 +1,53 @@
+QT       += core gui
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets concurrent
+CONFIG += c++14 console
+CONFIG -= app_bundle
+
+# 编辑器性能基准测试，直接编译 CustomEditor 的源码（不含其 main.cpp）
+EDITOR_DIR = ../CustomEditor
+
+INCLUDEPATH += $$EDITOR_DIR
+
+SOURCES += \
+    $$EDITOR_DIR/BackgroundHighlighter.cpp \
+    $$EDITOR_DIR/CompletionEngine.cpp \
+    $$EDITOR_DIR/Editor.cpp \
+    $$EDITOR_DIR/FoldingIndex.cpp \
+    $$EDITOR_DIR/FrameTimeProbe.cpp \
+    $$EDITOR_DIR/GutterRenderer.cpp \
+    $$EDITOR_DIR/LargeFileView.cpp \
+    $$EDITOR_DIR/MainWindow.cpp \
+    $$EDITOR_DIR/ParenthesisIndex.cpp \
+    $$EDITOR_DIR/SearchEngine.cpp \
+    $$EDITOR_DIR/TextTokenizer.cpp \
+    main.cpp
+
+HEADERS += \
+    $$EDITOR_DIR/BackgroundHighlighter.h \
+    $$EDITOR_DIR/CompletionEngine.h \
+    $$EDITOR_DIR/Editor.h \
+    $$EDITOR_DIR/FoldingIndex.h \
+    $$EDITOR_DIR/FrameTimeProbe.h \
+    $$EDITOR_DIR/GutterRenderer.h \
+    $$EDITOR_DIR/LargeFileView.h \
+    $$EDITOR_DIR/MainWindow.h \
+    $$EDITOR_DIR/ParenthesisIndex.h \
+    $$EDITOR_DIR/SearchEngine.h \
+    $$EDITOR_DIR/TextTokenizer.h
+
+RESOURCES += \
+    $$EDITOR_DIR/res.qrc
+
+TARGET = EditorBenchmark
+
+DESTDIR = ../bin
+
+UI_DIR = generatedfiles/ui
+
+MOC_DIR = generatedfiles/moc
+
+RCC_DIR = generatedfiles/rcc
+
+msvc:QMAKE_CXXFLAGS += -execution-charset:utf-8
+msvc:QMAKE_CXXFLAGS += -source-charset:utf-8
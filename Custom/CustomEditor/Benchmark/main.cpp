@@ -0,0 +1,273 @@
+#include "Editor.h"
+#include "TextTokenizer.h"
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QRegExp>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <cstdio>
+
+namespace
+{
+const int kLineCount = 100000;
+const int kMarkCount = 10000;
+const int kHighlightLineCount = 20000;
+
+void report(const char* name, qint64 nsecs, int count)
+{
+    std::printf("%-40s %10.3f ms  %10.3f us/op\n", name, nsecs / 1e6, count > 0 ? nsecs / 1e3 / count : 0.0);
+}
+
+QString makeText(int lineCount)
+{
+    QString text;
+    text.reserve(lineCount * 24);
+    for (int i = 0; i < lineCount; ++i)
+    {
+        text += QStringLiteral("    int value%1 = %1;\n").arg(i);
+    }
+    return text;
+}
+
+/**
+ * @brief: 高亮用的示例代码，包含关键字、类型、数字、字符串和单行、多行注释
+ */
+QStringList makeHighlightLines(int lineCount)
+{
+    const QStringList sample = QStringList() << QStringLiteral("model Pendulum \"simple pendulum\"")
+                                             << QStringLiteral("  parameter Real L = 1.5e-1 \"length\";")
+                                             << QStringLiteral("  Real phi(start = 0.7), w; // angle and speed")
+                                             << QStringLiteral("  /* integrated by the solver,")
+                                             << QStringLiteral("     see the documentation */")
+                                             << QStringLiteral("equation")
+                                             << QStringLiteral("  der(phi) = w;")
+                                             << QStringLiteral("  der(w) = -9.81 / L * sin(phi);")
+                                             << QStringLiteral("  annotation(experiment(StopTime = 10));")
+                                             << QStringLiteral("end Pendulum;");
+    QStringList lines;
+    lines.reserve(lineCount);
+    for (int i = 0; i < lineCount; ++i)
+    {
+        lines.append(sample.at(i % sample.size()));
+    }
+    return lines;
+}
+
+/**
+ * @brief: 改造前 TextHighlighter 的做法：每条正则规则各扫描一遍，再逐字符扫描注释和字符串
+ */
+class RegExpRuleHighlighter
+{
+public:
+    RegExpRuleHighlighter()
+    {
+        mRules << QRegExp("[0-9][0-9]*([.][0-9]*)?([eE][+-]?[0-9]*)?") << QRegExp("\\b[A-Za-z_][A-Za-z0-9_]*");
+        foreach (const QString& pattern, PlainTextEdit::getKeywords() + PlainTextEdit::getTypes())
+        {
+            mRules << QRegExp(QString("\\b%1\\b").arg(pattern));
+        }
+    }
+
+    /**
+     * @return: 本行结束时的块状态，pMatches 累加匹配到的区间数
+     */
+    int highlight(const QString& text, int blockState, int* pMatches) const
+    {
+        foreach (const QRegExp& rule, mRules)
+        {
+            QRegExp expression(rule);
+            int     index = expression.indexIn(text);
+            while (index >= 0)
+            {
+                ++*pMatches;
+                index = expression.indexIn(text, index + expression.matchedLength());
+            }
+        }
+        if (blockState == 1)
+        {
+            blockState = 0;
+        }
+        for (int index = 0; index < text.length(); ++index)
+        {
+            switch (blockState)
+            {
+            case 1:
+                break;
+            case 2:
+                if (text[index] == '*' && index + 1 < text.length() && text[index + 1] == '/')
+                {
+                    ++index;
+                    ++*pMatches;
+                    blockState = 0;
+                }
+                break;
+            case 3:
+                if (text[index] == '\\')
+                {
+                    ++index;
+                }
+                else if (text[index] == '"')
+                {
+                    ++*pMatches;
+                    blockState = 0;
+                }
+                break;
+            default:
+                if (text[index] == '/' && index + 1 < text.length() && text[index + 1] == '/')
+                {
+                    ++index;
+                    ++*pMatches;
+                    blockState = 1;
+                }
+                else if (text[index] == '/' && index + 1 < text.length() && text[index + 1] == '*')
+                {
+                    ++index;
+                    blockState = 2;
+                }
+                else if (text[index] == '"')
+                {
+                    blockState = 3;
+                }
+            }
+        }
+        return blockState;
+    }
+
+private:
+    QList<QRegExp> mRules;
+};
+
+/**
+ * @brief: 高亮基准：单遍 TextTokenizer 和改造前逐条 QRegExp 规则的吞吐量，单位 字符/秒
+ */
+void benchHighlighting()
+{
+    const QStringList lines = makeHighlightLines(kHighlightLineCount);
+    qint64            charCount = 0;
+    foreach (const QString& line, lines)
+    {
+        charCount += line.length();
+    }
+    std::printf("Highlighting: %d lines, %lld characters\n", kHighlightLineCount, static_cast<long long>(charCount));
+
+    const TextTokenizer   tokenizer(PlainTextEdit::getKeywords(), PlainTextEdit::getTypes());
+    TextTokenizer::Tokens tokens;
+    int                   tokenCount = 0;
+    int                   state = TextTokenizer::Normal;
+    QElapsedTimer         timer;
+    timer.start();
+    foreach (const QString& line, lines)
+    {
+        state = tokenizer.tokenize(line, state, &tokens);
+        tokenCount += tokens.size();
+    }
+    const qint64 tokenizerNsecs = timer.nsecsElapsed();
+    report("TextTokenizer::tokenize", tokenizerNsecs, kHighlightLineCount);
+
+    const RegExpRuleHighlighter regExpHighlighter;
+    int                         matchCount = 0;
+    state = 0;
+    timer.restart();
+    foreach (const QString& line, lines)
+    {
+        state = regExpHighlighter.highlight(line, state, &matchCount);
+    }
+    const qint64 regExpNsecs = timer.nsecsElapsed();
+    report("QRegExp rule loop", regExpNsecs, kHighlightLineCount);
+
+    std::printf("%-40s %10.0f chars/s\n", "TextTokenizer::tokenize", tokenizerNsecs > 0 ? charCount * 1e9 / tokenizerNsecs : 0.0);
+    std::printf("%-40s %10.0f chars/s\n", "QRegExp rule loop", regExpNsecs > 0 ? charCount * 1e9 / regExpNsecs : 0.0);
+    std::printf("(%d tokens, %d regexp matches)\n\n", tokenCount, matchCount);
+}
+
+/**
+ * @brief: DocumentMarker 基准：10 万行文档上 1 万个断点的添加、查找、切换、编辑后的行号跟随
+ */
+void benchDocumentMarker()
+{
+    std::printf("DocumentMarker: %d lines, %d marks\n", kLineCount, kMarkCount);
+    QTextDocument doc;
+    doc.setDocumentLayout(new BaseEditorDocumentLayout(&doc));
+    doc.setPlainText(makeText(kLineCount));
+    DocumentMarker marker(&doc, 1);
+
+    // 第一行不放标记，开头插入、删除行时所有标记都只做平移
+    const int                step = kLineCount / kMarkCount;
+    auto                     lineOf = [step](int i) { return i * step + step / 2 + 1; };
+    QList<BreakpointMarker*> marks;
+    for (int i = 0; i < kMarkCount; ++i)
+    {
+        marks.append(new BreakpointMarker(QString(), lineOf(i)));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < kMarkCount; ++i)
+    {
+        marker.addMark(marks.at(i), lineOf(i));
+    }
+    report("addMark", timer.nsecsElapsed(), kMarkCount);
+
+    timer.restart();
+    int found = 0;
+    for (int i = 0; i < kMarkCount; ++i)
+    {
+        found += marker.hasMark(marks.at(i)) ? 1 : 0;
+        found += marker.marksAt(lineOf(i)).size();
+    }
+    report("hasMark + marksAt", timer.nsecsElapsed(), kMarkCount);
+
+    // 断点切换：移除后重新添加
+    timer.restart();
+    for (int i = 0; i < kMarkCount; ++i)
+    {
+        marker.removeMark(marks.at(i));
+        marker.addMark(marks.at(i), lineOf(i));
+    }
+    report("toggle (removeMark + addMark)", timer.nsecsElapsed(), kMarkCount);
+
+    // 块内输入，块号不变，标记不应被处理
+    QTextCursor cursor(&doc);
+    const int   typeCount = 1000;
+    timer.restart();
+    for (int i = 0; i < typeCount; ++i)
+    {
+        cursor.setPosition(doc.findBlockByNumber((i * 97) % kLineCount).position());
+        cursor.insertText(QStringLiteral("x"));
+    }
+    report("type one character", timer.nsecsElapsed(), typeCount);
+
+    // 在文档开头插入、删除一行，所有标记整体平移
+    const int lineEditCount = 100;
+    timer.restart();
+    for (int i = 0; i < lineEditCount; ++i)
+    {
+        cursor.setPosition(0);
+        cursor.insertText(QStringLiteral("\n"));
+        cursor.setPosition(0);
+        cursor.deleteChar();
+    }
+    report("insert + remove line at top", timer.nsecsElapsed(), lineEditCount * 2);
+
+    timer.restart();
+    marker.updateBreakpointsLineNumber();
+    report("updateBreakpointsLineNumber", timer.nsecsElapsed(), 1);
+
+    for (int i = 0; i < kMarkCount; ++i)
+    {
+        marker.removeMark(marks.at(i));
+    }
+    qDeleteAll(marks);
+    std::printf("(%d lookups hit)\n\n", found);
+}
+}
+
+int main(int argc, char* argv[])
+{
+    QApplication a(argc, argv);
+    benchHighlighting();
+    benchDocumentMarker();
+    return 0;
+}
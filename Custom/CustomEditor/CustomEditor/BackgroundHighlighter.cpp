@@ -0,0 +1,296 @@
+﻿#include "BackgroundHighlighter.h"
+#include <QTextBlock>
+#include <QtConcurrent>
+
+static const int sVisibleMargin = 20;              // 可见区域上下额外高亮的行数
+static const int sMaxFillBlocks = 2000;            // 一次补全任务最多的块数
+static const int sMaxFillCharacters = 256 * 1024;  // 一次补全任务最多的字符数
+static const int sMaxFillChecks = 20000;           // 一次调度最多检查的已高亮块数，避免阻塞 GUI
+static const int sMinLookahead = 32;
+
+BackgroundHighlighter::BackgroundHighlighter(PlainTextEdit* pPlainTextEdit)
+    : QObject(pPlainTextEdit)
+    , mpPlainTextEdit(pPlainTextEdit)
+    , mpTextDocument(pPlainTextEdit->document())
+    , mTokenFormats(TextHighlighter::tokenFormats())
+    , mFillCursor(pPlainTextEdit->document())
+    , mFillLimit(pPlainTextEdit->document())
+    , mFillActive(true)
+    , mFullScanPending(true)
+    , mJobRunning(false)
+    , mApplying(false)
+    , mLookahead(sMinLookahead)
+{
+    // 在 GUI 线程里先构造共享的词法扫描器，字体、Tab 宽度和 TextHighlighter 保持一致
+    TextHighlighter::tokenizer();
+    TextHighlighter::applyEditorFont(mpPlainTextEdit);
+
+    mScheduleTimer.setSingleShot(true);
+    mScheduleTimer.setInterval(0);
+    connect(&mScheduleTimer, SIGNAL(timeout()), this, SLOT(scheduleHighlighting()));
+    connect(&mJobWatcher, SIGNAL(finished()), this, SLOT(handleJobFinished()));
+    // 只跟随文本变化调度；补全扫描期间每个任务结束都会先检查可见区域，滚动后的新区域会优先处理
+    connect(mpTextDocument, SIGNAL(contentsChange(int, int, int)), this, SLOT(handleContentsChange(int, int, int)));
+    mScheduleTimer.start();
+}
+
+BackgroundHighlighter::~BackgroundHighlighter()
+{
+    mJobWatcher.waitForFinished();
+}
+
+void BackgroundHighlighter::handleContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved);
+    if (mApplying)
+    {
+        return;
+    }
+    const int start = mpTextDocument->findBlock(position).position();
+    const int end = qMin(position + charsAdded, mpTextDocument->characterCount() - 1);
+    if (!mFillActive)
+    {
+        mFillCursor.setPosition(start);
+        mFillLimit.setPosition(end);
+    }
+    else
+    {
+        if (start < mFillCursor.position())
+        {
+            mFillCursor.setPosition(start);
+        }
+        if (end > mFillLimit.position())
+        {
+            mFillLimit.setPosition(end);
+        }
+    }
+    mFillActive = true;
+    mScheduleTimer.start();
+}
+
+int BackgroundHighlighter::blockStartState(const QTextBlock& block) const
+{
+    // 上一行还没有高亮时按普通状态推测，之后补全扫描到上一行时会再校正
+    TextBlockUserData* pPreviousUserData = BaseEditorDocumentLayout::testUserData(block.previous());
+    if (pPreviousUserData && pPreviousUserData->highlightRevision() != -1)
+    {
+        return pPreviousUserData->highlightEndState();
+    }
+    return TextTokenizer::Normal;
+}
+
+bool BackgroundHighlighter::isDirty(const QTextBlock& block) const
+{
+    TextBlockUserData* pTextBlockUserData = BaseEditorDocumentLayout::testUserData(block);
+    if (!pTextBlockUserData || pTextBlockUserData->highlightRevision() != block.revision())
+    {
+        return true;
+    }
+    return pTextBlockUserData->highlightStartState() != blockStartState(block);
+}
+
+void BackgroundHighlighter::scheduleHighlighting()
+{
+    // 同一时间只有一个任务，任务结束后 handleJobFinished 会再次调度
+    if (mJobRunning)
+    {
+        return;
+    }
+    if (!scheduleVisibleBlocks())
+    {
+        scheduleFillBlocks();
+    }
+}
+
+bool BackgroundHighlighter::scheduleVisibleBlocks()
+{
+    QTextBlock firstBlock = mpPlainTextEdit->cursorForPosition(QPoint(0, 0)).block();
+    QTextBlock lastBlock = mpPlainTextEdit->cursorForPosition(QPoint(0, mpPlainTextEdit->viewport()->height())).block();
+    int        count = lastBlock.blockNumber() - firstBlock.blockNumber() + 1;
+    for (int i = 0; i < sVisibleMargin && firstBlock.previous().isValid(); ++i)
+    {
+        firstBlock = firstBlock.previous();
+        ++count;
+    }
+    count += sVisibleMargin;
+
+    QTextBlock block = firstBlock;
+    while (block.isValid() && count > 0 && !isDirty(block))
+    {
+        block = block.next();
+        --count;
+    }
+    if (!block.isValid() || count <= 0)
+    {
+        return false;
+    }
+    if (block.previous().isValid() && isDirty(block.previous()))
+    {
+        // 开始状态是推测的，前面还有没高亮的块，补全扫描需要走到文档末尾
+        mFullScanPending = true;
+        mFillActive = true;
+    }
+    startJob(block, count);
+    return true;
+}
+
+bool BackgroundHighlighter::scheduleFillBlocks()
+{
+    if (!mFillActive)
+    {
+        return false;
+    }
+    QTextBlock block = mpTextDocument->findBlock(mFillCursor.position());
+    int        checks = 0;
+    while (block.isValid() && !isDirty(block))
+    {
+        if (!mFullScanPending && block.position() >= mFillLimit.position())
+        {
+            // 编辑引起的重新高亮到此为止，后面的块结束状态没有变化
+            mFillActive = false;
+            return false;
+        }
+        block = block.next();
+        if (++checks >= sMaxFillChecks && block.isValid())
+        {
+            mFillCursor.setPosition(block.position());
+            mScheduleTimer.start();
+            return false;
+        }
+    }
+    if (!block.isValid())
+    {
+        mFillActive = false;
+        mFullScanPending = false;
+        return false;
+    }
+    // 连续的脏块，再带上 lookahead 个块，结束状态变化时可以一次处理完
+    QTextBlock lastBlock = block;
+    int        count = 1;
+    int        characters = block.length();
+    while (count < sMaxFillBlocks && characters < sMaxFillCharacters && lastBlock.next().isValid() && isDirty(lastBlock.next()))
+    {
+        lastBlock = lastBlock.next();
+        characters += lastBlock.length();
+        ++count;
+    }
+    for (int i = 0; i < mLookahead && count < sMaxFillBlocks && lastBlock.next().isValid(); ++i)
+    {
+        lastBlock = lastBlock.next();
+        ++count;
+    }
+    mFillCursor.setPosition(lastBlock.next().isValid() ? lastBlock.next().position() : lastBlock.position());
+    startJob(block, count);
+    return true;
+}
+
+void BackgroundHighlighter::startJob(const QTextBlock& firstBlock, int blockCount)
+{
+    Job job;
+    job.mDocumentRevision = mpTextDocument->revision();
+    job.mFirstBlockNumber = firstBlock.blockNumber();
+    job.mStartState = blockStartState(firstBlock);
+    QTextBlock block = firstBlock;
+    for (int i = 0; i < blockCount && block.isValid(); ++i)
+    {
+        job.mTexts << block.text();
+        job.mRevisions << block.revision();
+        block = block.next();
+    }
+    mRunningJob = job;
+    mJobRunning = true;
+    mJobWatcher.setFuture(QtConcurrent::run(&BackgroundHighlighter::runJob, job, mTokenFormats));
+}
+
+BackgroundHighlighter::BlockResults BackgroundHighlighter::runJob(const Job& job, const QVector<QTextCharFormat>& formats)
+{
+    BlockResults results;
+    results.reserve(job.mTexts.size());
+    TextTokenizer::Tokens tokens;
+    int                   state = job.mStartState;
+    foreach (const QString& text, job.mTexts)
+    {
+        BlockResult result;
+        result.mStartState = state;
+        int lexerState = TextHighlighter::tokenizer()->tokenize(text, state & LexerStateMask, &tokens);
+        foreach (const TextTokenizer::Token& token, tokens)
+        {
+            if (token.type != TextTokenizer::Identifier)
+            {
+                QTextLayout::FormatRange range;
+                range.start = token.start;
+                range.length = token.length;
+                range.format = formats.at(token.type);
+                result.mFormats.append(range);
+            }
+        }
+        TextHighlighter::analyzeBlock(text, tokens, state & FoldingStateFlag, &result.mAnalysis);
+        state = lexerState | (result.mAnalysis.mFoldingState ? FoldingStateFlag : 0);
+        result.mEndState = state;
+        results.append(result);
+    }
+    return results;
+}
+
+void BackgroundHighlighter::handleJobFinished()
+{
+    mJobRunning = false;
+    applyResults(mJobWatcher.result());
+    scheduleHighlighting();
+}
+
+void BackgroundHighlighter::applyResults(const BlockResults& results)
+{
+    // 任务期间文档被编辑过，结果作废，编辑时已经重新安排了扫描
+    if (mRunningJob.mDocumentRevision != mpTextDocument->revision())
+    {
+        return;
+    }
+    QTextBlock block = mpTextDocument->findBlockByNumber(mRunningJob.mFirstBlockNumber);
+    int        from = -1;
+    int        to = -1;
+    mApplying = true;
+    for (int i = 0; i < results.size() && block.isValid(); ++i, block = block.next())
+    {
+        if (block.revision() != mRunningJob.mRevisions.at(i))
+        {
+            break;
+        }
+        const BlockResult& result = results.at(i);
+        TextBlockUserData* pTextBlockUserData = BaseEditorDocumentLayout::testUserData(block);
+        if (pTextBlockUserData && pTextBlockUserData->highlightRevision() == block.revision()
+            && pTextBlockUserData->highlightStartState() == result.mStartState)
+        {
+            // 文本和开始状态都没变，结果和现在的一样
+            continue;
+        }
+        block.layout()->setFormats(result.mFormats);
+        TextHighlighter::applyBlockAnalysis(block, result.mAnalysis);
+        BaseEditorDocumentLayout::userData(block)->setHighlightState(block.revision(), result.mStartState, result.mEndState);
+        if (from < 0)
+        {
+            from = block.position();
+        }
+        to = block.position() + block.length();
+    }
+    if (from >= 0)
+    {
+        mpTextDocument->markContentsDirty(from, to - from);
+    }
+    mApplying = false;
+
+    if (block.isValid() && isDirty(block))
+    {
+        // 结束状态一直在变化(比如在文件开头输入了 "/*")，让补全扫描接着处理，并加大下一次任务
+        if (!mFillActive || block.position() < mFillCursor.position())
+        {
+            mFillCursor.setPosition(block.position());
+        }
+        mFillActive = true;
+        mLookahead = qMin(mLookahead * 2, sMaxFillBlocks);
+    }
+    else
+    {
+        mLookahead = sMinLookahead;
+    }
+}
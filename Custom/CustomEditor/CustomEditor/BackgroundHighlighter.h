@@ -0,0 +1,84 @@
+﻿#ifndef BACKGROUNDHIGHLIGHTER_H
+#define BACKGROUNDHIGHLIGHTER_H
+
+#include "Editor.h"
+#include <QFutureWatcher>
+#include <QTextCursor>
+#include <QTextLayout>
+#include <QTimer>
+
+/**
+ * @class : 后台线程语法高亮
+ *          工作线程把文本块扫描成不可变的格式区间和括号、折叠信息，GUI 线程只负责把结果设置到文本块上。
+ *          先处理可见区域，其余部分在空闲时逐步补全。某一行编辑后，只有结束状态(多行注释、字符串、annotation)
+ *          发生变化时才会继续重新扫描后面的行。
+ *          和 TextHighlighter 二选一使用。
+ */
+class BackgroundHighlighter : public QObject
+{
+    Q_OBJECT
+public:
+    BackgroundHighlighter(PlainTextEdit* pPlainTextEdit);
+    ~BackgroundHighlighter();
+
+    /**
+     * @brief: 块状态 = 词法状态(TextTokenizer::State) | annotation 折叠标志
+     */
+    enum
+    {
+        LexerStateMask = 0x3,
+        FoldingStateFlag = 0x4
+    };
+
+    struct BlockResult
+    {
+        int                               mStartState;
+        int                               mEndState;
+        QVector<QTextLayout::FormatRange> mFormats;
+        BlockAnalysis                     mAnalysis;
+    };
+    typedef QVector<BlockResult> BlockResults;
+
+    struct Job
+    {
+        int          mDocumentRevision;
+        int          mFirstBlockNumber;
+        int          mStartState;
+        QStringList  mTexts;
+        QVector<int> mRevisions;
+    };
+
+private slots:
+    void handleContentsChange(int position, int charsRemoved, int charsAdded);
+    void scheduleHighlighting();
+    void handleJobFinished();
+
+private:
+    /**
+     * @brief: 工作线程执行，只读 job 和共享的词法扫描器
+     */
+    static BlockResults runJob(const Job& job, const QVector<QTextCharFormat>& formats);
+
+    bool isDirty(const QTextBlock& block) const;
+    int  blockStartState(const QTextBlock& block) const;
+    bool scheduleVisibleBlocks();
+    bool scheduleFillBlocks();
+    void startJob(const QTextBlock& firstBlock, int blockCount);
+    void applyResults(const BlockResults& results);
+
+    PlainTextEdit*               mpPlainTextEdit;
+    QTextDocument*               mpTextDocument;
+    QVector<QTextCharFormat>     mTokenFormats;
+    QFutureWatcher<BlockResults> mJobWatcher;
+    Job                          mRunningJob;
+    QTimer                       mScheduleTimer;
+    QTextCursor                  mFillCursor;      // 补全扫描的位置，随文档编辑自动移动
+    QTextCursor                  mFillLimit;       // 编辑范围的结尾，扫描到这里之后遇到已高亮的块就停止
+    bool                         mFillActive;      // 还有需要补全扫描的块
+    bool                         mFullScanPending; // 可能存在不连续的未高亮块，需要扫描到文档末尾
+    bool                         mJobRunning;
+    bool                         mApplying;
+    int                          mLookahead; // 结束状态连续变化时，下一次任务多带的块数
+};
+
+#endif // BACKGROUNDHIGHLIGHTER_H
@@ -0,0 +1,477 @@
+﻿#include "CompletionEngine.h"
+#include <algorithm>
+
+static const int sMaxCandidates = 200;
+static const int sFuzzyRangeLimit = 2000; // 模糊匹配每个索引区间最多取的条目数
+
+CompletionEngine::CompletionEngine(QObject* parent)
+    : QObject(parent)
+    , mLastComplete(false)
+{
+}
+
+void CompletionEngine::addSymbols(const QStringList& symbols, Kind kind)
+{
+    mSymbols.reserve(mSymbols.size() + symbols.size());
+    foreach (const QString& symbol, symbols)
+    {
+        if (!symbol.isEmpty())
+        {
+            mSymbols.append(makeEntry(symbol, kind));
+        }
+    }
+    // 同名的只保留先加入的
+    std::stable_sort(mSymbols.begin(), mSymbols.end());
+    mSymbols.erase(std::unique(mSymbols.begin(), mSymbols.end(), [](const Entry& a, const Entry& b) { return a.mText == b.mText; }), mSymbols.end());
+
+    // mSymbols 可能重新分配，索引和上一次的匹配结果都要重建
+    EntryPointers entries;
+    entries.reserve(mSymbols.size());
+    for (QVector<Entry>::const_iterator it = mSymbols.constBegin(); it != mSymbols.constEnd(); ++it)
+    {
+        entries.append(&*it);
+    }
+    mSymbolIndex.build(entries);
+    rebuildIdentifierIndex();
+}
+
+void CompletionEngine::clearSymbols()
+{
+    mSymbols.clear();
+    mSymbolIndex.clear();
+    rebuildIdentifierIndex();
+}
+
+void CompletionEngine::addIdentifiers(const QStringList& identifiers)
+{
+    foreach (const QString& identifier, identifiers)
+    {
+        if (mIdentifierCounts[identifier]++ == 0)
+        {
+            addIdentifierEntry(identifier);
+        }
+    }
+}
+
+void CompletionEngine::removeIdentifiers(const QStringList& identifiers)
+{
+    foreach (const QString& identifier, identifiers)
+    {
+        QHash<QString, int>::iterator it = mIdentifierCounts.find(identifier);
+        if (it != mIdentifierCounts.end() && --it.value() <= 0)
+        {
+            mIdentifierCounts.erase(it);
+            removeIdentifierEntry(identifier);
+        }
+    }
+}
+
+bool CompletionEngine::containsSymbol(const QString& text) const
+{
+    Entry entry;
+    entry.mText = text;
+    entry.mKey = text.toLower();
+    return std::binary_search(mSymbols.constBegin(), mSymbols.constEnd(), entry);
+}
+
+/**
+ * @brief: 有序插入一个标识符，输入时每次按键只改动正在输入的那个单词，不影响其余条目和增量过滤缓存
+ */
+void CompletionEngine::addIdentifierEntry(const QString& identifier)
+{
+    if (containsSymbol(identifier))
+    {
+        return;
+    }
+    const Entry* pEntry = &mIdentifierEntries.insert(std::make_pair(identifier, makeEntry(identifier, Identifier))).first->second;
+    mIdentifierIndex.insert(pEntry);
+    // 上一次的候选池要包含所有能匹配上一次输入的条目，新条目能匹配就补进去
+    if (mLastComplete && matchScore(mLastQuery, mLastQuery, *pEntry) >= 0)
+    {
+        mLastMatches.append(pEntry);
+    }
+}
+
+void CompletionEngine::removeIdentifierEntry(const QString& identifier)
+{
+    std::map<QString, Entry>::iterator it = mIdentifierEntries.find(identifier);
+    if (it == mIdentifierEntries.end())
+    {
+        return;
+    }
+    const Entry* pEntry = &it->second;
+    mIdentifierIndex.remove(pEntry);
+    mLastMatches.erase(std::remove(mLastMatches.begin(), mLastMatches.end(), pEntry), mLastMatches.end());
+    mIdentifierEntries.erase(it);
+}
+
+/**
+ * @brief: 符号变化后有的标识符变成了符号(或反过来)，重新生成标识符条目
+ */
+void CompletionEngine::rebuildIdentifierIndex()
+{
+    mLastComplete = false;
+    mLastMatches.clear();
+    mIdentifierEntries.clear();
+    EntryPointers entries;
+    entries.reserve(mIdentifierCounts.size());
+    for (QHash<QString, int>::const_iterator it = mIdentifierCounts.constBegin(); it != mIdentifierCounts.constEnd(); ++it)
+    {
+        if (!containsSymbol(it.key()))
+        {
+            entries.append(&mIdentifierEntries.insert(std::make_pair(it.key(), makeEntry(it.key(), Identifier))).first->second);
+        }
+    }
+    mIdentifierIndex.build(entries);
+}
+
+/**
+ * @brief: 第一个字符、驼峰大写、下划线或点之后的字符是单词开头
+ */
+bool CompletionEngine::isWordStart(const QString& text, int index)
+{
+    return (index == 0) || (text.at(index).isUpper() && !text.at(index - 1).isUpper()) || text.at(index - 1) == QLatin1Char('_')
+           || text.at(index - 1) == QLatin1Char('.');
+}
+
+CompletionEngine::Entry CompletionEngine::makeEntry(const QString& text, int kind)
+{
+    Entry entry;
+    entry.mText = text;
+    entry.mKey = text.toLower();
+    entry.mKind = kind;
+    QString acronym;
+    for (int i = 0; i < entry.mKey.length() && i < text.length(); ++i)
+    {
+        if (isWordStart(text, i))
+        {
+            acronym.append(entry.mKey.at(i));
+        }
+    }
+    if (acronym.length() > 1)
+    {
+        entry.mAcronym = acronym;
+    }
+    return entry;
+}
+
+bool CompletionEngine::Index::entryLess(const Entry* pA, const Entry* pB)
+{
+    return *pA < *pB;
+}
+
+bool CompletionEngine::Index::wordStartLess(const WordStart& a, const WordStart& b)
+{
+    const int result = a.mpEntry->mKey.midRef(a.mOffset).compare(b.mpEntry->mKey.midRef(b.mOffset));
+    if (result != 0)
+    {
+        return result < 0;
+    }
+    if (a.mpEntry != b.mpEntry)
+    {
+        return *a.mpEntry < *b.mpEntry;
+    }
+    return a.mOffset < b.mOffset;
+}
+
+bool CompletionEngine::Index::acronymLess(const Entry* pA, const Entry* pB)
+{
+    return pA->mAcronym < pB->mAcronym || (pA->mAcronym == pB->mAcronym && *pA < *pB);
+}
+
+void CompletionEngine::Index::clear()
+{
+    mEntries.clear();
+    mWordStarts.clear();
+    mAcronyms.clear();
+}
+
+/**
+ * @brief: 批量建立索引，每个数组只排序一次
+ */
+void CompletionEngine::Index::build(const EntryPointers& entries)
+{
+    clear();
+    mEntries = entries;
+    foreach (const Entry* pEntry, entries)
+    {
+        for (int i = 1; i < pEntry->mKey.length() && i < pEntry->mText.length(); ++i)
+        {
+            if (isWordStart(pEntry->mText, i))
+            {
+                WordStart wordStart = {pEntry, i};
+                mWordStarts.append(wordStart);
+            }
+        }
+        if (!pEntry->mAcronym.isEmpty())
+        {
+            mAcronyms.append(pEntry);
+        }
+    }
+    std::sort(mEntries.begin(), mEntries.end(), entryLess);
+    std::sort(mWordStarts.begin(), mWordStarts.end(), wordStartLess);
+    std::sort(mAcronyms.begin(), mAcronyms.end(), acronymLess);
+}
+
+void CompletionEngine::Index::insert(const Entry* pEntry)
+{
+    mEntries.insert(std::lower_bound(mEntries.begin(), mEntries.end(), pEntry, entryLess), pEntry);
+    for (int i = 1; i < pEntry->mKey.length() && i < pEntry->mText.length(); ++i)
+    {
+        if (isWordStart(pEntry->mText, i))
+        {
+            WordStart wordStart = {pEntry, i};
+            mWordStarts.insert(std::lower_bound(mWordStarts.begin(), mWordStarts.end(), wordStart, wordStartLess), wordStart);
+        }
+    }
+    if (!pEntry->mAcronym.isEmpty())
+    {
+        mAcronyms.insert(std::lower_bound(mAcronyms.begin(), mAcronyms.end(), pEntry, acronymLess), pEntry);
+    }
+}
+
+void CompletionEngine::Index::remove(const Entry* pEntry)
+{
+    EntryPointers::iterator entryIt = std::lower_bound(mEntries.begin(), mEntries.end(), pEntry, entryLess);
+    if (entryIt != mEntries.end() && *entryIt == pEntry)
+    {
+        mEntries.erase(entryIt);
+    }
+    for (int i = 1; i < pEntry->mKey.length() && i < pEntry->mText.length(); ++i)
+    {
+        if (isWordStart(pEntry->mText, i))
+        {
+            WordStart                    wordStart = {pEntry, i};
+            QVector<WordStart>::iterator it = std::lower_bound(mWordStarts.begin(), mWordStarts.end(), wordStart, wordStartLess);
+            if (it != mWordStarts.end() && it->mpEntry == pEntry && it->mOffset == i)
+            {
+                mWordStarts.erase(it);
+            }
+        }
+    }
+    if (!pEntry->mAcronym.isEmpty())
+    {
+        EntryPointers::iterator it = std::lower_bound(mAcronyms.begin(), mAcronyms.end(), pEntry, acronymLess);
+        if (it != mAcronyms.end() && *it == pEntry)
+        {
+            mAcronyms.erase(it);
+        }
+    }
+}
+
+/**
+ * @brief: 二分出 mKey 以 lowerKey 开头的区间
+ */
+void CompletionEngine::Index::appendPrefixRange(const QString& lowerKey, EntryPointers* pEntries) const
+{
+    EntryPointers::const_iterator it =
+        std::lower_bound(mEntries.constBegin(), mEntries.constEnd(), lowerKey, [](const Entry* pEntry, const QString& key) { return pEntry->mKey < key; });
+    for (; it != mEntries.constEnd() && (*it)->mKey.startsWith(lowerKey); ++it)
+    {
+        pEntries->append(*it);
+    }
+}
+
+/**
+ * @brief: 模糊匹配的候选：开头、某个单词开头或首字母缩写以 lowerKey 开头的条目，每个区间最多取 limit 个
+ * @return: 没有区间被截断时返回 true
+ */
+bool CompletionEngine::Index::appendFuzzyRanges(const QString& lowerKey, int limit, EntryPointers* pEntries) const
+{
+    bool complete = true;
+    int  count = 0;
+    for (EntryPointers::const_iterator it =
+             std::lower_bound(mEntries.constBegin(), mEntries.constEnd(), lowerKey, [](const Entry* pEntry, const QString& key) { return pEntry->mKey < key; });
+         it != mEntries.constEnd() && (*it)->mKey.startsWith(lowerKey); ++it, ++count)
+    {
+        if (count == limit)
+        {
+            complete = false;
+            break;
+        }
+        pEntries->append(*it);
+    }
+    count = 0;
+    for (QVector<WordStart>::const_iterator it = std::lower_bound(
+             mWordStarts.constBegin(), mWordStarts.constEnd(), lowerKey,
+             [](const WordStart& wordStart, const QString& key) { return wordStart.mpEntry->mKey.midRef(wordStart.mOffset).compare(key) < 0; });
+         it != mWordStarts.constEnd() && it->mpEntry->mKey.midRef(it->mOffset).startsWith(lowerKey); ++it, ++count)
+    {
+        if (count == limit)
+        {
+            complete = false;
+            break;
+        }
+        pEntries->append(it->mpEntry);
+    }
+    count = 0;
+    for (EntryPointers::const_iterator it = std::lower_bound(mAcronyms.constBegin(), mAcronyms.constEnd(), lowerKey,
+                                                             [](const Entry* pEntry, const QString& key) { return pEntry->mAcronym < key; });
+         it != mAcronyms.constEnd() && (*it)->mAcronym.startsWith(lowerKey); ++it, ++count)
+    {
+        if (count == limit)
+        {
+            complete = false;
+            break;
+        }
+        pEntries->append(*it);
+    }
+    return complete;
+}
+
+/**
+ * @brief: 不匹配返回 -1
+ *         前缀匹配得分最高(大小写一致、完全相同再加分)，其次是子序列匹配：
+ *         匹配到单词开头(驼峰大写、下划线或点之后)和连续匹配加分，越短越靠前
+ */
+int CompletionEngine::matchScore(const QString& query, const QString& lowerQuery, const Entry& entry)
+{
+    const QString& key = entry.mKey;
+    const QString& text = entry.mText;
+    int            score = 0;
+    if (key.startsWith(lowerQuery))
+    {
+        score = 1000;
+        if (text.startsWith(query))
+        {
+            score += 100;
+        }
+        if (key.length() == lowerQuery.length())
+        {
+            score += 50;
+        }
+    }
+    else
+    {
+        int queryIndex = 0;
+        int lastIndex = -2;
+        for (int i = 0; i < key.length() && i < text.length() && queryIndex < lowerQuery.length(); ++i)
+        {
+            if (key.at(i) != lowerQuery.at(queryIndex))
+            {
+                continue;
+            }
+            score += isWordStart(text, i) ? 20 : 1;
+            if (i == lastIndex + 1)
+            {
+                score += 5;
+            }
+            lastIndex = i;
+            ++queryIndex;
+        }
+        if (queryIndex < lowerQuery.length())
+        {
+            return -1;
+        }
+    }
+    // 文档里用到的标识符优先
+    if (entry.mKind == Identifier)
+    {
+        score += 15;
+    }
+    return score - text.length();
+}
+
+CompletionEngine::Candidates CompletionEngine::complete(const QString& prefix, int maxCount) const
+{
+    Candidates candidates;
+    if (prefix.isEmpty())
+    {
+        return candidates;
+    }
+    const QString lowerQuery = prefix.toLower();
+
+    // 候选池对更长的输入只会变小，输入变长时只在上一次的结果里过滤
+    EntryPointers pool;
+    if (mLastComplete && !mLastQuery.isEmpty() && lowerQuery.startsWith(mLastQuery))
+    {
+        pool = mLastMatches;
+    }
+    else
+    {
+        mSymbolIndex.appendPrefixRange(lowerQuery, &pool);
+        mIdentifierIndex.appendPrefixRange(lowerQuery, &pool);
+        // 前缀匹配已经够多时不查模糊匹配，这样的候选池不能给更长的输入继续过滤
+        mLastComplete = false;
+        if (pool.size() < maxCount)
+        {
+            const QString key = lowerQuery.left(2);
+            const bool    symbolsComplete = mSymbolIndex.appendFuzzyRanges(key, sFuzzyRangeLimit, &pool);
+            const bool    identifiersComplete = mIdentifierIndex.appendFuzzyRanges(key, sFuzzyRangeLimit, &pool);
+            mLastComplete = symbolsComplete && identifiersComplete;
+            std::sort(pool.begin(), pool.end());
+            pool.erase(std::unique(pool.begin(), pool.end()), pool.end());
+        }
+    }
+
+    EntryPointers matches;
+    foreach (const Entry* pEntry, pool)
+    {
+        const int score = matchScore(prefix, lowerQuery, *pEntry);
+        if (score < 0)
+        {
+            continue;
+        }
+        matches.append(pEntry);
+        // 正在输入的单词本身不作为候选项
+        if (pEntry->mKind == Identifier && pEntry->mText == prefix && mIdentifierCounts.value(prefix) <= 1)
+        {
+            continue;
+        }
+        Candidate candidate;
+        candidate.mText = pEntry->mText;
+        candidate.mKind = pEntry->mKind;
+        candidate.mScore = score;
+        candidates.append(candidate);
+    }
+    mLastQuery = lowerQuery;
+    mLastMatches = matches;
+
+    auto greater = [](const Candidate& a, const Candidate& b) { return a.mScore > b.mScore || (a.mScore == b.mScore && a.mText < b.mText); };
+    if (candidates.size() > maxCount)
+    {
+        std::partial_sort(candidates.begin(), candidates.begin() + maxCount, candidates.end(), greater);
+        candidates.resize(maxCount);
+    }
+    else
+    {
+        std::sort(candidates.begin(), candidates.end(), greater);
+    }
+    return candidates;
+}
+
+CompletionModel::CompletionModel(CompletionEngine* pEngine, QObject* parent)
+    : QAbstractListModel(parent)
+    , mpEngine(pEngine)
+{
+}
+
+void CompletionModel::setPrefix(const QString& prefix)
+{
+    beginResetModel();
+    mCandidates = mpEngine->complete(prefix, sMaxCandidates);
+    endResetModel();
+}
+
+int CompletionModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : mCandidates.size();
+}
+
+QVariant CompletionModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= mCandidates.size())
+    {
+        return QVariant();
+    }
+    switch (role)
+    {
+    case Qt::DisplayRole:
+    case Qt::EditRole:
+        return mCandidates.at(index.row()).mText;
+    case Qt::UserRole:
+        return mCandidates.at(index.row()).mKind;
+    default:
+        return QVariant();
+    }
+}
@@ -0,0 +1,129 @@
+﻿#ifndef COMPLETIONENGINE_H
+#define COMPLETIONENGINE_H
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+#include <map>
+
+/**
+ * @class : 自动补全候选项查找
+ *          关键字、类型、库符号保存在按小写排序的数组里，文档里的标识符按引用计数保存，随文本块重新高亮有序插入、删除。
+ *          查找时二分出前缀区间，前缀匹配不够时再从单词开头(驼峰、下划线、点之后)和首字母缩写的有序索引里取模糊匹配，
+ *          都不扫描全部条目；输入继续变长时只在上一次的匹配结果里过滤。
+ */
+class CompletionEngine : public QObject
+{
+    Q_OBJECT
+public:
+    enum Kind
+    {
+        Keyword,
+        Type,
+        Symbol,
+        Identifier // 文档里的标识符
+    };
+    struct Candidate
+    {
+        QString mText;
+        int     mKind;
+        int     mScore;
+    };
+    typedef QVector<Candidate> Candidates;
+
+    CompletionEngine(QObject* parent = nullptr);
+
+    /**
+     * @brief: 批量加入符号，整体排序一次，加载大量库符号时一次传入
+     */
+    void addSymbols(const QStringList& symbols, Kind kind);
+    void clearSymbols();
+    void addIdentifiers(const QStringList& identifiers);
+    void removeIdentifiers(const QStringList& identifiers);
+
+    /**
+     * @brief: 按得分从高到低返回最多 maxCount 个候选项
+     */
+    Candidates complete(const QString& prefix, int maxCount) const;
+
+private:
+    struct Entry
+    {
+        QString mText;
+        QString mKey;     // 小写，排序和匹配用
+        QString mAcronym; // 各单词首字母(小写)，只有一个单词时为空
+        int     mKind;
+        bool    operator<(const Entry& other) const
+        {
+            return mKey < other.mKey || (mKey == other.mKey && mText < other.mText);
+        }
+    };
+    typedef QVector<const Entry*> EntryPointers;
+
+    struct WordStart
+    {
+        const Entry* mpEntry;
+        int          mOffset; // mKey 里单词开头的位置，不含 0
+    };
+
+    /**
+     * @class : 一组条目的有序索引，条目地址在索引期间不能变
+     *          mEntries 按 mKey 排序做前缀查找，mWordStarts 按单词开头起的后缀排序，mAcronyms 按首字母缩写排序
+     */
+    struct Index
+    {
+        EntryPointers      mEntries;
+        QVector<WordStart> mWordStarts;
+        EntryPointers      mAcronyms;
+
+        static bool entryLess(const Entry* pA, const Entry* pB);
+        static bool wordStartLess(const WordStart& a, const WordStart& b);
+        static bool acronymLess(const Entry* pA, const Entry* pB);
+
+        void clear();
+        void build(const EntryPointers& entries);
+        void insert(const Entry* pEntry);
+        void remove(const Entry* pEntry);
+        void appendPrefixRange(const QString& lowerKey, EntryPointers* pEntries) const;
+        bool appendFuzzyRanges(const QString& lowerKey, int limit, EntryPointers* pEntries) const;
+    };
+
+    static bool  isWordStart(const QString& text, int index);
+    static Entry makeEntry(const QString& text, int kind);
+    static int   matchScore(const QString& query, const QString& lowerQuery, const Entry& entry);
+    bool         containsSymbol(const QString& text) const;
+    void         addIdentifierEntry(const QString& identifier);
+    void         removeIdentifierEntry(const QString& identifier);
+    void         rebuildIdentifierIndex();
+
+    QVector<Entry>           mSymbols;
+    Index                    mSymbolIndex;
+    QHash<QString, int>      mIdentifierCounts;
+    std::map<QString, Entry> mIdentifierEntries; // 不在 mSymbols 里的标识符，节点地址不变，供索引引用
+    Index                    mIdentifierIndex;
+    mutable bool             mLastComplete; // 上一次的候选池没有被截断，更长的输入可以只在 mLastMatches 里过滤
+    mutable QString          mLastQuery;
+    mutable EntryPointers    mLastMatches;
+};
+
+/**
+ * @class : 补全弹出窗口的数据模型
+ *          只保存当前前缀的候选项，data() 时才生成 QVariant，配合 QCompleter::UnfilteredPopupCompletion 使用
+ */
+class CompletionModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    CompletionModel(CompletionEngine* pEngine, QObject* parent = nullptr);
+
+    void     setPrefix(const QString& prefix);
+    int      rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+private:
+    CompletionEngine*            mpEngine;
+    CompletionEngine::Candidates mCandidates;
+};
+
+#endif // COMPLETIONENGINE_H
@@ -1,6 +1,6 @@
 QT       += core gui
 
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets concurrent
 CONFIG += c++14
 
 # You can make your code fail to compile if it uses deprecated APIs.
@@ -8,13 +8,31 @@ CONFIG += c++14
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    BackgroundHighlighter.cpp \
+    CompletionEngine.cpp \
     Editor.cpp \
+    FoldingIndex.cpp \
+    FrameTimeProbe.cpp \
+    GutterRenderer.cpp \
+    LargeFileView.cpp \
     MainWindow.cpp \
+    ParenthesisIndex.cpp \
+    SearchEngine.cpp \
+    TextTokenizer.cpp \
     main.cpp
 
 HEADERS += \
+    BackgroundHighlighter.h \
+    CompletionEngine.h \
     Editor.h \
-    MainWindow.h
+    FoldingIndex.h \
+    FrameTimeProbe.h \
+    GutterRenderer.h \
+    LargeFileView.h \
+    MainWindow.h \
+    ParenthesisIndex.h \
+    SearchEngine.h \
+    TextTokenizer.h
 
 # Default rules for deployment.
 TARGET = CustomEdit
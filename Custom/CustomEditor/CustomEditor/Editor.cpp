@@ -1,11 +1,15 @@
 ﻿#include "Editor.h"
+#include "FoldingIndex.h"
+#include "FrameTimeProbe.h"
+#include "GutterRenderer.h"
+#include "ParenthesisIndex.h"
+#include "SearchEngine.h"
 #include <MainWindow.h>
 #include <QAbstractItemView>
 #include <QDebug>
 #include <QLabel>
 #include <QPainter>
 #include <QScrollBar>
-#include <QSortFilterProxyModel>
 #include <QTextBlock>
 int PlainTextEdit::mTabSize = 4;
 int PlainTextEdit::mIndentSize = 2;
@@ -30,31 +34,41 @@ PlainTextEdit::PlainTextEdit(QWidget* parent)
 
     //功能1：数字行号
     mpLineNumberArea = new LineNumberArea(this);
+    mpGutterRenderer = new GutterRenderer;
+    mLineNumberAreaWidth = -1;
     connect(this, SIGNAL(blockCountChanged(int)), this, SLOT(updateLineNumberAreaWidth(int)));
     connect(this, SIGNAL(updateRequest(QRect, int)), this, SLOT(updateLineNumberArea(QRect, int)));
     updateLineNumberAreaWidth(0);                 //设置TextEdit的左间距，给行号窗体提供空间
     setLineWrapMode(QPlainTextEdit::WidgetWidth); //设置换行模式
 
-    //功能2：自动补全
-    mpStandardItemModel = new QStandardItemModel(this);
+    //功能2：自动补全，CompletionEngine 负责查找排序，QCompleter 只负责弹出窗口，不再过滤
+    mpCompletionModel = new CompletionModel(pModelicaTextDocumentLayout->completionEngine(), this);
     initCompleteModel();
-    QSortFilterProxyModel* pSortFilterProxyModel = new QSortFilterProxyModel(this);
-    pSortFilterProxyModel->setSourceModel(mpStandardItemModel);
-    pSortFilterProxyModel->setSortCaseSensitivity(Qt::CaseInsensitive);
-    pSortFilterProxyModel->sort(0, Qt::AscendingOrder);
     mpCompleter = new QCompleter(this);
-    mpCompleter->setModel(pSortFilterProxyModel);
+    mpCompleter->setModel(mpCompletionModel);
     mpCompleter->setCaseSensitivity(Qt::CaseInsensitive);
     mpCompleter->setWrapAround(false);
     mpCompleter->setWidget(this);
-    mpCompleter->setCompletionMode(QCompleter::PopupCompletion);
+    mpCompleter->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
     connect(mpCompleter, SIGNAL(highlighted(QModelIndex)), this, SLOT(showCompletionItemToolTip(QModelIndex)));
     connect(mpCompleter, SIGNAL(activated(QModelIndex)), this, SLOT(insertCompletionItem(QModelIndex)));
 
-    //功能3：
+    //功能3：查找，结果只给可见区域设置 extraSelections，滚动时更新
+    mpSearchEngine = new SearchEngine(document(), this);
+    mSearchMatchFormat.setBackground(QColor(255, 235, 120));
+    mFindPending = false;
+    connect(mpSearchEngine, SIGNAL(matchesFound()), this, SLOT(handleMatchesFound()));
+    connect(mpSearchEngine, SIGNAL(finished()), this, SLOT(handleMatchesFound()));
+    connect(verticalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(updateHighlights()));
 
     connect(document(), &QTextDocument::undoAvailable, this, &PlainTextEdit::slotUndoAvailable);
     setUndoRedoEnabled(true);
+    mpFrameTimeProbe = new FrameTimeProbe("PlainTextEdit");
+    mCurrentLineColor = QColor(232, 242, 254);
+    mFoldPlaceholderWidth = 0;
+    connect(this, SIGNAL(blockCountChanged(int)), this, SLOT(clearFoldPlaceholders()));
+    mParenthesesMatchFormat.setBackground(QColor(180, 238, 180));
+    mParenthesesMisMatchFormat.setBackground(QColor(255, 160, 160));
     connect(this, SIGNAL(cursorPositionChanged()), this, SLOT(updateHighlights()));
     connect(this, SIGNAL(cursorPositionChanged()), this, SLOT(updateCursorPosition()));
     updateHighlights();
@@ -66,6 +80,12 @@ PlainTextEdit::PlainTextEdit(QWidget* parent)
     setCanHaveBreakpoints(true);
 }
 
+PlainTextEdit::~PlainTextEdit()
+{
+    delete mpGutterRenderer;
+    delete mpFrameTimeProbe;
+}
+
 void PlainTextEdit::setCanHaveBreakpoints(bool canHaveBreakpoints)
 {
     mCanHaveBreakpoints = canHaveBreakpoints;
@@ -104,22 +124,21 @@ void PlainTextEdit::lineNumberAreaPaintEvent(QPaintEvent* event)
 {
     QPainter painter(mpLineNumberArea);
     painter.fillRect(event->rect(), QColor(240, 240, 240));
+    mpGutterRenderer->ensureCache(document()->defaultFont(), mpLineNumberArea->devicePixelRatioF(), mpLineNumberArea);
 
     QTextBlock block = firstVisibleBlock();
     int        blockNumber = block.blockNumber();
     //计算第一个文本块
-    qreal              top = blockBoundingGeometry(block).translated(contentOffset()).top();
-    qreal              bottom = top;
-    const QFontMetrics fm(document()->defaultFont());
-    int                fmLineSpacing = fm.lineSpacing();
-
-    int collapseColumnWidth = 4;
-    collapseColumnWidth = foldBoxWidth(fm);
-    const int lineNumbersWidth = mpLineNumberArea->width() - collapseColumnWidth;
-
+    qreal         top = blockBoundingGeometry(block).translated(contentOffset()).top();
+    qreal         bottom = top;
+    FoldingIndex* pFoldingIndex = foldingIndex();
+    const int     lineNumbersWidth = mpLineNumberArea->width() - mpGutterRenderer->foldBoxWidth();
+    const int     currentBlockNumber = textCursor().blockNumber();
+
+    //先收集可见行，再交给 GutterRenderer 批量绘制
+    QVector<GutterRenderer::Row> rows;
     while (block.isValid() && top <= event->rect().bottom())
     {
-        QTextDocument* pTextDocument = document();
         top = bottom;
         const qreal height = blockBoundingRect(block).height();
         bottom = top + height;
@@ -129,7 +148,7 @@ void PlainTextEdit::lineNumberAreaPaintEvent(QPaintEvent* event)
         int        nextVisibleBlockNumber = blockNumber + 1;
         if (!nextVisibleBlock.isVisible())
         {
-            nextVisibleBlock = pTextDocument->findBlockByLineNumber(nextVisibleBlock.firstLineNumber());
+            nextVisibleBlock = pFoldingIndex->nextVisibleBlock(block);
             nextVisibleBlockNumber = nextVisibleBlock.blockNumber();
         }
         if (bottom < event->rect().top())
@@ -138,97 +157,31 @@ void PlainTextEdit::lineNumberAreaPaintEvent(QPaintEvent* event)
             blockNumber = nextVisibleBlockNumber;
             continue;
         }
-        /* paint breakpoints */
+        GutterRenderer::Row row;
+        row.mTop = top;
+        row.mHeight = height;
+        row.mBlockNumber = blockNumber;
+        row.mCurrent = (blockNumber == currentBlockNumber);
+        row.mNumberVisible = block.isVisible();
+
         TextBlockUserData* pTextBlockUserData = static_cast<TextBlockUserData*>(block.userData());
         if (pTextBlockUserData && canHaveBreakpoints())
         {
-            int xoffset = 0;
-            foreach (ITextMark* mk, pTextBlockUserData->marks())
-            {
-                int   radius = fmLineSpacing;
-                QRect r(xoffset, top, radius, radius);
-                mk->icon().paint(&painter, r, Qt::AlignCenter);
-                xoffset += 2;
-            }
-        }
-        /* paint line numbers */
-        if (block.isVisible() && bottom >= event->rect().top())
-        {
-            QString number;
-            number = QString::number(blockNumber + 1);
-            if (blockNumber == textCursor().blockNumber())
-            {
-                painter.setPen(QColor(64, 64, 64));
-            }
-            else
-            {
-                painter.setPen(Qt::gray);
-            }
-            painter.setFont(document()->defaultFont());
-            painter.drawText(0, top, lineNumbersWidth, fm.height(), Qt::AlignRight, number);
+            row.mMarks = pTextBlockUserData->marks();
         }
 
-        // paint folding markers
-        painter.save();
-        painter.setRenderHint(QPainter::Antialiasing, false);
-        painter.setPen(Qt::gray);
-
-        // paint folding markers
+        const int          foldingIndent = BaseEditorDocumentLayout::foldingIndent(block);
         TextBlockUserData* nextBlockUserData = BaseEditorDocumentLayout::testUserData(nextBlock);
-        bool               drawFoldingControl = nextBlockUserData && BaseEditorDocumentLayout::foldingIndent(block) < nextBlockUserData->foldingIndent();
-        bool               drawLine = BaseEditorDocumentLayout::foldingIndent(block) > 0;
-        bool               drawEnd
-            = drawLine && (!nextBlockUserData || (nextBlockUserData && BaseEditorDocumentLayout::foldingIndent(block) > nextBlockUserData->foldingIndent()));
-        int   boxWidth = foldBoxWidth(fm);
-        int   size = boxWidth / 4;
-        QRect foldingMarkerBox(lineNumbersWidth + size, top + size, 2 * (size) + 1, 2 * (size) + 1);
-        QRect foldingLineBox(lineNumbersWidth + size, top, 2 * (size) + 1, height);
-
-        if (drawEnd)
-        {
-            painter.drawLine(QPointF(foldingLineBox.center().x(), foldingLineBox.top()), foldingLineBox.center());
-            painter.drawLine(foldingLineBox.center(), QPointF(foldingLineBox.right(), foldingLineBox.center().y()));
-        }
-
-        if (drawLine && !drawEnd)
-        {
-            painter.drawLine(QPointF(foldingLineBox.center().x(), foldingLineBox.top()), QPointF(foldingLineBox.center().x(), foldingLineBox.bottom()));
-        }
-
-        if (drawFoldingControl)
-        {
-            bool                 expanded = nextBlock.isVisible();
-            QStyle*              pStyle = style();
-            QStyleOptionViewItem styleOptionViewItem;
-            styleOptionViewItem.rect = foldingMarkerBox;
-            styleOptionViewItem.state = QStyle::State_Active | QStyle::State_Item | QStyle::State_Children;
-            /* For some reason QStyle::PE_IndicatorBranch is not showing up in MAC.
-             * So I use QStyle::PE_IndicatorArrowDown and QStyle::PE_IndicatorArrowRight
-             * Perhaps this is fixed in newer Qt versions. We will see when we use Qt 5 for MAC.
-             */
-#ifndef Q_OS_MAC
-            if (expanded)
-            {
-                styleOptionViewItem.state |= QStyle::State_Open;
-            }
-            pStyle->drawPrimitive(QStyle::PE_IndicatorBranch, &styleOptionViewItem, &painter, mpLineNumberArea);
-#else
-            styleOptionViewItem.rect.translate(-1, 0);
-            if (expanded)
-            {
-                pStyle->drawPrimitive(QStyle::PE_IndicatorArrowDown, &styleOptionViewItem, &painter, mpLineNumberArea);
-            }
-            else
-            {
-                pStyle->drawPrimitive(QStyle::PE_IndicatorArrowRight, &styleOptionViewItem, &painter, mpLineNumberArea);
-            }
-#endif
-        }
-        painter.restore();
+        row.mDrawFoldingControl = nextBlockUserData && foldingIndent < nextBlockUserData->foldingIndent();
+        row.mDrawLine = foldingIndent > 0;
+        row.mDrawEnd = row.mDrawLine && (!nextBlockUserData || foldingIndent > nextBlockUserData->foldingIndent());
+        row.mExpanded = nextBlock.isVisible();
+        rows.append(row);
 
         block = nextVisibleBlock;
         blockNumber = nextVisibleBlockNumber;
     }
+    mpGutterRenderer->paint(&painter, rows, lineNumbersWidth);
 }
 
 void PlainTextEdit::lineNumberAreaMouseEvent(QMouseEvent* event)
@@ -295,7 +248,15 @@ void PlainTextEdit::moveCursorVisible(bool ensureVisible)
 void PlainTextEdit::updateLineNumberAreaWidth(int newBlockCount)
 {
     Q_UNUSED(newBlockCount);
-    setViewportMargins(lineNumberAreaWidth(), 0, 0, 0);
+    //滚动时每次整屏更新都会调用，宽度不变就不重新设置边距，避免重新布局
+    const int width = lineNumberAreaWidth();
+    if (width != mLineNumberAreaWidth)
+    {
+        mLineNumberAreaWidth = width;
+        setViewportMargins(width, 0, 0, 0);
+        QRect cr = contentsRect();
+        mpLineNumberArea->setGeometry(QRect(cr.left(), cr.top(), width, cr.height()));
+    }
 }
 
 void PlainTextEdit::updateLineNumberArea(const QRect& rect, int dy)
@@ -323,11 +284,8 @@ void PlainTextEdit::showCompletionItemToolTip(const QModelIndex& index) {}
 void PlainTextEdit::insertCompletionItem(const QModelIndex& index)
 {
 
-    QVariant      value = index.data(Qt::UserRole);
-    CompleterItem completerItem = qvariant_cast<CompleterItem>(value);
-    QString       selectiontext = completerItem.mSelect;
-    QStringList   completionlength = completerItem.mValue.split("\n");
-    QTextCursor   cursor = textCursor();
+    QStringList completionlength = index.data(Qt::DisplayRole).toString().split("\n");
+    QTextCursor cursor = textCursor();
     cursor.beginEditBlock();
     cursor.setPosition(cursor.position(), QTextCursor::MoveAnchor);
     cursor.setPosition(cursor.position() - mpCompleter->completionPrefix().length(), QTextCursor::KeepAnchor);
@@ -340,16 +298,66 @@ void PlainTextEdit::insertCompletionItem(const QModelIndex& index)
 
 void PlainTextEdit::updateHighlights()
 {
-    QList<QTextEdit::ExtraSelection> emptySelect;
-    setExtraSelections(emptySelect);
-    QList<QTextEdit::ExtraSelection> selections = extraSelections();
-    QTextEdit::ExtraSelection        selection;
-    QColor                           lineColor = QColor(232, 242, 254);
-    selection.format.setBackground(lineColor);
-    selection.format.setProperty(QTextFormat::FullWidthSelection, true);
-    selection.cursor = textCursor();
-    selection.cursor.clearSelection();
-    selections.append(selection);
+    //当前行背景在 paintEvent 里绘制，不放在 extraSelections 里，光标换行时不用重新设置整个列表
+    updateCurrentLine();
+
+    QTextCursor                      cursor = textCursor();
+    QList<QTextEdit::ExtraSelection> selections;
+    QVector<int>                     key;
+
+    //查找结果
+    if (mpSearchEngine->matchCount() > 0)
+    {
+        const QTextBlock            lastBlock = cursorForPosition(viewport()->rect().bottomRight()).block();
+        const SearchEngine::Matches matches = mpSearchEngine->matchesInRange(firstVisibleBlock().position(), lastBlock.position() + lastBlock.length());
+        foreach (const SearchEngine::Match& match, matches)
+        {
+            QTextEdit::ExtraSelection matchSelection;
+            matchSelection.format = mSearchMatchFormat;
+            matchSelection.cursor = QTextCursor(document());
+            matchSelection.cursor.setPosition(match.mPosition);
+            matchSelection.cursor.setPosition(match.mPosition + match.mLength, QTextCursor::KeepAnchor);
+            selections.append(matchSelection);
+            key.append(match.mPosition);
+            key.append(match.mLength);
+        }
+        key.append(matches.size());
+    }
+
+    //括号匹配
+    auto appendParenthesis = [&](int position, TextBlockUserData::MatchType matchType) {
+        QTextEdit::ExtraSelection parenthesisSelection;
+        parenthesisSelection.format = (matchType == TextBlockUserData::Match) ? mParenthesesMatchFormat : mParenthesesMisMatchFormat;
+        parenthesisSelection.cursor = QTextCursor(document());
+        parenthesisSelection.cursor.setPosition(position);
+        parenthesisSelection.cursor.setPosition(position + 1, QTextCursor::KeepAnchor);
+        selections.append(parenthesisSelection);
+        key.append(position);
+        key.append(matchType);
+    };
+    if (!cursor.hasSelection())
+    {
+        QTextCursor                  backwardMatch = cursor;
+        TextBlockUserData::MatchType backwardMatchType = TextBlockUserData::matchCursorBackward(&backwardMatch);
+        if (backwardMatchType != TextBlockUserData::NoMatch)
+        {
+            appendParenthesis(cursor.position() - 1, backwardMatchType);
+            appendParenthesis(backwardMatch.position(), backwardMatchType);
+        }
+        QTextCursor                  forwardMatch = cursor;
+        TextBlockUserData::MatchType forwardMatchType = TextBlockUserData::matchCursorForward(&forwardMatch);
+        if (forwardMatchType != TextBlockUserData::NoMatch)
+        {
+            appendParenthesis(cursor.position(), forwardMatchType);
+            appendParenthesis(forwardMatch.position() - 1, forwardMatchType);
+        }
+    }
+    //括号、查找结果没变化时不重新设置，避免重绘
+    if (key == mHighlightsKey)
+    {
+        return;
+    }
+    mHighlightsKey = key;
     setExtraSelections(selections);
 }
 
@@ -369,10 +377,12 @@ void PlainTextEdit::resizeEvent(QResizeEvent* pEvent)
     //使用文本的矩形，它是去掉了间隔的矩形
     QRect cr = contentsRect();
     mpLineNumberArea->setGeometry(QRect(cr.left(), cr.top(), lineNumberAreaWidth(), cr.height()));
+    updateHighlights();
 }
 
 void PlainTextEdit::keyPressEvent(QKeyEvent* pEvent)
 {
+    mpFrameTimeProbe->markInput();
     bool shiftModifier = pEvent->modifiers().testFlag(Qt::ShiftModifier);
     bool controlModifier = pEvent->modifiers().testFlag(Qt::ControlModifier);
     bool isCompleterShortcut = controlModifier && (pEvent->key() == Qt::Key_Space); // CTRL+space
@@ -496,8 +506,14 @@ void PlainTextEdit::keyPressEvent(QKeyEvent* pEvent)
     }
     if (completionPrefix != mpCompleter->completionPrefix())
     {
+        mpCompletionModel->setPrefix(completionPrefix);
         mpCompleter->setCompletionPrefix(completionPrefix);
     }
+    if (mpCompletionModel->rowCount() == 0)
+    {
+        mpCompleter->popup()->hide();
+        return;
+    }
     QRect cr = cursorRect();
     cr.setWidth(mpCompleter->popup()->sizeHintForColumn(0) + mpCompleter->popup()->verticalScrollBar()->sizeHint().width());
     mpCompleter->complete(cr);
@@ -540,9 +556,87 @@ void PlainTextEdit::paintEvent(QPaintEvent* e)
     //            mpCompleterToolTipWidget->move(mpCompleter->popup()->mapToGlobal(QPoint(rect.x() + mpCompleter->popup()->width() + 2, rect.y() + 2)));
     //        }
     //    }
+    mpFrameTimeProbe->beginFrame();
+    //当前行背景画在文本下面
+    const QRectF lineRect = currentLineRect();
+    mCurrentLineRect = lineRect;
+    if (lineRect.height() > 0)
+    {
+        QPainter painter(viewport());
+        painter.fillRect(QRectF(0, lineRect.top() + contentOffset().y(), viewport()->width(), lineRect.height()), mCurrentLineColor);
+    }
     QPlainTextEdit::paintEvent(e);
+    paintFoldPlaceholders(e);
+    mpFrameTimeProbe->endFrame();
+}
+
+/**
+ * @brief: 当前行所在的视觉行，文档坐标；光标所在块不可见时返回空
+ */
+QRectF PlainTextEdit::currentLineRect() const
+{
+    const QTextCursor cursor = textCursor();
+    const QTextBlock  block = cursor.block();
+    if (!block.isVisible())
+    {
+        return QRectF();
+    }
+    const QRectF blockRect = blockBoundingGeometry(block);
+    QRectF       rect(0, blockRect.top(), 0, blockRect.height());
+    if (QTextLayout* pTextLayout = block.layout())
+    {
+        const QTextLine line = pTextLayout->lineForTextPosition(cursor.positionInBlock());
+        if (line.isValid())
+        {
+            rect.setTop(blockRect.top() + line.y());
+            rect.setHeight(line.height());
+        }
+    }
+    return rect;
+}
+
+/**
+ * @brief: 当前行变化时只重绘旧的和新的两行
+ */
+void PlainTextEdit::updateCurrentLine()
+{
+    const QRectF rect = currentLineRect();
+    if (rect == mCurrentLineRect)
+    {
+        return;
+    }
+    const qreal y = contentOffset().y();
+    const int   width = viewport()->width();
+    if (mCurrentLineRect.height() > 0)
+    {
+        viewport()->update(QRectF(0, mCurrentLineRect.top() + y, width, mCurrentLineRect.height()).toAlignedRect());
+    }
+    if (rect.height() > 0)
+    {
+        viewport()->update(QRectF(0, rect.top() + y, width, rect.height()).toAlignedRect());
+    }
+    mCurrentLineRect = rect;
+}
+
+void PlainTextEdit::paintFoldPlaceholders(QPaintEvent* e)
+{
+    //折叠框的宽度只和字体有关，字体(缩放)变化时重新计算
+    const QFont font = document()->defaultFont();
+    if (font != mFoldPlaceholderFont)
+    {
+        mFoldPlaceholderFont = font;
+        const QFontMetrics fm(font);
+        const QString      rectReplacement = QLatin1String(" ...); ");
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 11, 0))
+        mFoldPlaceholderWidth = fm.horizontalAdvance(rectReplacement);
+#else  // QT_VERSION_CHECK
+        mFoldPlaceholderWidth = fm.width(rectReplacement);
+#endif // QT_VERSION_CHECK
+        mFoldPlaceholders.clear();
+    }
+
     QPointF    offset(contentOffset());
-    QPainter   painter(viewport());
+    QPainter   painter;
     QTextBlock block = firstVisibleBlock();
 
     qreal top = blockBoundingGeometry(block).translated(offset).top();
@@ -554,80 +648,46 @@ void PlainTextEdit::paintEvent(QPaintEvent* e)
     int         selectionEnd = cursor.selectionEnd();
 
     QTextDocument* pTextDocument = document();
+    FoldingIndex*  pFoldingIndex = foldingIndex();
 
     while (block.isValid() && top <= e->rect().bottom())
     {
         QTextBlock nextBlock = block.next();
         QTextBlock nextVisibleBlock = nextBlock;
 
-        if (!nextVisibleBlock.isVisible())
+        if (nextBlock.isValid() && !nextBlock.isVisible())
         {
-            // invisible blocks do have zero line count
-            nextVisibleBlock = pTextDocument->findBlockByLineNumber(nextVisibleBlock.firstLineNumber());
-            // in case our code somewhere did not set the line count of the invisible block to 0
-            while (nextVisibleBlock.isValid() && !nextVisibleBlock.isVisible())
+            // 折叠索引二分查找隐藏区间的结尾
+            nextVisibleBlock = pFoldingIndex->nextVisibleBlock(block);
+            if (block.isVisible() && bottom >= e->rect().top())
             {
-                nextVisibleBlock = nextVisibleBlock.next();
-            }
-        }
-        if (block.isVisible() && bottom >= e->rect().top())
-        {
-            if (nextBlock.isValid() && !nextBlock.isVisible())
-            {
-                bool selectThis = (hasSelection && nextBlock.position() >= selectionStart && nextBlock.position() < selectionEnd);
-                painter.save();
-                painter.setFont(document()->defaultFont());
-                painter.setPen(QColor(Qt::darkGray));
-                if (selectThis)
+                //只有出现折叠框时才开始绘制
+                if (!painter.isActive())
                 {
-                    painter.setBrush(palette().highlight());
+                    painter.begin(viewport());
+                    painter.setFont(font);
+                    painter.setRenderHint(QPainter::Antialiasing, true);
                 }
+                bool selectThis = (hasSelection && nextBlock.position() >= selectionStart && nextBlock.position() < selectionEnd);
 
                 QTextLayout* pTextLayout = block.layout();
                 QTextLine    line = pTextLayout->lineAt(pTextLayout->lineCount() - 1);
                 QRectF       lineRect = line.naturalTextRect().translated(offset.x(), top);
                 lineRect.adjust(0, 0, -1, -1);
+                QRectF collapseRect(lineRect.right() + 12, lineRect.top(), mFoldPlaceholderWidth, lineRect.height());
 
-                QString replacement = QLatin1String("...");
-                QString rectReplacement = QLatin1String(" ") + replacement + QLatin1String("); ");
-
-                const QFontMetrics fm(document()->defaultFont());
-#if (QT_VERSION >= QT_VERSION_CHECK(5, 11, 0))
-                QRectF collapseRect(lineRect.right() + 12, lineRect.top(), fm.horizontalAdvance(rectReplacement), lineRect.height());
-#else  // QT_VERSION_CHECK
-                QRectF collapseRect(lineRect.right() + 12, lineRect.top(), fm.width(rectReplacement), lineRect.height());
-#endif // QT_VERSION_CHECK
-                painter.setRenderHint(QPainter::Antialiasing, true);
-                painter.translate(.5, .5);
-                painter.drawRoundedRect(collapseRect.adjusted(0, 0, 0, -1), 3, 3);
-                painter.setRenderHint(QPainter::Antialiasing, false);
-                painter.translate(-.5, -.5);
-
-                block = nextVisibleBlock.previous();
-                if (!block.isValid())
-                    block = pTextDocument->lastBlock();
-
-                if (TextBlockUserData* blockUserData = BaseEditorDocumentLayout::testUserData(block))
-                {
-                    if (blockUserData->foldingEndIncluded())
-                    {
-                        QString right = block.text().trimmed();
-                        if (right.endsWith(QLatin1Char(';')))
-                        {
-                            right.chop(1);
-                            right = right.trimmed();
-                            replacement.append(right.right(right.endsWith(QLatin1Char('/')) ? 2 : 1));
-                            replacement.append(QLatin1Char(';'));
-                        }
-                    }
-                }
+                painter.setPen(QColor(Qt::darkGray));
+                painter.setBrush(selectThis ? palette().highlight() : QBrush());
+                painter.drawRoundedRect(collapseRect.adjusted(0, 0, 0, -1).translated(.5, .5), 3, 3);
 
+                QTextBlock endBlock = nextVisibleBlock.previous();
+                if (!endBlock.isValid())
+                    endBlock = pTextDocument->lastBlock();
                 if (selectThis)
                 {
                     painter.setPen(palette().highlightedText().color());
                 }
-                painter.drawText(collapseRect, Qt::AlignCenter, replacement);
-                painter.restore();
+                painter.drawText(collapseRect, Qt::AlignCenter, foldPlaceholderText(block, endBlock));
             }
         }
 
@@ -637,6 +697,43 @@ void PlainTextEdit::paintEvent(QPaintEvent* e)
     }
 }
 
+/**
+ * @brief: 折叠区域以 ; 结尾时把结尾的符号也显示在 "..." 后面
+ */
+QString PlainTextEdit::foldPlaceholderText(const QTextBlock& block, const QTextBlock& endBlock)
+{
+    TextBlockUserData* blockUserData = BaseEditorDocumentLayout::testUserData(endBlock);
+    const bool         endIncluded = blockUserData && blockUserData->foldingEndIncluded();
+    FoldPlaceholder&   placeholder = mFoldPlaceholders[block.blockNumber()];
+    if (!placeholder.mText.isEmpty() && placeholder.mEndBlockNumber == endBlock.blockNumber() && placeholder.mEndRevision == endBlock.revision()
+        && placeholder.mEndIncluded == endIncluded)
+    {
+        return placeholder.mText;
+    }
+    QString replacement = QLatin1String("...");
+    if (endIncluded)
+    {
+        QString right = endBlock.text().trimmed();
+        if (right.endsWith(QLatin1Char(';')))
+        {
+            right.chop(1);
+            right = right.trimmed();
+            replacement.append(right.right(right.endsWith(QLatin1Char('/')) ? 2 : 1));
+            replacement.append(QLatin1Char(';'));
+        }
+    }
+    placeholder.mEndBlockNumber = endBlock.blockNumber();
+    placeholder.mEndRevision = endBlock.revision();
+    placeholder.mEndIncluded = endIncluded;
+    placeholder.mText = replacement;
+    return placeholder.mText;
+}
+
+void PlainTextEdit::clearFoldPlaceholders()
+{
+    mFoldPlaceholders.clear();
+}
+
 int PlainTextEdit::firstNonSpace(const QString& text)
 {
     int i = 0;
@@ -749,13 +846,8 @@ LineNumberArea* PlainTextEdit::getMpLineNumberArea() const
 
 void PlainTextEdit::insertCompleterTypes(QStringList types)
 {
-    for (int k = 0; k < types.size(); ++k)
-    {
-        QStandardItem* pStandardItem = new QStandardItem(types[k]);
-        //        pStandardItem->setIcon(ResourceCache::getIcon(":/Resources/icons/completerType.svg"));
-        pStandardItem->setData(QVariant::fromValue(CompleterItem(types[k], types[k], "")), Qt::UserRole);
-        mpStandardItemModel->appendRow(pStandardItem);
-    }
+    //一次传入整批符号，只排序一次
+    qobject_cast<BaseEditorDocumentLayout*>(document()->documentLayout())->completionEngine()->addSymbols(types, CompletionEngine::Symbol);
 }
 
 QStringList PlainTextEdit::getKeywords()
@@ -837,11 +929,10 @@ QStringList PlainTextEdit::getTypes()
 
 void PlainTextEdit::initCompleteModel()
 {
-    mpStandardItemModel->clear();
-    QStringList types = PlainTextEdit::getTypes();
-    insertCompleterTypes(types);
-    QStringList keywords = PlainTextEdit::getKeywords();
-    insertCompleterTypes(keywords);
+    CompletionEngine* pCompletionEngine = qobject_cast<BaseEditorDocumentLayout*>(document()->documentLayout())->completionEngine();
+    pCompletionEngine->clearSymbols();
+    pCompletionEngine->addSymbols(PlainTextEdit::getTypes(), CompletionEngine::Type);
+    pCompletionEngine->addSymbols(PlainTextEdit::getKeywords(), CompletionEngine::Keyword);
 }
 
 void PlainTextEdit::resetZoom()
@@ -885,9 +976,15 @@ QString PlainTextEdit::wordUnderCursor()
 
 void PlainTextEdit::toggleBreakpoint(const QString fileName, int lineNumber)
 {
-    BreakpointMarker* pBreakpointMarker;
-    auto              iter = lineDocMap.constFind(lineNumber);
-    if (iter == lineDocMap.end())
+    BreakpointMarker* pBreakpointMarker = 0;
+    foreach (ITextMark* pTextMark, mpDocumentMarker->marksAt(lineNumber))
+    {
+        if ((pBreakpointMarker = qobject_cast<BreakpointMarker*>(pTextMark)))
+        {
+            break;
+        }
+    }
+    if (!pBreakpointMarker)
     {
         qDebug().nospace() << __FILE__ << "(" << __LINE__ << ")" << __FUNCTION__ << " -- lineNumber " << lineNumber;
         /* create a breakpoint marker */
@@ -895,28 +992,122 @@ void PlainTextEdit::toggleBreakpoint(const QString fileName, int lineNumber)
         pBreakpointMarker->setEnabled(true);
         /* Add the marker to document marker */
         mpDocumentMarker->addMark(pBreakpointMarker, lineNumber);
-        /* insert the breakpoint in BreakpointsWidget */
-        lineDocMap.insert(lineNumber, pBreakpointMarker);
     }
     else
     {
         qDebug().nospace() << __FILE__ << "(" << __LINE__ << ")" << __FUNCTION__ << " -- lineNumber " << lineNumber;
-        BreakpointMarker* pBreakpointMarker = iter.value();
         mpDocumentMarker->removeMark(pBreakpointMarker);
-        lineDocMap.remove(lineNumber);
+        pBreakpointMarker->deleteLater();
         //        pBreakpointsTreeModel->removeBreakpoint(pBreakpointMarker);
     }
 }
 
 void PlainTextEdit::toggleBlockVisible(const QTextBlock& block)
+{
+    if (foldingIndex()->toggleFold(block))
+    {
+        updateFoldingLayout();
+    }
+}
+
+FoldingIndex* PlainTextEdit::foldingIndex() const
+{
+    return qobject_cast<BaseEditorDocumentLayout*>(document()->documentLayout())->foldingIndex();
+}
+
+void PlainTextEdit::updateFoldingLayout()
 {
     BaseEditorDocumentLayout* pBaseEditorDocumentLayout;
     pBaseEditorDocumentLayout = qobject_cast<BaseEditorDocumentLayout*>(document()->documentLayout());
-    BaseEditorDocumentLayout::foldOrUnfold(block, BaseEditorDocumentLayout::isFolded(block));
     pBaseEditorDocumentLayout->requestUpdate();
     pBaseEditorDocumentLayout->emitDocumentSizeChanged();
 }
 
+void PlainTextEdit::foldToLevel(int level)
+{
+    if (foldingIndex()->foldToLevel(level))
+    {
+        updateFoldingLayout();
+        moveCursorVisible(true);
+    }
+}
+
+void PlainTextEdit::foldAll()
+{
+    foldToLevel(0);
+}
+
+void PlainTextEdit::unfoldAll()
+{
+    if (foldingIndex()->unfoldAll())
+    {
+        updateFoldingLayout();
+    }
+}
+
+void PlainTextEdit::setSearchText(const QString& text, int options)
+{
+    mFindPending = !text.isEmpty();
+    mpSearchEngine->find(text, SearchEngine::Options(options));
+}
+
+bool PlainTextEdit::findNext()
+{
+    const SearchEngine::Match match = mpSearchEngine->nextMatch(textCursor().selectionEnd(), true);
+    if (match.mLength == 0)
+    {
+        return false;
+    }
+    selectRange(match.mPosition, match.mLength);
+    return true;
+}
+
+bool PlainTextEdit::findPrevious()
+{
+    const SearchEngine::Match match = mpSearchEngine->nextMatch(textCursor().selectionStart(), false);
+    if (match.mLength == 0)
+    {
+        return false;
+    }
+    selectRange(match.mPosition, match.mLength);
+    return true;
+}
+
+int PlainTextEdit::replaceAll(const QString& text, const QString& replacement, int options)
+{
+    mFindPending = false;
+    return mpSearchEngine->replaceAll(text, replacement, SearchEngine::Options(options));
+}
+
+void PlainTextEdit::selectRange(int position, int length)
+{
+    QTextCursor cursor = textCursor();
+    cursor.setPosition(position);
+    cursor.setPosition(position + length, QTextCursor::KeepAnchor);
+    setTextCursor(cursor);
+}
+
+void PlainTextEdit::handleMatchesFound()
+{
+    updateHighlights();
+    if (!mFindPending)
+    {
+        return;
+    }
+    //光标后面的块可能还没有查找完，查找结束之前只选中光标之后的匹配，不循环到开头
+    const int                 position = textCursor().selectionStart();
+    const SearchEngine::Match match = mpSearchEngine->nextMatch(position, true);
+    if (match.mLength > 0 && (match.mPosition >= position || !mpSearchEngine->isRunning()))
+    {
+        mFindPending = false;
+        selectRange(match.mPosition, match.mLength);
+    }
+    else if (!mpSearchEngine->isRunning())
+    {
+        mFindPending = false;
+    }
+}
+
 void PlainTextEdit::indentOrUnindent(bool doIndent)
 {
     qDebug().nospace() << __FILE__ << "(" << __LINE__ << ")" << __FUNCTION__ << " -- ";
@@ -989,38 +1180,6 @@ void LineNumberArea::paintEvent(QPaintEvent* event)
     mpEidtor->lineNumberAreaPaintEvent(event);
 }
 
-CompleterItem::CompleterItem(const QString& key, const QString& value, const QString& select)
-    : mKey(key)
-    , mValue(value)
-    , mSelect(select)
-{
-    int ind = value.indexOf(select, 0);
-    if (ind < 0)
-    {
-        mDescription = value;
-    }
-    else
-    {
-        mDescription = QString("<b>%1</b><i>%2</i>%3").arg(value.left(ind), select, value.right(value.size() - select.size() - ind)).replace("\n", "<br/>");
-    }
-}
-
-CompleterItem::CompleterItem(const QString& key, const QString& value, const QString& select, const QString& description)
-    : mKey(key)
-    , mValue(value)
-    , mSelect(select)
-    , mDescription(description)
-{
-}
-
-CompleterItem::CompleterItem(const QString& value, const QString& description)
-    : mKey(value)
-    , mValue(value)
-    , mSelect(value)
-    , mDescription(description)
-{
-}
-
 TextHighlighter::TextHighlighter(QPlainTextEdit* pPlainTextEdit)
     : QSyntaxHighlighter(pPlainTextEdit->document())
 {
@@ -1030,50 +1189,49 @@ TextHighlighter::TextHighlighter(QPlainTextEdit* pPlainTextEdit)
 
 void TextHighlighter::initializeSettings()
 {
-    QFont font;
-    font.setFamily("Courier New");
-    font.setPointSizeF(13);
-    mpPlainTextEdit->document()->setDefaultFont(font);
-    mpPlainTextEdit->setTabStopDistance((qreal)(4 * QFontMetrics(font).horizontalAdvance(QLatin1Char(' '))));
-    mHighlightingRules.clear();
-
-    HighlightingRule rule;
+    applyEditorFont(mpPlainTextEdit);
 
-    mTextFormat.setForeground(QColor(0, 0, 0));                //文本
-    mKeywordFormat.setForeground(QColor(0, 245, 255));         //关键字
-    mTypeFormat.setForeground(QColor(255, 10, 10));            //类型
-    mSingleLineCommentFormat.setForeground(QColor(0, 150, 0)); //单行注释
-    mMultiLineCommentFormat.setForeground(QColor(0, 150, 0));  //多行注释
+    mTokenFormats = tokenFormats();
+    mTextFormat = mTokenFormats.at(TextTokenizer::Identifier);
+    mKeywordFormat = mTokenFormats.at(TextTokenizer::Keyword);
+    mTypeFormat = mTokenFormats.at(TextTokenizer::Type);
+    mNumberFormat = mTokenFormats.at(TextTokenizer::Number);
+    mQuotationFormat = mTokenFormats.at(TextTokenizer::Quotation);
+    mSingleLineCommentFormat = mTokenFormats.at(TextTokenizer::SingleLineComment);
+    mMultiLineCommentFormat = mTokenFormats.at(TextTokenizer::MultiLineComment);
     mFunctionFormat.setForeground(QColor(0, 0, 255));
-    mQuotationFormat.setForeground(QColor(0, 139, 0));
-    mNumberFormat.setForeground(QColor(123, 104, 238)); //数字
-
-    //为每个文本项设置 正则匹配
-    rule.mPattern = QRegExp("[0-9][0-9]*([.][0-9]*)?([eE][+-]?[0-9]*)?");
-    rule.mFormat = mNumberFormat;
-    mHighlightingRules.append(rule);
+}
 
-    rule.mPattern = QRegExp("\\b[A-Za-z_][A-Za-z0-9_]*");
-    rule.mFormat = mTextFormat;
-    mHighlightingRules.append(rule);
+void TextHighlighter::applyEditorFont(QPlainTextEdit* pPlainTextEdit)
+{
+    QFont font;
+    font.setFamily("Courier New");
+    font.setPointSizeF(13);
+    pPlainTextEdit->document()->setDefaultFont(font);
+    pPlainTextEdit->setTabStopDistance((qreal)(4 * QFontMetrics(font).horizontalAdvance(QLatin1Char(' '))));
+}
 
-    QStringList keywordPatterns = PlainTextEdit::getKeywords();
-    foreach (const QString& pattern, keywordPatterns)
+const QVector<QTextCharFormat>& TextHighlighter::tokenFormats()
+{
+    static QVector<QTextCharFormat> formats;
+    if (formats.isEmpty())
     {
-        QString newPattern = QString("\\b%1\\b").arg(pattern);
-        rule.mPattern = QRegExp(newPattern);
-        rule.mFormat = mKeywordFormat;
-        mHighlightingRules.append(rule);
+        formats.resize(TextTokenizer::MultiLineComment + 1);
+        formats[TextTokenizer::Identifier].setForeground(QColor(0, 0, 0));          //文本
+        formats[TextTokenizer::Keyword].setForeground(QColor(0, 245, 255));         //关键字
+        formats[TextTokenizer::Type].setForeground(QColor(255, 10, 10));            //类型
+        formats[TextTokenizer::Number].setForeground(QColor(123, 104, 238));        //数字
+        formats[TextTokenizer::Quotation].setForeground(QColor(0, 139, 0));         //字符串
+        formats[TextTokenizer::SingleLineComment].setForeground(QColor(0, 150, 0)); //单行注释
+        formats[TextTokenizer::MultiLineComment].setForeground(QColor(0, 150, 0));  //多行注释
     }
+    return formats;
+}
 
-    QStringList typePatterns = PlainTextEdit::getTypes();
-    foreach (const QString& pattern, typePatterns)
-    {
-        QString newPattern = QString("\\b%1\\b").arg(pattern);
-        rule.mPattern = QRegExp(newPattern);
-        rule.mFormat = mTypeFormat;
-        mHighlightingRules.append(rule);
-    }
+const TextTokenizer* TextHighlighter::tokenizer()
+{
+    static const TextTokenizer textTokenizer(PlainTextEdit::getKeywords(), PlainTextEdit::getTypes());
+    return &textTokenizer;
 }
 
 void TextHighlighter::highlightBlock(const QString& text)
@@ -1087,25 +1245,21 @@ void TextHighlighter::highlightBlock(const QString& text)
     }
     setFormat(0, text.length(), QColor(0, 0, 0));
 
-    foreach (const HighlightingRule& rule, mHighlightingRules)
+    //一遍扫描得到 关键字/类型/数字/字符串/注释，替代原来每条正则规则各扫描一遍
+    int endState = tokenizer()->tokenize(text, previousBlockState(), &mTokens);
+    foreach (const TextTokenizer::Token& token, mTokens)
     {
-        QRegExp expression(rule.mPattern);
-        int     index = expression.indexIn(text);
-        while (index >= 0)
+        if (token.type != TextTokenizer::Identifier)
         {
-            int length = expression.matchedLength();
-            setFormat(index, length, rule.mFormat);
-            index = expression.indexIn(text, index + length);
+            setFormat(token.start, token.length, mTokenFormats.at(token.type));
         }
     }
-    highlightMultiLine(text);
+    highlightMultiLine(text, mTokens);
+    setCurrentBlockState(endState);
 }
 
-void TextHighlighter::highlightMultiLine(const QString& text)
+void TextHighlighter::highlightMultiLine(const QString& text, const TextTokenizer::Tokens& tokens)
 {
-
-    int                index = 0, startIndex = 0;
-    int                blockState = previousBlockState();
     bool               foldingState = false;
     QTextBlock         previousTextBlck = currentBlock().previous();
     TextBlockUserData* pPreviousTextBlockUserData = BaseEditorDocumentLayout::userData(previousTextBlck);
@@ -1113,71 +1267,62 @@ void TextHighlighter::highlightMultiLine(const QString& text)
     {
         foldingState = pPreviousTextBlockUserData->foldingState();
     }
-    QRegExp annotationRegExp("\\bannotation\\b");
-    int     annotationIndex = annotationRegExp.indexIn(text);
+    BlockAnalysis analysis;
+    analyzeBlock(text, tokens, foldingState, &analysis);
+    applyBlockAnalysis(currentBlock(), analysis);
+    // set text block user data
+    setCurrentBlockUserData(BaseEditorDocumentLayout::userData(currentBlock()));
+}
 
-    // store parentheses info
-    Parentheses        parentheses;
-    TextBlockUserData* pTextBlockUserData = BaseEditorDocumentLayout::userData(currentBlock());
-    if (pTextBlockUserData)
+void TextHighlighter::analyzeBlock(const QString& text, const TextTokenizer::Tokens& tokens, bool foldingState, BlockAnalysis* pAnalysis)
+{
+    int annotationIndex = -1;
+    foreach (const TextTokenizer::Token& token, tokens)
     {
-        pTextBlockUserData->clearParentheses();
-        pTextBlockUserData->setFoldingIndent(0);
-        pTextBlockUserData->setFoldingEndIncluded(false);
+        if (token.type == TextTokenizer::Keyword && text.midRef(token.start, token.length) == QLatin1String("annotation"))
+        {
+            annotationIndex = token.start;
+            break;
+        }
     }
-    while (index < text.length())
+
+    // 文档里的标识符，给自动补全用
+    QStringList& identifiers = pAnalysis->mIdentifiers;
+    identifiers.clear();
+    foreach (const TextTokenizer::Token& token, tokens)
     {
-        switch (blockState)
+        if (token.type == TextTokenizer::Identifier && token.length > 1)
         {
-        /* if the block already has single line comment then don't check for multi line comment and quotes. */
-        case 1:
-            if (text[index] == '/' && index + 1 < text.length() && text[index + 1] == '/')
+            const QString identifier = text.mid(token.start, token.length);
+            if (!identifiers.contains(identifier))
             {
-                index++;
-                blockState = 1; /* don't change the blockstate. */
-            }
-            break;
-        case 2:
-            if (text[index] == '*' && index + 1 < text.length() && text[index + 1] == '/')
-            {
-                index++;
-                setFormat(startIndex, index - startIndex + 1, mMultiLineCommentFormat);
-                blockState = 0;
-            }
-            break;
-        case 3:
-            if (text[index] == '\\')
-            {
-                index++;
-            }
-            else if (text[index] == '"')
-            {
-                setFormat(startIndex, index - startIndex + 1, mQuotationFormat);
-                blockState = 0;
-            }
-            break;
-        default:
-            /* check if single line comment then set the blockstate to 1. */
-            if (text[index] == '/' && index + 1 < text.length() && text[index + 1] == '/')
-            {
-                startIndex = index++;
-                setFormat(startIndex, text.length(), mSingleLineCommentFormat);
-                blockState = 1;
-            }
-            else if (text[index] == '/' && index + 1 < text.length() && text[index + 1] == '*')
-            {
-                startIndex = index++;
-                blockState = 2;
-            }
-            else if (text[index] == '"')
-            {
-                startIndex = index;
-                blockState = 3;
+                identifiers.append(identifier);
             }
         }
+    }
+
+    // store parentheses info
+    Parentheses& parentheses = pAnalysis->mParentheses;
+    parentheses.clear();
+    pAnalysis->mFoldingIndent = 0;
+    pAnalysis->mFoldingEndIncluded = false;
+    int tokenIndex = 0; // 当前(或下一个)注释、字符串
+    int startIndex = 0; // 最近一个注释、字符串的起始位置
+    for (int index = 0; index < text.length(); ++index)
+    {
+        while (tokenIndex < tokens.size() && (!tokens[tokenIndex].isCommentOrQuotation() || tokens[tokenIndex].end() <= index))
+        {
+            ++tokenIndex;
+        }
+        // no single line comment, no multi line comment and no quotes
+        bool code = true;
+        if (tokenIndex < tokens.size() && tokens[tokenIndex].start <= index)
+        {
+            code = false;
+            startIndex = tokens[tokenIndex].start;
+        }
 
-        // if no single line comment, no multi line comment and no quotes then store the parentheses
-        if (pTextBlockUserData && (blockState < 1 || blockState > 3))
+        if (code)
         {
             if (text[index] == '(' || text[index] == '{' || text[index] == '[')
             {
@@ -1188,106 +1333,110 @@ void TextHighlighter::highlightMultiLine(const QString& text)
                 parentheses.append(Parenthesis(Parenthesis::Closed, text[index], index));
             }
         }
-        if (pTextBlockUserData && foldingState)
+        if (foldingState)
         {
             // if no single line comment, no multi line comment and no quotes then check for annotation end
-            if (blockState < 1 || blockState > 3)
+            if (code)
             {
                 if (text[index] == ';')
                 {
-                    if (pTextBlockUserData)
+                    QString endText = text.mid(index + 1);
+                    /* if we have some text after closing the annotation then we don't want to fold it.
+                     * ticket:4310 But if the ending text is just white space then fold it.
+                     */
+                    if (index == text.length() - 1 || PlainTextEdit::firstNonSpace(endText) == endText.length())
                     {
-                        QString endText = text.mid(index + 1);
-                        /* if we have some text after closing the annotation then we don't want to fold it.
-                         * ticket:4310 But if the ending text is just white space then fold it.
-                         */
-                        if (index == text.length() - 1 || PlainTextEdit::firstNonSpace(endText) == endText.length())
-                        {
-                            if (annotationIndex < 0)
-                            { // if we have one line annotation, we don't want to fold it.
-                                pTextBlockUserData->setFoldingIndent(1);
-                            }
-                            pTextBlockUserData->setFoldingEndIncluded(true);
-                        }
-                        else
-                        {
-                            pTextBlockUserData->setFoldingIndent(0);
+                        if (annotationIndex < 0)
+                        { // if we have one line annotation, we don't want to fold it.
+                            pAnalysis->mFoldingIndent = 1;
                         }
+                        pAnalysis->mFoldingEndIncluded = true;
+                    }
+                    else
+                    {
+                        pAnalysis->mFoldingIndent = 0;
                     }
                     foldingState = false;
                 }
-                else if (pTextBlockUserData && annotationIndex < 0)
+                else if (annotationIndex < 0)
                 { // if we have one line annotation, we don't want to fold it.
-                    pTextBlockUserData->setFoldingIndent(1);
+                    pAnalysis->mFoldingIndent = 1;
                 }
             }
-            else if (pTextBlockUserData && annotationIndex < 0)
+            else if (annotationIndex < 0)
             { // if we have one line annotation, we don't want to fold it.
-                pTextBlockUserData->setFoldingIndent(1);
+                pAnalysis->mFoldingIndent = 1;
             }
-            else if (pTextBlockUserData && startIndex < annotationIndex)
+            else if (startIndex < annotationIndex)
             { // if we have annotation word before quote or comment block is starting then fold.
-                pTextBlockUserData->setFoldingIndent(1);
+                pAnalysis->mFoldingIndent = 1;
             }
         }
-        else
+        else if (code && text.midRef(index, 10) == QLatin1String("annotation"))
         {
             // if no single line comment, no multi line comment and no quotes then check for annotation start
-            if (blockState < 1 || blockState > 3)
-            {
-                if (text[index] == 'a' && index + 9 < text.length() && text[index + 1] == 'n' && text[index + 2] == 'n' && text[index + 3] == 'o'
-                    && text[index + 4] == 't' && text[index + 5] == 'a' && text[index + 6] == 't' && text[index + 7] == 'i' && text[index + 8] == 'o'
-                    && text[index + 9] == 'n')
-                {
-                    if (index + 9 == text.length() - 1)
-                    { // if we just have annotation keyword in the line
-                        index = index + 8;
-                        foldingState = true;
-                    }
-                    else if (index + 10 < text.length() && (text[index + 10] == '(' || text[index + 10] == ' '))
-                    { // if annotation keyword is followed by '(' or space.
-                        index = index + 9;
-                        foldingState = true;
-                    }
-                }
+            if (index + 9 == text.length() - 1)
+            { // if we just have annotation keyword in the line
+                index = index + 8;
+                foldingState = true;
+            }
+            else if (index + 10 < text.length() && (text[index + 10] == '(' || text[index + 10] == ' '))
+            { // if annotation keyword is followed by '(' or space.
+                index = index + 9;
+                foldingState = true;
             }
         }
-        index++;
     }
-    if (pTextBlockUserData)
+    pAnalysis->mFoldingState = foldingState;
+    // Hanldle empty blocks inside annotaiton section
+    if (text.isEmpty() && foldingState)
     {
-        pTextBlockUserData->setParentheses(parentheses);
-        if (foldingState)
-        {
-            pTextBlockUserData->setFoldingState(true);
-            // Hanldle empty blocks inside annotaiton section
-            if (text.isEmpty() && foldingState)
-            {
-                pTextBlockUserData->setFoldingIndent(1);
-            }
-        }
-        // set text block user data
-        setCurrentBlockUserData(pTextBlockUserData);
+        pAnalysis->mFoldingIndent = 1;
+    }
+}
+
+void TextHighlighter::applyBlockAnalysis(const QTextBlock& block, const BlockAnalysis& analysis)
+{
+    TextBlockUserData* pTextBlockUserData = BaseEditorDocumentLayout::userData(block);
+    if (!pTextBlockUserData)
+    {
+        return;
     }
-    switch (blockState)
+    BaseEditorDocumentLayout* pLayout = qobject_cast<BaseEditorDocumentLayout*>(block.document()->documentLayout());
+    if (pLayout && pTextBlockUserData->foldingIndent() != analysis.mFoldingIndent)
     {
-    case 2:
-        setFormat(startIndex, text.length() - startIndex, mMultiLineCommentFormat);
-        setCurrentBlockState(2);
-        break;
-    case 3:
-        setFormat(startIndex, text.length() - startIndex, mQuotationFormat);
-        setCurrentBlockState(3);
-        break;
+        //折叠区域由 foldingIndent 生成，缩进变化后重建
+        pLayout->foldingIndex()->invalidateRegions();
+    }
+    pTextBlockUserData->setParentheses(analysis.mParentheses);
+    pTextBlockUserData->setFoldingIndent(analysis.mFoldingIndent);
+    pTextBlockUserData->setFoldingEndIncluded(analysis.mFoldingEndIncluded);
+    pTextBlockUserData->setFoldingState(analysis.mFoldingState);
+    if (pLayout)
+    {
+        pLayout->parenthesisIndex()->updateBlock(block);
+        pTextBlockUserData->setIdentifiers(analysis.mIdentifiers, pLayout->completionEngine());
     }
 }
 
 BaseEditorDocumentLayout::BaseEditorDocumentLayout(QTextDocument* document)
     : QPlainTextDocumentLayout(document)
     , mHasBreakpoint(false)
+    , mpFoldingIndex(new FoldingIndex(document, this))
+    , mpParenthesisIndex(new ParenthesisIndex(document, this))
+    , mpCompletionEngine(new CompletionEngine(this))
 {
 }
 
+ParenthesisIndex* BaseEditorDocumentLayout::parenthesisIndex(const QTextBlock& block)
+{
+    if (BaseEditorDocumentLayout* pLayout = qobject_cast<BaseEditorDocumentLayout*>(block.document()->documentLayout()))
+    {
+        return pLayout->parenthesisIndex();
+    }
+    return nullptr;
+}
+
 Parentheses BaseEditorDocumentLayout::parentheses(const QTextBlock& block)
 {
     if (TextBlockUserData* userData = testUserData(block))
@@ -1413,24 +1562,66 @@ DocumentMarker::DocumentMarker(QTextDocument* doc, int lineStartNumber)
     : ITextMarkable(doc)
     , mpTextDocument(doc)
     , mLineStartNumber(lineStartNumber)
+    , mBlockCount(doc->blockCount())
 {
+    connect(mpTextDocument, SIGNAL(contentsChange(int, int, int)), this, SLOT(handleContentsChange(int, int, int)));
+}
+
+int DocumentMarker::blockNumberForLine(int line) const
+{
+    return mLineStartNumber > 0 ? line - mLineStartNumber : line - 1;
+}
+
+int DocumentMarker::lineForBlockNumber(int blockNumber) const
+{
+    return mLineStartNumber > 0 ? blockNumber + mLineStartNumber : blockNumber + 1;
+}
+
+void DocumentMarker::indexMark(ITextMark* mark, int blockNumber)
+{
+    mMarkBlocks.insert(mark, blockNumber);
+    mBlockMarks[blockNumber].append(mark);
+}
+
+void DocumentMarker::unindexMark(ITextMark* mark)
+{
+    QHash<ITextMark*, int>::iterator it = mMarkBlocks.find(mark);
+    if (it == mMarkBlocks.end())
+    {
+        return;
+    }
+    QMap<int, TextMarks>::iterator blockIt = mBlockMarks.find(it.value());
+    if (blockIt != mBlockMarks.end())
+    {
+        blockIt.value().removeAll(mark);
+        if (blockIt.value().isEmpty())
+        {
+            mBlockMarks.erase(blockIt);
+        }
+    }
+    mMarkBlocks.erase(it);
 }
 
 bool DocumentMarker::addMark(ITextMark* mark, int line)
 {
     if (line >= 1)
     {
-        int                       blockNumber = line - 1;
         BaseEditorDocumentLayout* docLayout = qobject_cast<BaseEditorDocumentLayout*>(mpTextDocument->documentLayout());
         if (!docLayout)
         {
             return false;
         }
-        QTextBlock block = mpTextDocument->findBlockByNumber(mLineStartNumber > 0 ? line - mLineStartNumber : blockNumber);
+        const int  blockNumber = blockNumberForLine(line);
+        QTextBlock block = mpTextDocument->findBlockByNumber(blockNumber);
         if (block.isValid())
         {
+            if (hasMark(mark))
+            {
+                removeMark(mark);
+            }
             TextBlockUserData* userData = BaseEditorDocumentLayout::userData(block);
             userData->addMark(mark);
+            indexMark(mark, blockNumber);
             mark->updateLineNumber(line);
             mark->updateBlock(block);
             docLayout->mHasBreakpoint = true;
@@ -1445,31 +1636,25 @@ TextMarks DocumentMarker::marksAt(int line) const
 {
     if (line >= 1)
     {
-        int        blockNumber = line - 1;
-        QTextBlock block = mpTextDocument->findBlockByNumber(blockNumber);
-        if (block.isValid())
-        {
-            if (TextBlockUserData* userData = BaseEditorDocumentLayout::testUserData(block))
-            {
-                return userData->marks();
-            }
-        }
+        return mBlockMarks.value(blockNumberForLine(line));
     }
     return TextMarks();
 }
 
 void DocumentMarker::removeMark(ITextMark* mark)
 {
+    QHash<ITextMark*, int>::const_iterator it = mMarkBlocks.constFind(mark);
+    if (it == mMarkBlocks.constEnd())
+    {
+        return;
+    }
     bool       needUpdate = false;
-    QTextBlock block = mpTextDocument->begin();
-    while (block.isValid())
+    QTextBlock block = mpTextDocument->findBlockByNumber(it.value());
+    if (TextBlockUserData* data = BaseEditorDocumentLayout::testUserData(block))
     {
-        if (TextBlockUserData* data = static_cast<TextBlockUserData*>(block.userData()))
-        {
-            needUpdate |= data->removeMark(mark);
-        }
-        block = block.next();
+        needUpdate = data->removeMark(mark);
     }
+    unindexMark(mark);
     if (needUpdate)
     {
         updateMark(0);
@@ -1478,19 +1663,7 @@ void DocumentMarker::removeMark(ITextMark* mark)
 
 bool DocumentMarker::hasMark(ITextMark* mark) const
 {
-    QTextBlock block = mpTextDocument->begin();
-    while (block.isValid())
-    {
-        if (TextBlockUserData* data = static_cast<TextBlockUserData*>(block.userData()))
-        {
-            if (data->hasMark(mark))
-            {
-                return true;
-            }
-        }
-        block = block.next();
-    }
-    return false;
+    return mMarkBlocks.contains(mark);
 }
 
 void DocumentMarker::updateMark(ITextMark* mark)
@@ -1505,19 +1678,84 @@ void DocumentMarker::updateMark(ITextMark* mark)
 
 void DocumentMarker::updateBreakpointsLineNumber()
 {
-    QTextBlock block = mpTextDocument->begin();
-    int        blockNumber = 0;
-    while (block.isValid())
+    for (QMap<int, TextMarks>::const_iterator it = mBlockMarks.constBegin(); it != mBlockMarks.constEnd(); ++it)
+    {
+        foreach (ITextMark* mrk, it.value())
+        {
+            mrk->updateLineNumber(lineForBlockNumber(it.key()));
+        }
+    }
+}
+
+void DocumentMarker::handleContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved);
+    const int blockCount = mpTextDocument->blockCount();
+    const int delta = blockCount - mBlockCount;
+    mBlockCount = blockCount;
+    if (mBlockMarks.isEmpty())
+    {
+        return;
+    }
+    const int firstBlock = mpTextDocument->findBlock(position).blockNumber();
+    const int endPosition = qMin(position + charsAdded, mpTextDocument->characterCount() - 1);
+    const int addedBlocks = mpTextDocument->findBlock(endPosition).blockNumber() - firstBlock;
+    const int removedBlocks = addedBlocks - delta;
+    // 块内编辑（输入字符等）既没有删除块也没有改变块号，标记不需要任何处理
+    if (delta == 0 && removedBlocks == 0)
     {
-        if (const TextBlockUserData* userData = BaseEditorDocumentLayout::testUserData(block))
+        return;
+    }
+    const int lastEditedBlock = firstBlock + removedBlocks;
+
+    // 编辑范围内的块：被删除的块的 TextBlockUserData 已经析构，只保留仍然留在原来块上的标记
+    if (removedBlocks > 0)
+    {
+        QMap<int, TextMarks>::iterator it = mBlockMarks.lowerBound(firstBlock);
+        while (it != mBlockMarks.end() && it.key() <= lastEditedBlock)
         {
-            foreach (ITextMark* mrk, userData->marks())
+            TextBlockUserData* userData = BaseEditorDocumentLayout::testUserData(mpTextDocument->findBlockByNumber(it.key()));
+            TextMarks&         marks = it.value();
+            for (int i = marks.size() - 1; i >= 0; --i)
+            {
+                if (!userData || !userData->hasMark(marks.at(i)))
+                {
+                    mMarkBlocks.remove(marks.at(i));
+                    marks.removeAt(i);
+                }
+            }
+            if (marks.isEmpty())
+            {
+                it = mBlockMarks.erase(it);
+            }
+            else
             {
-                mrk->updateLineNumber(mLineStartNumber > 0 ? blockNumber + mLineStartNumber : blockNumber + 1);
+                ++it;
             }
         }
-        block = block.next();
-        ++blockNumber;
+    }
+
+    // 编辑范围之后的块整体平移，块数不变时块号也不变
+    if (delta == 0)
+    {
+        return;
+    }
+    QMap<int, TextMarks>::iterator it = mBlockMarks.upperBound(lastEditedBlock);
+    QList<QPair<int, TextMarks>> movedMarks;
+    while (it != mBlockMarks.end())
+    {
+        movedMarks.append(qMakePair(it.key() + delta, it.value()));
+        it = mBlockMarks.erase(it);
+    }
+    for (int i = 0; i < movedMarks.size(); ++i)
+    {
+        const int newBlockNumber = movedMarks.at(i).first;
+        foreach (ITextMark* mark, movedMarks.at(i).second)
+        {
+            mMarkBlocks.insert(mark, newBlockNumber);
+            mark->updateLineNumber(lineForBlockNumber(newBlockNumber));
+        }
+        mBlockMarks[newBlockNumber].append(movedMarks.at(i).second);
     }
 }
 
@@ -1538,6 +1776,29 @@ TextBlockUserData::~TextBlockUserData()
     {
         mk->removeFromEditor();
     }
+    if (mpCompletionEngine)
+    {
+        mpCompletionEngine->removeIdentifiers(mIdentifiers);
+    }
+}
+
+void TextBlockUserData::setIdentifiers(const QStringList& identifiers, CompletionEngine* pCompletionEngine)
+{
+    if (identifiers == mIdentifiers && mpCompletionEngine == pCompletionEngine)
+    {
+        return;
+    }
+    // 先加新的再减旧的，本行没变的标识符引用计数不会归零，补全索引里只有增删的那几个有变化
+    if (pCompletionEngine)
+    {
+        pCompletionEngine->addIdentifiers(identifiers);
+    }
+    if (mpCompletionEngine)
+    {
+        mpCompletionEngine->removeIdentifiers(mIdentifiers);
+    }
+    mIdentifiers = identifiers;
+    mpCompletionEngine = pCompletionEngine;
 }
 
 /**
@@ -1545,8 +1806,9 @@ TextBlockUserData::~TextBlockUserData()
  */
 TextBlockUserData::MatchType TextBlockUserData::checkOpenParenthesis(QTextCursor* cursor, QChar c)
 {
-    QTextBlock block = cursor->block();
-    if (!BaseEditorDocumentLayout::hasParentheses(block))
+    QTextBlock        block = cursor->block();
+    ParenthesisIndex* pParenthesisIndex = BaseEditorDocumentLayout::parenthesisIndex(block);
+    if (!BaseEditorDocumentLayout::hasParentheses(block) || !pParenthesisIndex)
     {
         return NoMatch;
     }
@@ -1577,19 +1839,13 @@ TextBlockUserData::MatchType TextBlockUserData::checkOpenParenthesis(QTextCursor
             }
         }
 
-        if (i >= parentheses.count())
+        while (i >= parentheses.count())
         {
-            for (;;)
-            {
-                closedParenthesisBlock = closedParenthesisBlock.next();
-                if (!closedParenthesisBlock.isValid())
-                    return NoMatch;
-                if (BaseEditorDocumentLayout::hasParentheses(closedParenthesisBlock))
-                {
-                    parentheses = BaseEditorDocumentLayout::parentheses(closedParenthesisBlock);
-                    break;
-                }
-            }
+            // 本行没有配对，用括号索引直接跳到配对所在的块
+            closedParenthesisBlock = pParenthesisIndex->findClosedBlock(closedParenthesisBlock, ignore + 1, &ignore);
+            if (!closedParenthesisBlock.isValid())
+                return NoMatch;
+            parentheses = BaseEditorDocumentLayout::parentheses(closedParenthesisBlock);
             i = 0;
         }
 
@@ -1632,8 +1888,9 @@ TextBlockUserData::MatchType TextBlockUserData::checkOpenParenthesis(QTextCursor
  */
 TextBlockUserData::MatchType TextBlockUserData::checkClosedParenthesis(QTextCursor* cursor, QChar c)
 {
-    QTextBlock block = cursor->block();
-    if (!BaseEditorDocumentLayout::hasParentheses(block))
+    QTextBlock        block = cursor->block();
+    ParenthesisIndex* pParenthesisIndex = BaseEditorDocumentLayout::parenthesisIndex(block);
+    if (!BaseEditorDocumentLayout::hasParentheses(block) || !pParenthesisIndex)
     {
         return NoMatch;
     }
@@ -1664,20 +1921,13 @@ TextBlockUserData::MatchType TextBlockUserData::checkClosedParenthesis(QTextCurs
             }
         }
 
-        if (i < 0)
+        while (i < 0)
         {
-            for (;;)
-            {
-                openParenthesisBlock = openParenthesisBlock.previous();
-                if (!openParenthesisBlock.isValid())
-                    return NoMatch;
-
-                if (BaseEditorDocumentLayout::hasParentheses(openParenthesisBlock))
-                {
-                    parentheses = BaseEditorDocumentLayout::parentheses(openParenthesisBlock);
-                    break;
-                }
-            }
+            // 本行没有配对，用括号索引直接跳到配对所在的块
+            openParenthesisBlock = pParenthesisIndex->findOpenedBlock(openParenthesisBlock, ignore + 1, &ignore);
+            if (!openParenthesisBlock.isValid())
+                return NoMatch;
+            parentheses = BaseEditorDocumentLayout::parentheses(openParenthesisBlock);
             i = parentheses.count() - 1;
         }
 
@@ -1780,7 +2030,10 @@ BreakpointMarker::BreakpointMarker(const QString& fileName, int lineNumber)
 
 QIcon BreakpointMarker::icon() const
 {
-    return isEnabled() ? QIcon(":/Resources/icons/breakpoint_enabled.svg") : QIcon(":/Resources/icons/breakpoint_disabled.svg");
+    //只加载一次，cacheKey 不变，行号区域可以按 cacheKey 缓存图片
+    static const QIcon enabledIcon(":/Resources/icons/breakpoint_enabled.svg");
+    static const QIcon disabledIcon(":/Resources/icons/breakpoint_disabled.svg");
+    return isEnabled() ? enabledIcon : disabledIcon;
 }
 
 void BreakpointMarker::updateLineNumber(int lineNumber)
@@ -3,9 +3,16 @@
 #include <QCompleter>
 #include <QFileInfo>
 #include <QPlainTextEdit>
-#include <QStandardItemModel>
+#include <QPointer>
 #include <QSyntaxHighlighter>
+#include "CompletionEngine.h"
+#include "TextTokenizer.h"
 class LineNumberArea;
+class GutterRenderer;
+class FoldingIndex;
+class ParenthesisIndex;
+class SearchEngine;
+class FrameTimeProbe;
 class TextBlockUserData;
 class DocumentMarker;
 class BreakpointMarker;
@@ -14,6 +21,7 @@ class PlainTextEdit : public QPlainTextEdit
     Q_OBJECT
 public:
     PlainTextEdit(QWidget* parent = nullptr);
+    ~PlainTextEdit();
 
     void setCompletionCharacters(QString chars)
     {
@@ -28,6 +36,10 @@ public:
     {
         return mpDocumentMarker;
     }
+    SearchEngine* searchEngine() const
+    {
+        return mpSearchEngine;
+    }
     int             lineNumberAreaWidth();
     void            lineNumberAreaPaintEvent(QPaintEvent* event);
     void            lineNumberAreaMouseEvent(QMouseEvent* event);
@@ -47,12 +59,19 @@ public:
     static int         foldBoxWidth(const QFontMetrics& fm);
 
 private:
-    void    initCompleteModel();
-    QString wordUnderCursor();
-    void    indentOrUnindent(bool doIndent);
-    void    toggleBreakpoint(const QString fileName, int lineNumber);
-    void    toggleBlockVisible(const QTextBlock& block);
-    void    moveCursorVisible(bool ensureVisible);
+    void          initCompleteModel();
+    QString       wordUnderCursor();
+    void          indentOrUnindent(bool doIndent);
+    void          toggleBreakpoint(const QString fileName, int lineNumber);
+    void          toggleBlockVisible(const QTextBlock& block);
+    void          updateFoldingLayout();
+    FoldingIndex* foldingIndex() const;
+    void          moveCursorVisible(bool ensureVisible);
+    void          selectRange(int position, int length);
+    QRectF        currentLineRect() const;
+    void          updateCurrentLine();
+    void          paintFoldPlaceholders(QPaintEvent* event);
+    QString       foldPlaceholderText(const QTextBlock& block, const QTextBlock& endBlock);
 
 protected:
     virtual void resizeEvent(QResizeEvent* pEvent) override;
@@ -72,6 +91,22 @@ public slots:
     void resetZoom();
     void zoomIn();
     void zoomOut();
+    /**
+     * @brief: 折叠层级大于 level 的区域，展开其余区域，只刷新一次布局
+     */
+    void foldToLevel(int level);
+    void foldAll();
+    void unfoldAll();
+    /**
+     * @brief: 后台查找，结果边查找边高亮显示，options 为 SearchEngine::Options
+     */
+    void setSearchText(const QString& text, int options = 0);
+    bool findNext();
+    bool findPrevious();
+    /**
+     * @brief: 替换 text 的所有匹配，可以一次撤销，返回替换的个数；text 成为新的查找文本，替换之后只查找一次
+     */
+    int replaceAll(const QString& text, const QString& replacement, int options = 0);
 private slots:
     /**
      * @brief: 显示自动补全概述窗口
@@ -87,49 +122,47 @@ private slots:
      */
     void updateHighlights();
     void updateCursorPosition();
+    void handleMatchesFound();
+    void clearFoldPlaceholders();
 
     void slotUndoAvailable();
 
 private:
+    /**
+     * @brief: 折叠后显示的 "..." 文本，按折叠块号缓存，区域最后一块修改后重新生成
+     */
+    struct FoldPlaceholder
+    {
+        int     mEndBlockNumber;
+        int     mEndRevision;
+        bool    mEndIncluded;
+        QString mText;
+    };
+
     LineNumberArea*              mpLineNumberArea;
+    GutterRenderer*              mpGutterRenderer;
+    int                          mLineNumberAreaWidth; // 当前设置的左边距
     bool                         mCanHaveBreakpoints;
     QTextCharFormat              mParenthesesMatchFormat;
     QTextCharFormat              mParenthesesMisMatchFormat;
-    QStandardItemModel*          mpStandardItemModel;
+    QTextCharFormat              mSearchMatchFormat;
+    QColor                       mCurrentLineColor;
+    QRectF                       mCurrentLineRect; // 文档坐标，上次绘制当前行背景的位置，光标换行时只重绘新旧两行
+    QHash<int, FoldPlaceholder>  mFoldPlaceholders;
+    QFont                        mFoldPlaceholderFont;
+    qreal                        mFoldPlaceholderWidth; // 折叠框的宽度只和字体有关
+    FrameTimeProbe*              mpFrameTimeProbe;
+    QVector<int>                 mHighlightsKey; // 括号位置、可见的查找结果，没变化时不重新设置 extraSelections
+    SearchEngine*                mpSearchEngine;
+    bool                         mFindPending; // 设置查找文本后，第一个结果到达时选中
+    CompletionModel*             mpCompletionModel;
     QCompleter*                  mpCompleter;
     QString                      mCompletionCharacters;
     DocumentMarker*              mpDocumentMarker;
-    QMap<int, BreakpointMarker*> lineDocMap;
     static int                   mTabSize;
     static int                   mIndentSize;
 };
 
-/**
- * @class : 自动补全节点数据
- */
-class CompleterItem
-{
-public:
-    CompleterItem() {}
-    CompleterItem(const QString& key, const QString& value, const QString& select);
-    CompleterItem(const QString& key, const QString& value, const QString& select, const QString& description);
-    CompleterItem(const QString& value, const QString& description);
-    QString mKey;
-    QString mValue;
-    QString mSelect;
-    QString mDescription;
-    //排序与查找实现自定义比较规则
-    bool operator<(const CompleterItem& other) const
-    {
-        return (mKey < other.mKey) || ((mKey == other.mKey) && (mDescription < other.mDescription));
-    }
-    bool operator==(const CompleterItem& other) const
-    {
-        return mKey == other.mKey && mDescription == other.mDescription;
-    }
-};
-Q_DECLARE_METATYPE(CompleterItem) //通知QMetaType知道这个类型， 使用模板函数需要用到，主要是 QVarint
-
 /**
  *@class : 行号窗口
  */
@@ -154,43 +187,6 @@ private:
     PlainTextEdit* mpEidtor;
 };
 
-/**
- *@class : 语法着色类，必须实现 highlightBlock 函数
- */
-class TextHighlighter : public QSyntaxHighlighter
-{
-    Q_OBJECT
-public:
-    TextHighlighter(QPlainTextEdit* pPlainTextEdit = 0);
-    void initializeSettings();
-
-    /**
-     * @brief: 高亮多行，用来处理单行或者多行注释
-     */
-    void highlightMultiLine(const QString& text);
-
-protected:
-    //自动调用，必须是西安
-    virtual void highlightBlock(const QString& text) override;
-
-private:
-    QPlainTextEdit* mpPlainTextEdit;
-    struct HighlightingRule
-    {
-        QRegExp         mPattern;
-        QTextCharFormat mFormat;
-    };
-    QVector<HighlightingRule> mHighlightingRules;
-    QTextCharFormat           mTextFormat;
-    QTextCharFormat           mKeywordFormat;
-    QTextCharFormat           mTypeFormat;
-    QTextCharFormat           mFunctionFormat;
-    QTextCharFormat           mQuotationFormat;
-    QTextCharFormat           mSingleLineCommentFormat;
-    QTextCharFormat           mMultiLineCommentFormat;
-    QTextCharFormat           mNumberFormat;
-};
-
 struct Parenthesis
 {
     enum Type
@@ -215,6 +211,78 @@ struct Parenthesis
 };
 typedef QVector<Parenthesis> Parentheses;
 
+/**
+ * @brief: 一行文本的括号、折叠信息，只依赖本行文本和上一行的状态，可以在工作线程里计算
+ */
+struct BlockAnalysis
+{
+    inline BlockAnalysis()
+        : mFoldingIndent(0)
+        , mFoldingEndIncluded(false)
+        , mFoldingState(false)
+    {
+    }
+    Parentheses mParentheses;
+    int         mFoldingIndent;
+    bool        mFoldingEndIncluded;
+    bool        mFoldingState; // 本行结束时是否还在 annotation 里
+    QStringList mIdentifiers;  // 本行的标识符(去重)，给自动补全用
+};
+
+/**
+ *@class : 语法着色类，必须实现 highlightBlock 函数
+ */
+class TextHighlighter : public QSyntaxHighlighter
+{
+    Q_OBJECT
+public:
+    TextHighlighter(QPlainTextEdit* pPlainTextEdit = 0);
+    void initializeSettings();
+
+    /**
+     * @brief: 根据词法扫描结果处理注释、字符串之外的括号和 annotation 折叠
+     */
+    void highlightMultiLine(const QString& text, const TextTokenizer::Tokens& tokens);
+
+    /**
+     * @brief: 由 getKeywords()/getTypes() 生成的词法扫描器，所有高亮器共用
+     */
+    static const TextTokenizer* tokenizer();
+    /**
+     * @brief: 设置编辑器的字体(Courier New 13)和 Tab 宽度，着色格式只设置颜色，字体来自这里
+     */
+    static void applyEditorFont(QPlainTextEdit* pPlainTextEdit);
+    /**
+     * @brief: 按 TextTokenizer::TokenType 排列的着色格式
+     */
+    static const QVector<QTextCharFormat>& tokenFormats();
+    /**
+     * @brief: 计算一行的括号和折叠信息，foldingState 为上一行结束时的 annotation 状态
+     */
+    static void analyzeBlock(const QString& text, const TextTokenizer::Tokens& tokens, bool foldingState, BlockAnalysis* pAnalysis);
+    /**
+     * @brief: 把 analyzeBlock 的结果写入文本块的 TextBlockUserData，只能在 GUI 线程调用
+     */
+    static void applyBlockAnalysis(const QTextBlock& block, const BlockAnalysis& analysis);
+
+protected:
+    //自动调用，必须是西安
+    virtual void highlightBlock(const QString& text) override;
+
+private:
+    QPlainTextEdit*          mpPlainTextEdit;
+    TextTokenizer::Tokens    mTokens;
+    QVector<QTextCharFormat> mTokenFormats; // TokenType -> 格式
+    QTextCharFormat          mTextFormat;
+    QTextCharFormat          mKeywordFormat;
+    QTextCharFormat          mTypeFormat;
+    QTextCharFormat          mFunctionFormat;
+    QTextCharFormat          mQuotationFormat;
+    QTextCharFormat          mSingleLineCommentFormat;
+    QTextCharFormat          mMultiLineCommentFormat;
+    QTextCharFormat          mNumberFormat;
+};
+
 class BaseEditorDocumentLayout : public QPlainTextDocumentLayout
 {
     Q_OBJECT
@@ -234,7 +302,25 @@ public:
     {
         emit documentSizeChanged(documentSize());
     }
-    bool mHasBreakpoint;
+    FoldingIndex* foldingIndex() const
+    {
+        return mpFoldingIndex;
+    }
+    ParenthesisIndex* parenthesisIndex() const
+    {
+        return mpParenthesisIndex;
+    }
+    CompletionEngine* completionEngine() const
+    {
+        return mpCompletionEngine;
+    }
+    static ParenthesisIndex* parenthesisIndex(const QTextBlock& block);
+    bool                     mHasBreakpoint;
+
+private:
+    FoldingIndex*     mpFoldingIndex;
+    ParenthesisIndex* mpParenthesisIndex;
+    CompletionEngine* mpCompletionEngine;
 };
 
 class ITextMark : public QObject
@@ -370,9 +456,23 @@ public:
     void updateBreakpointsLineNumber();
     void updateBreakpointsBlock(const QTextBlock& block);
 
+private slots:
+    /**
+     * @brief: 跟随文档的插入、删除修正标记所在的块号
+     */
+    void handleContentsChange(int position, int charsRemoved, int charsAdded);
+
 private:
-    QTextDocument* mpTextDocument;
-    int            mLineStartNumber;
+    int  blockNumberForLine(int line) const;
+    int  lineForBlockNumber(int blockNumber) const;
+    void indexMark(ITextMark* mark, int blockNumber);
+    void unindexMark(ITextMark* mark);
+
+    QTextDocument*         mpTextDocument;
+    int                    mLineStartNumber;
+    int                    mBlockCount;
+    QHash<ITextMark*, int> mMarkBlocks; // 标记 -> 块号
+    QMap<int, TextMarks>   mBlockMarks; // 块号 -> 标记，有序
 };
 
 class TextBlockUserData : public QTextBlockUserData
@@ -387,6 +487,9 @@ public:
         , mFoldingEnd(false)
         , mFoldingStartIndex(-1)
         , mLeadingSpaces(-1)
+        , mHighlightRevision(-1)
+        , mHighlightStartState(0)
+        , mHighlightEndState(0)
     {
     }
     ~TextBlockUserData();
@@ -519,17 +622,50 @@ public:
         return mLeadingSpaces;
     }
 
+    // 后台高亮记录：高亮时文本块的 revision、开始状态和结束状态，revision 为 -1 表示还没有高亮
+    inline void setHighlightState(int revision, int startState, int endState)
+    {
+        mHighlightRevision = revision;
+        mHighlightStartState = startState;
+        mHighlightEndState = endState;
+    }
+    inline int highlightRevision() const
+    {
+        return mHighlightRevision;
+    }
+    inline int highlightStartState() const
+    {
+        return mHighlightStartState;
+    }
+    inline int highlightEndState() const
+    {
+        return mHighlightEndState;
+    }
+    /**
+     * @brief: 记录本行的标识符，同步更新补全索引；块删除时在析构里移除
+     */
+    void               setIdentifiers(const QStringList& identifiers, CompletionEngine* pCompletionEngine);
+    inline QStringList identifiers() const
+    {
+        return mIdentifiers;
+    }
+
 private:
-    TextMarks   _marks;
-    Parentheses mParentheses;
-    int         mFoldingIndent;
-    bool        mFolded;
-    bool        mFoldingEndIncluded;
-    bool        mFoldingState;
-    bool        mFoldingEndState;
-    bool        mFoldingEnd;
-    int         mFoldingStartIndex;
-    int         mLeadingSpaces;
+    TextMarks                  _marks;
+    Parentheses                mParentheses;
+    int                        mFoldingIndent;
+    bool                       mFolded;
+    bool                       mFoldingEndIncluded;
+    bool                       mFoldingState;
+    bool                       mFoldingEndState;
+    bool                       mFoldingEnd;
+    int                        mFoldingStartIndex;
+    int                        mLeadingSpaces;
+    int                        mHighlightRevision;
+    int                        mHighlightStartState;
+    int                        mHighlightEndState;
+    QStringList                mIdentifiers;
+    QPointer<CompletionEngine> mpCompletionEngine;
 };
 
 #endif // EDITOR_H
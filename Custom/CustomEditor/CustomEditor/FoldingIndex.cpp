@@ -0,0 +1,277 @@
+﻿#include "FoldingIndex.h"
+#include "Editor.h"
+#include <QTextDocument>
+#include <QTextLayout>
+#include <algorithm>
+
+FoldingIndex::FoldingIndex(QTextDocument* pTextDocument, QObject* parent)
+    : QObject(parent)
+    , mpTextDocument(pTextDocument)
+    , mBlockCount(pTextDocument->blockCount())
+    , mRegionsValid(false)
+    , mHiddenValid(false)
+{
+    connect(mpTextDocument, SIGNAL(contentsChange(int, int, int)), this, SLOT(handleContentsChange(int, int, int)));
+}
+
+const QVector<FoldingIndex::Region>& FoldingIndex::regions()
+{
+    if (!mRegionsValid)
+    {
+        rebuild();
+    }
+    return mRegions;
+}
+
+/**
+ * @brief: 一遍扫描生成折叠区域和隐藏区间
+ *         每个块先作为候选区域入栈，遇到缩进不大于它的块时出栈并确定结尾，没有内容的候选区域最后去掉
+ */
+void FoldingIndex::rebuild()
+{
+    mRegions.clear();
+    mHiddenRanges.clear();
+    QVector<QPair<int, int>> stack; // mRegions 下标, foldingIndent
+    int                      number = 0;
+    for (QTextBlock block = mpTextDocument->begin(); block.isValid(); block = block.next(), ++number)
+    {
+        TextBlockUserData* pTextBlockUserData = BaseEditorDocumentLayout::testUserData(block);
+        const int          indent = pTextBlockUserData ? pTextBlockUserData->foldingIndent() : 0;
+        while (!stack.isEmpty() && indent <= stack.last().second)
+        {
+            mRegions[stack.last().first].mEnd = number - 1;
+            stack.removeLast();
+        }
+        Region region;
+        region.mStart = number;
+        region.mEnd = number;
+        region.mLevel = stack.size() + 1;
+        region.mFolded = pTextBlockUserData && pTextBlockUserData->folded();
+        stack.append(qMakePair(mRegions.size(), indent));
+        mRegions.append(region);
+
+        if (!block.isVisible())
+        {
+            if (!mHiddenRanges.isEmpty() && mHiddenRanges.last().second == number - 1)
+            {
+                mHiddenRanges.last().second = number;
+            }
+            else
+            {
+                mHiddenRanges.append(Range(number, number));
+            }
+        }
+    }
+    foreach (const auto& item, stack)
+    {
+        mRegions[item.first].mEnd = number - 1;
+    }
+    int count = 0;
+    for (int i = 0; i < mRegions.size(); ++i)
+    {
+        if (mRegions[i].mEnd > mRegions[i].mStart)
+        {
+            mRegions[count++] = mRegions[i];
+        }
+    }
+    mRegions.resize(count);
+    mBlockCount = number;
+    mRegionsValid = true;
+    mHiddenValid = true;
+}
+
+int FoldingIndex::findRegion(int startBlockNumber) const
+{
+    auto it = std::lower_bound(mRegions.constBegin(), mRegions.constEnd(), startBlockNumber, [](const Region& region, int number) { return region.mStart < number; });
+    if (it != mRegions.constEnd() && it->mStart == startBlockNumber)
+    {
+        return int(it - mRegions.constBegin());
+    }
+    return -1;
+}
+
+int FoldingIndex::findRange(const QVector<Range>& ranges, int blockNumber)
+{
+    auto it = std::upper_bound(ranges.constBegin(), ranges.constEnd(), blockNumber, [](int number, const Range& range) { return number < range.first; });
+    if (it == ranges.constBegin())
+    {
+        return -1;
+    }
+    --it;
+    return blockNumber <= it->second ? int(it - ranges.constBegin()) : -1;
+}
+
+QTextBlock FoldingIndex::nextVisibleBlock(const QTextBlock& block)
+{
+    QTextBlock next = block.next();
+    if (!next.isValid() || next.isVisible())
+    {
+        return next;
+    }
+    if (!mHiddenValid)
+    {
+        rebuild();
+    }
+    const int index = findRange(mHiddenRanges, next.blockNumber());
+    if (index >= 0)
+    {
+        next = mpTextDocument->findBlockByNumber(mHiddenRanges.at(index).second + 1);
+    }
+    // 别处直接修改了块的可见性，逐块查找，下次使用前重建
+    while (next.isValid() && !next.isVisible())
+    {
+        mHiddenValid = false;
+        next = next.next();
+    }
+    return next;
+}
+
+void FoldingIndex::setRegionFolded(int index, bool folded)
+{
+    Region& region = mRegions[index];
+    if (region.mFolded != folded)
+    {
+        region.mFolded = folded;
+        BaseEditorDocumentLayout::setFolded(mpTextDocument->findBlockByNumber(region.mStart), folded);
+    }
+}
+
+bool FoldingIndex::toggleFold(const QTextBlock& block)
+{
+    regions();
+    const int index = findRegion(block.blockNumber());
+    if (index >= 0)
+    {
+        setRegionFolded(index, !mRegions.at(index).mFolded);
+    }
+    else
+    {
+        // 缩进变化后已经不是折叠区域，只把之前隐藏的块显示出来
+        BaseEditorDocumentLayout::setFolded(block, false);
+    }
+    return applyHiddenRanges(computeHiddenRanges());
+}
+
+bool FoldingIndex::foldToLevel(int level)
+{
+    regions();
+    for (int i = 0; i < mRegions.size(); ++i)
+    {
+        setRegionFolded(i, mRegions.at(i).mLevel > level);
+    }
+    return applyHiddenRanges(computeHiddenRanges());
+}
+
+bool FoldingIndex::unfoldAll()
+{
+    regions();
+    for (int i = 0; i < mRegions.size(); ++i)
+    {
+        setRegionFolded(i, false);
+    }
+    return applyHiddenRanges(computeHiddenRanges());
+}
+
+/**
+ * @brief: 由折叠标志计算隐藏区间，嵌套在已折叠区域里的区域不用再处理
+ *         文档最后一个块不隐藏，和 BaseEditorDocumentLayout::foldOrUnfold 一致
+ */
+QVector<FoldingIndex::Range> FoldingIndex::computeHiddenRanges() const
+{
+    QVector<Range> ranges;
+    const int      lastHideable = mBlockCount - 2;
+    foreach (const Region& region, mRegions)
+    {
+        if (!region.mFolded || (!ranges.isEmpty() && region.mStart <= ranges.last().second))
+        {
+            continue;
+        }
+        const int first = region.mStart + 1;
+        const int last = qMin(region.mEnd, lastHideable);
+        if (first <= last)
+        {
+            ranges.append(Range(first, last));
+        }
+    }
+    return ranges;
+}
+
+/**
+ * @brief: 新旧隐藏区间按端点分段比较，只修改可见性变化的块
+ */
+bool FoldingIndex::applyHiddenRanges(const QVector<Range>& ranges)
+{
+    if (!mHiddenValid)
+    {
+        rebuild();
+    }
+    QVector<int> points;
+    points.reserve(2 * (ranges.size() + mHiddenRanges.size()));
+    foreach (const Range& range, ranges + mHiddenRanges)
+    {
+        points.append(range.first);
+        points.append(range.second + 1);
+    }
+    std::sort(points.begin(), points.end());
+    points.erase(std::unique(points.begin(), points.end()), points.end());
+
+    bool changed = false;
+    for (int i = 0; i + 1 < points.size(); ++i)
+    {
+        const bool hidden = findRange(ranges, points[i]) >= 0;
+        if (hidden != (findRange(mHiddenRanges, points[i]) >= 0))
+        {
+            setBlocksVisible(points[i], points[i + 1] - 1, !hidden);
+            changed = true;
+        }
+    }
+    mHiddenRanges = ranges;
+    return changed;
+}
+
+void FoldingIndex::setBlocksVisible(int first, int last, bool visible)
+{
+    QTextBlock block = mpTextDocument->findBlockByNumber(first);
+    for (int number = first; number <= last && block.isValid(); ++number, block = block.next())
+    {
+        block.setVisible(visible);
+        block.setLineCount(visible ? qMax(1, block.layout()->lineCount()) : 0);
+    }
+}
+
+/**
+ * @brief: 编辑范围之后的隐藏区间按块数变化平移，和编辑范围重叠时下次使用前重建
+ */
+void FoldingIndex::handleContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved);
+    const int blockCount = mpTextDocument->blockCount();
+    const int delta = blockCount - mBlockCount;
+    mBlockCount = blockCount;
+    if (delta != 0)
+    {
+        mRegionsValid = false;
+    }
+    if (!mHiddenValid || mHiddenRanges.isEmpty())
+    {
+        return;
+    }
+    const int firstBlock = mpTextDocument->findBlock(position).blockNumber();
+    const int endPosition = qMin(position + charsAdded, mpTextDocument->characterCount() - 1);
+    const int oldLastBlock = mpTextDocument->findBlock(endPosition).blockNumber() - delta;
+    for (int i = 0; i < mHiddenRanges.size(); ++i)
+    {
+        Range& range = mHiddenRanges[i];
+        if (range.second < firstBlock)
+        {
+            continue;
+        }
+        if (range.first <= oldLastBlock)
+        {
+            mHiddenValid = false;
+            return;
+        }
+        range.first += delta;
+        range.second += delta;
+    }
+}
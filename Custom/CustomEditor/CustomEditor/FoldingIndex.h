@@ -0,0 +1,72 @@
+﻿#ifndef FOLDINGINDEX_H
+#define FOLDINGINDEX_H
+
+#include <QObject>
+#include <QPair>
+#include <QTextBlock>
+#include <QVector>
+
+/**
+ * @class : 折叠区域索引
+ *          按块号保存所有折叠区域(按起始块排序)和当前隐藏的块区间，
+ *          查找下一个可见块、折叠/展开某个区域都是二分查找，只修改可见性变化的块。
+ *          区域由高亮记录的 foldingIndent 生成，foldingIndent 变化或者块数变化时标记失效，下次使用时一遍扫描重建。
+ */
+class FoldingIndex : public QObject
+{
+    Q_OBJECT
+public:
+    struct Region
+    {
+        int  mStart;  // 显示折叠按钮的块
+        int  mEnd;    // 区域最后一个块
+        int  mLevel;  // 嵌套层级，最外层为 1
+        bool mFolded;
+    };
+
+    FoldingIndex(QTextDocument* pTextDocument, QObject* parent = nullptr);
+
+    inline void invalidateRegions()
+    {
+        mRegionsValid = false;
+    }
+    const QVector<Region>& regions();
+
+    /**
+     * @brief: 跳过折叠隐藏的块，返回 block 之后的第一个可见块
+     */
+    QTextBlock nextVisibleBlock(const QTextBlock& block);
+
+    /**
+     * @brief: 以下操作返回是否有块的可见性发生变化，调用者据此统一刷新一次布局
+     */
+    bool toggleFold(const QTextBlock& block);
+    /**
+     * @brief: 折叠层级大于 level 的区域，展开其余区域；level 为 0 时全部折叠
+     */
+    bool foldToLevel(int level);
+    bool unfoldAll();
+
+private slots:
+    void handleContentsChange(int position, int charsRemoved, int charsAdded);
+
+private:
+    typedef QPair<int, int> Range; // 隐藏的块号区间 [first, second]
+
+    void           rebuild();
+    int            findRegion(int startBlockNumber) const;
+    void           setRegionFolded(int index, bool folded);
+    QVector<Range> computeHiddenRanges() const;
+    bool           applyHiddenRanges(const QVector<Range>& ranges);
+    void           setBlocksVisible(int first, int last, bool visible);
+    static int     findRange(const QVector<Range>& ranges, int blockNumber);
+
+    QTextDocument*  mpTextDocument;
+    int             mBlockCount;
+    bool            mRegionsValid;
+    bool            mHiddenValid;
+    QVector<Region> mRegions;
+    QVector<Range>  mHiddenRanges;
+};
+
+#endif // FOLDINGINDEX_H
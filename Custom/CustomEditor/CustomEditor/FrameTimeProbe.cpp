@@ -0,0 +1,88 @@
+﻿#include "FrameTimeProbe.h"
+#include <QDebug>
+
+FrameTimeProbe::FrameTimeProbe(const QString& name)
+    : mName(name)
+    , mEnabled(false)
+    , mFrameStart(0)
+    , mInputTime(-1)
+{
+    reset();
+    setEnabled(qEnvironmentVariableIsSet("CUSTOMEDITOR_FRAME_PROBE"));
+}
+
+void FrameTimeProbe::setEnabled(bool enabled)
+{
+    mEnabled = enabled;
+    if (mEnabled && !mClock.isValid())
+    {
+        mClock.start();
+    }
+    reset();
+}
+
+void FrameTimeProbe::markInput()
+{
+    if (mEnabled && mInputTime < 0)
+    {
+        mInputTime = mClock.nsecsElapsed();
+    }
+}
+
+void FrameTimeProbe::beginFrame()
+{
+    if (mEnabled)
+    {
+        mFrameStart = mClock.nsecsElapsed();
+    }
+}
+
+void FrameTimeProbe::endFrame()
+{
+    if (!mEnabled)
+    {
+        return;
+    }
+    const qint64 now = mClock.nsecsElapsed();
+    const qint64 frame = now - mFrameStart;
+    ++mFrames;
+    mFrameTotal += frame;
+    mFrameMax = qMax(mFrameMax, frame);
+    if (mInputTime >= 0)
+    {
+        const qint64 latency = now - mInputTime;
+        ++mInputs;
+        mLatencyTotal += latency;
+        mLatencyMax = qMax(mLatencyMax, latency);
+        mInputTime = -1;
+    }
+    if (mFrames >= sReportInterval)
+    {
+        const Statistics s = statistics();
+        qDebug().nospace() << __FILE__ << "(" << __LINE__ << "):" << mName << " frames " << s.mFrames << " avg " << s.mAverageFrameMs << "ms max "
+                           << s.mMaxFrameMs << "ms, input latency avg " << s.mAverageLatencyMs << "ms max " << s.mMaxLatencyMs << "ms";
+        reset();
+    }
+}
+
+FrameTimeProbe::Statistics FrameTimeProbe::statistics() const
+{
+    Statistics s;
+    s.mFrames = mFrames;
+    s.mAverageFrameMs = mFrames > 0 ? mFrameTotal / 1e6 / mFrames : 0.0;
+    s.mMaxFrameMs = mFrameMax / 1e6;
+    s.mInputs = mInputs;
+    s.mAverageLatencyMs = mInputs > 0 ? mLatencyTotal / 1e6 / mInputs : 0.0;
+    s.mMaxLatencyMs = mLatencyMax / 1e6;
+    return s;
+}
+
+void FrameTimeProbe::reset()
+{
+    mFrames = 0;
+    mFrameTotal = 0;
+    mFrameMax = 0;
+    mInputs = 0;
+    mLatencyTotal = 0;
+    mLatencyMax = 0;
+}
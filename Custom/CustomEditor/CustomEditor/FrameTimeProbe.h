@@ -0,0 +1,59 @@
+﻿#ifndef FRAMETIMEPROBE_H
+#define FRAMETIMEPROBE_H
+
+#include <QElapsedTimer>
+#include <QString>
+
+/**
+ * @class : 帧时间探针
+ *          记录每次 paintEvent 的耗时，以及 输入事件 到 下一帧绘制完成 的延迟，每 sReportInterval 帧输出一次统计。
+ *          设置环境变量 CUSTOMEDITOR_FRAME_PROBE 时默认启用，没有启用时每帧只有一次判断的开销
+ */
+class FrameTimeProbe
+{
+public:
+    struct Statistics
+    {
+        int    mFrames;
+        double mAverageFrameMs;
+        double mMaxFrameMs;
+        int    mInputs;        // 统计到延迟的输入事件个数
+        double mAverageLatencyMs;
+        double mMaxLatencyMs;
+    };
+
+    FrameTimeProbe(const QString& name);
+
+    inline bool isEnabled() const
+    {
+        return mEnabled;
+    }
+    void setEnabled(bool enabled);
+
+    /**
+     * @brief: 收到按键等输入事件时调用，同一帧之前的多次输入按第一次计算延迟
+     */
+    void markInput();
+    void beginFrame();
+    void endFrame();
+
+    Statistics statistics() const;
+    void       reset();
+
+    static const int sReportInterval = 120;
+
+private:
+    QString       mName;
+    bool          mEnabled;
+    QElapsedTimer mClock;
+    qint64        mFrameStart;
+    qint64        mInputTime; // -1 表示没有等待绘制的输入
+    int           mFrames;
+    qint64        mFrameTotal; // 纳秒
+    qint64        mFrameMax;
+    int           mInputs;
+    qint64        mLatencyTotal;
+    qint64        mLatencyMax;
+};
+
+#endif // FRAMETIMEPROBE_H
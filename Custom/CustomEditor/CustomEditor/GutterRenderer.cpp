@@ -0,0 +1,184 @@
+﻿#include "GutterRenderer.h"
+#include <QStyle>
+#include <QStyleOptionViewItem>
+
+GutterRenderer::GutterRenderer()
+    : mValid(false)
+    , mDevicePixelRatio(1)
+    , mDigitWidth(0)
+    , mDigitHeight(0)
+    , mLineSpacing(0)
+    , mFoldBoxWidth(0)
+{
+}
+
+void GutterRenderer::ensureCache(const QFont& font, qreal devicePixelRatio, QWidget* pWidget)
+{
+    if (mValid && font == mFont && qFuzzyCompare(devicePixelRatio, mDevicePixelRatio))
+    {
+        return;
+    }
+    mValid = true;
+    mFont = font;
+    mDevicePixelRatio = devicePixelRatio;
+    mIconPixmaps.clear();
+
+    const QFontMetrics fm(font);
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 11, 0))
+    mDigitWidth = fm.horizontalAdvance(QLatin1Char('9'));
+#else  // QT_VERSION_CHECK
+    mDigitWidth = fm.width(QLatin1Char('9'));
+#endif // QT_VERSION_CHECK
+    mDigitHeight = fm.height();
+    mLineSpacing = fm.lineSpacing();
+    mFoldBoxWidth = PlainTextEdit::foldBoxWidth(fm);
+
+    // 数字图集
+    mDigitAtlas = QPixmap(QSize(10 * mDigitWidth, 2 * mDigitHeight) * devicePixelRatio);
+    mDigitAtlas.setDevicePixelRatio(devicePixelRatio);
+    mDigitAtlas.fill(Qt::transparent);
+    {
+        QPainter painter(&mDigitAtlas);
+        painter.setFont(font);
+        for (int row = 0; row < 2; ++row)
+        {
+            painter.setPen(row == 0 ? QColor(Qt::gray) : QColor(64, 64, 64));
+            for (int digit = 0; digit < 10; ++digit)
+            {
+                painter.drawText(QRect(digit * mDigitWidth, row * mDigitHeight, mDigitWidth, mDigitHeight), Qt::AlignRight, QString::number(digit));
+            }
+        }
+    }
+
+    // 折叠按钮
+    const int size = mFoldBoxWidth / 4;
+    const int boxSize = 2 * size + 1;
+    for (int expanded = 0; expanded < 2; ++expanded)
+    {
+        QPixmap pixmap(QSize(boxSize, boxSize) * devicePixelRatio);
+        pixmap.setDevicePixelRatio(devicePixelRatio);
+        pixmap.fill(Qt::transparent);
+        QPainter             painter(&pixmap);
+        QStyle*              pStyle = pWidget->style();
+        QStyleOptionViewItem styleOptionViewItem;
+        styleOptionViewItem.rect = QRect(0, 0, boxSize, boxSize);
+        styleOptionViewItem.state = QStyle::State_Active | QStyle::State_Item | QStyle::State_Children;
+        /* For some reason QStyle::PE_IndicatorBranch is not showing up in MAC.
+         * So I use QStyle::PE_IndicatorArrowDown and QStyle::PE_IndicatorArrowRight
+         * Perhaps this is fixed in newer Qt versions. We will see when we use Qt 5 for MAC.
+         */
+#ifndef Q_OS_MAC
+        if (expanded)
+        {
+            styleOptionViewItem.state |= QStyle::State_Open;
+        }
+        pStyle->drawPrimitive(QStyle::PE_IndicatorBranch, &styleOptionViewItem, &painter, pWidget);
+#else
+        styleOptionViewItem.rect.translate(-1, 0);
+        if (expanded)
+        {
+            pStyle->drawPrimitive(QStyle::PE_IndicatorArrowDown, &styleOptionViewItem, &painter, pWidget);
+        }
+        else
+        {
+            pStyle->drawPrimitive(QStyle::PE_IndicatorArrowRight, &styleOptionViewItem, &painter, pWidget);
+        }
+#endif
+        mFoldingPixmaps[expanded] = pixmap;
+    }
+}
+
+const QPixmap& GutterRenderer::iconPixmap(const QIcon& icon)
+{
+    QHash<qint64, QPixmap>::iterator it = mIconPixmaps.find(icon.cacheKey());
+    if (it == mIconPixmaps.end())
+    {
+        QPixmap pixmap = icon.pixmap(QSize(mLineSpacing, mLineSpacing) * mDevicePixelRatio);
+        pixmap.setDevicePixelRatio(mDevicePixelRatio);
+        it = mIconPixmaps.insert(icon.cacheKey(), pixmap);
+    }
+    return it.value();
+}
+
+void GutterRenderer::appendFragment(QVector<QPainter::PixmapFragment>* pFragments, const QRectF& target, const QRectF& source)
+{
+    pFragments->append(QPainter::PixmapFragment::create(target.center(), source, target.width() / source.width(), target.height() / source.height()));
+}
+
+void GutterRenderer::paint(QPainter* pPainter, const QVector<Row>& rows, int lineNumbersWidth)
+{
+    const qreal dpr = mDevicePixelRatio;
+
+    /* paint breakpoints */
+    QHash<qint64, QVector<QPainter::PixmapFragment>> iconFragments;
+    foreach (const Row& row, rows)
+    {
+        int xoffset = 0;
+        foreach (ITextMark* mk, row.mMarks)
+        {
+            const QIcon    icon = mk->icon();
+            const QPixmap& pixmap = iconPixmap(icon);
+            const QSizeF   size = QSizeF(pixmap.size()) / dpr;
+            // 和 QIcon::paint(Qt::AlignCenter) 一样居中
+            QRectF target(QPointF(xoffset + (mLineSpacing - size.width()) / 2, row.mTop + (mLineSpacing - size.height()) / 2), size);
+            appendFragment(&iconFragments[icon.cacheKey()], target, QRectF(QPointF(0, 0), pixmap.size()));
+            xoffset += 2;
+        }
+    }
+    for (QHash<qint64, QVector<QPainter::PixmapFragment>>::const_iterator it = iconFragments.constBegin(); it != iconFragments.constEnd(); ++it)
+    {
+        pPainter->drawPixmapFragments(it.value().constData(), it.value().size(), mIconPixmaps.value(it.key()));
+    }
+
+    /* paint line numbers */
+    QVector<QPainter::PixmapFragment> digitFragments;
+    foreach (const Row& row, rows)
+    {
+        if (!row.mNumberVisible)
+        {
+            continue;
+        }
+        const int atlasRow = row.mCurrent ? 1 : 0;
+        int       number = row.mBlockNumber + 1;
+        int       x = lineNumbersWidth;
+        do
+        {
+            x -= mDigitWidth;
+            QRectF source(QPointF((number % 10) * mDigitWidth, atlasRow * mDigitHeight) * dpr, QSizeF(mDigitWidth, mDigitHeight) * dpr);
+            appendFragment(&digitFragments, QRectF(x, row.mTop, mDigitWidth, mDigitHeight), source);
+            number /= 10;
+        } while (number > 0);
+    }
+    pPainter->drawPixmapFragments(digitFragments.constData(), digitFragments.size(), mDigitAtlas);
+
+    /* paint folding markers */
+    const int                         size = mFoldBoxWidth / 4;
+    const QRectF                      boxSource(QPointF(0, 0), QSizeF(2 * size + 1, 2 * size + 1) * dpr);
+    QVector<QLineF>                   lines;
+    QVector<QPainter::PixmapFragment> foldingFragments[2];
+    foreach (const Row& row, rows)
+    {
+        QRect foldingMarkerBox(lineNumbersWidth + size, row.mTop + size, 2 * (size) + 1, 2 * (size) + 1);
+        QRect foldingLineBox(lineNumbersWidth + size, row.mTop, 2 * (size) + 1, row.mHeight);
+        if (row.mDrawEnd)
+        {
+            lines.append(QLineF(QPointF(foldingLineBox.center().x(), foldingLineBox.top()), foldingLineBox.center()));
+            lines.append(QLineF(foldingLineBox.center(), QPointF(foldingLineBox.right(), foldingLineBox.center().y())));
+        }
+        if (row.mDrawLine && !row.mDrawEnd)
+        {
+            lines.append(QLineF(QPointF(foldingLineBox.center().x(), foldingLineBox.top()), QPointF(foldingLineBox.center().x(), foldingLineBox.bottom())));
+        }
+        if (row.mDrawFoldingControl)
+        {
+            appendFragment(&foldingFragments[row.mExpanded ? 1 : 0], foldingMarkerBox, boxSource);
+        }
+    }
+    pPainter->setRenderHint(QPainter::Antialiasing, false);
+    pPainter->setPen(Qt::gray);
+    pPainter->drawLines(lines);
+    for (int expanded = 0; expanded < 2; ++expanded)
+    {
+        pPainter->drawPixmapFragments(foldingFragments[expanded].constData(), foldingFragments[expanded].size(), mFoldingPixmaps[expanded]);
+    }
+}
@@ -0,0 +1,72 @@
+﻿#ifndef GUTTERRENDERER_H
+#define GUTTERRENDERER_H
+
+#include "Editor.h"
+#include <QHash>
+#include <QPainter>
+#include <QPixmap>
+
+/**
+ * @class : 行号区域绘制
+ *          数字、折叠按钮、断点图标按 字体(缩放)和设备像素比 缓存成图片，
+ *          可见行先收集成 Row，再按图片分组一次性绘制，不再每行设置字体、save/restore、调用 QStyle
+ */
+class GutterRenderer
+{
+public:
+    struct Row
+    {
+        Row()
+            : mTop(0)
+            , mHeight(0)
+            , mBlockNumber(0)
+            , mCurrent(false)
+            , mNumberVisible(false)
+            , mDrawFoldingControl(false)
+            , mExpanded(false)
+            , mDrawLine(false)
+            , mDrawEnd(false)
+        {
+        }
+        qreal     mTop;
+        qreal     mHeight;
+        int       mBlockNumber;
+        bool      mCurrent;
+        bool      mNumberVisible;
+        bool      mDrawFoldingControl;
+        bool      mExpanded;
+        bool      mDrawLine;
+        bool      mDrawEnd;
+        TextMarks mMarks;
+    };
+
+    GutterRenderer();
+
+    /**
+     * @brief: 字体(缩放)或者设备像素比变化时重建缓存的图片
+     */
+    void ensureCache(const QFont& font, qreal devicePixelRatio, QWidget* pWidget);
+    void paint(QPainter* pPainter, const QVector<Row>& rows, int lineNumbersWidth);
+
+    inline int foldBoxWidth() const
+    {
+        return mFoldBoxWidth;
+    }
+
+private:
+    const QPixmap& iconPixmap(const QIcon& icon);
+    static void    appendFragment(QVector<QPainter::PixmapFragment>* pFragments, const QRectF& target, const QRectF& source);
+
+    bool                   mValid;
+    QFont                  mFont;
+    qreal                  mDevicePixelRatio;
+    int                    mDigitWidth;
+    int                    mDigitHeight;
+    int                    mLineSpacing;
+    int                    mFoldBoxWidth;
+    QPixmap                mDigitAtlas;         // 0-9，第一行普通颜色，第二行当前行颜色
+    QPixmap                mFoldingPixmaps[2];  // 0 折叠，1 展开
+    QHash<qint64, QPixmap> mIconPixmaps;        // QIcon::cacheKey() -> 图片
+};
+
+#endif // GUTTERRENDERER_H
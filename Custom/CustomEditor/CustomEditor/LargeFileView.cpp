@@ -0,0 +1,560 @@
+﻿#include "LargeFileView.h"
+#include "Editor.h"
+#include "GutterRenderer.h"
+#include <QApplication>
+#include <QByteArrayMatcher>
+#include <QDebug>
+#include <QKeyEvent>
+#include <QPainter>
+#include <QScrollBar>
+#include <QTextLayout>
+#include <QtMath>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cstring>
+
+static const int    sCheckpointInterval = 64;                // 每隔多少行记录一个起始偏移
+static const qint64 sIndexChunkSize = 4 * 1024 * 1024;       // 建索引时每扫描这么多字节提交一次
+static const qint64 sSearchChunkSize = 64 * 1024 * 1024;     // 查找时每块的大小
+static const qint64 sMaxLineBytes = 16 * 1024;               // 超长的行只显示前面这部分
+static const int    sTextMargin = 4;
+
+LargeFileView::LargeFileView(QWidget* parent)
+    : QAbstractScrollArea(parent)
+    , mpData(nullptr)
+    , mSize(0)
+    , mMatchOffset(-1)
+    , mMatchLine(-1)
+    , mMaxLineWidth(0)
+{
+    QFont font;
+    font.setFamily("Courier New");
+    font.setPointSizeF(13);
+    setFont(font);
+    viewport()->setAutoFillBackground(false);
+
+    mpGutter = new LargeFileGutter(this);
+    mpGutterRenderer = new GutterRenderer;
+
+    mIndexTimer.setInterval(100);
+    connect(&mIndexTimer, SIGNAL(timeout()), this, SLOT(updateIndexProgress()));
+    connect(&mSearchWatcher, SIGNAL(finished()), this, SLOT(handleSearchFinished()));
+    updateGutterGeometry();
+}
+
+LargeFileView::~LargeFileView()
+{
+    closeFile();
+    delete mpGutterRenderer;
+}
+
+bool LargeFileView::openFile(const QString& fileName)
+{
+    closeFile();
+    mFile.setFileName(fileName);
+    if (!mFile.open(QIODevice::ReadOnly))
+    {
+        qDebug().nospace() << __FILE__ << "(" << __LINE__ << "):" << mFile.errorString();
+        return false;
+    }
+    mSize = mFile.size();
+    mpIndex = QSharedPointer<LineIndex>(new LineIndex);
+    mpIndex->mCheckpoints.append(0);
+    if (mSize > 0)
+    {
+        mpData = reinterpret_cast<const char*>(mFile.map(0, mSize));
+        if (!mpData)
+        {
+            qDebug().nospace() << __FILE__ << "(" << __LINE__ << "):" << mFile.errorString();
+            mFile.close();
+            mSize = 0;
+            return false;
+        }
+        mIndexFuture = QtConcurrent::run(&LargeFileView::buildLineIndex, mpData, mSize, mpIndex);
+        mIndexTimer.start();
+    }
+    else
+    {
+        mpIndex->mFinished = 1;
+    }
+    verticalScrollBar()->setValue(0);
+    horizontalScrollBar()->setValue(0);
+    updateGutterGeometry();
+    updateScrollBars();
+    viewport()->update();
+    return true;
+}
+
+void LargeFileView::closeFile()
+{
+    // 工作线程还在读映射的内存，先让它们退出再取消映射
+    if (mpIndex)
+    {
+        mpIndex->mCancel = 1;
+    }
+    mIndexFuture.waitForFinished();
+    mSearchWatcher.waitForFinished();
+    mIndexTimer.stop();
+    if (mpData)
+    {
+        mFile.unmap(reinterpret_cast<uchar*>(const_cast<char*>(mpData)));
+        mpData = nullptr;
+    }
+    mFile.close();
+    mSize = 0;
+    mpIndex.clear();
+    mMatchOffset = -1;
+    mMatchLine = -1;
+    mMaxLineWidth = 0;
+}
+
+int LargeFileView::lineCount() const
+{
+    if (!mpIndex)
+    {
+        return 0;
+    }
+    QMutexLocker locker(&mpIndex->mMutex);
+    return mpIndex->mLineCount;
+}
+
+/**
+ * @brief: 工作线程里扫描换行符，每 sIndexChunkSize 字节把新的检查点提交给界面线程
+ */
+void LargeFileView::buildLineIndex(const char* pData, qint64 size, QSharedPointer<LineIndex> pIndex)
+{
+    QVector<qint64> checkpoints;
+    qint64          offset = 0;
+    int             lines = 0; // offset 之前的换行符个数
+    while (offset < size && !pIndex->mCancel.loadAcquire())
+    {
+        const qint64 chunkEnd = qMin(size, offset + sIndexChunkSize);
+        while (offset < chunkEnd)
+        {
+            const char* pNewline = static_cast<const char*>(memchr(pData + offset, '\n', size_t(chunkEnd - offset)));
+            if (!pNewline)
+            {
+                offset = chunkEnd;
+                break;
+            }
+            offset = pNewline - pData + 1;
+            if (++lines % sCheckpointInterval == 0)
+            {
+                checkpoints.append(offset);
+            }
+        }
+        QMutexLocker locker(&pIndex->mMutex);
+        pIndex->mCheckpoints += checkpoints;
+        pIndex->mLineCount = lines + 1;
+        pIndex->mIndexedBytes = offset;
+        checkpoints.clear();
+    }
+    pIndex->mFinished = 1;
+}
+
+qint64 LargeFileView::skipLines(const char* pData, qint64 size, qint64 offset, int lines)
+{
+    for (; lines > 0 && offset < size; --lines)
+    {
+        const char* pNewline = static_cast<const char*>(memchr(pData + offset, '\n', size_t(size - offset)));
+        if (!pNewline)
+        {
+            return -1;
+        }
+        offset = pNewline - pData + 1;
+    }
+    return lines > 0 ? -1 : offset;
+}
+
+/**
+ * @brief: 最近的检查点加上最多 63 次 memchr，索引还没有扫描到这一行时返回 -1
+ */
+qint64 LargeFileView::lineOffset(int line) const
+{
+    if (!mpIndex || line < 0)
+    {
+        return -1;
+    }
+    qint64 offset = 0;
+    {
+        QMutexLocker locker(&mpIndex->mMutex);
+        if (line >= mpIndex->mLineCount)
+        {
+            return -1;
+        }
+        const int checkpoint = line / sCheckpointInterval;
+        if (checkpoint >= mpIndex->mCheckpoints.size())
+        {
+            return -1;
+        }
+        offset = mpIndex->mCheckpoints.at(checkpoint);
+    }
+    return skipLines(mpData, mSize, offset, line % sCheckpointInterval);
+}
+
+/**
+ * @brief: 行内容的结束位置(不含换行符)，超长的行截断
+ */
+qint64 LargeFileView::lineEnd(qint64 offset) const
+{
+    const qint64 limit = qMin(mSize, offset + sMaxLineBytes);
+    const char*  pNewline = static_cast<const char*>(memchr(mpData + offset, '\n', size_t(limit - offset)));
+    qint64       end = pNewline ? pNewline - mpData : limit;
+    if (end > offset && mpData[end - 1] == '\r')
+    {
+        --end;
+    }
+    return end;
+}
+
+int LargeFileView::lineHeight() const
+{
+    return QFontMetrics(font()).lineSpacing();
+}
+
+int LargeFileView::gutterWidth() const
+{
+    int digits = 2;
+    int max = qMax(1, lineCount());
+    while (max >= 100)
+    {
+        max /= 10;
+        ++digits;
+    }
+    const QFontMetrics fm(font());
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 11, 0))
+    int space = fm.horizontalAdvance(QLatin1Char('9')) * digits;
+#else  // QT_VERSION_CHECK
+    int space = fm.width(QLatin1Char('9')) * digits;
+#endif // QT_VERSION_CHECK
+    space += 4;
+    space += PlainTextEdit::foldBoxWidth(fm);
+    return space;
+}
+
+void LargeFileView::updateGutterGeometry()
+{
+    const int width = gutterWidth();
+    if (width != mpGutter->width())
+    {
+        setViewportMargins(width, 0, 0, 0);
+    }
+    const QRect cr = contentsRect();
+    mpGutter->setGeometry(QRect(cr.left(), cr.top(), width, cr.height()));
+}
+
+void LargeFileView::updateScrollBars()
+{
+    const int pageLines = qMax(1, viewport()->height() / lineHeight());
+    verticalScrollBar()->setSingleStep(1);
+    verticalScrollBar()->setPageStep(pageLines);
+    verticalScrollBar()->setRange(0, qMax(0, lineCount() - pageLines));
+    horizontalScrollBar()->setSingleStep(QFontMetrics(font()).averageCharWidth());
+    horizontalScrollBar()->setPageStep(viewport()->width());
+    horizontalScrollBar()->setRange(0, qMax(0, mMaxLineWidth + 2 * sTextMargin - viewport()->width()));
+}
+
+void LargeFileView::updateIndexProgress()
+{
+    if (!mpIndex)
+    {
+        mIndexTimer.stop();
+        return;
+    }
+    qint64 indexedBytes = 0;
+    {
+        QMutexLocker locker(&mpIndex->mMutex);
+        indexedBytes = mpIndex->mIndexedBytes;
+    }
+    const int firstLine = verticalScrollBar()->value();
+    const int pageLines = viewport()->height() / lineHeight() + 1;
+    const int oldLineCount = verticalScrollBar()->maximum() + verticalScrollBar()->pageStep();
+    updateGutterGeometry();
+    updateScrollBars();
+    // 只有当前页还没有完全扫描到时才需要重绘
+    if (oldLineCount < firstLine + pageLines)
+    {
+        viewport()->update();
+        mpGutter->update();
+    }
+    if (mpIndex->mFinished.loadAcquire())
+    {
+        mIndexTimer.stop();
+        viewport()->update();
+        mpGutter->update();
+    }
+    emit indexProgressChanged(mSize > 0 ? int(indexedBytes * 100 / mSize) : 100);
+}
+
+/**
+ * @brief: 从可见第一行所在的检查点开始扫描到可见的最后一行，只有可见的行解码、排版、绘制。
+ *         检查点之前的多行注释、字符串状态不保存，从检查点开始按普通状态扫描
+ */
+void LargeFileView::paintEvent(QPaintEvent* event)
+{
+    QPainter painter(viewport());
+    painter.fillRect(event->rect(), Qt::white);
+    if (!mpData)
+    {
+        return;
+    }
+    const int lineCount = this->lineCount();
+    const int height = lineHeight();
+    const int firstLine = verticalScrollBar()->value();
+    const int lastLine = qMin(lineCount, firstLine + viewport()->height() / height + 2);
+    const int startLine = firstLine - firstLine % sCheckpointInterval;
+    qint64    offset = lineOffset(startLine);
+    if (offset < 0)
+    {
+        return;
+    }
+
+    const TextTokenizer*              pTokenizer = TextHighlighter::tokenizer();
+    const QVector<QTextCharFormat>&   formats = TextHighlighter::tokenFormats();
+    TextTokenizer::Tokens             tokens;
+    QVector<QTextLayout::FormatRange> ranges;
+    QTextOption                       textOption;
+    textOption.setWrapMode(QTextOption::NoWrap);
+    int   state = TextTokenizer::Normal;
+    int   maxLineWidth = mMaxLineWidth;
+    qreal y = 0;
+    for (int line = startLine; line < lastLine && offset >= 0 && offset <= mSize; ++line)
+    {
+        const qint64  end = lineEnd(offset);
+        const QString text = QString::fromUtf8(mpData + offset, int(end - offset));
+        state = pTokenizer->tokenize(text, state, &tokens);
+        if (line >= firstLine)
+        {
+            ranges.clear();
+            foreach (const TextTokenizer::Token& token, tokens)
+            {
+                if (token.type == TextTokenizer::Identifier)
+                {
+                    continue;
+                }
+                QTextLayout::FormatRange range;
+                range.start = token.start;
+                range.length = token.length;
+                range.format = formats.at(token.type);
+                ranges.append(range);
+            }
+            if (mMatchOffset >= offset && mMatchOffset < end)
+            {
+                QTextLayout::FormatRange range;
+                range.start = QString::fromUtf8(mpData + offset, int(mMatchOffset - offset)).length();
+                range.length = QString::fromUtf8(mSearchText).length();
+                range.format.setBackground(QColor(255, 255, 0));
+                ranges.append(range);
+            }
+            QTextLayout layout(text, font(), viewport());
+            layout.setTextOption(textOption);
+            layout.setFormats(ranges);
+            layout.beginLayout();
+            QTextLine textLine = layout.createLine();
+            if (textLine.isValid())
+            {
+                textLine.setLineWidth(qreal(1 << 24));
+            }
+            layout.endLayout();
+            layout.draw(&painter, QPointF(sTextMargin - horizontalScrollBar()->value(), y));
+            if (textLine.isValid())
+            {
+                maxLineWidth = qMax(maxLineWidth, qCeil(textLine.naturalTextWidth()));
+            }
+            y += height;
+        }
+        // 最后一行后面没有换行符时 skipLines 返回 -1，结束循环
+        offset = skipLines(mpData, mSize, offset, 1);
+    }
+    if (maxLineWidth != mMaxLineWidth)
+    {
+        mMaxLineWidth = maxLineWidth;
+        updateScrollBars();
+    }
+}
+
+void LargeFileView::gutterPaintEvent(QPaintEvent* event)
+{
+    QPainter painter(mpGutter);
+    painter.fillRect(event->rect(), QColor(240, 240, 240));
+    if (!mpIndex)
+    {
+        return;
+    }
+    mpGutterRenderer->ensureCache(font(), mpGutter->devicePixelRatioF(), mpGutter);
+
+    const int                    height = lineHeight();
+    const int                    firstLine = verticalScrollBar()->value();
+    const int                    lastLine = qMin(lineCount(), firstLine + mpGutter->height() / height + 2);
+    QVector<GutterRenderer::Row> rows;
+    rows.reserve(lastLine - firstLine);
+    for (int line = firstLine; line < lastLine; ++line)
+    {
+        GutterRenderer::Row row;
+        row.mTop = (line - firstLine) * height;
+        row.mHeight = height;
+        row.mBlockNumber = line;
+        row.mCurrent = (line == mMatchLine);
+        row.mNumberVisible = true;
+        rows.append(row);
+    }
+    mpGutterRenderer->paint(&painter, rows, mpGutter->width() - mpGutterRenderer->foldBoxWidth());
+}
+
+void LargeFileView::resizeEvent(QResizeEvent* event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    updateGutterGeometry();
+    updateScrollBars();
+}
+
+void LargeFileView::scrollContentsBy(int dx, int dy)
+{
+    Q_UNUSED(dx);
+    Q_UNUSED(dy);
+    viewport()->update();
+    mpGutter->update();
+}
+
+void LargeFileView::keyPressEvent(QKeyEvent* event)
+{
+    // 查找、查找下一个由 MainWindow 的快捷键处理
+    QScrollBar* pScrollBar = verticalScrollBar();
+    if (event->matches(QKeySequence::MoveToStartOfDocument))
+    {
+        pScrollBar->setValue(0);
+    }
+    else if (event->matches(QKeySequence::MoveToEndOfDocument))
+    {
+        pScrollBar->setValue(pScrollBar->maximum());
+    }
+    else if (event->matches(QKeySequence::MoveToPreviousLine))
+    {
+        pScrollBar->triggerAction(QAbstractSlider::SliderSingleStepSub);
+    }
+    else if (event->matches(QKeySequence::MoveToNextLine))
+    {
+        pScrollBar->triggerAction(QAbstractSlider::SliderSingleStepAdd);
+    }
+    else if (event->matches(QKeySequence::MoveToPreviousPage))
+    {
+        pScrollBar->triggerAction(QAbstractSlider::SliderPageStepSub);
+    }
+    else if (event->matches(QKeySequence::MoveToNextPage))
+    {
+        pScrollBar->triggerAction(QAbstractSlider::SliderPageStepAdd);
+    }
+    else
+    {
+        QAbstractScrollArea::keyPressEvent(event);
+    }
+}
+
+void LargeFileView::gotoLine(int line)
+{
+    const int pageLines = qMax(1, viewport()->height() / lineHeight());
+    verticalScrollBar()->setValue(qMax(0, line - pageLines / 2));
+}
+
+QString LargeFileView::searchText() const
+{
+    return QString::fromUtf8(mSearchText);
+}
+
+void LargeFileView::find(const QString& text)
+{
+    if (text.isEmpty() || !mpData || mSearchWatcher.isRunning())
+    {
+        return;
+    }
+    const QByteArray needle = text.toUtf8();
+    qint64           from = 0;
+    if (needle == mSearchText && mMatchOffset >= 0)
+    {
+        from = mMatchOffset + 1;
+    }
+    else
+    {
+        from = qMax(qint64(0), lineOffset(verticalScrollBar()->value()));
+    }
+    mSearchText = needle;
+    mSearchWatcher.setFuture(QtConcurrent::run(&LargeFileView::searchText, mpData, mSize, mSearchText, from, mpIndex));
+}
+
+void LargeFileView::findNext()
+{
+    find(QString::fromUtf8(mSearchText));
+}
+
+/**
+ * @brief: 从 from 查找到文件末尾再从头查找到 from，按块查找，块之间重叠 text.size() - 1 个字节。
+ *         找到后从最近的检查点数换行符得到行号
+ */
+LargeFileView::SearchResult LargeFileView::searchText(const char* pData, qint64 size, const QByteArray& text, qint64 from, QSharedPointer<LineIndex> pIndex)
+{
+    SearchResult result;
+    result.mOffset = -1;
+    result.mLine = -1;
+    const QByteArrayMatcher matcher(text);
+    const qint64            overlap = text.size() - 1;
+    for (int pass = 0; pass < 2 && result.mOffset < 0; ++pass)
+    {
+        const qint64 begin = pass == 0 ? from : 0;
+        const qint64 end = pass == 0 ? size : qMin(size, from + overlap);
+        for (qint64 chunk = begin; chunk < end && result.mOffset < 0; chunk += sSearchChunkSize)
+        {
+            if (pIndex->mCancel.loadAcquire())
+            {
+                return result;
+            }
+            const qint64 chunkEnd = qMin(end, chunk + sSearchChunkSize + overlap);
+            const int    index = matcher.indexIn(pData + chunk, int(chunkEnd - chunk));
+            if (index >= 0)
+            {
+                result.mOffset = chunk + index;
+            }
+        }
+    }
+    if (result.mOffset < 0)
+    {
+        return result;
+    }
+
+    // 索引可能还没有扫描到这里，从已有的最后一个检查点开始数也是正确的
+    qint64 offset = 0;
+    int    line = 0;
+    {
+        QMutexLocker locker(&pIndex->mMutex);
+        const QVector<qint64>& checkpoints = pIndex->mCheckpoints;
+        const int              checkpoint = int(std::upper_bound(checkpoints.constBegin(), checkpoints.constEnd(), result.mOffset) - checkpoints.constBegin()) - 1;
+        offset = checkpoints.at(checkpoint);
+        line = checkpoint * sCheckpointInterval;
+    }
+    while (offset < result.mOffset)
+    {
+        const char* pNewline = static_cast<const char*>(memchr(pData + offset, '\n', size_t(result.mOffset - offset)));
+        if (!pNewline)
+        {
+            break;
+        }
+        offset = pNewline - pData + 1;
+        ++line;
+    }
+    result.mLine = line;
+    return result;
+}
+
+void LargeFileView::handleSearchFinished()
+{
+    const SearchResult result = mSearchWatcher.result();
+    if (result.mOffset < 0)
+    {
+        QApplication::beep();
+        return;
+    }
+    mMatchOffset = result.mOffset;
+    mMatchLine = result.mLine;
+    gotoLine(mMatchLine);
+    viewport()->update();
+    mpGutter->update();
+}
@@ -0,0 +1,134 @@
+﻿#ifndef LARGEFILEVIEW_H
+#define LARGEFILEVIEW_H
+
+#include <QAbstractScrollArea>
+#include <QAtomicInt>
+#include <QFile>
+#include <QFuture>
+#include <QFutureWatcher>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QTimer>
+#include <QVector>
+
+class GutterRenderer;
+class LargeFileGutter;
+
+/**
+ * @class : 大文件只读查看
+ *          文件用 QFile::map 映射，不复制到 QTextDocument；后台线程建立稀疏的行偏移索引(每 64 行记录一个起始偏移)，
+ *          绘制时只解码、高亮、排版可见的几十行，内存占用和首次显示时间与文件大小无关。
+ *          行号使用 GutterRenderer，语法高亮使用 TextHighlighter 共用的词法扫描器，查找在工作线程里进行。
+ */
+class LargeFileView : public QAbstractScrollArea
+{
+    Q_OBJECT
+public:
+    LargeFileView(QWidget* parent = nullptr);
+    ~LargeFileView();
+
+    bool openFile(const QString& fileName);
+    void closeFile();
+    int  lineCount() const;
+    int  gutterWidth() const;
+    void gutterPaintEvent(QPaintEvent* event);
+    /**
+     * @brief: 最近一次查找的内容，大文件查看没有选区，查找对话框用它预填
+     */
+    QString searchText() const;
+
+    /**
+     * @brief: 小于这个大小的文件直接用 PlainTextEdit 打开
+     */
+    static const qint64 sLargeFileSize = 16 * 1024 * 1024;
+
+public slots:
+    void gotoLine(int line);
+    void find(const QString& text);
+    void findNext();
+
+signals:
+    void indexProgressChanged(int percent);
+
+protected:
+    virtual void paintEvent(QPaintEvent* event) override;
+    virtual void resizeEvent(QResizeEvent* event) override;
+    virtual void keyPressEvent(QKeyEvent* event) override;
+    virtual void scrollContentsBy(int dx, int dy) override;
+
+private slots:
+    void updateIndexProgress();
+    void handleSearchFinished();
+
+private:
+    struct LineIndex
+    {
+        LineIndex()
+            : mLineCount(1)
+            , mIndexedBytes(0)
+            , mCancel(0)
+            , mFinished(0)
+        {
+        }
+        QMutex          mMutex;
+        QVector<qint64> mCheckpoints;  // mCheckpoints[i] 为第 i * sCheckpointInterval 行的起始偏移
+        int             mLineCount;    // 已经扫描到的行数
+        qint64          mIndexedBytes; // 已经扫描的字节数
+        QAtomicInt      mCancel;       // 关闭文件时通知工作线程退出
+        QAtomicInt      mFinished;
+    };
+    struct SearchResult
+    {
+        qint64 mOffset;
+        int    mLine;
+    };
+
+    static void         buildLineIndex(const char* pData, qint64 size, QSharedPointer<LineIndex> pIndex);
+    static SearchResult searchText(const char* pData, qint64 size, const QByteArray& text, qint64 from, QSharedPointer<LineIndex> pIndex);
+    static qint64       skipLines(const char* pData, qint64 size, qint64 offset, int lines);
+
+    qint64 lineOffset(int line) const;
+    qint64 lineEnd(qint64 offset) const;
+    int    lineHeight() const;
+    void   updateScrollBars();
+    void   updateGutterGeometry();
+
+    QFile                        mFile;
+    const char*                  mpData;
+    qint64                       mSize;
+    QSharedPointer<LineIndex>    mpIndex;
+    QFuture<void>                mIndexFuture;
+    QTimer                       mIndexTimer;
+    QFutureWatcher<SearchResult> mSearchWatcher;
+    QByteArray                   mSearchText;
+    qint64                       mMatchOffset; // 当前查找结果的字节偏移，-1 表示没有
+    int                          mMatchLine;
+    int                          mMaxLineWidth; // 已经显示过的最长行，决定水平滚动范围
+    LargeFileGutter*             mpGutter;
+    GutterRenderer*              mpGutterRenderer;
+};
+
+/**
+ * @class : 大文件查看的行号区域，绘制交给 LargeFileView
+ */
+class LargeFileGutter : public QWidget
+{
+    Q_OBJECT
+public:
+    LargeFileGutter(LargeFileView* pView)
+        : QWidget(pView)
+        , mpView(pView)
+    {
+    }
+
+protected:
+    virtual void paintEvent(QPaintEvent* event) override
+    {
+        mpView->gutterPaintEvent(event);
+    }
+
+private:
+    LargeFileView* mpView;
+};
+
+#endif // LARGEFILEVIEW_H
@@ -1,13 +1,26 @@
 ﻿#include "MainWindow.h"
+#include "BackgroundHighlighter.h"
+#include "SearchEngine.h"
 #include <QDebug>
+#include <QFileDialog>
+#include <QFileInfo>
 #include <QGridLayout>
+#include <QInputDialog>
+#include <QStatusBar>
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent)
 {
     mplainTextEdit = new PlainTextEdit(this);
-    new TextHighlighter(mplainTextEdit);
+    //语法高亮放到工作线程，打开大文件时不阻塞界面；同步高亮使用 new TextHighlighter(mplainTextEdit)
+    new BackgroundHighlighter(mplainTextEdit);
+    //大文件只读查看，文件映射到内存，不加载到 QTextDocument
+    mpLargeFileView = new LargeFileView(this);
+    connect(mpLargeFileView, SIGNAL(indexProgressChanged(int)), this, SLOT(handleIndexProgressChanged(int)));
+    mpStackedWidget = new QStackedWidget(this);
+    mpStackedWidget->addWidget(mplainTextEdit);
+    mpStackedWidget->addWidget(mpLargeFileView);
     createActions();
-    setCentralWidget(mplainTextEdit);
+    setCentralWidget(mpStackedWidget);
     resize(1000, 600);
 
 }
@@ -22,6 +35,11 @@ MainWindow* MainWindow::instance()
 
 void MainWindow::createActions()
 {
+    // open file
+    mpOpenAction = new QAction(tr("打开"), this);
+    mpOpenAction->setStatusTip(tr("打开文件"));
+    mpOpenAction->setShortcut(QKeySequence::Open);
+    connect(mpOpenAction, SIGNAL(triggered()), this, SLOT(openFile()));
     mpUndoAction = new QAction(QIcon(":/Resources/icons/undo.svg"), tr("Undo"), this);
     mpUndoAction->setShortcut(QKeySequence::Undo);
     mpUndoAction->setEnabled(false);
@@ -47,14 +65,48 @@ void MainWindow::createActions()
     mpZoomOutAction->setStatusTip(tr("放大"));
     mpZoomOutAction->setShortcut(QKeySequence("Ctrl+-"));
     connect(mpZoomOutAction, SIGNAL(triggered()), mplainTextEdit, SLOT(zoomOut()));
+    // fold all
+    mpFoldAllAction = new QAction(tr("全部折叠"), this);
+    mpFoldAllAction->setStatusTip(tr("全部折叠"));
+    mpFoldAllAction->setShortcut(QKeySequence("Ctrl+Shift+["));
+    connect(mpFoldAllAction, SIGNAL(triggered()), mplainTextEdit, SLOT(foldAll()));
+    // unfold all
+    mpUnfoldAllAction = new QAction(tr("全部展开"), this);
+    mpUnfoldAllAction->setStatusTip(tr("全部展开"));
+    mpUnfoldAllAction->setShortcut(QKeySequence("Ctrl+Shift+]"));
+    connect(mpUnfoldAllAction, SIGNAL(triggered()), mplainTextEdit, SLOT(unfoldAll()));
+    // find
+    mpFindAction = new QAction(tr("查找"), this);
+    mpFindAction->setStatusTip(tr("查找"));
+    mpFindAction->setShortcut(QKeySequence::Find);
+    connect(mpFindAction, SIGNAL(triggered()), this, SLOT(find()));
+    // find next
+    mpFindNextAction = new QAction(tr("查找下一个"), this);
+    mpFindNextAction->setStatusTip(tr("查找下一个"));
+    mpFindNextAction->setShortcut(QKeySequence::FindNext);
+    connect(mpFindNextAction, SIGNAL(triggered()), this, SLOT(findNext()));
+    // replace all
+    mpReplaceAllAction = new QAction(tr("全部替换"), this);
+    mpReplaceAllAction->setStatusTip(tr("全部替换"));
+    mpReplaceAllAction->setShortcut(QKeySequence::Replace);
+    connect(mpReplaceAllAction, SIGNAL(triggered()), this, SLOT(replaceAll()));
 
     mpToolbar = addToolBar(tr("文本编辑"));
+    mpToolbar->addAction(mpOpenAction);
+    mpToolbar->addSeparator();
     mpToolbar->addAction(mpUndoAction);
     mpToolbar->addAction(mpRedoAction);
     mpToolbar->addSeparator();
     mpToolbar->addAction(mpResetZoomAction);
     mpToolbar->addAction(mpZoomInAction);
     mpToolbar->addAction(mpZoomOutAction);
+    mpToolbar->addSeparator();
+    mpToolbar->addAction(mpFoldAllAction);
+    mpToolbar->addAction(mpUnfoldAllAction);
+    mpToolbar->addSeparator();
+    mpToolbar->addAction(mpFindAction);
+    mpToolbar->addAction(mpFindNextAction);
+    mpToolbar->addAction(mpReplaceAllAction);
 
     connect(mplainTextEdit->document(), SIGNAL(redoAvailable(bool)),this, SLOT(handleCanUndoChanged(bool)));
     connect(mplainTextEdit->document(), SIGNAL(undoAvailable(bool)), this, SLOT(handleCanUndoChanged(bool)));
@@ -67,3 +119,113 @@ void MainWindow::handleCanUndoChanged(bool enable)
     mpUndoAction->setEnabled(mplainTextEdit->document()->isUndoAvailable());
     mpRedoAction->setEnabled(mplainTextEdit->document()->isRedoAvailable());
 }
+
+/**
+ * @brief: 超过 LargeFileView::sLargeFileSize 的文件用只读的大文件查看打开，其他的加载到编辑器
+ */
+void MainWindow::openFile()
+{
+    const QString fileName = QFileDialog::getOpenFileName(this, tr("打开文件"));
+    if (fileName.isEmpty())
+    {
+        return;
+    }
+    if (QFileInfo(fileName).size() >= LargeFileView::sLargeFileSize)
+    {
+        if (mpLargeFileView->openFile(fileName))
+        {
+            mpStackedWidget->setCurrentWidget(mpLargeFileView);
+            mpLargeFileView->setFocus();
+        }
+        return;
+    }
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qDebug().nospace() << __FILE__ << "(" << __LINE__ << "):" << file.errorString();
+        return;
+    }
+    mpLargeFileView->closeFile();
+    mplainTextEdit->setPlainText(QString::fromUtf8(file.readAll()));
+    mpStackedWidget->setCurrentWidget(mplainTextEdit);
+    mplainTextEdit->setFocus();
+}
+
+void MainWindow::handleIndexProgressChanged(int percent)
+{
+    if (percent < 100)
+    {
+        statusBar()->showMessage(tr("正在建立行索引 %1%").arg(percent));
+    }
+    else
+    {
+        statusBar()->showMessage(tr("共 %1 行").arg(mpLargeFileView->lineCount()), 3000);
+    }
+}
+
+void MainWindow::find()
+{
+    // 预填当前显示的视图里的内容：编辑器优先用单行选区，其次是上一次的查找内容
+    QString initialText;
+    if (mpStackedWidget->currentWidget() == mpLargeFileView)
+    {
+        initialText = mpLargeFileView->searchText();
+    }
+    else
+    {
+        initialText = mplainTextEdit->textCursor().selectedText();
+        if (initialText.isEmpty() || initialText.contains(QChar::ParagraphSeparator))
+        {
+            initialText = mplainTextEdit->searchEngine()->pattern();
+        }
+    }
+    bool          ok = false;
+    const QString text = QInputDialog::getText(this, tr("查找"), tr("查找内容:"), QLineEdit::Normal, initialText, &ok);
+    if (!ok)
+    {
+        return;
+    }
+    if (mpStackedWidget->currentWidget() == mpLargeFileView)
+    {
+        mpLargeFileView->find(text);
+    }
+    else
+    {
+        mplainTextEdit->setSearchText(text);
+    }
+}
+
+void MainWindow::findNext()
+{
+    if (mpStackedWidget->currentWidget() == mpLargeFileView)
+    {
+        mpLargeFileView->findNext();
+    }
+    else
+    {
+        mplainTextEdit->findNext();
+    }
+}
+
+void MainWindow::replaceAll()
+{
+    if (mpStackedWidget->currentWidget() == mpLargeFileView)
+    {
+        statusBar()->showMessage(tr("大文件只读，不能替换"), 3000);
+        return;
+    }
+    bool          ok = false;
+    const QString text = QInputDialog::getText(this, tr("全部替换"), tr("查找内容:"), QLineEdit::Normal, mplainTextEdit->searchEngine()->pattern(), &ok);
+    if (!ok || text.isEmpty())
+    {
+        return;
+    }
+    const QString replacement = QInputDialog::getText(this, tr("全部替换"), tr("替换为:"), QLineEdit::Normal, QString(), &ok);
+    if (!ok)
+    {
+        return;
+    }
+    // 直接按输入的内容替换，不先启动一次后台查找
+    const int count = mplainTextEdit->replaceAll(text, replacement);
+    statusBar()->showMessage(tr("替换了 %1 处").arg(count), 3000);
+}
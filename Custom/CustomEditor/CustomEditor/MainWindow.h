@@ -2,8 +2,10 @@
 #define WIDGET_H
 
 #include "Editor.h"
+#include "LargeFileView.h"
 #include <QAction>
 #include <QMainWindow>
+#include <QStackedWidget>
 #include <QToolBar>
 class MainWindow : public QMainWindow
 {
@@ -18,17 +20,30 @@ private:
 
 public slots:
     void handleCanUndoChanged(bool enable);
+    void openFile();
+    void handleIndexProgressChanged(int percent);
+    void find();
+    void findNext();
+    void replaceAll();
 protected:
     //    void paintEvent(QPaintEvent* event);
 
 
 private:
-    PlainTextEdit* mplainTextEdit;
-    QToolBar*      mpToolbar;
-    QAction*       mpUndoAction;
-    QAction*       mpRedoAction;
-    QAction*       mpResetZoomAction;
-    QAction*       mpZoomInAction;
-    QAction*       mpZoomOutAction;
+    PlainTextEdit*  mplainTextEdit;
+    LargeFileView*  mpLargeFileView;
+    QStackedWidget* mpStackedWidget;
+    QToolBar*       mpToolbar;
+    QAction*        mpOpenAction;
+    QAction*        mpUndoAction;
+    QAction*        mpRedoAction;
+    QAction*        mpResetZoomAction;
+    QAction*        mpZoomInAction;
+    QAction*        mpZoomOutAction;
+    QAction*        mpFoldAllAction;
+    QAction*        mpUnfoldAllAction;
+    QAction*        mpFindAction;
+    QAction*        mpFindNextAction;
+    QAction*        mpReplaceAllAction;
 };
 #endif // WIDGET_H
@@ -0,0 +1,366 @@
+﻿#include "ParenthesisIndex.h"
+#include "Editor.h"
+#include <QTextDocument>
+
+ParenthesisIndex::ParenthesisIndex(QTextDocument* pTextDocument, QObject* parent)
+    : QObject(parent)
+    , mpTextDocument(pTextDocument)
+    , mValid(false)
+    , mBlockCount(0)
+    , mRoot(-1)
+    , mRandom(2463534242u)
+{
+    connect(mpTextDocument, SIGNAL(contentsChange(int, int, int)), this, SLOT(handleContentsChange(int, int, int)));
+}
+
+ParenthesisIndex::Unmatched ParenthesisIndex::blockValue(const QTextBlock& block)
+{
+    Unmatched value;
+    if (TextBlockUserData* pTextBlockUserData = BaseEditorDocumentLayout::testUserData(block))
+    {
+        foreach (const Parenthesis& parenthesis, pTextBlockUserData->parentheses())
+        {
+            if (parenthesis.type == Parenthesis::Opened)
+            {
+                ++value.mOpened;
+            }
+            else if (value.mOpened > 0)
+            {
+                --value.mOpened;
+            }
+            else
+            {
+                ++value.mClosed;
+            }
+        }
+    }
+    return value;
+}
+
+ParenthesisIndex::Unmatched ParenthesisIndex::combine(const Unmatched& left, const Unmatched& right)
+{
+    Unmatched value;
+    value.mClosed = left.mClosed + qMax(0, right.mClosed - left.mOpened);
+    value.mOpened = right.mOpened + qMax(0, left.mOpened - right.mClosed);
+    return value;
+}
+
+void ParenthesisIndex::ensureValid()
+{
+    if (mValid && mBlockCount == mpTextDocument->blockCount())
+    {
+        return;
+    }
+    mNodes.clear();
+    mFreeNodes.clear();
+    QVector<Unmatched> values;
+    values.reserve(mpTextDocument->blockCount());
+    for (QTextBlock block = mpTextDocument->begin(); block.isValid(); block = block.next())
+    {
+        values.append(blockValue(block));
+    }
+    mBlockCount = values.size();
+    mRoot = build(values);
+    mValid = true;
+}
+
+int ParenthesisIndex::size(int node) const
+{
+    return node < 0 ? 0 : mNodes.at(node).mSize;
+}
+
+int ParenthesisIndex::createNode(const Unmatched& value)
+{
+    int index;
+    if (!mFreeNodes.isEmpty())
+    {
+        index = mFreeNodes.takeLast();
+    }
+    else
+    {
+        index = mNodes.size();
+        mNodes.append(Node());
+    }
+    mRandom ^= mRandom << 13;
+    mRandom ^= mRandom >> 17;
+    mRandom ^= mRandom << 5;
+    Node& node = mNodes[index];
+    node.mLeft = -1;
+    node.mRight = -1;
+    node.mPriority = mRandom;
+    node.mSize = 1;
+    node.mValue = value;
+    node.mTotal = value;
+    return index;
+}
+
+void ParenthesisIndex::freeNodes(int node)
+{
+    if (node < 0)
+    {
+        return;
+    }
+    freeNodes(mNodes.at(node).mLeft);
+    freeNodes(mNodes.at(node).mRight);
+    mFreeNodes.append(node);
+}
+
+/**
+ * @brief: 子节点变化之后重算 node 的子树大小和合并结果
+ */
+void ParenthesisIndex::updateNode(int node)
+{
+    Node&           n = mNodes[node];
+    const Unmatched empty;
+    n.mSize = 1 + size(n.mLeft) + size(n.mRight);
+    n.mTotal = combine(combine(n.mLeft < 0 ? empty : mNodes.at(n.mLeft).mTotal, n.mValue), n.mRight < 0 ? empty : mNodes.at(n.mRight).mTotal);
+}
+
+/**
+ * @brief: 按顺序用 values 建一棵树，返回根，O(n)
+ *         优先级随机，用栈维护最右边的一条链(笛卡尔树的建法)，出栈的节点子树已经确定，出栈时重算
+ */
+int ParenthesisIndex::build(const QVector<Unmatched>& values)
+{
+    QVector<int> stack;
+    foreach (const Unmatched& value, values)
+    {
+        const int node = createNode(value);
+        int       last = -1;
+        while (!stack.isEmpty() && mNodes.at(stack.last()).mPriority < mNodes.at(node).mPriority)
+        {
+            last = stack.takeLast();
+            updateNode(last);
+        }
+        mNodes[node].mLeft = last;
+        if (!stack.isEmpty())
+        {
+            mNodes[stack.last()].mRight = node;
+        }
+        stack.append(node);
+    }
+    while (stack.size() > 1)
+    {
+        updateNode(stack.takeLast());
+    }
+    if (stack.isEmpty())
+    {
+        return -1;
+    }
+    updateNode(stack.first());
+    return stack.first();
+}
+
+/**
+ * @brief: 把 node 的子树切成前 count 个块和其余的块
+ */
+void ParenthesisIndex::split(int node, int count, int* pLeft, int* pRight)
+{
+    if (node < 0)
+    {
+        *pLeft = -1;
+        *pRight = -1;
+        return;
+    }
+    const int leftSize = size(mNodes.at(node).mLeft);
+    int       left, right;
+    if (count <= leftSize)
+    {
+        split(mNodes.at(node).mLeft, count, &left, &right);
+        mNodes[node].mLeft = right;
+        *pLeft = left;
+        *pRight = node;
+    }
+    else
+    {
+        split(mNodes.at(node).mRight, count - leftSize - 1, &left, &right);
+        mNodes[node].mRight = left;
+        *pLeft = node;
+        *pRight = right;
+    }
+    updateNode(node);
+}
+
+/**
+ * @brief: 把 right 的块接在 left 的块之后，返回新的根
+ */
+int ParenthesisIndex::join(int left, int right)
+{
+    if (left < 0 || right < 0)
+    {
+        return left < 0 ? right : left;
+    }
+    if (mNodes.at(left).mPriority > mNodes.at(right).mPriority)
+    {
+        const int child = join(mNodes.at(left).mRight, right);
+        mNodes[left].mRight = child;
+        updateNode(left);
+        return left;
+    }
+    const int child = join(left, mNodes.at(right).mLeft);
+    mNodes[right].mLeft = child;
+    updateNode(right);
+    return right;
+}
+
+/**
+ * @brief: 修改第 index 个块的值，沿路径重算
+ */
+void ParenthesisIndex::assign(int node, int index, const Unmatched& value)
+{
+    const int leftSize = size(mNodes.at(node).mLeft);
+    if (index < leftSize)
+    {
+        assign(mNodes.at(node).mLeft, index, value);
+    }
+    else if (index > leftSize)
+    {
+        assign(mNodes.at(node).mRight, index - leftSize - 1, value);
+    }
+    else
+    {
+        mNodes[node].mValue = value;
+    }
+    updateNode(node);
+}
+
+void ParenthesisIndex::updateBlock(const QTextBlock& block)
+{
+    // 块数已经变化的话等下次查找时整体重建
+    if (!mValid || mBlockCount != mpTextDocument->blockCount())
+    {
+        mValid = false;
+        return;
+    }
+    assign(mRoot, block.blockNumber(), blockValue(block));
+}
+
+/**
+ * @brief: 在子树(第一个块号为 offset)里查找块号 >= from、深度降到 -need 的第一个块，经过的块从 need 里扣除
+ */
+int ParenthesisIndex::findForward(int node, int offset, int from, int* pNeed) const
+{
+    if (node < 0)
+    {
+        return -1;
+    }
+    const Node& n = mNodes.at(node);
+    if (offset + n.mSize <= from)
+    {
+        return -1;
+    }
+    if (offset >= from && n.mTotal.mClosed < *pNeed)
+    {
+        *pNeed += n.mTotal.mOpened - n.mTotal.mClosed;
+        return -1;
+    }
+    const int self = offset + size(n.mLeft);
+    const int leaf = findForward(n.mLeft, offset, from, pNeed);
+    if (leaf >= 0)
+    {
+        return leaf;
+    }
+    if (self >= from)
+    {
+        if (n.mValue.mClosed >= *pNeed)
+        {
+            return self;
+        }
+        *pNeed += n.mValue.mOpened - n.mValue.mClosed;
+    }
+    return findForward(n.mRight, self + 1, from, pNeed);
+}
+
+int ParenthesisIndex::findBackward(int node, int offset, int to, int* pNeed) const
+{
+    if (node < 0 || offset > to)
+    {
+        return -1;
+    }
+    const Node& n = mNodes.at(node);
+    if (offset + n.mSize - 1 <= to && n.mTotal.mOpened < *pNeed)
+    {
+        *pNeed += n.mTotal.mClosed - n.mTotal.mOpened;
+        return -1;
+    }
+    const int self = offset + size(n.mLeft);
+    const int leaf = findBackward(n.mRight, self + 1, to, pNeed);
+    if (leaf >= 0)
+    {
+        return leaf;
+    }
+    if (self <= to)
+    {
+        if (n.mValue.mOpened >= *pNeed)
+        {
+            return self;
+        }
+        *pNeed += n.mValue.mClosed - n.mValue.mOpened;
+    }
+    return findBackward(n.mLeft, offset, to, pNeed);
+}
+
+QTextBlock ParenthesisIndex::findClosedBlock(const QTextBlock& block, int need, int* pIgnore)
+{
+    ensureValid();
+    const int leaf = findForward(mRoot, 0, block.blockNumber() + 1, &need);
+    if (leaf < 0)
+    {
+        return QTextBlock();
+    }
+    *pIgnore = need - 1;
+    return mpTextDocument->findBlockByNumber(leaf);
+}
+
+QTextBlock ParenthesisIndex::findOpenedBlock(const QTextBlock& block, int need, int* pIgnore)
+{
+    ensureValid();
+    const int to = block.blockNumber() - 1;
+    if (to < 0)
+    {
+        return QTextBlock();
+    }
+    const int leaf = findBackward(mRoot, 0, to, &need);
+    if (leaf < 0)
+    {
+        return QTextBlock();
+    }
+    *pIgnore = need - 1;
+    return mpTextDocument->findBlockByNumber(leaf);
+}
+
+void ParenthesisIndex::handleContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved);
+    // 索引还没建立时等下次查找整体建立；块数不变时编辑过的块会重新高亮并调用 updateBlock
+    const int blockCount = mpTextDocument->blockCount();
+    const int delta = blockCount - mBlockCount;
+    if (!mValid || delta == 0)
+    {
+        return;
+    }
+    const int firstBlock = mpTextDocument->findBlock(position).blockNumber();
+    const int endPosition = qMin(position + charsAdded, mpTextDocument->characterCount() - 1);
+    const int addedBlocks = mpTextDocument->findBlock(endPosition).blockNumber() - firstBlock;
+    const int removedBlocks = addedBlocks - delta;
+    if (firstBlock < 0 || removedBlocks < 0 || firstBlock + removedBlocks >= mBlockCount)
+    {
+        mValid = false;
+        return;
+    }
+
+    // 在编辑处切开：[0, firstBlock) | 编辑前的 firstBlock 和被移除的块 | 之后的块，中间一段换成编辑后的块
+    int left, middle, right;
+    split(mRoot, firstBlock, &left, &right);
+    split(right, removedBlocks + 1, &middle, &right);
+    freeNodes(middle);
+    QVector<Unmatched> values;
+    values.reserve(addedBlocks + 1);
+    QTextBlock block = mpTextDocument->findBlockByNumber(firstBlock);
+    for (int i = 0; i <= addedBlocks && block.isValid(); ++i, block = block.next())
+    {
+        values.append(blockValue(block));
+    }
+    mRoot = join(join(left, build(values)), right);
+    mBlockCount = blockCount;
+}
@@ -0,0 +1,84 @@
+﻿#ifndef PARENTHESISINDEX_H
+#define PARENTHESISINDEX_H
+
+#include <QObject>
+#include <QTextBlock>
+#include <QVector>
+
+/**
+ * @class : 括号嵌套深度索引
+ *          每个块内部抵消之后只剩 "mClosed 个右括号 + mOpened 个左括号"，块的深度变化 = mOpened - mClosed。
+ *          每个块是隐式 treap(按块号排列、带子树大小的随机平衡树)的一个节点，节点同时保存子树合并后的 (mClosed, mOpened)，
+ *          括号匹配跨块时直接定位到匹配所在的块，不再逐块遍历。
+ *          高亮更新括号时修改对应节点并沿路径重算，O(log n)；块数变化时把树在编辑处切开，换掉被移除的块、接上新增的块，
+ *          O(log n + 变化的块数)，编辑点之后的块不用处理。
+ */
+class ParenthesisIndex : public QObject
+{
+    Q_OBJECT
+public:
+    ParenthesisIndex(QTextDocument* pTextDocument, QObject* parent = nullptr);
+
+    /**
+     * @brief: 高亮设置了块的括号之后调用
+     */
+    void updateBlock(const QTextBlock& block);
+
+    /**
+     * @brief: 从 block 之后开始，查找第 need 个没有配对的右括号所在的块
+     * @param pIgnore: 返回在找到的块里还需要跳过的右括号个数
+     */
+    QTextBlock findClosedBlock(const QTextBlock& block, int need, int* pIgnore);
+    /**
+     * @brief: 从 block 之前开始，查找第 need 个没有配对的左括号所在的块
+     */
+    QTextBlock findOpenedBlock(const QTextBlock& block, int need, int* pIgnore);
+
+private slots:
+    void handleContentsChange(int position, int charsRemoved, int charsAdded);
+
+private:
+    struct Unmatched
+    {
+        Unmatched()
+            : mClosed(0)
+            , mOpened(0)
+        {
+        }
+        int mClosed; // 没有配对的右括号
+        int mOpened; // 没有配对的左括号
+    };
+    struct Node
+    {
+        int       mLeft;
+        int       mRight;
+        quint32   mPriority;
+        int       mSize;  // 子树的块数
+        Unmatched mValue; // 本块
+        Unmatched mTotal; // 整个子树按块号顺序合并
+    };
+
+    static Unmatched blockValue(const QTextBlock& block);
+    static Unmatched combine(const Unmatched& left, const Unmatched& right);
+    void             ensureValid();
+    int              size(int node) const;
+    int              createNode(const Unmatched& value);
+    void             freeNodes(int node);
+    void             updateNode(int node);
+    int              build(const QVector<Unmatched>& values);
+    void             split(int node, int count, int* pLeft, int* pRight);
+    int              join(int left, int right);
+    void             assign(int node, int index, const Unmatched& value);
+    int              findForward(int node, int offset, int from, int* pNeed) const;
+    int              findBackward(int node, int offset, int to, int* pNeed) const;
+
+    QTextDocument* mpTextDocument;
+    bool           mValid;
+    int            mBlockCount;
+    int            mRoot;
+    QVector<Node>  mNodes;     // 节点池，用下标互相引用
+    QVector<int>   mFreeNodes; // mNodes 里空闲的下标
+    quint32        mRandom;    // xorshift 状态，生成节点优先级
+};
+
+#endif // PARENTHESISINDEX_H
@@ -0,0 +1,548 @@
+﻿#include "SearchEngine.h"
+#include <QStringMatcher>
+#include <QTextCursor>
+#include <QTextDocument>
+#include <QtConcurrent>
+#include <algorithm>
+
+static const int sChunkSize = 256 * 1024; // 每个块的字符数，按行对齐
+
+/**
+ * @brief: 正则表达式里一定会出现的最长一段字面文本，用来筛选行；
+ *         含有 | 或者 (? 的表达式，以及分组、字符类、可选字符里的文本都不使用，返回空表示不筛选
+ */
+static QString requiredLiteral(const QString& pattern)
+{
+    QString best;
+    if (pattern.contains(QLatin1Char('|')) || pattern.contains(QLatin1String("(?")))
+    {
+        return best;
+    }
+    QString current;
+    auto    flush = [&]() {
+        if (current.length() > best.length())
+        {
+            best = current;
+        }
+        current.clear();
+    };
+    auto isOptional = [&](int i) {
+        return i < pattern.length() && (pattern.at(i) == QLatin1Char('?') || pattern.at(i) == QLatin1Char('*') || pattern.at(i) == QLatin1Char('{'));
+    };
+    int depth = 0;
+    for (int i = 0; i < pattern.length(); ++i)
+    {
+        const QChar c = pattern.at(i);
+        if (c == QLatin1Char('\\'))
+        {
+            // 转义的标点是字面字符，\d \w 等是字符类
+            if (i + 1 < pattern.length() && !pattern.at(i + 1).isLetterOrNumber() && depth == 0 && !isOptional(i + 2))
+            {
+                current += pattern.at(i + 1);
+            }
+            else
+            {
+                flush();
+            }
+            ++i;
+            continue;
+        }
+        if (c == QLatin1Char('['))
+        {
+            flush();
+            int j = i + 1;
+            if (j < pattern.length() && pattern.at(j) == QLatin1Char('^'))
+            {
+                ++j;
+            }
+            if (j < pattern.length() && pattern.at(j) == QLatin1Char(']'))
+            {
+                ++j;
+            }
+            for (; j < pattern.length() && pattern.at(j) != QLatin1Char(']'); ++j)
+            {
+                if (pattern.at(j) == QLatin1Char('\\'))
+                {
+                    ++j;
+                }
+            }
+            i = j;
+            continue;
+        }
+        if (c == QLatin1Char('{'))
+        {
+            flush();
+            const int j = pattern.indexOf(QLatin1Char('}'), i);
+            i = j < 0 ? pattern.length() : j;
+            continue;
+        }
+        if (c == QLatin1Char('('))
+        {
+            flush();
+            ++depth;
+            continue;
+        }
+        if (c == QLatin1Char(')'))
+        {
+            flush();
+            --depth;
+            continue;
+        }
+        if (QStringLiteral("^$.*+?").contains(c) || depth > 0 || isOptional(i + 1))
+        {
+            flush();
+            continue;
+        }
+        current += c;
+    }
+    flush();
+    return best;
+}
+
+/**
+ * @class : 在一个块里查找，工作线程共享只读的一份
+ */
+class ChunkSearcher
+{
+public:
+    ChunkSearcher(const QString& text, const QString& pattern, SearchEngine::Options options)
+        : mText(text)
+        , mOptions(options)
+    {
+        const Qt::CaseSensitivity caseSensitivity = (options & SearchEngine::CaseSensitive) ? Qt::CaseSensitive : Qt::CaseInsensitive;
+        if (options & SearchEngine::RegularExpression)
+        {
+            const QString wrapped = (options & SearchEngine::WholeWords) ? QStringLiteral("\\b(?:%1)\\b").arg(pattern) : pattern;
+            mRegularExpression.setPattern(wrapped);
+            if (caseSensitivity == Qt::CaseInsensitive)
+            {
+                mRegularExpression.setPatternOptions(QRegularExpression::CaseInsensitiveOption);
+            }
+            mRegularExpression.optimize();
+            mMatcher = QStringMatcher(requiredLiteral(pattern), caseSensitivity);
+        }
+        else
+        {
+            mMatcher = QStringMatcher(pattern, caseSensitivity);
+        }
+    }
+
+    bool isValid() const
+    {
+        return !(mOptions & SearchEngine::RegularExpression) || mRegularExpression.isValid();
+    }
+
+    /**
+     * @brief: 对块里的每个匹配调用 f(position, length, pMatch)，普通文本查找时 pMatch 为空
+     */
+    template <typename F>
+    void forEachMatch(const SearchEngine::Chunk& chunk, F f) const
+    {
+        const QChar* pText = mText.constData();
+        const int    literalLength = mMatcher.pattern().length();
+        if (!(mOptions & SearchEngine::RegularExpression))
+        {
+            int position = chunk.mStart;
+            while ((position = mMatcher.indexIn(pText, chunk.mEnd, position)) >= 0)
+            {
+                if ((mOptions & SearchEngine::WholeWords) && !isWholeWord(position, position + literalLength))
+                {
+                    ++position;
+                    continue;
+                }
+                f(position, literalLength, nullptr);
+                position += literalLength;
+            }
+            return;
+        }
+        int lineStart = chunk.mStart;
+        while (lineStart < chunk.mEnd)
+        {
+            // 先用字面文本跳到可能匹配的行
+            if (literalLength > 0)
+            {
+                const int candidate = mMatcher.indexIn(pText, chunk.mEnd, lineStart);
+                if (candidate < 0)
+                {
+                    return;
+                }
+                lineStart = mText.lastIndexOf(QLatin1Char('\n'), candidate) + 1;
+            }
+            int lineEnd = mText.indexOf(QLatin1Char('\n'), lineStart);
+            if (lineEnd < 0 || lineEnd > chunk.mEnd)
+            {
+                lineEnd = chunk.mEnd;
+            }
+            const QString                   line = mText.mid(lineStart, lineEnd - lineStart);
+            QRegularExpressionMatchIterator it = mRegularExpression.globalMatch(line);
+            while (it.hasNext())
+            {
+                const QRegularExpressionMatch match = it.next();
+                if (match.capturedLength() > 0)
+                {
+                    f(lineStart + match.capturedStart(), match.capturedLength(), &match);
+                }
+            }
+            lineStart = lineEnd + 1;
+        }
+    }
+
+    const QString& text() const
+    {
+        return mText;
+    }
+
+private:
+    static bool isWordCharacter(QChar c)
+    {
+        return c.isLetterOrNumber() || c == QLatin1Char('_');
+    }
+    bool isWholeWord(int start, int end) const
+    {
+        return (start == 0 || !isWordCharacter(mText.at(start - 1))) && (end >= mText.length() || !isWordCharacter(mText.at(end)));
+    }
+
+    QString               mText;
+    SearchEngine::Options mOptions;
+    QStringMatcher        mMatcher; // 普通文本为查找的文本，正则表达式为筛选行用的字面文本
+    QRegularExpression    mRegularExpression;
+};
+
+/**
+ * @class : QtConcurrent::mapped 使用，查找一个块
+ */
+struct FindChunk
+{
+    typedef SearchEngine::Matches result_type;
+
+    FindChunk(const ChunkSearcher& searcher)
+        : mSearcher(searcher)
+    {
+    }
+    SearchEngine::Matches operator()(const SearchEngine::Chunk& chunk) const
+    {
+        SearchEngine::Matches matches;
+        mSearcher.forEachMatch(chunk, [&matches](int position, int length, const QRegularExpressionMatch*) {
+            SearchEngine::Match match;
+            match.mPosition = position;
+            match.mLength = length;
+            matches.append(match);
+        });
+        return matches;
+    }
+
+    ChunkSearcher mSearcher;
+};
+
+/**
+ * @class : QtConcurrent::blockingMapped 使用，生成一个块里每一行替换后的文本
+ */
+struct ReplaceChunk
+{
+    typedef SearchEngine::Edits result_type;
+
+    ReplaceChunk(const ChunkSearcher& searcher, const QString& replacement)
+        : mSearcher(searcher)
+        , mReplacement(replacement)
+    {
+    }
+    SearchEngine::Edits operator()(const SearchEngine::Chunk& chunk) const
+    {
+        const QString&      text = mSearcher.text();
+        SearchEngine::Edits edits;
+        SearchEngine::Edit  edit;
+        int                 lineEnd = -1;
+        mSearcher.forEachMatch(chunk, [&](int position, int length, const QRegularExpressionMatch* pMatch) {
+            if (position < lineEnd)
+            {
+                // 同一行的匹配合并到一次修改里
+                edit.mText += text.midRef(edit.mEnd, position - edit.mEnd);
+                ++edit.mCount;
+            }
+            else
+            {
+                if (lineEnd >= 0)
+                {
+                    edits.append(edit);
+                }
+                lineEnd = text.indexOf(QLatin1Char('\n'), position);
+                if (lineEnd < 0)
+                {
+                    lineEnd = text.length();
+                }
+                edit.mStart = position;
+                edit.mText.clear();
+                edit.mCount = 1;
+            }
+            edit.mText += expand(pMatch);
+            edit.mEnd = position + length;
+        });
+        if (lineEnd >= 0)
+        {
+            edits.append(edit);
+        }
+        return edits;
+    }
+
+    /**
+     * @brief: \1 - \9 替换为捕获的内容，\\ 为反斜杠
+     */
+    QString expand(const QRegularExpressionMatch* pMatch) const
+    {
+        if (!pMatch || !mReplacement.contains(QLatin1Char('\\')))
+        {
+            return mReplacement;
+        }
+        QString result;
+        for (int i = 0; i < mReplacement.length(); ++i)
+        {
+            const QChar c = mReplacement.at(i);
+            if (c == QLatin1Char('\\') && i + 1 < mReplacement.length())
+            {
+                const QChar next = mReplacement.at(i + 1);
+                if (next.isDigit())
+                {
+                    result += pMatch->captured(next.digitValue());
+                    ++i;
+                    continue;
+                }
+                if (next == QLatin1Char('\\'))
+                {
+                    result += next;
+                    ++i;
+                    continue;
+                }
+            }
+            result += c;
+        }
+        return result;
+    }
+
+    ChunkSearcher mSearcher;
+    QString       mReplacement;
+};
+
+SearchEngine::SearchEngine(QTextDocument* pTextDocument, QObject* parent)
+    : QObject(parent)
+    , mpTextDocument(pTextDocument)
+    , mMatchCount(0)
+    , mRevision(-1)
+    , mReplacing(false)
+{
+    mRestartTimer.setSingleShot(true);
+    mRestartTimer.setInterval(200);
+    connect(&mRestartTimer, SIGNAL(timeout()), this, SLOT(restart()));
+    connect(&mWatcher, SIGNAL(resultReadyAt(int)), this, SLOT(handleResultReadyAt(int)));
+    connect(&mWatcher, SIGNAL(finished()), this, SIGNAL(finished()));
+    connect(mpTextDocument, SIGNAL(contentsChange(int, int, int)), this, SLOT(handleContentsChange(int, int, int)));
+}
+
+SearchEngine::~SearchEngine()
+{
+    mWatcher.cancel();
+    mWatcher.waitForFinished();
+}
+
+QVector<SearchEngine::Chunk> SearchEngine::splitChunks(const QString& text)
+{
+    QVector<Chunk> chunks;
+    chunks.reserve(text.length() / sChunkSize + 1);
+    for (int start = 0; start < text.length();)
+    {
+        int end = start + sChunkSize;
+        if (end >= text.length())
+        {
+            end = text.length();
+        }
+        else
+        {
+            const int newline = text.indexOf(QLatin1Char('\n'), end);
+            end = newline < 0 ? text.length() : newline + 1;
+        }
+        Chunk chunk;
+        chunk.mStart = start;
+        chunk.mEnd = end;
+        chunks.append(chunk);
+        start = end;
+    }
+    return chunks;
+}
+
+void SearchEngine::find(const QString& pattern, Options options)
+{
+    mRestartTimer.stop();
+    mWatcher.cancel();
+    mWatcher.waitForFinished();
+    mPattern = pattern;
+    mOptions = options;
+    mChunks.clear();
+    mChunkMatches.clear();
+    mMatchCount = 0;
+    mRevision = mpTextDocument->revision();
+
+    // 匹配不跨行
+    const QString text = mpTextDocument->toPlainText();
+    ChunkSearcher searcher(text, pattern, options);
+    if (pattern.isEmpty() || pattern.contains(QLatin1Char('\n')) || !searcher.isValid())
+    {
+        emit matchesFound();
+        emit finished();
+        return;
+    }
+    mChunks = splitChunks(text);
+    mChunkMatches.resize(mChunks.size());
+    mWatcher.setFuture(QtConcurrent::mapped(mChunks, FindChunk(searcher)));
+}
+
+void SearchEngine::clear()
+{
+    find(QString(), mOptions);
+}
+
+void SearchEngine::restart()
+{
+    find(mPattern, mOptions);
+}
+
+bool SearchEngine::isRunning() const
+{
+    return mWatcher.isRunning();
+}
+
+int SearchEngine::matchCount() const
+{
+    return mMatchCount;
+}
+
+void SearchEngine::handleResultReadyAt(int index)
+{
+    if (index < 0 || index >= mChunkMatches.size())
+    {
+        return;
+    }
+    mChunkMatches[index] = mWatcher.resultAt(index);
+    mMatchCount += mChunkMatches.at(index).size();
+    emit matchesFound();
+}
+
+void SearchEngine::handleContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(position);
+    Q_UNUSED(charsRemoved);
+    Q_UNUSED(charsAdded);
+    // 高亮修改格式也会触发 contentsChange，文本没有变化时版本号不变
+    if (mReplacing || mPattern.isEmpty() || mpTextDocument->revision() == mRevision)
+    {
+        return;
+    }
+    mWatcher.cancel();
+    mChunks.clear();
+    mChunkMatches.clear();
+    mMatchCount = 0;
+    mRevision = mpTextDocument->revision();
+    emit matchesFound();
+    mRestartTimer.start();
+}
+
+int SearchEngine::findChunk(int position) const
+{
+    auto it = std::upper_bound(mChunks.constBegin(), mChunks.constEnd(), position, [](int p, const Chunk& chunk) { return p < chunk.mStart; });
+    return qMax(0, int(it - mChunks.constBegin()) - 1);
+}
+
+SearchEngine::Matches SearchEngine::matchesInRange(int from, int to) const
+{
+    Matches matches;
+    for (int i = findChunk(from); i < mChunks.size() && mChunks.at(i).mStart < to; ++i)
+    {
+        const Matches& chunkMatches = mChunkMatches.at(i);
+        auto           it = std::lower_bound(chunkMatches.constBegin(), chunkMatches.constEnd(), from,
+                                   [](const Match& match, int position) { return match.mPosition + match.mLength <= position; });
+        for (; it != chunkMatches.constEnd() && it->mPosition < to; ++it)
+        {
+            matches.append(*it);
+        }
+    }
+    return matches;
+}
+
+SearchEngine::Match SearchEngine::nextMatch(int position, bool forward) const
+{
+    Match none;
+    none.mPosition = position;
+    none.mLength = 0;
+    const int count = mChunks.size();
+    if (mMatchCount == 0 || count == 0)
+    {
+        return none;
+    }
+    const int first = findChunk(position);
+    auto      less = [](const Match& match, int p) { return match.mPosition < p; };
+    // 多走一圈回到起始的块，处理循环查找
+    for (int k = 0; k <= count; ++k)
+    {
+        const int      i = forward ? (first + k) % count : (first - k + count) % count;
+        const Matches& matches = mChunkMatches.at(i);
+        if (matches.isEmpty())
+        {
+            continue;
+        }
+        if (k > 0)
+        {
+            return forward ? matches.first() : matches.last();
+        }
+        auto it = std::lower_bound(matches.constBegin(), matches.constEnd(), position, less);
+        if (forward && it != matches.constEnd())
+        {
+            return *it;
+        }
+        if (!forward && it != matches.constBegin())
+        {
+            return *(it - 1);
+        }
+    }
+    return none;
+}
+
+int SearchEngine::replaceAll(const QString& pattern, const QString& replacement, Options options)
+{
+    mRestartTimer.stop();
+    mWatcher.cancel();
+    mWatcher.waitForFinished();
+    const QString text = mpTextDocument->toPlainText();
+    ChunkSearcher searcher(text, pattern, options);
+    if (!searcher.isValid())
+    {
+        return -1;
+    }
+    if (pattern.isEmpty() || pattern.contains(QLatin1Char('\n')))
+    {
+        return 0;
+    }
+    const QVector<Edits> chunkEdits = QtConcurrent::blockingMapped<QVector<Edits>>(splitChunks(text), ReplaceChunk(searcher, replacement));
+
+    // 从后往前替换，前面的位置不受影响；每行只修改一次，不跨行，断点、折叠等块数据保留
+    int count = 0;
+    mReplacing = true;
+    QTextCursor cursor(mpTextDocument);
+    cursor.beginEditBlock();
+    for (int i = chunkEdits.size() - 1; i >= 0; --i)
+    {
+        const Edits& edits = chunkEdits.at(i);
+        for (int j = edits.size() - 1; j >= 0; --j)
+        {
+            const Edit& edit = edits.at(j);
+            cursor.setPosition(edit.mStart);
+            cursor.setPosition(edit.mEnd, QTextCursor::KeepAnchor);
+            cursor.insertText(edit.mText);
+            count += edit.mCount;
+        }
+    }
+    cursor.endEditBlock();
+    mReplacing = false;
+
+    mPattern = pattern;
+    mOptions = options;
+    restart();
+    return count;
+}
@@ -0,0 +1,118 @@
+﻿#ifndef SEARCHENGINE_H
+#define SEARCHENGINE_H
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <QRegularExpression>
+#include <QTimer>
+#include <QVector>
+
+class QTextDocument;
+
+/**
+ * @class : 多线程查找/全部替换
+ *          文档文本按行切成约 256K 字符的块，QtConcurrent 并行查找，每个块查找完成就通知编辑器，结果边查找边显示。
+ *          普通文本用 QStringMatcher 查找；正则表达式先提取一定会出现的一段字面文本，用它筛选出可能匹配的行，只对这些行执行正则。
+ *          匹配不跨行。文档修改后结果失效，稍后自动重新查找。
+ */
+class SearchEngine : public QObject
+{
+    Q_OBJECT
+public:
+    enum Option
+    {
+        CaseSensitive = 0x1,
+        WholeWords = 0x2,
+        RegularExpression = 0x4
+    };
+    Q_DECLARE_FLAGS(Options, Option)
+
+    struct Match
+    {
+        int mPosition;
+        int mLength;
+    };
+    typedef QVector<Match> Matches;
+    struct Chunk
+    {
+        int mStart;
+        int mEnd; // 包含行尾的换行符
+    };
+    // 全部替换时一行里所有匹配合并成一次修改
+    struct Edit
+    {
+        int     mStart;
+        int     mEnd;
+        QString mText;
+        int     mCount; // 这一行替换的个数
+    };
+    typedef QVector<Edit> Edits;
+
+    SearchEngine(QTextDocument* pTextDocument, QObject* parent = nullptr);
+    ~SearchEngine();
+
+    /**
+     * @brief: 后台查找，已有的查找会被取消；pattern 为空时清除结果
+     */
+    void find(const QString& pattern, Options options);
+    void clear();
+    bool isRunning() const;
+    int  matchCount() const;
+
+    /**
+     * @brief: 返回 [from, to) 之间的匹配，按位置排序
+     */
+    Matches matchesInRange(int from, int to) const;
+    /**
+     * @brief: 返回 position 之后(forward)或之前的第一个匹配，没有时从另一端循环查找，mLength 为 0 表示没有匹配
+     */
+    Match nextMatch(int position, bool forward) const;
+
+    /**
+     * @brief: 并行查找并生成替换后的文本，在一个 beginEditBlock/endEditBlock 里按行替换，可以一次撤销
+     *         正则表达式的替换文本里 \1 - \9 表示捕获的内容
+     *         替换之后 pattern 成为当前的查找内容，重新查找一次
+     * @return: 替换的个数，正则表达式无效时返回 -1
+     */
+    int replaceAll(const QString& pattern, const QString& replacement, Options options);
+
+    const QString& pattern() const
+    {
+        return mPattern;
+    }
+    Options options() const
+    {
+        return mOptions;
+    }
+
+signals:
+    /**
+     * @brief: 有新的块查找完成
+     */
+    void matchesFound();
+    void finished();
+
+private slots:
+    void handleResultReadyAt(int index);
+    void handleContentsChange(int position, int charsRemoved, int charsAdded);
+    void restart();
+
+private:
+    static QVector<Chunk> splitChunks(const QString& text);
+    int                   findChunk(int position) const;
+
+    QTextDocument*          mpTextDocument;
+    QString                 mPattern;
+    Options                 mOptions;
+    QVector<Chunk>          mChunks;
+    QVector<Matches>        mChunkMatches; // 与 mChunks 一一对应，还没有查找完的块为空
+    int                     mMatchCount;
+    QFutureWatcher<Matches> mWatcher;
+    QTimer                  mRestartTimer;
+    int                     mRevision; // 查找时的文档版本，只修改格式不会改变版本
+    bool                    mReplacing;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(SearchEngine::Options)
+
+#endif // SEARCHENGINE_H
@@ -0,0 +1,262 @@
+﻿#include "TextTokenizer.h"
+#include <climits>
+#include <cstring>
+
+TextTokenizer::TextTokenizer(const QStringList& keywords, const QStringList& types)
+    : mSeed(0)
+    , mMask(0)
+    , mMinLength(0)
+    , mMaxLength(0)
+{
+    //字符分类表，只处理 ASCII，其余字符在 charClass 里单独判断
+    memset(mCharClasses, Other, sizeof(mCharClasses));
+    for (int c = 'a'; c <= 'z'; ++c)
+    {
+        mCharClasses[c] = Letter;
+        mCharClasses[c - 'a' + 'A'] = Letter;
+    }
+    mCharClasses[int('_')] = Letter;
+    for (int c = '0'; c <= '9'; ++c)
+    {
+        mCharClasses[c] = Digit;
+    }
+
+    //后加入的同名单词覆盖前面的，和原来规则列表里类型规则在关键字之后的效果一致
+    QStringList words = keywords + types;
+    for (int i = 0; i < words.size(); ++i)
+    {
+        TokenType type = i < keywords.size() ? Keyword : Type;
+        bool      exists = false;
+        for (int k = 0; k < mWords.size(); ++k)
+        {
+            if (mWords[k].mText == words[i])
+            {
+                mWords[k].mType = type;
+                exists = true;
+                break;
+            }
+        }
+        if (!exists && !words[i].isEmpty())
+        {
+            Word word;
+            word.mText = words[i];
+            word.mType = type;
+            mWords.append(word);
+        }
+    }
+    buildPerfectHash();
+}
+
+void TextTokenizer::buildPerfectHash()
+{
+    mMinLength = INT_MAX;
+    mMaxLength = 0;
+    foreach (const Word& word, mWords)
+    {
+        mMinLength = qMin(mMinLength, word.mText.length());
+        mMaxLength = qMax(mMaxLength, word.mText.length());
+    }
+    // 槽数取 >= n^2 的 2 的幂，随机种子无冲突的概率在一半以上，通常几次就能找到
+    int size = 64;
+    while (size < mWords.size() * mWords.size())
+    {
+        size <<= 1;
+    }
+    for (;;)
+    {
+        mTable.fill(-1, size);
+        mMask = uint(size - 1);
+        for (mSeed = 1; mSeed < 4096; ++mSeed)
+        {
+            bool collision = false;
+            for (int i = 0; i < mWords.size() && !collision; ++i)
+            {
+                const QString& text = mWords[i].mText;
+                short&         slot = mTable[int(hashWord(text.constData(), text.length(), mSeed) & mMask)];
+                if (slot >= 0)
+                {
+                    collision = true;
+                }
+                else
+                {
+                    slot = short(i);
+                }
+            }
+            if (!collision)
+            {
+                return;
+            }
+            mTable.fill(-1);
+        }
+        size <<= 1;
+    }
+}
+
+TextTokenizer::TokenType TextTokenizer::lookupWord(const QChar* pWord, int length) const
+{
+    if (length < mMinLength || length > mMaxLength)
+    {
+        return Identifier;
+    }
+    const int index = mTable.at(int(hashWord(pWord, length, mSeed) & mMask));
+    if (index < 0)
+    {
+        return Identifier;
+    }
+    const Word& word = mWords.at(index);
+    if (word.mText.length() == length && memcmp(word.mText.constData(), pWord, length * sizeof(QChar)) == 0)
+    {
+        return word.mType;
+    }
+    return Identifier;
+}
+
+/**
+ * @brief: 等价于原来的正则 [0-9][0-9]*([.][0-9]*)?([eE][+-]?[0-9]*)?，返回数字结束的位置
+ */
+int TextTokenizer::scanNumber(const QChar* p, int index, int length)
+{
+    while (index < length && p[index].unicode() >= '0' && p[index].unicode() <= '9')
+    {
+        ++index;
+    }
+    if (index < length && p[index] == QLatin1Char('.'))
+    {
+        ++index;
+        while (index < length && p[index].unicode() >= '0' && p[index].unicode() <= '9')
+        {
+            ++index;
+        }
+    }
+    if (index < length && (p[index] == QLatin1Char('e') || p[index] == QLatin1Char('E')))
+    {
+        ++index;
+        if (index < length && (p[index] == QLatin1Char('+') || p[index] == QLatin1Char('-')))
+        {
+            ++index;
+        }
+        while (index < length && p[index].unicode() >= '0' && p[index].unicode() <= '9')
+        {
+            ++index;
+        }
+    }
+    return index;
+}
+
+/**
+ * @brief: 查找多行注释结尾 "*\/"，返回注释之后的位置，没有找到返回 -1
+ */
+int TextTokenizer::findMultiLineCommentEnd(const QChar* p, int index, int length)
+{
+    for (; index + 1 < length; ++index)
+    {
+        if (p[index] == QLatin1Char('*') && p[index + 1] == QLatin1Char('/'))
+        {
+            return index + 2;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief: 查找字符串结尾的引号，跳过转义字符，返回引号之后的位置，没有找到返回 -1
+ */
+int TextTokenizer::findQuotationEnd(const QChar* p, int index, int length)
+{
+    for (; index < length; ++index)
+    {
+        if (p[index] == QLatin1Char('\\'))
+        {
+            ++index;
+        }
+        else if (p[index] == QLatin1Char('"'))
+        {
+            return index + 1;
+        }
+    }
+    return -1;
+}
+
+int TextTokenizer::tokenize(const QString& text, int state, Tokens* pTokens) const
+{
+    pTokens->clear();
+    const QChar* p = text.constData();
+    const int    length = text.length();
+    int          index = 0;
+
+    // 续接上一行没有结束的多行注释或者字符串
+    if (state == InMultiLineComment || state == InQuotation)
+    {
+        const bool comment = (state == InMultiLineComment);
+        int        end = comment ? findMultiLineCommentEnd(p, 0, length) : findQuotationEnd(p, 0, length);
+        if (end < 0)
+        {
+            pTokens->append(Token(0, length, comment ? MultiLineComment : Quotation));
+            return state;
+        }
+        pTokens->append(Token(0, end, comment ? MultiLineComment : Quotation));
+        index = end;
+    }
+
+    while (index < length)
+    {
+        const QChar c = p[index];
+        if (c == QLatin1Char('/') && index + 1 < length)
+        {
+            if (p[index + 1] == QLatin1Char('/'))
+            {
+                pTokens->append(Token(index, length - index, SingleLineComment));
+                return Normal;
+            }
+            if (p[index + 1] == QLatin1Char('*'))
+            {
+                int end = findMultiLineCommentEnd(p, index + 2, length);
+                if (end < 0)
+                {
+                    pTokens->append(Token(index, length - index, MultiLineComment));
+                    return InMultiLineComment;
+                }
+                pTokens->append(Token(index, end - index, MultiLineComment));
+                index = end;
+                continue;
+            }
+        }
+        if (c == QLatin1Char('"'))
+        {
+            int end = findQuotationEnd(p, index + 1, length);
+            if (end < 0)
+            {
+                pTokens->append(Token(index, length - index, Quotation));
+                return InQuotation;
+            }
+            pTokens->append(Token(index, end - index, Quotation));
+            index = end;
+            continue;
+        }
+
+        const int cls = charClass(c);
+        if (cls == Other)
+        {
+            ++index;
+            continue;
+        }
+        const int start = index;
+        if (cls == Digit)
+        {
+            index = scanNumber(p, index, length);
+            pTokens->append(Token(start, index - start, Number));
+            // 紧跟在数字后面的字母 (12abc) 原来也不着色，直接跳过
+            while (index < length && charClass(p[index]) != Other)
+            {
+                ++index;
+            }
+            continue;
+        }
+        while (index < length && charClass(p[index]) != Other)
+        {
+            ++index;
+        }
+        pTokens->append(Token(start, index - start, lookupWord(p + start, index - start)));
+    }
+    return Normal;
+}
@@ -0,0 +1,117 @@
+﻿#ifndef TEXTTOKENIZER_H
+#define TEXTTOKENIZER_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+/**
+ * @class : 表驱动的单遍词法扫描器
+ *          一次线性扫描就把一行文本分成 关键字/类型/标识符/数字/字符串/注释，
+ *          关键字查找使用构造时生成的完美哈希表。只读，可以跨线程共享。
+ */
+class TextTokenizer
+{
+public:
+    enum TokenType
+    {
+        Identifier,
+        Keyword,
+        Type,
+        Number,
+        Quotation,
+        SingleLineComment,
+        MultiLineComment
+    };
+    // 块状态，和 QSyntaxHighlighter 的 blockState 保持一致
+    enum State
+    {
+        Normal = 0,
+        InMultiLineComment = 2,
+        InQuotation = 3
+    };
+    struct Token
+    {
+        Token()
+            : start(0)
+            , length(0)
+            , type(Identifier)
+        {
+        }
+        Token(int s, int l, TokenType t)
+            : start(s)
+            , length(l)
+            , type(t)
+        {
+        }
+        int       start;
+        int       length;
+        TokenType type;
+
+        inline int end() const
+        {
+            return start + length;
+        }
+        inline bool isCommentOrQuotation() const
+        {
+            return type >= Quotation;
+        }
+    };
+    typedef QVector<Token> Tokens;
+
+    TextTokenizer(const QStringList& keywords, const QStringList& types);
+
+    /**
+     * @brief: 扫描一行文本
+     * @param state: 上一行结束时的块状态
+     * @return: 本行结束时的块状态
+     */
+    int tokenize(const QString& text, int state, Tokens* pTokens) const;
+
+    /**
+     * @brief: 完美哈希查找，返回 Keyword/Type，不是关键字返回 Identifier
+     */
+    TokenType lookupWord(const QChar* pWord, int length) const;
+
+private:
+    enum CharClass
+    {
+        Other = 0,
+        Letter = 1, // A-Z a-z _
+        Digit = 2
+    };
+    inline int charClass(QChar c) const
+    {
+        const ushort u = c.unicode();
+        return u < 128 ? mCharClasses[u] : (c.isLetterOrNumber() ? Letter : Other);
+    }
+    static inline uint hashWord(const QChar* pWord, int length, uint seed)
+    {
+        uint h = seed ^ uint(length);
+        for (int i = 0; i < length; ++i)
+        {
+            h = (h ^ pWord[i].unicode()) * 16777619u;
+        }
+        return h ^ (h >> 15);
+    }
+    void       buildPerfectHash();
+    static int scanNumber(const QChar* p, int index, int length);
+    static int findMultiLineCommentEnd(const QChar* p, int index, int length);
+    static int findQuotationEnd(const QChar* p, int index, int length);
+
+    uchar mCharClasses[128];
+
+    struct Word
+    {
+        QString   mText;
+        TokenType mType;
+    };
+    QVector<Word>  mWords;
+    QVector<short> mTable; // 哈希槽 -> mWords 下标，-1 为空
+    uint           mSeed;
+    uint           mMask;
+    int            mMinLength;
+    int            mMaxLength;
+};
+
+#endif // TEXTTOKENIZER_H
@@ -54,6 +54,10 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    //曲线(和它的 stream)删除之前先停止采集线程
+    acquisitionRunning = false;
+    if (acquisitionThread.joinable())
+        acquisitionThread.join();
     delete ui;
 }
 
@@ -681,6 +685,28 @@ void MainWindow::realTimer()
     customPlot->axisRect()->setupFullAxesBox();
     customPlot->yAxis->setRange(-1.2, 1.2);
 
+    //采集线程写入无锁环形缓冲区，每次 replot 之前一次性按顺序追加到曲线，只保留最近 8 秒的数据
+    stream1 = new QCPGraphDataStream(graph1);
+    stream1->setRetentionWindow(8);
+    stream2 = new QCPGraphDataStream(graph2);
+    stream2->setRetentionWindow(8);
+    graph1->data()->setLevelOfDetailEnabled(true);
+    graph2->data()->setLevelOfDetailEnabled(true);
+    connect(customPlot, SIGNAL(beforeReplot()), stream1, SLOT(drain()));
+    connect(customPlot, SIGNAL(beforeReplot()), stream2, SLOT(drain()));
+    //界面线程只记录绘制命令，图层在线程池里光栅化；上一帧没画完时的 replot 合并成一帧
+    customPlot->setAsyncReplot(true);
+    //每个图层单独缓存，只重绘内容变化的图层(背景、图例不随数据重绘)
+    customPlot->setPlottingHint(QCP::phDirtyLayers);
+    //设置环境变量 QCP_REPLOT_PROFILER 后记录每一帧各阶段、各图层的耗时，并在左上角显示
+    if (qEnvironmentVariableIsSet("QCP_REPLOT_PROFILER"))
+    {
+        customPlot->profiler()->setEnabled(true);
+        customPlot->profiler()->setOverlayVisible(true);
+    }
+    acquisitionClock.start();
+    acquisitionRunning = true;
+    acquisitionThread = std::thread(&MainWindow::acquire, this);
 
     // make left and bottom axes transfer their ranges to right and top axes:
     connect(customPlot->xAxis, SIGNAL(rangeChanged(QCPRange)), customPlot->xAxis2, SLOT(setRange(QCPRange)));
@@ -778,22 +804,35 @@ void MainWindow::slotHide()
 
 }
 
-void MainWindow::realtimeDataSlot()
+void MainWindow::acquire()
 {
-    static QTime timeStart = QTime::currentTime();
-    // calculate two new data points:
-    double key = timeStart.msecsTo(QTime::currentTime())/1000.0; // time elapsed since start of demo, in seconds
-    static double lastPointKey = 0;
-    if (key-lastPointKey > 0.002) // at most add point every 2 ms
+    //每毫秒生成一批采样点，每个通道约 10 万点/秒
+    const int batchSize = 100;
+    QVector<QCPGraphData> batch1(batchSize), batch2(batchSize);
+    double lastKey = acquisitionClock.nsecsElapsed()/1e9;
+    while (acquisitionRunning)
     {
-      // add data to lines:
-      customPlot->graph(0)->addData(key, qSin(key)+std::rand()/(double)RAND_MAX*1*qSin(key/0.3843));
-      customPlot->graph(1)->addData(key, qCos(key)+std::rand()/(double)RAND_MAX*0.5*qSin(key/0.4364));
-      // rescale value (vertical) axis to fit the current data:
-      //ui->customPlot->graph(0)->rescaleValueAxis();
-      //ui->customPlot->graph(1)->rescaleValueAxis(true);
-      lastPointKey = key;
+        const double key = acquisitionClock.nsecsElapsed()/1e9;
+        for (int i = 0; i < batchSize; ++i)
+        {
+            const double k = lastKey + (key-lastKey)*(i+1)/batchSize;
+            batch1[i] = QCPGraphData(k, qSin(k)+std::rand()/(double)RAND_MAX*1*qSin(k/0.3843));
+            batch2[i] = QCPGraphData(k, qCos(k)+std::rand()/(double)RAND_MAX*0.5*qSin(k/0.4364));
+        }
+        stream1->push(batch1.constData(), batchSize);
+        stream2->push(batch2.constData(), batchSize);
+        lastKey = key;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
+}
+
+void MainWindow::realtimeDataSlot()
+{
+    // time elapsed since start of demo, in seconds; data points come from acquire() via stream1/stream2
+    double key = acquisitionClock.nsecsElapsed()/1e9;
+    // rescale value (vertical) axis to fit the current data:
+    //ui->customPlot->graph(0)->rescaleValueAxis();
+    //ui->customPlot->graph(1)->rescaleValueAxis(true);
     // make key axis range scroll with the data (at a constant range size of 8):
     customPlot->xAxis->setRange(key, 8, Qt::AlignRight);
     customPlot->replot();
@@ -805,9 +844,11 @@ void MainWindow::realtimeDataSlot()
     if (key-lastFpsKey > 2) // average fps over 2 seconds
     {
       statusBar->showMessage(
-            QString("%1 FPS, Total Data points: %2")
+            QString("%1 FPS, Total Data points: %2, GUI %3 ms, worker %4 ms")
             .arg(frameCount/(key-lastFpsKey), 0, 'f', 0)
             .arg(customPlot->graph(0)->data()->size()+customPlot->graph(1)->data()->size())
+            .arg(customPlot->replotTime(true), 0, 'f', 2)
+            .arg(customPlot->replotWorkerTime(true), 0, 'f', 2)
             , 0);
       lastFpsKey = key;
       frameCount = 0;
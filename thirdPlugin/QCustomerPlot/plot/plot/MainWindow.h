@@ -5,6 +5,9 @@
 #include "Plot/qcustomplot.h"
 #include "QAction"
 #include "QMenu"
+#include <QElapsedTimer>
+#include <atomic>
+#include <thread>
 
 #if _MSC_VER >= 1600    //解决msvc中文乱码的问题
 #pragma execution_character_set("utf-8")
@@ -52,6 +55,12 @@ private:
     QAction * stopAction;
     QAction * continueAction;
     QMenu menu;
+    QCPGraphDataStream * stream1;
+    QCPGraphDataStream * stream2;
+    QElapsedTimer acquisitionClock;
+    std::atomic<bool> acquisitionRunning{false};
+    std::thread acquisitionThread;
+    void acquire(); //采集线程，写入 stream1/stream2
     Q_SLOT void realtimeDataSlot();
 
 };
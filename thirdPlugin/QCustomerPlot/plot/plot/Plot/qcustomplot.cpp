@@ -25,6 +25,18 @@
 
 #include "qcustomplot.h"
 
+#include <QtCore/QFile>
+#include <QtCore/QRunnable>
+#include <QtCore/QSemaphore>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+#include <QtGui/QPaintEngine>
+#include <QtGui/QPicture>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define QCP_SSE2
+#  include <emmintrin.h>
+#endif
+
 
 /* including file 'src/vector2d.cpp'       */
 /* modified 2022-11-06T12:45:56, size 7973 */
@@ -296,7 +308,8 @@ QCPVector2D &QCPVector2D::operator-=(const QCPVector2D &vector)
 */
 QCPPainter::QCPPainter() :
   mModes(pmDefault),
-  mIsAntialiasing(false)
+  mIsAntialiasing(false),
+  mReplayDevicePixelRatio(0)
 {
   // don't setRenderHint(QPainter::NonCosmeticDefautPen) here, because painter isn't active yet and
   // a call to begin() will follow
@@ -311,7 +324,8 @@ QCPPainter::QCPPainter() :
 QCPPainter::QCPPainter(QPaintDevice *device) :
   QPainter(device),
   mModes(pmDefault),
-  mIsAntialiasing(false)
+  mIsAntialiasing(false),
+  mReplayDevicePixelRatio(0)
 {
 #if QT_VERSION < QT_VERSION_CHECK(5, 0, 0) // before Qt5, default pens used to be cosmetic if NonCosmeticDefaultPen flag isn't set. So we set it to get consistency across Qt versions.
   if (isActive())
@@ -441,6 +455,18 @@ void QCPPainter::setMode(QCPPainter::PainterMode mode, bool enabled)
     mModes |= mode;
 }
 
+/*!
+  Declares that this painter records into a QPicture which is later replayed on a raster image
+  with the device pixel ratio \a ratio, like the asynchronous replot does (see \ref
+  QCustomPlot::setAsyncReplot). This allows raster optimizations such as scatter sprites (\ref
+  QCPScatterStyle::drawShapes) and cached tick labels (\ref QCPLabelCache) despite \ref
+  pmNoCaching. The default 0 means the replay target is unknown.
+*/
+void QCPPainter::setReplayDevicePixelRatio(double ratio)
+{
+  mReplayDevicePixelRatio = ratio;
+}
+
 /*!
   Saves the painter (see QPainter::save). Since QCPPainter adds some new internal state to
   QPainter, the save/restore functions are reimplemented to also save/restore those members.
@@ -720,6 +746,93 @@ void QCPPaintBufferPixmap::reallocateBuffer()
 }
 
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPPaintBufferImage
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPPaintBufferImage
+  \brief A paint buffer based on QImage, using software raster rendering
+
+  This paint buffer is used instead of \ref QCPPaintBufferPixmap if \ref
+  QCustomPlot::setAsyncReplot is true. Other than QPixmap, a QImage may be painted on outside the
+  GUI thread, so the layers can be rasterized by worker threads. The finished images are then
+  exchanged with the displayed one via \ref swapImage.
+*/
+
+/*!
+  Creates an image paint buffer instance with the specified \a size and \a devicePixelRatio, if
+  applicable.
+*/
+QCPPaintBufferImage::QCPPaintBufferImage(const QSize &size, double devicePixelRatio) :
+  QCPAbstractPaintBuffer(size, devicePixelRatio)
+{
+  QCPPaintBufferImage::reallocateBuffer();
+}
+
+QCPPaintBufferImage::~QCPPaintBufferImage()
+{
+}
+
+/* inherits documentation from base class */
+QCPPainter *QCPPaintBufferImage::startPainting()
+{
+  QCPPainter *result = new QCPPainter(&mBuffer);
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+  result->setRenderHint(QPainter::HighQualityAntialiasing);
+#endif
+  return result;
+}
+
+/* inherits documentation from base class */
+void QCPPaintBufferImage::draw(QCPPainter *painter) const
+{
+  if (painter && painter->isActive())
+    painter->drawImage(0, 0, mBuffer);
+  else
+    qDebug() << Q_FUNC_INFO << "invalid or inactive painter passed";
+}
+
+/* inherits documentation from base class */
+void QCPPaintBufferImage::clear(const QColor &color)
+{
+  mBuffer.fill(color);
+}
+
+/*!
+  Exchanges the buffer contents with \a image. The caller is responsible for \a image having the
+  size and device pixel ratio of this buffer.
+
+  This is used by the asynchronous replot (\ref QCustomPlot::setAsyncReplot) to show a frame that
+  was rasterized by a worker thread. The previous contents are returned in \a image, so the next
+  frame can render into them without allocating a new image.
+*/
+void QCPPaintBufferImage::swapImage(QImage &image)
+{
+  mBuffer.swap(image);
+}
+
+/* inherits documentation from base class */
+void QCPPaintBufferImage::reallocateBuffer()
+{
+  setInvalidated();
+  if (!qFuzzyCompare(1.0, mDevicePixelRatio))
+  {
+#ifdef QCP_DEVICEPIXELRATIO_SUPPORTED
+    mBuffer = QImage(mSize*mDevicePixelRatio, QImage::Format_ARGB32_Premultiplied);
+    mBuffer.setDevicePixelRatio(mDevicePixelRatio);
+#else
+    qDebug() << Q_FUNC_INFO << "Device pixel ratios not supported for Qt versions before 5.4";
+    mDevicePixelRatio = 1.0;
+    mBuffer = QImage(mSize, QImage::Format_ARGB32_Premultiplied);
+#endif
+  } else
+  {
+    mBuffer = QImage(mSize, QImage::Format_ARGB32_Premultiplied);
+  }
+  mBuffer.fill(Qt::transparent); // asynchronous replots show the buffer before the first frame arrives
+}
+
+
 #ifdef QCP_OPENGL_PBUFFER
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////// QCPPaintBufferGlPbuffer
@@ -1070,7 +1183,8 @@ QCPLayer::QCPLayer(QCustomPlot *parentPlot, const QString &layerName) :
   mName(layerName),
   mIndex(-1), // will be set to a proper value by the QCustomPlot layer creation function
   mVisible(true),
-  mMode(lmLogical)
+  mMode(lmLogical),
+  mDirty(true)
 {
   // Note: no need to make sure layerName is unique, because layer
   // management is done with QCustomPlot functions.
@@ -1100,7 +1214,11 @@ QCPLayer::~QCPLayer()
 */
 void QCPLayer::setVisible(bool visible)
 {
-  mVisible = visible;
+  if (mVisible != visible)
+  {
+    mVisible = visible;
+    markDirty();
+  }
 }
 
 /*!
@@ -1134,6 +1252,19 @@ void QCPLayer::setMode(QCPLayer::LayerMode mode)
   }
 }
 
+/*!
+  Marks this layer as changed, so its paint buffer is redrawn by the next \ref QCustomPlot::replot
+  even if the \ref QCP::phDirtyLayers plotting hint is set and none of its layerables reports a
+  changed \ref QCPLayerable::contentVersion.
+
+  Use this (or \ref QCPLayerable::markDirty) after changing something the dirty tracking can't
+  detect, e.g. the settings of an axis ticker or a selection decorator.
+*/
+void QCPLayer::markDirty()
+{
+  mDirty = true;
+}
+
 /*! \internal
 
   Draws the contents of this layer with the provided \a painter.
@@ -1142,10 +1273,12 @@ void QCPLayer::setMode(QCPLayer::LayerMode mode)
 */
 void QCPLayer::draw(QCPPainter *painter)
 {
+  QCPReplotProfiler::Scope scope(mParentPlot->profiler(), this);
   foreach (QCPLayerable *child, mChildren)
   {
     if (child->realVisibility())
     {
+      QCPReplotProfiler::Scope childScope(mParentPlot->profiler(), child);
       painter->save();
       painter->setClipRect(child->clipRect().translated(0, -1));
       child->applyDefaultAntialiasingHint(painter);
@@ -1191,13 +1324,14 @@ void QCPLayer::drawToPaintBuffer()
   buffers were thus invalidated.
 
   If the layer mode is \ref lmLogical however, this method simply calls \ref QCustomPlot::replot on
-  the parent QCustomPlot instance.
+  the parent QCustomPlot instance. The same happens while an asynchronous replot is being rendered
+  (\ref QCustomPlot::setAsyncReplot), because the finished frame would overwrite this layer again.
 
   \see draw
 */
 void QCPLayer::replot()
 {
-  if (mMode == lmBuffered && !mParentPlot->hasInvalidatedPaintBuffers())
+  if (mMode == lmBuffered && !mParentPlot->hasInvalidatedPaintBuffers() && !mParentPlot->isRendering())
   {
     if (QSharedPointer<QCPAbstractPaintBuffer> pb = mPaintBuffer.toStrongRef())
     {
@@ -1287,6 +1421,14 @@ void QCPLayer::removeChild(QCPLayerable *layerable)
   set manually by the user.
 */
 
+/*! \fn quint64 QCPLayerable::propertyVersion() const
+
+  Returns a counter that is increased by \ref markDirty, i.e. whenever a property of this
+  layerable changes.
+
+  \see contentVersion
+*/
+
 /* end documentation of inline functions */
 /* start documentation of pure virtual functions */
 
@@ -1369,7 +1511,9 @@ QCPLayerable::QCPLayerable(QCustomPlot *plot, QString targetLayer, QCPLayerable
   mParentPlot(plot),
   mParentLayerable(parentLayerable),
   mLayer(nullptr),
-  mAntialiased(true)
+  mAntialiased(true),
+  mPropertyVersion(0),
+  mDrawnContentVersion(0)
 {
   if (mParentPlot)
   {
@@ -1396,7 +1540,11 @@ QCPLayerable::~QCPLayerable()
 */
 void QCPLayerable::setVisible(bool on)
 {
-  mVisible = on;
+  if (mVisible != on)
+  {
+    mVisible = on;
+    markDirty();
+  }
 }
 
 /*!
@@ -1443,7 +1591,25 @@ bool QCPLayerable::setLayer(const QString &layerName)
 */
 void QCPLayerable::setAntialiased(bool enabled)
 {
-  mAntialiased = enabled;
+  if (mAntialiased != enabled)
+  {
+    mAntialiased = enabled;
+    markDirty();
+  }
+}
+
+/*!
+  Tells the parent plot that this layerable has to be redrawn, by increasing \ref propertyVersion
+  and thus \ref contentVersion. This only makes a difference if the \ref QCP::phDirtyLayers
+  plotting hint is set, see \ref QCustomPlot::replot.
+
+  The setters of the QCustomPlot layerables call this method, so it is only necessary to call it
+  manually for changes the layerable can't see itself, like changing the settings of a shared
+  axis ticker or of a selection decorator.
+*/
+void QCPLayerable::markDirty()
+{
+  ++mPropertyVersion;
 }
 
 /*!
@@ -1508,6 +1674,32 @@ double QCPLayerable::selectTest(const QPointF &pos, bool onlySelectable, QVarian
   return -1.0;
 }
 
+/*! \internal
+
+  Combines the content \a version of an object the caller depends on with \a seed. Unlike a plain
+  sum, exchanging one dependency for another one with a similar version (e.g. switching the key
+  axis of a plottable) still changes the result.
+*/
+static inline quint64 qcpCombineVersions(quint64 seed, quint64 version)
+{
+  return seed ^ (version + Q_UINT64_C(0x9e3779b97f4a7c15) + (seed << 6) + (seed >> 2));
+}
+
+/*!
+  Returns a value that changes whenever the appearance of this layerable changes. If the \ref
+  QCP::phDirtyLayers plotting hint is set, \ref QCustomPlot::replot only redraws the paint buffers
+  of layers which contain a layerable whose content version differs from the one at the last
+  replot.
+
+  The default implementation returns \ref propertyVersion. Subclasses whose appearance depends on
+  other objects (e.g. a plottable on its data and axes) reimplement this method and combine the
+  versions of those objects with their own.
+*/
+quint64 QCPLayerable::contentVersion() const
+{
+  return mPropertyVersion;
+}
+
 /*! \internal
   
   Sets the parent plot of this layerable. Use this function once to set the parent plot if you have
@@ -2883,6 +3075,7 @@ QCPRange QCPSelectionRect::range(const QCPAxis *axis) const
 void QCPSelectionRect::setPen(const QPen &pen)
 {
   mPen = pen;
+  markDirty();
 }
 
 /*!
@@ -2894,6 +3087,7 @@ void QCPSelectionRect::setPen(const QPen &pen)
 void QCPSelectionRect::setBrush(const QBrush &brush)
 {
   mBrush = brush;
+  markDirty();
 }
 
 /*!
@@ -2907,6 +3101,7 @@ void QCPSelectionRect::cancel()
     mActive = false;
     emit canceled(mRect, nullptr);
   }
+  markDirty();
 }
 
 /*! \internal
@@ -2920,6 +3115,7 @@ void QCPSelectionRect::startSelection(QMouseEvent *event)
   mActive = true;
   mRect = QRect(event->pos(), event->pos());
   emit started(event);
+  markDirty();
 }
 
 /*! \internal
@@ -2933,6 +3129,7 @@ void QCPSelectionRect::moveSelection(QMouseEvent *event)
   mRect.setBottomRight(event->pos());
   emit changed(mRect, event);
   layer()->replot();
+  markDirty();
 }
 
 /*! \internal
@@ -2946,6 +3143,7 @@ void QCPSelectionRect::endSelection(QMouseEvent *event)
   mRect.setBottomRight(event->pos());
   mActive = false;
   emit accepted(mRect, event);
+  markDirty();
 }
 
 /*! \internal
@@ -2987,6 +3185,641 @@ void QCPSelectionRect::draw(QCPPainter *painter)
 /* end of 'src/selectionrect.cpp' */
 
 
+/* including file 'src/profiler.cpp'       */
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPReplotProfiler
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPReplotProfiler
+  \brief Records where the time of a replot is spent
+
+  Each QCustomPlot owns a profiler, accessible via \ref QCustomPlot::profiler. It is disabled by
+  default. Once enabled with \ref setEnabled, every \ref QCustomPlot::replot records a frame: a
+  tree of timed events covering \ref QCustomPlot::updateLayout and its layout phases, the tick
+  generation of each axis, the paint buffer setup, the drawing of each layer and of each layerable
+  on it, and the rendering of the axis labels. The compositing in \ref QCustomPlot::paintEvent and,
+  if \ref QCustomPlot::setAsyncReplot is enabled, the rasterization in the worker threads are
+  added to the frame of the replot they display.
+
+  The most recent frames are retained (see \ref setFrameCapacity). They can be inspected via \ref
+  frame and \ref lastFrame, summarized via \ref frameTimes and \ref statistics, or exported as a
+  Chrome trace event file via \ref toChromeTrace and \ref saveChromeTrace, which can be opened in
+  chrome://tracing or the Perfetto UI.
+
+  \ref setOverlayVisible places a \ref QCPProfilerOverlay on top of the plot, which shows the
+  frame times and the most expensive events while the plot is running.
+
+  Custom code, e.g. the \ref QCPLayerable::draw method of a custom plottable, can add own events
+  to the current frame with a \ref QCPReplotProfiler::Scope:
+  \code
+  QCPReplotProfiler::Scope scope(mParentPlot->profiler(), "expensive step");
+  \endcode
+
+  While disabled, the instrumentation of the replot pipeline only checks a flag. The profiler must
+  only be accessed from the GUI thread.
+*/
+
+/*!
+  Creates a disabled profiler for \a parentPlot. There is no need to create a profiler manually,
+  use the one returned by \ref QCustomPlot::profiler.
+*/
+QCPReplotProfiler::QCPReplotProfiler(QCustomPlot *parentPlot) :
+  mParentPlot(parentPlot),
+  mEnabled(false),
+  mFrameCapacity(120),
+  mFrameNumber(0),
+  mFrameOpen(false),
+  mDepth(0)
+{
+  mClock.start();
+}
+
+QCPReplotProfiler::~QCPReplotProfiler()
+{
+  delete mOverlay.data();
+}
+
+/*!
+  Sets whether replots are recorded. Disabling the profiler keeps the recorded frames, use \ref
+  clear to remove them.
+*/
+void QCPReplotProfiler::setEnabled(bool enabled)
+{
+  mEnabled = enabled;
+}
+
+/*!
+  Sets how many of the most recent frames are retained. Older frames are discarded.
+*/
+void QCPReplotProfiler::setFrameCapacity(int frames)
+{
+  mFrameCapacity = qMax(1, frames);
+  while (mFrames.size() > mFrameCapacity)
+    mFrames.removeFirst();
+}
+
+/*!
+  Sets whether a \ref QCPProfilerOverlay showing the recorded frames is drawn on top of the plot.
+  The overlay is placed on a layer named "profiler", which is created above all other layers if it
+  doesn't exist yet.
+
+  The overlay doesn't enable the profiler, see \ref setEnabled.
+*/
+void QCPReplotProfiler::setOverlayVisible(bool visible)
+{
+  if (visible && !mOverlay)
+  {
+    if (!mParentPlot->layer(QLatin1String("profiler")))
+    {
+      mParentPlot->addLayer(QLatin1String("profiler"), mParentPlot->layer(mParentPlot->layerCount()-1), QCustomPlot::limAbove);
+      mParentPlot->layer(QLatin1String("profiler"))->setMode(QCPLayer::lmBuffered);
+    }
+    mOverlay = new QCPProfilerOverlay(this);
+  } else if (!visible && mOverlay)
+    delete mOverlay.data();
+}
+
+/*!
+  Starts an event with the given \a name and \a category in the current frame and returns a handle
+  which must be passed to \ref end when the event is over. Events started before the matching \ref
+  end of another event become its children.
+
+  If the profiler is disabled, nothing is recorded and -1 is returned. Usually a \ref Scope is used
+  instead of calling this method directly.
+*/
+qint64 QCPReplotProfiler::begin(const QString &name, Category category)
+{
+  if (!mEnabled)
+    return -1;
+  if (mFrames.isEmpty()) // event outside of a replot, before the first recorded frame
+  {
+    Frame frame;
+    frame.number = ++mFrameNumber;
+    mFrames.append(frame);
+  }
+  Frame &frame = mFrames.last();
+  Event event;
+  event.name = name;
+  event.category = category;
+  event.depth = mDepth++;
+  event.thread = 0;
+  event.duration = -1;
+  event.start = timestamp();
+  frame.events.append(event);
+  return (qint64(frame.number) << 32) | (frame.events.size()-1);
+}
+
+/*!
+  Ends the event of \a handle, which was returned by \ref begin. Passing -1 does nothing.
+*/
+void QCPReplotProfiler::end(qint64 handle)
+{
+  const qint64 now = timestamp();
+  if (handle < 0)
+    return;
+  if (mDepth > 0)
+    --mDepth;
+  const int frameNumber = int(handle >> 32);
+  const int index = int(handle & 0xFFFFFFFF);
+  for (int i=mFrames.size()-1; i>=0; --i)
+  {
+    if (mFrames.at(i).number == frameNumber)
+    {
+      QVector<Event> &events = mFrames[i].events;
+      if (index < events.size() && events.at(index).duration < 0)
+        events[index].duration = now-events.at(index).start;
+      return;
+    }
+  }
+}
+
+/*!
+  Removes all recorded frames.
+*/
+void QCPReplotProfiler::clear()
+{
+  mFrames.clear();
+  mFrameOpen = false;
+  mWorkerThreads.clear();
+}
+
+/*!
+  Returns the number of retained frames whose replot has finished.
+
+  \see frame
+*/
+int QCPReplotProfiler::frameCount() const
+{
+  return mFrames.size()-(mFrameOpen ? 1 : 0);
+}
+
+/*!
+  Returns the events of the retained frame with \a index, ordered by their start in each thread.
+  Index 0 is the oldest frame, \ref frameCount - 1 the most recent one. Each event is followed by
+  its child events.
+
+  \see lastFrame
+*/
+QVector<QCPReplotProfiler::Event> QCPReplotProfiler::frame(int index) const
+{
+  if (index >= 0 && index < frameCount())
+    return mFrames.at(index).events;
+  return QVector<Event>();
+}
+
+/*!
+  Returns the events of the most recent frame whose replot has finished.
+
+  \see frame
+*/
+QVector<QCPReplotProfiler::Event> QCPReplotProfiler::lastFrame() const
+{
+  return frame(frameCount()-1);
+}
+
+/*!
+  Returns the duration of the replot of each retained frame in milliseconds, oldest first.
+*/
+QVector<double> QCPReplotProfiler::frameTimes() const
+{
+  QVector<double> result;
+  result.reserve(frameCount());
+  for (int i=0; i<frameCount(); ++i)
+  {
+    foreach (const Event &event, mFrames.at(i).events)
+    {
+      if (event.category == pcReplot && event.duration >= 0)
+      {
+        result.append(event.duration*1e-6);
+        break;
+      }
+    }
+  }
+  return result;
+}
+
+/*! \internal
+
+  Orders statistics by descending self time, used by \ref QCPReplotProfiler::statistics.
+*/
+static bool qcpMoreSelfTime(const QCPReplotProfiler::Statistics &a, const QCPReplotProfiler::Statistics &b)
+{
+  return a.self > b.self;
+}
+
+/*!
+  Accumulates the events of the \a frames most recent frames by name and category. If \a frames
+  is 0, all retained frames are used. The result is ordered by descending self time, so the first
+  entries are the sections which are expensive on their own rather than by their children.
+*/
+QList<QCPReplotProfiler::Statistics> QCPReplotProfiler::statistics(int frames) const
+{
+  QList<Statistics> result;
+  QHash<QPair<int, QString>, int> indices;
+  const int lastFrame = frameCount();
+  const int firstFrame = frames > 0 ? qMax(0, lastFrame-frames) : 0;
+  for (int i=firstFrame; i<lastFrame; ++i)
+  {
+    const QVector<Event> &events = mFrames.at(i).events;
+    QVector<qint64> childTime(events.size(), 0);
+    QVector<int> parents; // open ancestors of the current GUI thread event
+    for (int k=0; k<events.size(); ++k)
+    {
+      const Event &event = events.at(k);
+      if (event.thread != 0 || event.duration < 0)
+        continue;
+      while (!parents.isEmpty() && events.at(parents.last()).depth >= event.depth)
+        parents.removeLast();
+      if (!parents.isEmpty())
+        childTime[parents.last()] += event.duration;
+      parents.append(k);
+    }
+    for (int k=0; k<events.size(); ++k)
+    {
+      const Event &event = events.at(k);
+      if (event.duration < 0)
+        continue;
+      const QPair<int, QString> key(event.category, event.name);
+      QHash<QPair<int, QString>, int>::const_iterator it = indices.constFind(key);
+      if (it == indices.constEnd())
+      {
+        Statistics statistics;
+        statistics.name = event.name;
+        statistics.category = event.category;
+        statistics.count = 0;
+        statistics.total = 0;
+        statistics.self = 0;
+        statistics.maximum = 0;
+        it = indices.insert(key, result.size());
+        result.append(statistics);
+      }
+      Statistics &statistics = result[it.value()];
+      ++statistics.count;
+      statistics.total += event.duration*1e-6;
+      statistics.self += qMax(qint64(0), event.duration-childTime.at(k))*1e-6;
+      statistics.maximum = qMax(statistics.maximum, event.duration*1e-6);
+    }
+  }
+  std::sort(result.begin(), result.end(), qcpMoreSelfTime);
+  return result;
+}
+
+/*! \internal
+
+  Returns \a text as a quoted JSON string, used by \ref QCPReplotProfiler::toChromeTrace.
+*/
+static QByteArray qcpJsonString(const QString &text)
+{
+  QString result;
+  result.reserve(text.size()+2);
+  result += QLatin1Char('"');
+  foreach (QChar c, text)
+  {
+    if (c == QLatin1Char('"') || c == QLatin1Char('\\'))
+    {
+      result += QLatin1Char('\\');
+      result += c;
+    } else if (c.unicode() < 0x20)
+      result += QString(QLatin1String("\\u%1")).arg(c.unicode(), 4, 16, QLatin1Char('0'));
+    else
+      result += c;
+  }
+  result += QLatin1Char('"');
+  return result.toUtf8();
+}
+
+/*!
+  Returns the retained frames in the Chrome trace event format (JSON), which can be opened in
+  chrome://tracing or the Perfetto UI. Each event is a complete ("X") event with its category (\ref
+  categoryName) and the number of its frame as argument. The GUI thread is reported as thread 0,
+  the worker threads of asynchronous replots as threads 1 and up.
+
+  \see saveChromeTrace
+*/
+QByteArray QCPReplotProfiler::toChromeTrace() const
+{
+  const QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+  QByteArray result("{\"traceEvents\":[\n");
+  result.append("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":"+pid+",\"tid\":0,\"args\":{\"name\":\"GUI\"}}");
+  for (int i=0; i<mWorkerThreads.size(); ++i)
+  {
+    const QByteArray tid = QByteArray::number(i+1);
+    result.append(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":"+pid+",\"tid\":"+tid+",\"args\":{\"name\":\"worker "+tid+"\"}}");
+  }
+  foreach (const Frame &frame, mFrames)
+  {
+    const QByteArray frameNumber = QByteArray::number(frame.number);
+    foreach (const Event &event, frame.events)
+    {
+      if (event.duration < 0)
+        continue;
+      result.append(",\n{\"name\":"+qcpJsonString(event.name)+
+                    ",\"cat\":"+qcpJsonString(categoryName(event.category))+
+                    ",\"ph\":\"X\",\"ts\":"+QByteArray::number(event.start*1e-3, 'f', 3)+
+                    ",\"dur\":"+QByteArray::number(event.duration*1e-3, 'f', 3)+
+                    ",\"pid\":"+pid+",\"tid\":"+QByteArray::number(event.thread)+
+                    ",\"args\":{\"frame\":"+frameNumber+"}}");
+    }
+  }
+  result.append("\n],\"displayTimeUnit\":\"ms\"}\n");
+  return result;
+}
+
+/*!
+  Writes \ref toChromeTrace to the file \a fileName. Returns false if the file couldn't be written.
+*/
+bool QCPReplotProfiler::saveChromeTrace(const QString &fileName) const
+{
+  QFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+  {
+    qDebug() << Q_FUNC_INFO << "couldn't open file" << fileName;
+    return false;
+  }
+  const QByteArray trace = toChromeTrace();
+  return file.write(trace) == trace.size();
+}
+
+/*!
+  Returns the name of \a category as used in \ref toChromeTrace.
+*/
+QString QCPReplotProfiler::categoryName(Category category)
+{
+  switch (category)
+  {
+    case pcReplot:    return QLatin1String("replot");
+    case pcLayout:    return QLatin1String("layout");
+    case pcTicks:     return QLatin1String("ticks");
+    case pcBuffers:   return QLatin1String("buffers");
+    case pcLayer:     return QLatin1String("layer");
+    case pcLayerable: return QLatin1String("layerable");
+    case pcLabels:    return QLatin1String("labels");
+    case pcComposite: return QLatin1String("composite");
+    case pcWorker:    return QLatin1String("worker");
+    case pcUser:      return QLatin1String("user");
+  }
+  return QString();
+}
+
+/*! \internal
+
+  Starts a new frame and its root event. Called by \ref QCustomPlot::replot, which passes the
+  returned handle to \ref endFrame when it's done.
+*/
+qint64 QCPReplotProfiler::beginFrame()
+{
+  if (!mEnabled)
+    return -1;
+  Frame frame;
+  frame.number = ++mFrameNumber;
+  mFrames.append(frame);
+  while (mFrames.size() > mFrameCapacity)
+    mFrames.removeFirst();
+  mFrameOpen = true;
+  return begin(QLatin1String("QCustomPlot::replot"), pcReplot);
+}
+
+/*! \internal
+
+  Ends the frame started by \ref beginFrame. Events recorded after this, e.g. by \ref
+  QCustomPlot::paintEvent, are added to this frame until the next one begins.
+*/
+void QCPReplotProfiler::endFrame(qint64 handle)
+{
+  end(handle);
+  mFrameOpen = false;
+}
+
+/*! \internal
+
+  Adds an event of a worker thread to the frame with \a frameNumber, if it is still retained.
+  \a start and \a end are timestamps of the profiler clock. \a thread identifies the worker, the
+  workers are numbered in the order they were first reported.
+*/
+void QCPReplotProfiler::addWorkerEvent(int frameNumber, const QString &name, Qt::HANDLE thread, qint64 start, qint64 end)
+{
+  for (int i=mFrames.size()-1; i>=0; --i)
+  {
+    if (mFrames.at(i).number == frameNumber)
+    {
+      int threadIndex = mWorkerThreads.indexOf(thread);
+      if (threadIndex < 0)
+      {
+        threadIndex = mWorkerThreads.size();
+        mWorkerThreads.append(thread);
+      }
+      Event event;
+      event.name = name;
+      event.category = pcWorker;
+      event.depth = 0;
+      event.thread = threadIndex+1;
+      event.start = start;
+      event.duration = end-start;
+      mFrames[i].events.append(event);
+      return;
+    }
+  }
+}
+
+/*! \internal
+
+  Returns the event name of \a layerable: its class name, followed by the name of a plottable, the
+  side of an axis or the object name, if available.
+*/
+QString QCPReplotProfiler::eventName(const QCPLayerable *layerable)
+{
+  if (!layerable)
+    return QString();
+  QString result = QLatin1String(layerable->metaObject()->className());
+  if (const QCPAbstractPlottable *plottable = qobject_cast<const QCPAbstractPlottable*>(layerable))
+  {
+    if (!plottable->name().isEmpty())
+      result += QLatin1String(" \"") + plottable->name() + QLatin1Char('"');
+  } else if (const QCPAxis *axis = qobject_cast<const QCPAxis*>(layerable))
+  {
+    switch (axis->axisType())
+    {
+      case QCPAxis::atLeft:   result += QLatin1String(" (left)"); break;
+      case QCPAxis::atRight:  result += QLatin1String(" (right)"); break;
+      case QCPAxis::atTop:    result += QLatin1String(" (top)"); break;
+      case QCPAxis::atBottom: result += QLatin1String(" (bottom)"); break;
+    }
+  } else if (!layerable->objectName().isEmpty())
+    result += QLatin1String(" \"") + layerable->objectName() + QLatin1Char('"');
+  return result;
+}
+
+/*! \internal
+
+  Returns the event name of \a layer.
+*/
+QString QCPReplotProfiler::eventName(const QCPLayer *layer)
+{
+  if (!layer)
+    return QString();
+  return QLatin1String("layer \"") + layer->name() + QLatin1Char('"');
+}
+
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPProfilerOverlay
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPProfilerOverlay
+  \brief Shows the frames recorded by a QCPReplotProfiler on top of the plot
+
+  The overlay is created by \ref QCPReplotProfiler::setOverlayVisible. It draws a box in the top
+  left corner of the viewport with the replot time of the last frame, the average and maximum over
+  the retained frames and a bar chart of the recent frame times. Below, the \ref setEntryCount
+  events with the highest self time per frame are listed (see \ref
+  QCPReplotProfiler::statistics).
+
+  The overlay shows the frames up to the previous replot, since the current one is still being
+  recorded while the overlay is drawn.
+*/
+
+/*!
+  Creates an overlay for \a profiler on the layer "profiler". Usually the overlay is created by
+  \ref QCPReplotProfiler::setOverlayVisible.
+*/
+QCPProfilerOverlay::QCPProfilerOverlay(QCPReplotProfiler *profiler) :
+  QCPLayerable(profiler->parentPlot(), QLatin1String("profiler")),
+  mProfiler(profiler),
+  mEntryCount(8),
+  mFont(profiler->parentPlot()->font()),
+  mStatisticsFrame(-1)
+{
+  mFont.setPointSizeF(qMax(6.0, mFont.pointSizeF()*0.85));
+}
+
+QCPProfilerOverlay::~QCPProfilerOverlay()
+{
+}
+
+/*!
+  Sets how many of the most expensive events are listed below the frame times.
+*/
+void QCPProfilerOverlay::setEntryCount(int count)
+{
+  mEntryCount = qMax(0, count);
+  mStatisticsFrame = -1;
+  markDirty();
+}
+
+/*!
+  Sets the font of the overlay text.
+*/
+void QCPProfilerOverlay::setFont(const QFont &font)
+{
+  mFont = font;
+  markDirty();
+}
+
+/*!
+  Changes with every frame the profiler records, so the overlay is redrawn by each replot even if
+  the \ref QCP::phDirtyLayers plotting hint is set.
+
+  \seebaseclassmethod
+*/
+quint64 QCPProfilerOverlay::contentVersion() const
+{
+  return qcpCombineVersions(QCPLayerable::contentVersion(), quint64(mProfiler->mFrameNumber));
+}
+
+/* inherits documentation from base class */
+void QCPProfilerOverlay::applyDefaultAntialiasingHint(QCPPainter *painter) const
+{
+  applyAntialiasingHint(painter, mAntialiased, QCP::aeOther);
+}
+
+/*! \internal
+
+  Draws the frame times and the most expensive events of the profiler.
+
+  The event list only changes when the profiler records a new frame, so it is computed once per
+  recorded frame and reused by further replots (e.g. of other layers) in between.
+
+  \seebaseclassmethod
+*/
+void QCPProfilerOverlay::draw(QCPPainter *painter)
+{
+  const QVector<double> times = mProfiler->frameTimes();
+  QStringList lines;
+  if (times.isEmpty())
+    lines << QLatin1String(mProfiler->enabled() ? "no frames recorded yet" : "profiler disabled");
+  else
+  {
+    double sum = 0, maximum = 0;
+    foreach (double time, times)
+    {
+      sum += time;
+      maximum = qMax(maximum, time);
+    }
+    lines << QString(QLatin1String("replot %1 ms  avg %2 ms  max %3 ms")).arg(times.last(), 0, 'f', 2).arg(sum/times.size(), 0, 'f', 2).arg(maximum, 0, 'f', 2);
+    if (mStatisticsFrame != mProfiler->mFrameNumber)
+    {
+      mStatisticsFrame = mProfiler->mFrameNumber;
+      mStatisticsLines.clear();
+      const int frames = mProfiler->frameCount();
+      const QList<QCPReplotProfiler::Statistics> statistics = mProfiler->statistics();
+      for (int i=0; i<qMin(mEntryCount, statistics.size()); ++i)
+      {
+        const QCPReplotProfiler::Statistics &entry = statistics.at(i);
+        QString name = entry.name;
+        if (name.size() > 40)
+          name = name.left(39) + QChar(0x2026); // ellipsis
+        mStatisticsLines << QString(QLatin1String("%1 ms  %2")).arg(entry.self/frames, 6, 'f', 2).arg(name);
+      }
+    }
+    lines << mStatisticsLines;
+  }
+  
+  painter->setFont(mFont);
+  const QFontMetrics metrics = painter->fontMetrics();
+  const int padding = 6;
+  const int lineHeight = metrics.height();
+  const int chartHeight = times.isEmpty() ? 0 : 3*lineHeight;
+  int textWidth = 120;
+  foreach (const QString &line, lines)
+    textWidth = qMax(textWidth, metrics.boundingRect(line).width());
+  const QRect box(mParentPlot->viewport().topLeft()+QPoint(8, 8),
+                  QSize(textWidth+2*padding, lines.size()*lineHeight+chartHeight+(chartHeight > 0 ? padding : 0)+2*padding));
+  painter->setPen(QPen(QColor(120, 120, 120)));
+  painter->setBrush(QColor(255, 255, 255, 220));
+  painter->drawRect(box);
+  
+  int y = box.top()+padding;
+  painter->setPen(QPen(Qt::black));
+  painter->drawText(QRect(box.left()+padding, y, textWidth, lineHeight), Qt::AlignLeft | Qt::AlignVCenter, lines.first());
+  y += lineHeight;
+  if (chartHeight > 0) // bar chart of the frame times, newest on the right
+  {
+    y += padding/2;
+    double maximum = 0;
+    foreach (double time, times)
+      maximum = qMax(maximum, time);
+    const QRectF chart(box.left()+padding, y, textWidth, chartHeight);
+    const double barWidth = chart.width()/qMax(times.size(), 60);
+    painter->setPen(Qt::NoPen);
+    painter->setBrush(QColor(70, 130, 180));
+    for (int i=0; i<times.size(); ++i)
+    {
+      const double height = maximum > 0 ? times.at(i)/maximum*chart.height() : 0;
+      painter->drawRect(QRectF(chart.right()-(times.size()-i)*barWidth, chart.bottom()-height, qMax(1.0, barWidth-1), height));
+    }
+    y += chartHeight+padding/2;
+  }
+  painter->setPen(QPen(Qt::black));
+  for (int i=1; i<lines.size(); ++i)
+  {
+    painter->drawText(QRect(box.left()+padding, y, textWidth, lineHeight), Qt::AlignLeft | Qt::AlignVCenter, lines.at(i));
+    y += lineHeight;
+  }
+}
+/* end of 'src/profiler.cpp' */
+
+
 /* including file 'src/layout.cpp'          */
 /* modified 2022-11-06T12:45:56, size 78863 */
 
@@ -5458,6 +6291,178 @@ void QCPLineEnding::draw(QCPPainter *painter, const QCPVector2D &pos, double ang
 /* modified 2022-11-06T12:45:56, size 27519   */
 
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPLabelCache
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPLabelCache
+  \brief Process-wide cache of rasterized tick labels
+  
+  When the plotting hint \ref QCP::phCacheLabels is set, axes (including the axes of color scales)
+  and polar axes draw their tick labels from images that are kept in this cache. There is only one
+  instance, returned by \ref instance, which is shared by all axes of all QCustomPlot widgets in
+  the process. The key of a label contains the text and every parameter that affects its
+  rasterization, e.g. font, color, rotation and device pixel ratio. So axes with the same tick
+  label style share their labels, and changing a parameter doesn't require flushing the cache, the
+  labels with the old parameters are simply no longer used and are eventually evicted.
+  
+  The cache is bounded by the total size of the labels, see \ref setMaximumCost. The least
+  recently used labels are evicted first. \ref statistics returns the number of hits and misses,
+  which shows how effective the cache is for a given application, e.g. during zoom animations.
+  
+  To avoid rasterizing the labels of the first replots, the cache may be filled in advance with
+  \ref QCPAxis::prewarmTickLabels.
+  
+  The labels are rasterized into images. Raster painters draw a pixmap that is converted from the
+  image once, while painters recording an asynchronous replot (\ref QCustomPlot::setAsyncReplot)
+  draw the image itself, so the labels are not rasterized from text again in every frame of a zoom
+  animation. Since it also holds pixmaps, the cache may only be used from the GUI thread.
+*/
+
+/*! \internal
+  
+  Removes the cached labels when the application object is destroyed, because pixmaps must not
+  outlive it.
+*/
+static void qcpClearLabelCache()
+{
+  QCPLabelCache::instance()->clear();
+}
+
+/*!
+  Returns the cache instance shared by all axes and plots.
+*/
+QCPLabelCache *QCPLabelCache::instance()
+{
+  static QCPLabelCache cache;
+  return &cache;
+}
+
+/*! \internal
+  
+  Constructs the cache with a maximum cost of 4 megabytes. Use \ref instance to access the cache.
+*/
+QCPLabelCache::QCPLabelCache() :
+  mLabels(4096),
+  mHits(0),
+  mMisses(0)
+{
+  qAddPostRoutine(qcpClearLabelCache);
+}
+
+/*!
+  Returns the number of hits and misses since the last call of \ref resetStatistics, as well as the
+  number of labels currently held and their total size.
+*/
+QCPLabelCache::Statistics QCPLabelCache::statistics() const
+{
+  Statistics result;
+  result.hits = mHits;
+  result.misses = mMisses;
+  result.labelCount = mLabels.count();
+  result.totalCost = mLabels.totalCost();
+  return result;
+}
+
+/*!
+  Sets the maximum total size of the cached labels in \a kilobytes. If the cache currently
+  holds more, the least recently used labels are evicted.
+*/
+void QCPLabelCache::setMaximumCost(int kilobytes)
+{
+  mLabels.setMaxCost(qMax(0, kilobytes));
+}
+
+/*!
+  Returns whether labels drawn with \a painter may come from the cache. This is the case for all
+  painters except those in \ref QCPPainter::pmNoCaching mode (e.g. exports), unless they record an
+  asynchronous replot that is replayed on raster images (see \ref
+  QCPPainter::setReplayDevicePixelRatio).
+*/
+bool QCPLabelCache::supports(const QCPPainter *painter)
+{
+  if (!painter->modes().testFlag(QCPPainter::pmNoCaching))
+    return true;
+  return painter->replayDevicePixelRatio() > 0 && painter->paintEngine() && painter->paintEngine()->type() == QPaintEngine::Picture;
+}
+
+/*!
+  Looks up the label stored under \a key. If it exists, it is copied to \a label and true is
+  returned. The image and pixmap are implicitly shared, so the copy is cheap and stays valid even if
+  the label is evicted afterwards.
+  
+  If \a countStatistics is false, the lookup isn't counted as hit or miss, which is useful for
+  lookups that don't lead to a rasterization on a miss, e.g. when only the size of the label is
+  needed.
+*/
+bool QCPLabelCache::find(const QByteArray &key, Label *label, bool countStatistics)
+{
+  if (const Label *cachedLabel = mLabels.object(key))
+  {
+    if (countStatistics)
+      ++mHits;
+    *label = *cachedLabel;
+    return true;
+  }
+  if (countStatistics)
+    ++mMisses;
+  return false;
+}
+
+/*!
+  Stores \a label under \a key, replacing a label that already exists with the same key. The cost
+  of the label is the size of its image and pixmap in kilobytes.
+*/
+void QCPLabelCache::insert(const QByteArray &key, const Label &label)
+{
+  const int cost = qMax(1, label.image.width()*label.image.height()*label.image.depth()*2/(8*1024));
+  mLabels.insert(key, new Label(label), cost);
+}
+
+/*!
+  Draws \a label, which was returned by \ref find for \a key, with \a painter such that its anchor
+  is at \a pos.
+  
+  A painter that records an asynchronous replot draws the image, which the recorded QPicture only
+  references, so the worker threads that replay it never touch a pixmap. Other painters draw the
+  pixmap of the label, which is converted from the image the first time and then kept in the cache.
+*/
+void QCPLabelCache::draw(QCPPainter *painter, const QPointF &pos, const QByteArray &key, const Label &label)
+{
+  if (painter->replayDevicePixelRatio() > 0 && painter->paintEngine() && painter->paintEngine()->type() == QPaintEngine::Picture)
+  {
+    painter->drawImage(QRectF(pos+label.offset, QSizeF(label.image.size())/painter->replayDevicePixelRatio()), label.image);
+    return;
+  }
+  QPixmap pixmap = label.pixmap;
+  if (pixmap.isNull())
+  {
+    pixmap = QPixmap::fromImage(label.image);
+    if (Label *cachedLabel = mLabels.object(key))
+      cachedLabel->pixmap = pixmap;
+  }
+  painter->drawPixmap(pos+label.offset, pixmap);
+}
+
+/*!
+  Removes all labels from the cache. They are rasterized again the next time they are drawn. The
+  statistics are not reset, see \ref resetStatistics.
+*/
+void QCPLabelCache::clear()
+{
+  mLabels.clear();
+}
+
+/*!
+  Sets the hit and miss counters returned by \ref statistics to zero.
+*/
+void QCPLabelCache::resetStatistics()
+{
+  mHits = 0;
+  mMisses = 0;
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////// QCPLabelPainterPrivate
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -5491,8 +6496,7 @@ QCPLabelPainterPrivate::QCPLabelPainterPrivate(QCustomPlot *parentPlot) :
   mSubstituteExponent(true),
   mMultiplicationSymbol(QChar(215)),
   mAbbreviateDecimalPowers(false),
-  mParentPlot(parentPlot),
-  mLabelCache(16)
+  mParentPlot(parentPlot)
 {
   analyzeFontMetrics();
 }
@@ -5526,6 +6530,7 @@ void QCPLabelPainterPrivate::setFont(const QFont &font)
   if (mFont != font)
   {
     mFont = font;
+    mLabelParameterHash.clear();
     analyzeFontMetrics();
   }
 }
@@ -5548,26 +6553,19 @@ void QCPLabelPainterPrivate::setRotation(double rotation)
 void QCPLabelPainterPrivate::setSubstituteExponent(bool enabled)
 {
   mSubstituteExponent = enabled;
+  mLabelParameterHash.clear();
 }
 
 void QCPLabelPainterPrivate::setMultiplicationSymbol(QChar symbol)
 {
   mMultiplicationSymbol = symbol;
+  mLabelParameterHash.clear();
 }
 
 void QCPLabelPainterPrivate::setAbbreviateDecimalPowers(bool enabled)
 {
   mAbbreviateDecimalPowers = enabled;
-}
-
-void QCPLabelPainterPrivate::setCacheSize(int labelCount)
-{
-  mLabelCache.setMaxCost(labelCount);
-}
-
-int QCPLabelPainterPrivate::cacheSize() const
-{
-  return mLabelCache.maxCost();
+  mLabelParameterHash.clear();
 }
 
 void QCPLabelPainterPrivate::drawTickLabel(QCPPainter *painter, const QPointF &tickPos, const QString &text)
@@ -5632,32 +6630,32 @@ int QCPLabelPainterPrivate::size() const
 
 /*! \internal
   
-  Clears the internal label cache. Upon the next \ref draw, all labels will be created new. This
-  method is called automatically if any parameters have changed that invalidate the cached labels,
-  such as font, color, etc. Usually you won't need to call this method manually.
+  Removes all labels from the shared \ref QCPLabelCache, so they are created new when they are
+  drawn the next time. Since the cache keys contain all label parameters, this is not necessary
+  when parameters such as font or color change. Note that this also affects the labels of all
+  other axes.
 */
 void QCPLabelPainterPrivate::clearCache()
 {
-  mLabelCache.clear();
+  mLabelParameterHash.clear();
+  QCPLabelCache::instance()->clear();
 }
 
 /*! \internal
   
-  Returns a hash that allows uniquely identifying whether the label parameters have changed such
-  that the cached labels must be refreshed (\ref clearCache). It is used in \ref draw. If the
-  return value of this method hasn't changed since the last redraw, the respective label parameters
-  haven't changed and cached labels may be used.
+  Returns a byte array that identifies the label parameters which are the same for all labels of
+  this label painter, like the font and the number format. It is the prefix of the keys under
+  which the labels are stored in the shared \ref QCPLabelCache, the parameters which may vary
+  from label to label are appended in \ref cacheKey. The result is kept in \a
+  mLabelParameterHash, which the respective setters clear.
 */
 QByteArray QCPLabelPainterPrivate::generateLabelParameterHash() const
 {
-  QByteArray result;
-  result.append(QByteArray::number(mParentPlot->bufferDevicePixelRatio()));
-  result.append(QByteArray::number(mRotation));
-  //result.append(QByteArray::number(int(tickLabelSide))); TODO: check whether this is really a cache-invalidating property
-  result.append(QByteArray::number(int(mSubstituteExponent)));
-  result.append(QString(mMultiplicationSymbol).toUtf8());
-  result.append(mColor.name().toLatin1()+QByteArray::number(mColor.alpha(), 16));
-  result.append(mFont.toString().toLatin1());
+  QByteArray result("label|");
+  result.append(QByteArray::number(int(mSubstituteExponent))+'|');
+  result.append(QString(mMultiplicationSymbol).toUtf8()+'|');
+  result.append(QByteArray::number(int(mAbbreviateDecimalPowers))+'|');
+  result.append(mFont.toString().toUtf8()+'|');
   return result;
 }
 
@@ -5686,14 +6684,17 @@ void QCPLabelPainterPrivate::drawLabelMaybeCached(QCPPainter *painter, const QFo
   if (text.isEmpty()) return;
   QSize finalSize;
 
-  if (mParentPlot->plottingHints().testFlag(QCP::phCacheLabels) && !painter->modes().testFlag(QCPPainter::pmNoCaching)) // label caching enabled
+  if (mParentPlot->plottingHints().testFlag(QCP::phCacheLabels) && QCPLabelCache::supports(painter)) // label caching enabled
   {
-    QByteArray key = cacheKey(text, color, rotation, side);
-    CachedLabel *cachedLabel = mLabelCache.take(QString::fromUtf8(key)); // attempt to take label from cache (don't use object() because we want ownership/prevent deletion during our operations, we re-insert it afterwards)
-    if (!cachedLabel)  // no cached label existed, create it
+    if (mLabelParameterHash.isEmpty())
+      mLabelParameterHash = generateLabelParameterHash();
+    const QByteArray key = cacheKey(text, color, rotation, side);
+    QCPLabelCache::Label cachedLabel;
+    if (!QCPLabelCache::instance()->find(key, &cachedLabel)) // no cached label existed, create it
     {
       LabelData labelData = getTickLabelData(font, color, rotation, side, text);
       cachedLabel = createCachedLabel(labelData);
+      QCPLabelCache::instance()->insert(key, cachedLabel);
     }
     // if label would be partly clipped by widget border on sides, don't draw it (only for outside tick labels):
     bool labelClippedByBorder = false;
@@ -5708,10 +6709,9 @@ void QCPLabelPainterPrivate::drawLabelMaybeCached(QCPPainter *painter, const QFo
     */
     if (!labelClippedByBorder)
     {
-      painter->drawPixmap(pos+cachedLabel->offset, cachedLabel->pixmap);
-      finalSize = cachedLabel->pixmap.size()/mParentPlot->bufferDevicePixelRatio(); // TODO: collect this in a member rect list?
+      QCPLabelCache::instance()->draw(painter, pos, key, cachedLabel);
+      finalSize = cachedLabel.image.size()/mParentPlot->bufferDevicePixelRatio(); // TODO: collect this in a member rect list?
     }
-    mLabelCache.insert(QString::fromUtf8(key), cachedLabel);
   } else // label caching disabled, draw text directly on surface:
   {
     LabelData labelData = getTickLabelData(font, color, rotation, side, text);
@@ -5957,40 +6957,40 @@ void QCPLabelPainterPrivate::getMaxTickLabelSize(const QFont &font, const QStrin
 }
 */
 
-QCPLabelPainterPrivate::CachedLabel *QCPLabelPainterPrivate::createCachedLabel(const LabelData &labelData) const
+QCPLabelCache::Label QCPLabelPainterPrivate::createCachedLabel(const LabelData &labelData) const
 {
-  CachedLabel *result = new CachedLabel;
+  QCPLabelCache::Label result;
   
-  // allocate pixmap with the correct size and pixel ratio:
-  if (!qFuzzyCompare(1.0, mParentPlot->bufferDevicePixelRatio()))
-  {
-    result->pixmap = QPixmap(labelData.rotatedTotalBounds.size()*mParentPlot->bufferDevicePixelRatio());
+  // allocate image with the correct size and pixel ratio:
+  result.image = QImage(labelData.rotatedTotalBounds.size()*mParentPlot->bufferDevicePixelRatio(), QImage::Format_ARGB32_Premultiplied);
 #ifdef QCP_DEVICEPIXELRATIO_SUPPORTED
-#  ifdef QCP_DEVICEPIXELRATIO_FLOAT
-    result->pixmap.setDevicePixelRatio(mParentPlot->devicePixelRatioF());
-#  else
-    result->pixmap.setDevicePixelRatio(mParentPlot->devicePixelRatio());
-#  endif
+  result.image.setDevicePixelRatio(mParentPlot->bufferDevicePixelRatio());
 #endif
-  } else
-    result->pixmap = QPixmap(labelData.rotatedTotalBounds.size());
-  result->pixmap.fill(Qt::transparent);
+  result.image.fill(Qt::transparent);
   
-  // draw the label into the pixmap
-  // offset is between label anchor and topleft of cache pixmap, so pixmap can be drawn at pos+offset to make the label anchor appear at pos.
+  // draw the label into the image
+  // offset is between label anchor and topleft of cache image, so image can be drawn at pos+offset to make the label anchor appear at pos.
   // We use rotatedTotalBounds.topLeft() because rotatedTotalBounds is in a coordinate system where the label anchor is at (0, 0)
-  result->offset = labelData.rotatedTotalBounds.topLeft();
-  QCPPainter cachePainter(&result->pixmap);
-  drawText(&cachePainter, -result->offset, labelData);
+  const QPoint offset = labelData.rotatedTotalBounds.topLeft();
+  result.offset = offset;
+  QCPPainter cachePainter(&result.image);
+  drawText(&cachePainter, -offset, labelData);
   return result;
 }
 
+/*! \internal
+  
+  Returns the key of the label with \a text in the shared \ref QCPLabelCache. It consists of \a
+  mLabelParameterHash and the parameters that may differ between the labels of this label painter.
+*/
 QByteArray QCPLabelPainterPrivate::cacheKey(const QString &text, const QColor &color, double rotation, AnchorSide side) const
 {
-  return text.toUtf8()+
-      QByteArray::number(color.red()+256*color.green()+65536*color.blue(), 36)+
-      QByteArray::number(color.alpha()+256*int(side), 36)+
-      QByteArray::number(int(rotation*100), 36);
+  return mLabelParameterHash+
+      QByteArray::number(mParentPlot->bufferDevicePixelRatio())+'|'+
+      QByteArray::number(color.rgba(), 36)+'|'+
+      QByteArray::number(int(side), 36)+'|'+
+      QByteArray::number(int(rotation*100), 36)+'|'+
+      text.toUtf8();
 }
 
 QCPLabelPainterPrivate::AnchorSide QCPLabelPainterPrivate::skewedAnchorSide(const QPointF &tickPos, double sideExpandHorz, double sideExpandVert) const
@@ -7882,6 +8882,7 @@ QCPGrid::QCPGrid(QCPAxis *parentAxis) :
 void QCPGrid::setSubGridVisible(bool visible)
 {
   mSubGridVisible = visible;
+  markDirty();
 }
 
 /*!
@@ -7890,6 +8891,7 @@ void QCPGrid::setSubGridVisible(bool visible)
 void QCPGrid::setAntialiasedSubGrid(bool enabled)
 {
   mAntialiasedSubGrid = enabled;
+  markDirty();
 }
 
 /*!
@@ -7898,6 +8900,7 @@ void QCPGrid::setAntialiasedSubGrid(bool enabled)
 void QCPGrid::setAntialiasedZeroLine(bool enabled)
 {
   mAntialiasedZeroLine = enabled;
+  markDirty();
 }
 
 /*!
@@ -7906,6 +8909,7 @@ void QCPGrid::setAntialiasedZeroLine(bool enabled)
 void QCPGrid::setPen(const QPen &pen)
 {
   mPen = pen;
+  markDirty();
 }
 
 /*!
@@ -7914,6 +8918,7 @@ void QCPGrid::setPen(const QPen &pen)
 void QCPGrid::setSubGridPen(const QPen &pen)
 {
   mSubGridPen = pen;
+  markDirty();
 }
 
 /*!
@@ -7925,6 +8930,18 @@ void QCPGrid::setSubGridPen(const QPen &pen)
 void QCPGrid::setZeroLinePen(const QPen &pen)
 {
   mZeroLinePen = pen;
+  markDirty();
+}
+
+/*!
+  Returns a value that changes whenever the properties of this grid or of its parent axis (e.g. its
+  range or tick positions) change.
+  
+  \seebaseclassmethod
+*/
+quint64 QCPGrid::contentVersion() const
+{
+  return qcpCombineVersions(QCPLayerable::contentVersion(), mParentAxis->contentVersion());
 }
 
 /*! \internal
@@ -8376,6 +9393,7 @@ void QCPAxis::setScaleType(QCPAxis::ScaleType type)
     mCachedMarginValid = false;
     emit scaleTypeChanged(mScaleType);
   }
+  markDirty();
 }
 
 /*!
@@ -8402,6 +9420,7 @@ void QCPAxis::setRange(const QCPRange &range)
   }
   emit rangeChanged(mRange);
   emit rangeChanged(mRange, oldRange);
+  markDirty();
 }
 
 /*!
@@ -8445,6 +9464,7 @@ void QCPAxis::setSelectedParts(const SelectableParts &selected)
     mSelectedParts = selected;
     emit selectionChanged(mSelectedParts);
   }
+  markDirty();
 }
 
 /*!
@@ -8474,6 +9494,7 @@ void QCPAxis::setRange(double lower, double upper)
   }
   emit rangeChanged(mRange);
   emit rangeChanged(mRange, oldRange);
+  markDirty();
 }
 
 /*!
@@ -8495,6 +9516,7 @@ void QCPAxis::setRange(double position, double size, Qt::AlignmentFlag alignment
     setRange(position-size, position);
   else // alignment == Qt::AlignCenter
     setRange(position-size/2.0, position+size/2.0);
+  markDirty();
 }
 
 /*!
@@ -8517,6 +9539,7 @@ void QCPAxis::setRangeLower(double lower)
   }
   emit rangeChanged(mRange);
   emit rangeChanged(mRange, oldRange);
+  markDirty();
 }
 
 /*!
@@ -8539,6 +9562,7 @@ void QCPAxis::setRangeUpper(double upper)
   }
   emit rangeChanged(mRange);
   emit rangeChanged(mRange, oldRange);
+  markDirty();
 }
 
 /*!
@@ -8553,6 +9577,7 @@ void QCPAxis::setRangeUpper(double upper)
 void QCPAxis::setRangeReversed(bool reversed)
 {
   mRangeReversed = reversed;
+  markDirty();
 }
 
 /*!
@@ -8575,6 +9600,7 @@ void QCPAxis::setTicker(QSharedPointer<QCPAxisTicker> ticker)
   else
     qDebug() << Q_FUNC_INFO << "can not set nullptr as axis ticker";
   // no need to invalidate margin cache here because produced tick labels are checked for changes in setupTickVector
+  markDirty();
 }
 
 /*!
@@ -8592,6 +9618,7 @@ void QCPAxis::setTicks(bool show)
     mTicks = show;
     mCachedMarginValid = false;
   }
+  markDirty();
 }
 
 /*!
@@ -8606,6 +9633,7 @@ void QCPAxis::setTickLabels(bool show)
     if (!mTickLabels)
       mTickVectorLabels.clear();
   }
+  markDirty();
 }
 
 /*!
@@ -8619,6 +9647,7 @@ void QCPAxis::setTickLabelPadding(int padding)
     mAxisPainter->tickLabelPadding = padding;
     mCachedMarginValid = false;
   }
+  markDirty();
 }
 
 /*!
@@ -8633,6 +9662,7 @@ void QCPAxis::setTickLabelFont(const QFont &font)
     mTickLabelFont = font;
     mCachedMarginValid = false;
   }
+  markDirty();
 }
 
 /*!
@@ -8643,6 +9673,7 @@ void QCPAxis::setTickLabelFont(const QFont &font)
 void QCPAxis::setTickLabelColor(const QColor &color)
 {
   mTickLabelColor = color;
+  markDirty();
 }
 
 /*!
@@ -8661,6 +9692,7 @@ void QCPAxis::setTickLabelRotation(double degrees)
     mAxisPainter->tickLabelRotation = qBound(-90.0, degrees, 90.0);
     mCachedMarginValid = false;
   }
+  markDirty();
 }
 
 /*!
@@ -8674,6 +9706,7 @@ void QCPAxis::setTickLabelSide(LabelSide side)
 {
   mAxisPainter->tickLabelSide = side;
   mCachedMarginValid = false;
+  markDirty();
 }
 
 /*!
@@ -8719,6 +9752,7 @@ void QCPAxis::setNumberFormat(const QString &formatCode)
     return;
   }
   mCachedMarginValid = false;
+  markDirty();
   
   // interpret first char as number format char:
   QString allowedFormatChars(QLatin1String("eEfgG"));
@@ -8778,6 +9812,7 @@ void QCPAxis::setNumberPrecision(int precision)
     mNumberPrecision = precision;
     mCachedMarginValid = false;
   }
+  markDirty();
 }
 
 /*!
@@ -8792,6 +9827,7 @@ void QCPAxis::setTickLength(int inside, int outside)
 {
   setTickLengthIn(inside);
   setTickLengthOut(outside);
+  markDirty();
 }
 
 /*!
@@ -8806,6 +9842,7 @@ void QCPAxis::setTickLengthIn(int inside)
   {
     mAxisPainter->tickLengthIn = inside;
   }
+  markDirty();
 }
 
 /*!
@@ -8822,6 +9859,7 @@ void QCPAxis::setTickLengthOut(int outside)
     mAxisPainter->tickLengthOut = outside;
     mCachedMarginValid = false; // only outside tick length can change margin
   }
+  markDirty();
 }
 
 /*!
@@ -8838,6 +9876,7 @@ void QCPAxis::setSubTicks(bool show)
     mSubTicks = show;
     mCachedMarginValid = false;
   }
+  markDirty();
 }
 
 /*!
@@ -8852,6 +9891,7 @@ void QCPAxis::setSubTickLength(int inside, int outside)
 {
   setSubTickLengthIn(inside);
   setSubTickLengthOut(outside);
+  markDirty();
 }
 
 /*!
@@ -8866,6 +9906,7 @@ void QCPAxis::setSubTickLengthIn(int inside)
   {
     mAxisPainter->subTickLengthIn = inside;
   }
+  markDirty();
 }
 
 /*!
@@ -8882,6 +9923,7 @@ void QCPAxis::setSubTickLengthOut(int outside)
     mAxisPainter->subTickLengthOut = outside;
     mCachedMarginValid = false; // only outside tick length can change margin
   }
+  markDirty();
 }
 
 /*!
@@ -8892,6 +9934,7 @@ void QCPAxis::setSubTickLengthOut(int outside)
 void QCPAxis::setBasePen(const QPen &pen)
 {
   mBasePen = pen;
+  markDirty();
 }
 
 /*!
@@ -8902,6 +9945,7 @@ void QCPAxis::setBasePen(const QPen &pen)
 void QCPAxis::setTickPen(const QPen &pen)
 {
   mTickPen = pen;
+  markDirty();
 }
 
 /*!
@@ -8912,6 +9956,7 @@ void QCPAxis::setTickPen(const QPen &pen)
 void QCPAxis::setSubTickPen(const QPen &pen)
 {
   mSubTickPen = pen;
+  markDirty();
 }
 
 /*!
@@ -8926,6 +9971,7 @@ void QCPAxis::setLabelFont(const QFont &font)
     mLabelFont = font;
     mCachedMarginValid = false;
   }
+  markDirty();
 }
 
 /*!
@@ -8936,6 +9982,7 @@ void QCPAxis::setLabelFont(const QFont &font)
 void QCPAxis::setLabelColor(const QColor &color)
 {
   mLabelColor = color;
+  markDirty();
 }
 
 /*!
@@ -8949,6 +9996,7 @@ void QCPAxis::setLabel(const QString &str)
     mLabel = str;
     mCachedMarginValid = false;
   }
+  markDirty();
 }
 
 /*!
@@ -8963,6 +10011,7 @@ void QCPAxis::setLabelPadding(int padding)
     mAxisPainter->labelPadding = padding;
     mCachedMarginValid = false;
   }
+  markDirty();
 }
 
 /*!
@@ -8982,6 +10031,7 @@ void QCPAxis::setPadding(int padding)
     mPadding = padding;
     mCachedMarginValid = false;
   }
+  markDirty();
 }
 
 /*!
@@ -8994,7 +10044,11 @@ void QCPAxis::setPadding(int padding)
 */
 void QCPAxis::setOffset(int offset)
 {
-  mAxisPainter->offset = offset;
+  if (mAxisPainter->offset != offset)
+  {
+    mAxisPainter->offset = offset;
+    markDirty();
+  }
 }
 
 /*!
@@ -9009,6 +10063,7 @@ void QCPAxis::setSelectedTickLabelFont(const QFont &font)
     mSelectedTickLabelFont = font;
     // don't set mCachedMarginValid to false here because margin calculation is always done with non-selected fonts
   }
+  markDirty();
 }
 
 /*!
@@ -9020,6 +10075,7 @@ void QCPAxis::setSelectedLabelFont(const QFont &font)
 {
   mSelectedLabelFont = font;
   // don't set mCachedMarginValid to false here because margin calculation is always done with non-selected fonts
+  markDirty();
 }
 
 /*!
@@ -9033,6 +10089,7 @@ void QCPAxis::setSelectedTickLabelColor(const QColor &color)
   {
     mSelectedTickLabelColor = color;
   }
+  markDirty();
 }
 
 /*!
@@ -9043,6 +10100,7 @@ void QCPAxis::setSelectedTickLabelColor(const QColor &color)
 void QCPAxis::setSelectedLabelColor(const QColor &color)
 {
   mSelectedLabelColor = color;
+  markDirty();
 }
 
 /*!
@@ -9053,6 +10111,7 @@ void QCPAxis::setSelectedLabelColor(const QColor &color)
 void QCPAxis::setSelectedBasePen(const QPen &pen)
 {
   mSelectedBasePen = pen;
+  markDirty();
 }
 
 /*!
@@ -9063,6 +10122,7 @@ void QCPAxis::setSelectedBasePen(const QPen &pen)
 void QCPAxis::setSelectedTickPen(const QPen &pen)
 {
   mSelectedTickPen = pen;
+  markDirty();
 }
 
 /*!
@@ -9073,6 +10133,7 @@ void QCPAxis::setSelectedTickPen(const QPen &pen)
 void QCPAxis::setSelectedSubTickPen(const QPen &pen)
 {
   mSelectedSubTickPen = pen;
+  markDirty();
 }
 
 /*!
@@ -9088,6 +10149,7 @@ void QCPAxis::setSelectedSubTickPen(const QPen &pen)
 void QCPAxis::setLowerEnding(const QCPLineEnding &ending)
 {
   mAxisPainter->lowerEnding = ending;
+  markDirty();
 }
 
 /*!
@@ -9103,6 +10165,7 @@ void QCPAxis::setLowerEnding(const QCPLineEnding &ending)
 void QCPAxis::setUpperEnding(const QCPLineEnding &ending)
 {
   mAxisPainter->upperEnding = ending;
+  markDirty();
 }
 
 /*!
@@ -9126,6 +10189,7 @@ void QCPAxis::moveRange(double diff)
   }
   emit rangeChanged(mRange);
   emit rangeChanged(mRange, oldRange);
+  markDirty();
 }
 
 /*!
@@ -9140,6 +10204,7 @@ void QCPAxis::moveRange(double diff)
 void QCPAxis::scaleRange(double factor)
 {
   scaleRange(factor, range().center());
+  markDirty();
 }
 
 /*! \overload
@@ -9175,6 +10240,7 @@ void QCPAxis::scaleRange(double factor, double center)
   }
   emit rangeChanged(mRange);
   emit rangeChanged(mRange, oldRange);
+  markDirty();
 }
 
 /*!
@@ -9206,6 +10272,7 @@ void QCPAxis::setScaleRatio(const QCPAxis *otherAxis, double ratio)
   
   double newRangeSize = ratio*otherAxis->range().size()*ownPixelSize/double(otherPixelSize);
   setRange(range().center(), newRangeSize, Qt::AlignCenter);
+  markDirty();
 }
 
 /*!
@@ -9259,6 +10326,52 @@ void QCPAxis::rescale(bool onlyVisiblePlottables)
   }
 }
 
+/*!
+  Fills the shared \ref QCPLabelCache with the tick labels of \a values, formatted with the current
+  number format, tick label font and color of this axis, so the first replots and zoom animations
+  don't need to rasterize them. If \a values is empty, a set of common tick values is used: the
+  integers from -10 to 10, the tenths between 0 and 1, the multiples of 10 up to 100 and the
+  multiples of 100 up to 1000.
+  
+  Since the cache is shared, this only has to be done for one of several axes that have the same
+  tick label style, also across different plots. Call it after the tick label style of the axis is
+  set up and the widget is shown, because the cached labels depend on the device pixel ratio.
+  Labels of tickers that don't produce plain numbers, like \ref QCPAxisTickerDateTime, aren't
+  covered by the default values.
+  
+  Has no effect if the plotting hint \ref QCP::phCacheLabels is not set.
+  
+  \see QCPLabelCache::statistics
+*/
+void QCPAxis::prewarmTickLabels(const QVector<double> &values)
+{
+  if (!mParentPlot->plottingHints().testFlag(QCP::phCacheLabels))
+    return;
+  
+  QVector<double> tickValues = values;
+  if (tickValues.isEmpty())
+  {
+    for (int i=-10; i<=10; ++i)
+      tickValues.append(i);
+    for (int i=1; i<10; ++i)
+      tickValues.append(i/10.0);
+    for (int i=2; i<=10; ++i)
+      tickValues << i*10 << i*100;
+  }
+  QVector<QString> texts;
+  texts.reserve(tickValues.size());
+  foreach (double value, tickValues)
+    texts.append(mParentPlot->locale().toString(value, mNumberFormatChar.toLatin1(), mNumberPrecision));
+  
+  // transfer the properties that define the tick label appearance, like in draw:
+  mAxisPainter->type = mAxisType;
+  mAxisPainter->substituteExponent = mNumberBeautifulPowers;
+  mAxisPainter->tickLabelFont = getTickLabelFont();
+  mAxisPainter->tickLabelColor = getTickLabelColor();
+  mAxisPainter->abbreviateDecimalPowers = mScaleType == stLogarithmic;
+  mAxisPainter->prewarmCache(texts);
+}
+
 /*!
   Transforms \a value, in pixel coordinates of the QCustomPlot widget, to axis coordinates.
 */
@@ -9297,6 +10410,135 @@ double QCPAxis::pixelToCoord(double value) const
   }
 }
 
+/*! \internal
+  
+  Holds the mapping of a \ref QCPAxis from plot coordinates to pixels in the form
+  <tt>origin+(coord-reference)*scale</tt> for linear axes, or
+  <tt>origin+ln(coord/reference)*scale</tt> for logarithmic axes. This way, many coordinates can be
+  transformed without evaluating orientation, range reversal and scale type of the axis for every
+  coordinate. Up to floating point rounding, \ref map returns the same as \ref
+  QCPAxis::coordToPixel.
+  
+  The transform is only valid as long as the axis range and axis rect don't change.
+*/
+struct QCPAxisPixelTransform
+{
+  explicit QCPAxisPixelTransform(const QCPAxis *axis)
+  {
+    const QRect rect = axis->axisRect()->rect();
+    const QCPRange range = axis->range();
+    const bool horizontal = axis->orientation() == Qt::Horizontal;
+    const double extent = horizontal ? rect.width() : -rect.height(); // vertical pixel coordinates grow downwards
+    logarithmic = axis->scaleType() == QCPAxis::stLogarithmic;
+    negativeRange = range.upper < 0.0;
+    reference = axis->rangeReversed() ? range.upper : range.lower;
+    scale = (axis->rangeReversed() ? -extent : extent)/(logarithmic ? qLn(range.upper/range.lower) : range.size());
+    origin = horizontal ? rect.left() : rect.bottom();
+    // coordinates with the wrong sign for a logarithmic range are placed 200 pixels outside, on the side coordToPixel places them:
+    const bool upperSide = negativeRange != axis->rangeReversed();
+    if (horizontal)
+      invalidPixel = upperSide ? rect.right()+200 : rect.left()-200;
+    else
+      invalidPixel = upperSide ? rect.top()-200 : rect.bottom()+200;
+  }
+  
+  inline double map(double coord) const
+  {
+    if (!logarithmic)
+      return origin+(coord-reference)*scale;
+    else if (negativeRange ? coord >= 0.0 : coord <= 0.0) // invalid value for logarithmic scale
+      return invalidPixel;
+    else
+      return origin+qLn(coord/reference)*scale;
+  }
+  
+  bool logarithmic, negativeRange;
+  double reference, scale, origin, invalidPixel;
+};
+
+/*! \internal
+  
+  Transforms \a count coordinates from \a coords to pixels with \a transform and writes them to
+  \a pixels. Linear transforms process two coordinates per SSE2 instruction. There is no vector
+  logarithm in SSE2, so logarithmic transforms stay scalar, but they still save the second
+  logarithm and the branches of \ref QCPAxis::coordToPixel per coordinate.
+*/
+static void qcpTransformCoords(const QCPAxisPixelTransform &transform, const double *coords, double *pixels, int count)
+{
+  int i = 0;
+#ifdef QCP_SSE2
+  if (!transform.logarithmic)
+  {
+    const __m128d reference = _mm_set1_pd(transform.reference);
+    const __m128d scale = _mm_set1_pd(transform.scale);
+    const __m128d origin = _mm_set1_pd(transform.origin);
+    for (; i+2 <= count; i += 2)
+      _mm_storeu_pd(pixels+i, _mm_add_pd(origin, _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(coords+i), reference), scale)));
+  }
+#endif
+  for (; i<count; ++i)
+    pixels[i] = transform.map(coords[i]);
+}
+
+/*! \internal
+  
+  Transforms \a count data points to pixel coordinates and writes them to \a points. The key and
+  value of point \a i are read from <tt>keys[i*stride]</tt> and <tt>values[i*stride]</tt>, so
+  both separate key/value arrays (\a stride 1) and arrays of \ref QCPGraphData (\a stride 2,
+  \a values pointing one double after \a keys) can be transformed directly. If \a keyVertical is
+  true, the key pixel is written to the y coordinate of the points.
+  
+  If both transforms are linear, the SSE2 path transforms a whole point (interleaved data) or two
+  points (separate arrays) per instruction and stores the results into the QPointF array without
+  going through scalar setters.
+*/
+static void qcpTransformPoints(const QCPAxisPixelTransform &keyTransform, const QCPAxisPixelTransform &valueTransform, bool keyVertical,
+                               const double *keys, const double *values, int stride, QPointF *points, int count)
+{
+  int i = 0;
+#ifdef QCP_SSE2
+  if (sizeof(qreal) == sizeof(double) && !keyTransform.logarithmic && !valueTransform.logarithmic)
+  {
+    double *out = reinterpret_cast<double*>(points);
+    if (stride == 1) // separate arrays, transform two keys and two values at once and interleave them
+    {
+      const __m128d keyReference = _mm_set1_pd(keyTransform.reference), keyScale = _mm_set1_pd(keyTransform.scale), keyOrigin = _mm_set1_pd(keyTransform.origin);
+      const __m128d valueReference = _mm_set1_pd(valueTransform.reference), valueScale = _mm_set1_pd(valueTransform.scale), valueOrigin = _mm_set1_pd(valueTransform.origin);
+      for (; i+2 <= count; i += 2)
+      {
+        const __m128d keyPixels = _mm_add_pd(keyOrigin, _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(keys+i), keyReference), keyScale));
+        const __m128d valuePixels = _mm_add_pd(valueOrigin, _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(values+i), valueReference), valueScale));
+        const __m128d x = keyVertical ? valuePixels : keyPixels;
+        const __m128d y = keyVertical ? keyPixels : valuePixels;
+        _mm_storeu_pd(out+2*i, _mm_unpacklo_pd(x, y));
+        _mm_storeu_pd(out+2*i+2, _mm_unpackhi_pd(x, y));
+      }
+    } else if (stride == 2 && values == keys+1) // interleaved key/value pairs, transform one pair at once
+    {
+      const __m128d reference = _mm_set_pd(valueTransform.reference, keyTransform.reference);
+      const __m128d scale = _mm_set_pd(valueTransform.scale, keyTransform.scale);
+      const __m128d origin = _mm_set_pd(valueTransform.origin, keyTransform.origin);
+      for (; i<count; ++i)
+      {
+        __m128d pixels = _mm_add_pd(origin, _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(keys+2*i), reference), scale));
+        if (keyVertical)
+          pixels = _mm_shuffle_pd(pixels, pixels, 1);
+        _mm_storeu_pd(out+2*i, pixels);
+      }
+    }
+  }
+#endif
+  for (; i<count; ++i)
+  {
+    const double keyPixel = keyTransform.map(keys[i*stride]);
+    const double valuePixel = valueTransform.map(values[i*stride]);
+    if (keyVertical)
+      points[i] = QPointF(valuePixel, keyPixel);
+    else
+      points[i] = QPointF(keyPixel, valuePixel);
+  }
+}
+
 /*!
   Transforms \a value, in coordinates of the axis, to pixel coordinates of the QCustomPlot widget.
 */
@@ -9349,6 +10591,22 @@ double QCPAxis::coordToPixel(double value) const
   }
 }
 
+/*!
+  Transforms the \a count coordinates in \a coords, in coordinates of the axis, to pixel
+  coordinates of the QCustomPlot widget, and writes them to \a pixels. \a coords and \a pixels may
+  point to the same array.
+  
+  The result is the same as calling \ref coordToPixel for every coordinate, but the axis
+  orientation, range and scale type are only evaluated once. On linear axes, two coordinates are
+  transformed per SSE2 instruction if the library was compiled with SSE2 support. Use this method
+  to transform large arrays of coordinates, e.g. sample columns held in separate key and value
+  arrays (see \ref QCPGraphColumnData).
+*/
+void QCPAxis::coordsToPixels(const double *coords, double *pixels, int count) const
+{
+  qcpTransformCoords(QCPAxisPixelTransform(this), coords, pixels, count);
+}
+
 /*!
   Returns the part of the axis that is hit by \a pos (in pixels). The return value of this function
   is independent of the user-selectable parts defined with \ref setSelectableParts. Further, this
@@ -9730,15 +10988,20 @@ void QCPAxis::draw(QCPPainter *painter)
   
   If a change in the label text/count is detected, the cached axis margin is invalidated to make
   sure the next margin calculation recalculates the label sizes and returns an up-to-date value.
+  If the ticks or labels changed, the axis is marked dirty (\ref markDirty).
 */
 void QCPAxis::setupTickVectors()
 {
   if (!mParentPlot) return;
   if ((!mTicks && !mTickLabels && !mGrid->visible()) || mRange.size() <= 0) return;
   
+  QVector<double> oldTicks = mTickVector;
   QVector<QString> oldLabels = mTickVectorLabels;
+  QCPReplotProfiler::Scope scope(mParentPlot->profiler(), this, QCPReplotProfiler::pcTicks);
   mTicker->generate(mRange, mParentPlot->locale(), mNumberFormatChar, mNumberPrecision, mTickVector, mSubTicks ? &mSubTickVector : nullptr, mTickLabels ? &mTickVectorLabels : nullptr);
   mCachedMarginValid &= mTickVectorLabels == oldLabels; // if labels have changed, margin might have changed, too
+  if (mTickVector != oldTicks || mTickVectorLabels != oldLabels) // e.g. the ticker was reconfigured, the axis and its grid need redrawing
+    markDirty();
 }
 
 /*! \internal
@@ -9915,8 +11178,7 @@ QCPAxisPainterPrivate::QCPAxisPainterPrivate(QCustomPlot *parentPlot) :
   offset(0),
   abbreviateDecimalPowers(false),
   reversedEndings(false),
-  mParentPlot(parentPlot),
-  mLabelCache(16) // cache at most 16 (tick) labels
+  mParentPlot(parentPlot)
 {
 }
 
@@ -9933,12 +11195,7 @@ QCPAxisPainterPrivate::~QCPAxisPainterPrivate()
 */
 void QCPAxisPainterPrivate::draw(QCPPainter *painter)
 {
-  QByteArray newHash = generateLabelParameterHash();
-  if (newHash != mLabelParameterHash)
-  {
-    mLabelCache.clear();
-    mLabelParameterHash = newHash;
-  }
+  mLabelParameterHash = generateLabelParameterHash();
   
   QPoint origin;
   switch (type)
@@ -10023,6 +11280,7 @@ void QCPAxisPainterPrivate::draw(QCPPainter *painter)
   QSize tickLabelsSize(0, 0); // size of largest tick label, for offset calculation of axis label
   if (!tickLabels.isEmpty())
   {
+    QCPReplotProfiler::Scope scope(mParentPlot->profiler(), "tick labels", QCPReplotProfiler::pcLabels);
     if (tickLabelSide == QCPAxis::lsOutside)
       margin += tickLabelPadding;
     painter->setFont(tickLabelFont);
@@ -10043,6 +11301,7 @@ void QCPAxisPainterPrivate::draw(QCPPainter *painter)
   QRect labelBounds;
   if (!label.isEmpty())
   {
+    QCPReplotProfiler::Scope scope(mParentPlot->profiler(), "axis label", QCPReplotProfiler::pcLabels);
     margin += labelPadding;
     painter->setFont(labelFont);
     painter->setPen(QPen(labelColor));
@@ -10128,12 +11387,7 @@ int QCPAxisPainterPrivate::size()
 {
   int result = 0;
 
-  QByteArray newHash = generateLabelParameterHash();
-  if (newHash != mLabelParameterHash)
-  {
-    mLabelCache.clear();
-    mLabelParameterHash = newHash;
-  }
+  mLabelParameterHash = generateLabelParameterHash();
   
   // get length of tick marks pointing outwards:
   if (!tickPositions.isEmpty())
@@ -10166,32 +11420,79 @@ int QCPAxisPainterPrivate::size()
 
 /*! \internal
   
-  Clears the internal label cache. Upon the next \ref draw, all labels will be created new. This
-  method is called automatically in \ref draw, if any parameters have changed that invalidate the
-  cached labels, such as font, color, etc.
+  Removes all labels from the shared \ref QCPLabelCache, so they are created new when they are
+  drawn the next time. Since the cache keys contain all label parameters, this is not necessary
+  when parameters such as font or color change. Note that this also affects the labels of all
+  other axes.
 */
 void QCPAxisPainterPrivate::clearCache()
 {
-  mLabelCache.clear();
+  QCPLabelCache::instance()->clear();
+}
+
+/*! \internal
+  
+  Rasterizes the tick labels with the given \a texts and the current label parameters, and stores
+  them in the shared \ref QCPLabelCache, unless they are already cached. Used by \ref
+  QCPAxis::prewarmTickLabels.
+*/
+void QCPAxisPainterPrivate::prewarmCache(const QVector<QString> &texts)
+{
+  mLabelParameterHash = generateLabelParameterHash();
+  QCPLabelCache *cache = QCPLabelCache::instance();
+  QCPLabelCache::Label cachedLabel;
+  foreach (const QString &text, texts)
+  {
+    if (text.isEmpty())
+      continue;
+    const QByteArray key = mLabelParameterHash+text.toUtf8();
+    if (!cache->find(key, &cachedLabel, false))
+      cache->insert(key, createCachedLabel(tickLabelFont, tickLabelColor, text));
+  }
 }
 
 /*! \internal
   
-  Returns a hash that allows uniquely identifying whether the label parameters have changed such
-  that the cached labels must be refreshed (\ref clearCache). It is used in \ref draw. If the
-  return value of this method hasn't changed since the last redraw, the respective label parameters
-  haven't changed and cached labels may be used.
+  Returns a byte array that identifies all parameters that affect how a tick label is rasterized
+  and where it is placed relative to its anchor. It is the prefix of the keys under which the tick
+  labels are stored in the shared \ref QCPLabelCache, so axes with the same parameters (also in
+  different plots) share their labels, and changed parameters simply lead to different keys. It is
+  updated at the beginning of \ref draw and \ref size.
 */
 QByteArray QCPAxisPainterPrivate::generateLabelParameterHash() const
 {
-  QByteArray result;
-  result.append(QByteArray::number(mParentPlot->bufferDevicePixelRatio()));
-  result.append(QByteArray::number(tickLabelRotation));
-  result.append(QByteArray::number(int(tickLabelSide)));
-  result.append(QByteArray::number(int(substituteExponent)));
-  result.append(QByteArray::number(int(numberMultiplyCross)));
-  result.append(tickLabelColor.name().toLatin1()+QByteArray::number(tickLabelColor.alpha(), 16));
-  result.append(tickLabelFont.toString().toLatin1());
+  QByteArray result("axis|");
+  result.append(QByteArray::number(mParentPlot->bufferDevicePixelRatio())+'|');
+  result.append(QByteArray::number(int(type))+'|');
+  result.append(QByteArray::number(tickLabelRotation)+'|');
+  result.append(QByteArray::number(int(tickLabelSide))+'|');
+  result.append(QByteArray::number(int(substituteExponent))+'|');
+  result.append(QByteArray::number(int(numberMultiplyCross))+'|');
+  result.append(QByteArray::number(int(abbreviateDecimalPowers))+'|');
+  result.append(QByteArray::number(tickLabelColor.rgba(), 16)+'|');
+  result.append(tickLabelFont.toString().toUtf8()+'|');
+  return result;
+}
+
+/*! \internal
+  
+  Creates the image of the tick label with \a text for the label cache, drawn with \a font and \a
+  color. The offset of the returned label is the distance from the label anchor (as calculated in
+  \ref placeTickLabel) to the top left corner of the image.
+*/
+QCPLabelCache::Label QCPAxisPainterPrivate::createCachedLabel(const QFont &font, const QColor &color, const QString &text) const
+{
+  QCPLabelCache::Label result;
+  TickLabelData labelData = getTickLabelData(font, text);
+  result.offset = getTickLabelDrawOffset(labelData)+labelData.rotatedTotalBounds.topLeft();
+  result.image = QImage(labelData.rotatedTotalBounds.size()*mParentPlot->bufferDevicePixelRatio(), QImage::Format_ARGB32_Premultiplied);
+#ifdef QCP_DEVICEPIXELRATIO_SUPPORTED
+  result.image.setDevicePixelRatio(mParentPlot->bufferDevicePixelRatio());
+#endif
+  result.image.fill(Qt::transparent);
+  QCPPainter cachePainter(&result.image);
+  cachePainter.setPen(QPen(color));
+  drawTickLabel(&cachePainter, -labelData.rotatedTotalBounds.topLeft().x(), -labelData.rotatedTotalBounds.topLeft().y(), labelData);
   return result;
 }
 
@@ -10227,46 +11528,29 @@ void QCPAxisPainterPrivate::placeTickLabel(QCPPainter *painter, double position,
     case QCPAxis::atTop:    labelAnchor = QPointF(position, axisRect.top()-distanceToAxis-offset); break;
     case QCPAxis::atBottom: labelAnchor = QPointF(position, axisRect.bottom()+distanceToAxis+offset); break;
   }
-  if (mParentPlot->plottingHints().testFlag(QCP::phCacheLabels) && !painter->modes().testFlag(QCPPainter::pmNoCaching)) // label caching enabled
+  if (mParentPlot->plottingHints().testFlag(QCP::phCacheLabels) && QCPLabelCache::supports(painter)) // label caching enabled
   {
-    CachedLabel *cachedLabel = mLabelCache.take(text); // attempt to get label from cache
-    if (!cachedLabel)  // no cached label existed, create it
+    const QByteArray key = mLabelParameterHash+text.toUtf8();
+    QCPLabelCache::Label cachedLabel;
+    if (!QCPLabelCache::instance()->find(key, &cachedLabel)) // no cached label existed, create it
     {
-      cachedLabel = new CachedLabel;
-      TickLabelData labelData = getTickLabelData(painter->font(), text);
-      cachedLabel->offset = getTickLabelDrawOffset(labelData)+labelData.rotatedTotalBounds.topLeft();
-      if (!qFuzzyCompare(1.0, mParentPlot->bufferDevicePixelRatio()))
-      {
-        cachedLabel->pixmap = QPixmap(labelData.rotatedTotalBounds.size()*mParentPlot->bufferDevicePixelRatio());
-#ifdef QCP_DEVICEPIXELRATIO_SUPPORTED
-#  ifdef QCP_DEVICEPIXELRATIO_FLOAT
-        cachedLabel->pixmap.setDevicePixelRatio(mParentPlot->devicePixelRatioF());
-#  else
-        cachedLabel->pixmap.setDevicePixelRatio(mParentPlot->devicePixelRatio());
-#  endif
-#endif
-      } else
-        cachedLabel->pixmap = QPixmap(labelData.rotatedTotalBounds.size());
-      cachedLabel->pixmap.fill(Qt::transparent);
-      QCPPainter cachePainter(&cachedLabel->pixmap);
-      cachePainter.setPen(painter->pen());
-      drawTickLabel(&cachePainter, -labelData.rotatedTotalBounds.topLeft().x(), -labelData.rotatedTotalBounds.topLeft().y(), labelData);
+      cachedLabel = createCachedLabel(painter->font(), painter->pen().color(), text);
+      QCPLabelCache::instance()->insert(key, cachedLabel);
     }
     // if label would be partly clipped by widget border on sides, don't draw it (only for outside tick labels):
     bool labelClippedByBorder = false;
     if (tickLabelSide == QCPAxis::lsOutside)
     {
       if (QCPAxis::orientation(type) == Qt::Horizontal)
-        labelClippedByBorder = labelAnchor.x()+cachedLabel->offset.x()+cachedLabel->pixmap.width()/mParentPlot->bufferDevicePixelRatio() > viewportRect.right() || labelAnchor.x()+cachedLabel->offset.x() < viewportRect.left();
+        labelClippedByBorder = labelAnchor.x()+cachedLabel.offset.x()+cachedLabel.image.width()/mParentPlot->bufferDevicePixelRatio() > viewportRect.right() || labelAnchor.x()+cachedLabel.offset.x() < viewportRect.left();
       else
-        labelClippedByBorder = labelAnchor.y()+cachedLabel->offset.y()+cachedLabel->pixmap.height()/mParentPlot->bufferDevicePixelRatio() > viewportRect.bottom() || labelAnchor.y()+cachedLabel->offset.y() < viewportRect.top();
+        labelClippedByBorder = labelAnchor.y()+cachedLabel.offset.y()+cachedLabel.image.height()/mParentPlot->bufferDevicePixelRatio() > viewportRect.bottom() || labelAnchor.y()+cachedLabel.offset.y() < viewportRect.top();
     }
     if (!labelClippedByBorder)
     {
-      painter->drawPixmap(labelAnchor+cachedLabel->offset, cachedLabel->pixmap);
-      finalSize = cachedLabel->pixmap.size()/mParentPlot->bufferDevicePixelRatio();
+      QCPLabelCache::instance()->draw(painter, labelAnchor, key, cachedLabel);
+      finalSize = cachedLabel.image.size()/mParentPlot->bufferDevicePixelRatio();
     }
-    mLabelCache.insert(text, cachedLabel); // return label to cache or insert for the first time if newly created
   } else // label caching disabled, draw text directly on surface:
   {
     TickLabelData labelData = getTickLabelData(painter->font(), text);
@@ -10529,10 +11813,10 @@ void QCPAxisPainterPrivate::getMaxTickLabelSize(const QFont &font, const QString
 {
   // note: this function must return the same tick label sizes as the placeTickLabel function.
   QSize finalSize;
-  if (mParentPlot->plottingHints().testFlag(QCP::phCacheLabels) && mLabelCache.contains(text)) // label caching enabled and have cached label
+  QCPLabelCache::Label cachedLabel;
+  if (mParentPlot->plottingHints().testFlag(QCP::phCacheLabels) && QCPLabelCache::instance()->find(mLabelParameterHash+text.toUtf8(), &cachedLabel, false)) // label caching enabled and have cached label
   {
-    const CachedLabel *cachedLabel = mLabelCache.object(text);
-    finalSize = cachedLabel->pixmap.size()/mParentPlot->bufferDevicePixelRatio();
+    finalSize = cachedLabel.image.size()/mParentPlot->bufferDevicePixelRatio();
   } else // label caching disabled or no label with this text cached:
   {
     TickLabelData labelData = getTickLabelData(font, text);
@@ -11018,6 +12302,191 @@ void QCPScatterStyle::drawShape(QCPPainter *painter, double x, double y) const
     }
   }
 }
+
+/*!
+  Draws the scatter shape with \a painter at each of the \a points. Points with NaN coordinates are
+  skipped.
+  
+  If \a cached is true, the shape is rasterized only once into a sprite image, which is then drawn
+  at all \a points with a single QPainter::drawPixmapFragments call. This is much faster than
+  drawing the shape's lines, ellipses and polygons for every point. The sprites are kept in a cache
+  shared by all scatter styles, keyed by shape, size, pen, brush, antialiasing and device pixel
+  ratio. The sprites are aligned to device pixels, so the scatters lose their sub-pixel positions.
+  
+  Sprites are only used for rasterized output. When recording an asynchronous replot (the \a
+  painter has a \ref QCPPainter::setReplayDevicePixelRatio "replay device pixel ratio"), the sprite
+  is recorded as a QImage at every point, so the worker threads blit it instead of rasterizing the
+  shape. If the \a painter is otherwise in \ref QCPPainter::pmVectorized or \ref
+  QCPPainter::pmNoCaching mode (e.g. PDF export, see \ref QCustomPlot::savePdf), isn't a raster
+  painter, has a transformation other than a translation, or if the pen or brush isn't a single
+  color, each point is drawn with \ref drawShape instead. The same applies to \ref ssPixmap, \ref
+  ssCustom and shapes larger than 128 pixels.
+  
+  Like \ref drawShape, this function uses the pen and brush of \a painter, see \ref applyTo.
+  
+  \see QCP::phCacheScatters
+*/
+void QCPScatterStyle::drawShapes(QCPPainter *painter, const QVector<QPointF> &points, bool cached) const
+{
+  if (mShape == ssNone || points.isEmpty())
+    return;
+  if (cached && drawSprites(painter, points))
+    return;
+  foreach (const QPointF &point, points)
+  {
+    if (!qIsNaN(point.x()) && !qIsNaN(point.y()))
+      drawShape(painter, point.x(), point.y());
+  }
+}
+
+/*! \internal
+  
+  A rasterized scatter shape, see \ref QCPScatterStyle::drawSprites. The image is what asynchronous
+  replot recordings reference, since their worker threads must not touch pixmaps. The pixmap for
+  drawing on raster devices is created from it on first use.
+*/
+struct QCPScatterSprite
+{
+  QImage image;
+  QPixmap pixmap;
+};
+
+/*! \internal
+  
+  Returns the cache of the scatter sprites drawn by \ref QCPScatterStyle::drawSprites. The cost of
+  a sprite is the size of its image and pixmap in kilobytes. Since it holds pixmaps, the cache is only accessed from the GUI
+  thread.
+*/
+static QCache<QByteArray, QCPScatterSprite> &qcpScatterSpriteCache()
+{
+  static QCache<QByteArray, QCPScatterSprite> cache(4096);
+  return cache;
+}
+
+/*! \internal
+  
+  Draws the scatter shape at all \a points by blitting a cached sprite, see \ref drawShapes.
+  Returns false without drawing anything if sprites can't reproduce the shape with the current
+  state of \a painter.
+*/
+bool QCPScatterStyle::drawSprites(QCPPainter *painter, const QVector<QPointF> &points) const
+{
+#if QT_VERSION < QT_VERSION_CHECK(4, 7, 0)
+  Q_UNUSED(painter)
+  Q_UNUSED(points)
+  return false;
+#else
+  if (mShape == ssPixmap || mShape == ssCustom)
+    return false;
+  if (painter->modes().testFlag(QCPPainter::pmVectorized) || !painter->paintEngine() || painter->transform().type() > QTransform::TxTranslate)
+    return false;
+  // an asynchronous replot records into a QPicture which its workers replay on raster images:
+  const bool recording = painter->replayDevicePixelRatio() > 0 && painter->paintEngine()->type() == QPaintEngine::Picture;
+  if (!recording && (painter->modes().testFlag(QCPPainter::pmNoCaching) || painter->paintEngine()->type() != QPaintEngine::Raster))
+    return false;
+  const QPen pen = painter->pen();
+  const QBrush brush = painter->brush();
+  if ((pen.style() != Qt::NoPen && pen.brush().style() != Qt::SolidPattern) ||
+      (brush.style() != Qt::NoBrush && brush.style() != Qt::SolidPattern)) // gradient and pattern fills depend on the position
+    return false;
+  // half the sprite size, with room for the pen and its caps and joins:
+  const double penWidth = pen.style() == Qt::NoPen ? 0 : qMax(1.0, pen.widthF());
+  const double extent = (mShape == ssDot ? 0 : mSize/2.0) + penWidth + 2;
+  if (extent > 64)
+    return false;
+  
+  double devicePixelRatio = 1.0;
+  if (recording)
+    devicePixelRatio = painter->replayDevicePixelRatio();
+#ifdef QCP_DEVICEPIXELRATIO_SUPPORTED
+  else
+  {
+#  ifdef QCP_DEVICEPIXELRATIO_FLOAT
+    devicePixelRatio = painter->device()->devicePixelRatioF();
+#  else
+    devicePixelRatio = painter->device()->devicePixelRatio();
+#  endif
+  }
+#endif
+  
+  QPixmap sprite;
+  const QImage image = spriteImage(pen, brush, painter->antialiasing(), extent, devicePixelRatio, recording ? nullptr : &sprite);
+  if (recording)
+  {
+    // QPicture keeps a reference to the image instead of serializing it for every point:
+    const double logicalSize = image.width()/devicePixelRatio;
+    foreach (const QPointF &point, points)
+    {
+      if (!qIsNaN(point.x()) && !qIsNaN(point.y()))
+        painter->drawImage(QRectF(point.x()-logicalSize*0.5, point.y()-logicalSize*0.5, logicalSize, logicalSize), image);
+    }
+    return true;
+  }
+  
+  QVector<QPainter::PixmapFragment> fragments;
+  fragments.reserve(points.size());
+  const QRectF source(0, 0, sprite.width(), sprite.height()); // in device pixels, so the fragments are scaled back to logical pixels
+  foreach (const QPointF &point, points)
+  {
+    if (!qIsNaN(point.x()) && !qIsNaN(point.y()))
+      fragments.append(QPainter::PixmapFragment::create(point, source, 1.0/devicePixelRatio, 1.0/devicePixelRatio));
+  }
+  painter->drawPixmapFragments(fragments.constData(), fragments.size(), sprite);
+  return true;
+#endif
+}
+
+/*! \internal
+  
+  Returns the sprite of this scatter shape drawn with \a pen, \a brush and \a antialiased, reaching
+  \a extent logical pixels from its center, for the given \a devicePixelRatio. The sprite is taken
+  from the cache or rasterized into it. If \a pixmap is not null, it receives the sprite as pixmap
+  for raster devices. This must only be called from the GUI thread.
+  
+  This is a helper function for \ref drawSprites.
+*/
+QImage QCPScatterStyle::spriteImage(const QPen &pen, const QBrush &brush, bool antialiased, double extent, double devicePixelRatio, QPixmap *pixmap) const
+{
+  QByteArray key = QByteArray::number(int(mShape)) + ' ' + QByteArray::number(mSize) + ' ' + QByteArray::number(devicePixelRatio) + ' ' + QByteArray::number(int(antialiased));
+  key += ' ' + QByteArray::number(pen.color().rgba()) + ' ' + QByteArray::number(pen.widthF()) + ' ' + QByteArray::number(int(pen.style())) + ' ' + QByteArray::number(int(pen.capStyle()));
+  key += ' ' + QByteArray::number(int(pen.joinStyle())) + ' ' + QByteArray::number(int(pen.isCosmetic())) + ' ' + QByteArray::number(pen.dashOffset());
+  key += ' ' + QByteArray::number(int(brush.style())) + ' ' + QByteArray::number(brush.color().rgba());
+  if (pen.style() == Qt::CustomDashLine)
+  {
+    foreach (qreal dash, pen.dashPattern())
+      key += ' ' + QByteArray::number(dash);
+  }
+  
+  QCache<QByteArray, QCPScatterSprite> &cache = qcpScatterSpriteCache();
+  QCPScatterSprite *sprite = cache.object(key);
+  if (!sprite) // rasterize the shape centered in a new sprite
+  {
+    int pixelSize = qCeil(2*extent*devicePixelRatio);
+    pixelSize += pixelSize % 2;
+    sprite = new QCPScatterSprite;
+    sprite->image = QImage(pixelSize, pixelSize, QImage::Format_ARGB32_Premultiplied);
+#ifdef QCP_DEVICEPIXELRATIO_SUPPORTED
+    sprite->image.setDevicePixelRatio(devicePixelRatio);
+#endif
+    sprite->image.fill(Qt::transparent);
+    {
+      QCPPainter spritePainter(&sprite->image);
+      spritePainter.setPen(pen);
+      spritePainter.setBrush(brush);
+      spritePainter.setAntialiasing(antialiased);
+      const double center = pixelSize/(2.0*devicePixelRatio) - (antialiased ? 0.5 : 0); // setAntialiasing shifts by half a pixel, as it does on painter
+      drawShape(&spritePainter, center, center);
+    }
+    cache.insert(key, sprite, qMax(1, pixelSize*pixelSize*8/1024)); // image and pixmap
+  }
+  if (pixmap)
+  {
+    if (sprite->pixmap.isNull())
+      sprite->pixmap = QPixmap::fromImage(sprite->image);
+    *pixmap = sprite->pixmap;
+  }
+  return sprite->image;
+}
 /* end of 'src/scatterstyle.cpp' */
 
 
@@ -11311,6 +12780,15 @@ bool QCPSelectionDecorator::registerWithPlottable(QCPAbstractPlottable *plottabl
   \see selected, setSelection, setSelectable
 */
 
+/*! \fn virtual quint64 QCPAbstractPlottable::dataVersion() const
+  
+  Returns a value that changes whenever the data of this plottable changes. It is part of the \ref
+  contentVersion used by the \ref QCP::phDirtyLayers plotting hint. One-dimensional plottables
+  return the \ref QCPDataContainer::version of their data container. The default implementation
+  returns zero, so plottables without own data tracking must call \ref markDirty after data
+  changes.
+*/
+
 /*! \fn virtual QCPPlottableInterface1D *QCPAbstractPlottable::interface1D()
   
   If this plottable is a one-dimensional plottable, i.e. it implements the \ref
@@ -11452,6 +12930,7 @@ QCPAbstractPlottable::~QCPAbstractPlottable()
 void QCPAbstractPlottable::setName(const QString &name)
 {
   mName = name;
+  markDirty();
 }
 
 /*!
@@ -11463,6 +12942,7 @@ void QCPAbstractPlottable::setName(const QString &name)
 void QCPAbstractPlottable::setAntialiasedFill(bool enabled)
 {
   mAntialiasedFill = enabled;
+  markDirty();
 }
 
 /*!
@@ -11474,6 +12954,7 @@ void QCPAbstractPlottable::setAntialiasedFill(bool enabled)
 void QCPAbstractPlottable::setAntialiasedScatters(bool enabled)
 {
   mAntialiasedScatters = enabled;
+  markDirty();
 }
 
 /*!
@@ -11487,6 +12968,7 @@ void QCPAbstractPlottable::setAntialiasedScatters(bool enabled)
 void QCPAbstractPlottable::setPen(const QPen &pen)
 {
   mPen = pen;
+  markDirty();
 }
 
 /*!
@@ -11501,6 +12983,7 @@ void QCPAbstractPlottable::setPen(const QPen &pen)
 void QCPAbstractPlottable::setBrush(const QBrush &brush)
 {
   mBrush = brush;
+  markDirty();
 }
 
 /*!
@@ -11517,6 +13000,7 @@ void QCPAbstractPlottable::setBrush(const QBrush &brush)
 void QCPAbstractPlottable::setKeyAxis(QCPAxis *axis)
 {
   mKeyAxis = axis;
+  markDirty();
 }
 
 /*!
@@ -11533,6 +13017,7 @@ void QCPAbstractPlottable::setKeyAxis(QCPAxis *axis)
 void QCPAbstractPlottable::setValueAxis(QCPAxis *axis)
 {
   mValueAxis = axis;
+  markDirty();
 }
 
 
@@ -11563,6 +13048,7 @@ void QCPAbstractPlottable::setSelection(QCPDataSelection selection)
     emit selectionChanged(selected());
     emit selectionChanged(mSelection);
   }
+  markDirty();
 }
 
 /*!
@@ -11588,6 +13074,7 @@ void QCPAbstractPlottable::setSelectionDecorator(QCPSelectionDecorator *decorato
     delete mSelectionDecorator;
     mSelectionDecorator = nullptr;
   }
+  markDirty();
 }
 
 /*!
@@ -11880,6 +13367,25 @@ bool QCPAbstractPlottable::removeFromLegend() const
     return removeFromLegend(mParentPlot->legend);
 }
 
+/*!
+  Returns a value that changes whenever the properties, the data (\ref dataVersion) or the range
+  and appearance of the key or value axis of this plottable change.
+  
+  Changes of the selection decorator (\ref setSelectionDecorator) aren't detected, call \ref
+  markDirty after modifying it.
+  
+  \seebaseclassmethod
+*/
+quint64 QCPAbstractPlottable::contentVersion() const
+{
+  quint64 version = qcpCombineVersions(QCPLayerable::contentVersion(), dataVersion());
+  if (mKeyAxis)
+    version = qcpCombineVersions(version, mKeyAxis->contentVersion());
+  if (mValueAxis)
+    version = qcpCombineVersions(version, mValueAxis->contentVersion());
+  return version;
+}
+
 /* inherits documentation from base class */
 QRect QCPAbstractPlottable::clipRect() const
 {
@@ -11989,6 +13495,213 @@ void QCPAbstractPlottable::deselectEvent(bool *selectionStateChanged)
       *selectionStateChanged = mSelection != selectionBefore;
   }
 }
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPDataPixelIndex
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPDataPixelIndex
+  \brief A grid in pixel space over the data points of a one-dimensional plottable, for fast hit tests
+  
+  Without an index, hit tests transform data points to pixels one by one and compare them with the
+  tested position or rect: \ref QCPAbstractPlottable1D::selectTestRect looks at all data points in
+  the key range of the rect, QCPCurve's point distance at all data points of the curve. With
+  millions of data points, this makes clicking and rubber band selection sluggish.
+  
+  The index divides the viewport of the plot (plus a margin) into square cells of \ref cellSize
+  pixels and stores the indices of the data points in each cell, ascending within a cell. Hit tests
+  then only look at the data points in the cells around the tested position or inside the tested
+  rect (\ref findCandidates). Data points outside the indexed area are not stored, since they can't
+  be hit by the mouse. Hit tests reaching outside the indexed area aren't served by the index
+  (\ref covers) and fall back to looking at the data.
+  
+  For hit tests on the line through consecutive data points, the index additionally lists the line
+  segments longer than \ref segmentThreshold which pass the indexed area (\ref longSegments). Any
+  other segment closer than a distance d to a position has an end point closer than d plus half
+  the threshold, so it is found through the cells around the position.
+  
+  QCPAbstractPlottable1D holds one index per plottable and rebuilds it lazily, on the first hit
+  test after the data, an axis range or scale type, or the layout changed (see \ref isUpToDate).
+  Building costs one transformation of all data points, so the index is only used for plottables
+  with at least \ref minimumDataCount data points.
+*/
+
+/*!
+  Creates an invalid index. It becomes valid after it was built with \ref beginBuild, \ref
+  addPoint and \ref endBuild.
+*/
+QCPDataPixelIndex::QCPDataPixelIndex() :
+  mValid(false),
+  mDataVersion(0),
+  mKeyAxisVersion(0),
+  mValueAxisVersion(0),
+  mCellSize(4),
+  mColumns(0),
+  mRows(0),
+  mLastFinite(false)
+{
+}
+
+/*!
+  Returns whether the index is valid and was built for the data version \a dataVersion (see \ref
+  QCPAbstractPlottable::dataVersion) and the current state of \a keyAxis, \a valueAxis and the plot
+  viewport. Changing an axis range or scale type changes the axis' \ref
+  QCPLayerable::propertyVersion, changing the layout moves the axis rects.
+*/
+bool QCPDataPixelIndex::isUpToDate(quint64 dataVersion, const QCPAxis *keyAxis, const QCPAxis *valueAxis) const
+{
+  return mValid &&
+         mDataVersion == dataVersion &&
+         mKeyAxisVersion == keyAxis->propertyVersion() &&
+         mValueAxisVersion == valueAxis->propertyVersion() &&
+         mKeyAxisRect == keyAxis->axisRect()->rect() &&
+         mValueAxisRect == valueAxis->axisRect()->rect() &&
+         mViewport == keyAxis->parentPlot()->viewport();
+}
+
+/*!
+  Invalidates the index and releases its memory.
+*/
+void QCPDataPixelIndex::clear()
+{
+  mValid = false;
+  mColumns = 0;
+  mRows = 0;
+  mCellStart.clear();
+  mIndices.clear();
+  mLongSegments.clear();
+  mPointCells.clear();
+  mLastFinite = false;
+}
+
+/*!
+  Starts building the index for \a dataCount data points of the data version \a dataVersion, shown
+  on \a keyAxis and \a valueAxis. The pixel positions of the data points must then be passed in
+  order of their data index with \ref addPoint, followed by a call to \ref endBuild.
+*/
+void QCPDataPixelIndex::beginBuild(quint64 dataVersion, const QCPAxis *keyAxis, const QCPAxis *valueAxis, int dataCount)
+{
+  clear();
+  mDataVersion = dataVersion;
+  mKeyAxisVersion = keyAxis->propertyVersion();
+  mValueAxisVersion = valueAxis->propertyVersion();
+  mKeyAxisRect = keyAxis->axisRect()->rect();
+  mValueAxisRect = valueAxis->axisRect()->rect();
+  mViewport = keyAxis->parentPlot()->viewport();
+  // positions within the viewport can be hit, the margin covers the selection tolerance around them:
+  const double margin = keyAxis->parentPlot()->selectionTolerance()+segmentThreshold();
+  mBounds = QRectF(mViewport).adjusted(-margin, -margin, margin, margin);
+  mColumns = qMax(1, qCeil(mBounds.width()/mCellSize));
+  mRows = qMax(1, qCeil(mBounds.height()/mCellSize));
+  mPointCells.reserve(dataCount);
+}
+
+/*!
+  Adds the data point with the next data index at the pixel position \a pixel. Points with
+  non-finite coordinates (e.g. NaN values) are never returned as candidates.
+*/
+void QCPDataPixelIndex::addPoint(const QPointF &pixel)
+{
+  const int index = mPointCells.size();
+  const bool finite = qIsFinite(pixel.x()) && qIsFinite(pixel.y());
+  int cell = -1;
+  if (finite && mBounds.contains(pixel))
+  {
+    const int column = qMin(int((pixel.x()-mBounds.left())/mCellSize), mColumns-1);
+    const int row = qMin(int((pixel.y()-mBounds.top())/mCellSize), mRows-1);
+    cell = row*mColumns+column;
+  }
+  mPointCells.append(cell);
+  
+  // remember segments to the previous point that can't be found through their end points. Short segments with both end points outside the indexed area can't come close enough to a covered position to matter:
+  if (finite && mLastFinite && QCPVector2D(pixel-mLastPixel).lengthSquared() > segmentThreshold()*segmentThreshold())
+  {
+    // QRectF::intersects doesn't work with the degenerate bounding rects of horizontal and vertical segments, so compare manually:
+    if (qMax(pixel.x(), mLastPixel.x()) >= mBounds.left() && qMin(pixel.x(), mLastPixel.x()) <= mBounds.right() &&
+        qMax(pixel.y(), mLastPixel.y()) >= mBounds.top() && qMin(pixel.y(), mLastPixel.y()) <= mBounds.bottom())
+      mLongSegments.append(index-1);
+  }
+  mLastPixel = pixel;
+  mLastFinite = finite;
+}
+
+/*!
+  Finishes building the index after all data points were added with \ref addPoint. The index is
+  valid afterwards, unless the viewport is empty.
+*/
+void QCPDataPixelIndex::endBuild()
+{
+  // counting sort of the data indices by cell, which keeps them ascending within each cell:
+  const int cellCount = mColumns*mRows;
+  const int pointCount = mPointCells.size();
+  const int *pointCells = mPointCells.constData();
+  mCellStart.fill(0, cellCount+1);
+  int *cellStart = mCellStart.data();
+  for (int i=0; i<pointCount; ++i)
+  {
+    if (pointCells[i] >= 0)
+      ++cellStart[pointCells[i]+1];
+  }
+  for (int i=0; i<cellCount; ++i)
+    cellStart[i+1] += cellStart[i];
+  mIndices.resize(cellStart[cellCount]);
+  int *indices = mIndices.data();
+  QVector<int> fillPosition(mCellStart);
+  int *fill = fillPosition.data();
+  for (int i=0; i<pointCount; ++i)
+  {
+    if (pointCells[i] >= 0)
+      indices[fill[pointCells[i]]++] = i;
+  }
+  mPointCells = QVector<int>();
+  mValid = !mViewport.isEmpty();
+}
+
+/*!
+  Returns whether all data points within \a pixelRect are in the index, i.e. whether \ref
+  findCandidates can be used instead of looking at the data.
+*/
+bool QCPDataPixelIndex::covers(const QRectF &pixelRect) const
+{
+  return mValid && mBounds.contains(pixelRect.normalized());
+}
+
+/*!
+  Appends the indices of the data points that may lie within \a pixelRect. Data points in cells
+  that lie completely inside \a pixelRect are appended to \a inside, the ones in cells on the
+  border of \a pixelRect to \a border, which thus still need to be checked. If \a inside is zero,
+  all candidates are appended to \a border.
+  
+  The appended indices are ordered by cell, and ascending within each cell. Only cells covered by
+  the index are looked at, see \ref covers.
+*/
+void QCPDataPixelIndex::findCandidates(const QRectF &pixelRect, QVector<int> *inside, QVector<int> *border) const
+{
+  if (!mValid)
+    return;
+  const QRectF rect = pixelRect.normalized();
+  const int firstColumn = qBound(0, int((rect.left()-mBounds.left())/mCellSize), mColumns-1);
+  const int lastColumn = qBound(0, int((rect.right()-mBounds.left())/mCellSize), mColumns-1);
+  const int firstRow = qBound(0, int((rect.top()-mBounds.top())/mCellSize), mRows-1);
+  const int lastRow = qBound(0, int((rect.bottom()-mBounds.top())/mCellSize), mRows-1);
+  const QRectF innerRect = rect.adjusted(1, 1, -1, -1); // shrunk so rounding of cell positions can't classify points outside rect as inside
+  for (int row=firstRow; row<=lastRow; ++row)
+  {
+    for (int column=firstColumn; column<=lastColumn; ++column)
+    {
+      const int cell = row*mColumns+column;
+      const int begin = mCellStart.at(cell);
+      const int end = mCellStart.at(cell+1);
+      if (begin == end)
+        continue;
+      const QRectF cellRect(mBounds.left()+column*mCellSize, mBounds.top()+row*mCellSize, mCellSize, mCellSize);
+      QVector<int> *target = inside && innerRect.contains(cellRect) ? inside : border;
+      const int oldSize = target->size();
+      target->resize(oldSize+end-begin);
+      std::copy(mIndices.constData()+begin, mIndices.constData()+end, target->data()+oldSize);
+    }
+  }
+}
 /* end of 'src/plottable.cpp' */
 
 
@@ -12311,6 +14024,7 @@ void QCPItemPosition::setTypeX(QCPItemPosition::PositionType type)
     if (retainPixelPosition)
       setPixelPosition(pixel);
   }
+  mParentItem->markDirty();
 }
 
 /*!
@@ -12341,6 +14055,7 @@ void QCPItemPosition::setTypeY(QCPItemPosition::PositionType type)
     if (retainPixelPosition)
       setPixelPosition(pixel);
   }
+  mParentItem->markDirty();
 }
 
 /*!
@@ -12430,6 +14145,7 @@ bool QCPItemPosition::setParentAnchorX(QCPItemAnchor *parentAnchor, bool keepPix
     setPixelPosition(pixelP);
   else
     setCoords(0, coords().y());
+  mParentItem->markDirty();
   return true;
 }
 
@@ -12495,6 +14211,7 @@ bool QCPItemPosition::setParentAnchorY(QCPItemAnchor *parentAnchor, bool keepPix
     setPixelPosition(pixelP);
   else
     setCoords(coords().x(), 0);
+  mParentItem->markDirty();
   return true;
 }
 
@@ -12517,8 +14234,12 @@ bool QCPItemPosition::setParentAnchorY(QCPItemAnchor *parentAnchor, bool keepPix
 */
 void QCPItemPosition::setCoords(double key, double value)
 {
-  mKey = key;
-  mValue = value;
+  if (key != mKey || value != mValue)
+  {
+    mKey = key;
+    mValue = value;
+    mParentItem->markDirty();
+  }
 }
 
 /*! \overload
@@ -12641,6 +14362,7 @@ void QCPItemPosition::setAxes(QCPAxis *keyAxis, QCPAxis *valueAxis)
 {
   mKeyAxis = keyAxis;
   mValueAxis = valueAxis;
+  mParentItem->markDirty();
 }
 
 /*!
@@ -12651,6 +14373,7 @@ void QCPItemPosition::setAxes(QCPAxis *keyAxis, QCPAxis *valueAxis)
 void QCPItemPosition::setAxisRect(QCPAxisRect *axisRect)
 {
   mAxisRect = axisRect;
+  mParentItem->markDirty();
 }
 
 /*!
@@ -12967,6 +14690,7 @@ void QCPAbstractItem::setClipToAxisRect(bool clip)
   mClipToAxisRect = clip;
   if (mClipToAxisRect)
     setParentLayerable(mClipAxisRect.data());
+  markDirty();
 }
 
 /*!
@@ -12980,6 +14704,7 @@ void QCPAbstractItem::setClipAxisRect(QCPAxisRect *rect)
   mClipAxisRect = rect;
   if (mClipToAxisRect)
     setParentLayerable(mClipAxisRect.data());
+  markDirty();
 }
 
 /*!
@@ -13021,6 +14746,7 @@ void QCPAbstractItem::setSelected(bool selected)
     mSelected = selected;
     emit selectionChanged(mSelected);
   }
+  markDirty();
 }
 
 /*!
@@ -13083,6 +14809,28 @@ bool QCPAbstractItem::hasAnchor(const QString &name) const
   return false;
 }
 
+/*!
+  Returns a value that changes whenever the properties of this item, the coordinates of its
+  positions or the axes its positions are plotted on change.
+  
+  Positions anchored to other items (\ref QCPItemPosition::setParentAnchor) don't follow changes of
+  the parent item, call \ref markDirty on the dependent item in that case.
+  
+  \seebaseclassmethod
+*/
+quint64 QCPAbstractItem::contentVersion() const
+{
+  quint64 version = QCPLayerable::contentVersion();
+  foreach (QCPItemPosition *position, mPositions)
+  {
+    if (QCPAxis *keyAxis = position->keyAxis())
+      version = qcpCombineVersions(version, keyAxis->contentVersion());
+    if (QCPAxis *valueAxis = position->valueAxis())
+      version = qcpCombineVersions(version, valueAxis->contentVersion());
+  }
+  return version;
+}
+
 /*! \internal
   
   Returns the rect the visual representation of this item is clipped to. This depends on the
@@ -13296,6 +15044,20 @@ QCP::Interaction QCPAbstractItem::selectionCategory() const
   one cell with the main QCPAxisRect inside.
 */
 
+/*! \fn bool QCustomPlot::isRendering() const
+  
+  Returns whether worker threads are currently rasterizing a frame started by an asynchronous
+  replot (see \ref setAsyncReplot).
+  
+  \see asyncReplotFinished
+*/
+
+/*! \fn QCPReplotProfiler *QCustomPlot::profiler() const
+  
+  Returns the profiler of this plot. Once enabled (\ref QCPReplotProfiler::setEnabled), it records
+  how long each phase, layer and layerable of a replot takes, in more detail than \ref replotTime.
+*/
+
 /* end of documentation of inline functions */
 /* start of documentation of signals */
 
@@ -13490,6 +15252,16 @@ QCP::Interaction QCPAbstractItem::selectionCategory() const
   \see replot, beforeReplot, afterLayout
 */
 
+/*! \fn void QCustomPlot::asyncReplotFinished()
+  
+  This signal is emitted when the frame of an asynchronous replot (see \ref setAsyncReplot) was
+  rasterized by the worker threads and is about to be shown. Unlike \ref afterReplot, it is
+  emitted outside of \ref replot, so connecting another plot's replot slot to it mutually will
+  keep both plots replotting continuously.
+  
+  \see isRendering, replotWorkerTime
+*/
+
 /* end of documentation of signals */
 /* start of documentation of public members */
 
@@ -13613,11 +15385,12 @@ QCustomPlot::QCustomPlot(QWidget *parent) :
   mBackgroundScaled(true),
   mBackgroundScaledMode(Qt::KeepAspectRatioByExpanding),
   mCurrentLayer(nullptr),
-  mPlottingHints(QCP::phCacheLabels|QCP::phImmediateRefresh),
+  mPlottingHints(QCP::phCacheLabels|QCP::phCacheScatters|QCP::phImmediateRefresh),
   mMultiSelectModifier(Qt::ControlModifier),
   mSelectionRectMode(QCP::srmNone),
   mSelectionRect(nullptr),
   mOpenGl(false),
+  mAsyncReplot(false),
   mMouseHasMoved(false),
   mMouseEventLayerable(nullptr),
   mMouseSignalLayerable(nullptr),
@@ -13625,6 +15398,10 @@ QCustomPlot::QCustomPlot(QWidget *parent) :
   mReplotQueued(false),
   mReplotTime(0),
   mReplotTimeAverage(0),
+  mReplotWorkerTime(0),
+  mReplotWorkerTimeAverage(0),
+  mProfiler(new QCPReplotProfiler(this)),
+  mAsyncReplotPending(false),
   mOpenGlMultisamples(16),
   mOpenGlAntialiasedElementsBackup(QCP::aeNone),
   mOpenGlCacheLabelsBackup(true)
@@ -13694,6 +15471,8 @@ QCustomPlot::QCustomPlot(QWidget *parent) :
 
 QCustomPlot::~QCustomPlot()
 {
+  if (mAsyncFrame) // the workers post their completion to this instance, so wait until they're done
+    mAsyncFrame->finished.acquire(mAsyncFrame->buffers.size());
   clearPlottables();
   clearItems();
 
@@ -13706,6 +15485,8 @@ QCustomPlot::~QCustomPlot()
   mCurrentLayer = nullptr;
   qDeleteAll(mLayers); // don't use removeLayer, because it would prevent the last layer to be removed
   mLayers.clear();
+  delete mProfiler;
+  mProfiler = nullptr;
 }
 
 /*!
@@ -13923,6 +15704,11 @@ void QCustomPlot::setNoAntialiasingOnDrag(bool enabled)
 */
 void QCustomPlot::setPlottingHints(const QCP::PlottingHints &hints)
 {
+  if (hints.testFlag(QCP::phDirtyLayers) != mPlottingHints.testFlag(QCP::phDirtyLayers)) // the layers are distributed differently on the paint buffers
+  {
+    foreach (QSharedPointer<QCPAbstractPaintBuffer> buffer, mPaintBuffers)
+      buffer->setInvalidated();
+  }
   mPlottingHints = hints;
 }
 
@@ -14101,6 +15887,47 @@ void QCustomPlot::setOpenGl(bool enabled, int multisampling)
 #endif
 }
 
+/*!
+  Sets whether \ref replot rasterizes the layers on worker threads instead of the GUI thread.
+
+  When \a enabled is true, \ref replot still updates the layout and lets all layerables draw
+  themselves on the GUI thread, but into a QPicture per paint buffer, which merely records the
+  drawing commands (with the data already transformed to pixel coordinates and reduced by adaptive
+  sampling). The pictures are then played back into QImage based paint buffers (\ref
+  QCPPaintBufferImage) by the global QThreadPool, one task per paint buffer, so layers in \ref
+  QCPLayer::lmBuffered mode are rasterized in parallel. When all buffers of a frame are done,
+  they are exchanged with the displayed ones and the widget is updated. Because the workers only
+  see the recorded commands, plottables, axes and items may be changed as usual while a frame is
+  being rasterized.
+
+  Calls to \ref replot while a frame is being rasterized don't start a new one. Instead, one
+  follow-up frame with the then current plot state is replotted as soon as the running frame is
+  done, so the displayed frame rate adapts to the rendering speed instead of replots piling up.
+  \ref isRendering tells whether a frame is currently in flight, and the signal \ref
+  asyncReplotFinished is emitted when its buffers are shown. The signals \ref beforeReplot and
+  \ref afterReplot keep their meaning and frame the GUI thread part of the replot. \ref
+  replotTime reports the time spent on the GUI thread, \ref replotWorkerTime the time the workers
+  needed to rasterize the frame.
+
+  Since labels are drawn as text in the recorded frames, label caching (\ref QCP::phCacheLabels)
+  and \ref QCP::phFastPolylines don't apply in this mode. If OpenGL is enabled (\ref
+  setOpenGl), it takes precedence and replots are synchronous.
+
+  This is worthwhile for plots with many points, thick or antialiased lines or large fills, where
+  rasterization dominates the replot time. For simple plots the additional recording pass may
+  outweigh the gain.
+*/
+void QCustomPlot::setAsyncReplot(bool enabled)
+{
+  if (mAsyncReplot == enabled)
+    return;
+  mAsyncReplot = enabled;
+  // recreate all paint buffers, asynchronous replots need image based ones:
+  mPaintBuffers.clear();
+  mAsyncSpareImages.clear();
+  setupPaintBuffers();
+}
+
 /*!
   Sets the viewport of this QCustomPlot. Usually users of QCustomPlot don't need to change the
   viewport manually.
@@ -14142,7 +15969,10 @@ void QCustomPlot::setBufferDevicePixelRatio(double ratio)
 #ifdef QCP_DEVICEPIXELRATIO_SUPPORTED
     mBufferDevicePixelRatio = ratio;
     foreach (QSharedPointer<QCPAbstractPaintBuffer> buffer, mPaintBuffers)
+    {
       buffer->setDevicePixelRatio(mBufferDevicePixelRatio);
+      buffer->setInvalidated();
+    }
     // Note: axis label cache has devicePixelRatio as part of cache hash, so no need to manually clear cache here
 #else
     qDebug() << Q_FUNC_INFO << "Device pixel ratios not supported for Qt versions before 5.4";
@@ -15112,6 +16942,18 @@ void QCustomPlot::deselectAll()
   If a layer is in mode \ref QCPLayer::lmBuffered (\ref QCPLayer::setMode), it is also possible to
   replot only that specific layer via \ref QCPLayer::replot. See the documentation there for
   details.
+
+  If \ref setAsyncReplot is enabled, this method returns before the new frame is rasterized, see
+  the documentation there.
+
+  If the \ref QCP::phDirtyLayers plotting hint is set, each layer is drawn into its own paint
+  buffer, and only the buffers of layers whose content changed since the last replot are redrawn.
+  Layerables report changes via \ref QCPLayerable::contentVersion: their setters, the data
+  containers of plottables and the ranges and ticks of axes are tracked, as well as the geometry of
+  the layout. Static layers like grids, axes and legends thus cost nothing while only plottable data
+  changes. Changes that aren't tracked, like the settings of an axis ticker object or a selection
+  decorator, or items anchored to a changing item, must be announced by calling \ref
+  QCPLayerable::markDirty or \ref QCPLayer::markDirty before the replot.
   
   \see replotTime
 */
@@ -15129,9 +16971,16 @@ void QCustomPlot::replot(QCustomPlot::RefreshPriority refreshPriority)
   
   if (mReplotting) // incase signals loop back to replot slot
     return;
+  if (mAsyncFrame) // workers are still rasterizing the last frame, replot once more with the then current state when they're done
+  {
+    mAsyncReplotPending = true;
+    mReplotQueued = false;
+    return;
+  }
   mReplotting = true;
   mReplotQueued = false;
   emit beforeReplot();
+  const qint64 profilerFrame = mProfiler->beginFrame();
   
 # if QT_VERSION < QT_VERSION_CHECK(4, 8, 0)
   QTime replotTimer;
@@ -15144,15 +16993,42 @@ void QCustomPlot::replot(QCustomPlot::RefreshPriority refreshPriority)
   updateLayout();
   // draw all layered objects (grid, axes, plottables, items, legend,...) into their buffers:
   setupPaintBuffers();
-  foreach (QCPLayer *layer, mLayers)
-    layer->drawToPaintBuffer();
-  foreach (QSharedPointer<QCPAbstractPaintBuffer> buffer, mPaintBuffers)
-    buffer->setInvalidated(false);
-  
-  if ((refreshPriority == rpRefreshHint && mPlottingHints.testFlag(QCP::phImmediateRefresh)) || refreshPriority==rpImmediateRefresh)
-    repaint();
-  else
-    update();
+  if (mAsyncReplot && !mOpenGl)
+  {
+    startAsyncReplot(refreshPriority); // the widget is updated by finishAsyncReplot
+  } else if (mPlottingHints.testFlag(QCP::phDirtyLayers))
+  {
+    const QVector<bool> dirty = dirtyPaintBuffers();
+    for (int i=0; i<mPaintBuffers.size(); ++i)
+    {
+      if (dirty.at(i))
+        mPaintBuffers.at(i)->clear(Qt::transparent);
+    }
+    foreach (QCPLayer *layer, mLayers)
+    {
+      const int bufferIndex = mPaintBuffers.indexOf(layer->mPaintBuffer.toStrongRef());
+      if (bufferIndex >= 0 && dirty.at(bufferIndex))
+        layer->drawToPaintBuffer();
+    }
+    foreach (QSharedPointer<QCPAbstractPaintBuffer> buffer, mPaintBuffers)
+      buffer->setInvalidated(false);
+    
+    if ((refreshPriority == rpRefreshHint && mPlottingHints.testFlag(QCP::phImmediateRefresh)) || refreshPriority==rpImmediateRefresh)
+      repaint();
+    else
+      update();
+  } else
+  {
+    foreach (QCPLayer *layer, mLayers)
+      layer->drawToPaintBuffer();
+    foreach (QSharedPointer<QCPAbstractPaintBuffer> buffer, mPaintBuffers)
+      buffer->setInvalidated(false);
+    
+    if ((refreshPriority == rpRefreshHint && mPlottingHints.testFlag(QCP::phImmediateRefresh)) || refreshPriority==rpImmediateRefresh)
+      repaint();
+    else
+      update();
+  }
   
 # if QT_VERSION < QT_VERSION_CHECK(4, 8, 0)
   mReplotTime = replotTimer.elapsed();
@@ -15163,6 +17039,7 @@ void QCustomPlot::replot(QCustomPlot::RefreshPriority refreshPriority)
     mReplotTimeAverage = mReplotTimeAverage*0.9 + mReplotTime*0.1; // exponential moving average with a time constant of 10 last replots
   else
     mReplotTimeAverage = mReplotTime; // no previous replots to average with, so initialize with replot time
+  mProfiler->endFrame(profilerFrame);
   
   emit afterReplot();
   mReplotting = false;
@@ -15171,14 +17048,31 @@ void QCustomPlot::replot(QCustomPlot::RefreshPriority refreshPriority)
 /*!
   Returns the time in milliseconds that the last replot took. If \a average is set to true, an
   exponential moving average over the last couple of replots is returned.
+
+  If \ref setAsyncReplot is enabled, this is only the time spent on the GUI thread, i.e. updating
+  the layout and recording the layers. The rasterization is reported by \ref replotWorkerTime.
   
-  \see replot
+  \see replot, profiler
 */
 double QCustomPlot::replotTime(bool average) const
 {
   return average ? mReplotTimeAverage : mReplotTime;
 }
 
+/*!
+  Returns the time in milliseconds from handing the last asynchronous replot to the worker threads
+  until its last paint buffer was rasterized. If \a average is set to true, an exponential moving
+  average over the last couple of frames is returned.
+
+  This is zero unless \ref setAsyncReplot is enabled.
+
+  \see replotTime
+*/
+double QCustomPlot::replotWorkerTime(bool average) const
+{
+  return average ? mReplotWorkerTimeAverage : mReplotWorkerTime;
+}
+
 /*!
   Rescales the axes such that all plottables (like graphs) in the plot are fully visible.
   
@@ -15485,6 +17379,7 @@ void QCustomPlot::paintEvent(QPaintEvent *event)
   }
 #endif
   
+  QCPReplotProfiler::Scope scope(mProfiler, "QCustomPlot::paintEvent", QCPReplotProfiler::pcComposite);
   QCPPainter painter(this);
   if (painter.isActive())
   {
@@ -15770,10 +17665,20 @@ void QCustomPlot::draw(QCPPainter *painter)
 */
 void QCustomPlot::updateLayout()
 {
+  QCPReplotProfiler::Scope scope(mProfiler, "QCustomPlot::updateLayout", QCPReplotProfiler::pcLayout);
   // run through layout phases:
-  mPlotLayout->update(QCPLayoutElement::upPreparation);
-  mPlotLayout->update(QCPLayoutElement::upMargins);
-  mPlotLayout->update(QCPLayoutElement::upLayout);
+  {
+    QCPReplotProfiler::Scope phaseScope(mProfiler, "upPreparation", QCPReplotProfiler::pcLayout);
+    mPlotLayout->update(QCPLayoutElement::upPreparation);
+  }
+  {
+    QCPReplotProfiler::Scope phaseScope(mProfiler, "upMargins", QCPReplotProfiler::pcLayout);
+    mPlotLayout->update(QCPLayoutElement::upMargins);
+  }
+  {
+    QCPReplotProfiler::Scope phaseScope(mProfiler, "upLayout", QCPReplotProfiler::pcLayout);
+    mPlotLayout->update(QCPLayoutElement::upLayout);
+  }
 
   emit afterLayout();
 }
@@ -15830,7 +17735,13 @@ void QCustomPlot::drawBackground(QCPPainter *painter)
   This method uses \ref createPaintBuffer to create new paint buffers.
 
   After this method, the paint buffers are empty (filled with \c Qt::transparent) and invalidated
-  (so an attempt to replot only a single buffered layer causes a full replot).
+  (so an attempt to replot only a single buffered layer causes a full replot). For asynchronous
+  replots (\ref setAsyncReplot) the buffers keep showing the previous frame until the new one is
+  rasterized, so they are only invalidated.
+
+  If the \ref QCP::phDirtyLayers plotting hint is set, every layer gets its own paint buffer and
+  the buffers keep their contents. Only buffers whose layer association changed are invalidated,
+  the others are cleared and redrawn by \ref replot if \ref dirtyPaintBuffers reports them.
 
   This method is called in every \ref replot call, prior to actually drawing the layers (into their
   associated paint buffer). If the paint buffers don't need changing/reallocating, this method
@@ -15838,6 +17749,8 @@ void QCustomPlot::drawBackground(QCPPainter *painter)
 */
 void QCustomPlot::setupPaintBuffers()
 {
+  QCPReplotProfiler::Scope scope(mProfiler, "QCustomPlot::setupPaintBuffers", QCPReplotProfiler::pcBuffers);
+  const bool dirtyLayers = mPlottingHints.testFlag(QCP::phDirtyLayers);
   int bufferIndex = 0;
   if (mPaintBuffers.isEmpty())
     mPaintBuffers.append(QSharedPointer<QCPAbstractPaintBuffer>(createPaintBuffer()));
@@ -15845,7 +17758,17 @@ void QCustomPlot::setupPaintBuffers()
   for (int layerIndex = 0; layerIndex < mLayers.size(); ++layerIndex)
   {
     QCPLayer *layer = mLayers.at(layerIndex);
-    if (layer->mode() == QCPLayer::lmLogical)
+    if (dirtyLayers) // every layer gets its own buffer, so unchanged layers can keep their contents
+    {
+      bufferIndex = layerIndex;
+      if (bufferIndex >= mPaintBuffers.size())
+        mPaintBuffers.append(QSharedPointer<QCPAbstractPaintBuffer>(createPaintBuffer()));
+      if (layer->mPaintBuffer.toStrongRef() != mPaintBuffers.at(bufferIndex))
+      {
+        layer->mPaintBuffer = mPaintBuffers.at(bufferIndex).toWeakRef();
+        mPaintBuffers.at(bufferIndex)->setInvalidated();
+      }
+    } else if (layer->mode() == QCPLayer::lmLogical)
     {
       layer->mPaintBuffer = mPaintBuffers.at(bufferIndex).toWeakRef();
     } else if (layer->mode() == QCPLayer::lmBuffered)
@@ -15868,8 +17791,18 @@ void QCustomPlot::setupPaintBuffers()
   // resize buffers to viewport size and clear contents:
   foreach (QSharedPointer<QCPAbstractPaintBuffer> buffer, mPaintBuffers)
   {
+    if (dirtyLayers)
+    {
+      if (buffer->size() != viewport().size())
+      {
+        buffer->setSize(viewport().size());
+        buffer->setInvalidated();
+      }
+      continue;
+    }
     buffer->setSize(viewport().size()); // won't do anything if already correct size
-    buffer->clear(Qt::transparent);
+    if (!mAsyncReplot || mOpenGl)
+      buffer->clear(Qt::transparent);
     buffer->setInvalidated();
   }
 }
@@ -15878,8 +17811,8 @@ void QCustomPlot::setupPaintBuffers()
 
   This method is used by \ref setupPaintBuffers when it needs to create new paint buffers.
 
-  Depending on the current setting of \ref setOpenGl, and the current Qt version, different
-  backends (subclasses of \ref QCPAbstractPaintBuffer) are created, initialized with the proper
+  Depending on the current setting of \ref setOpenGl and \ref setAsyncReplot, and the current Qt
+  version, different backends (subclasses of \ref QCPAbstractPaintBuffer) are created, initialized with the proper
   size and device pixel ratio, and returned.
 */
 QCPAbstractPaintBuffer *QCustomPlot::createPaintBuffer()
@@ -15894,7 +17827,9 @@ QCPAbstractPaintBuffer *QCustomPlot::createPaintBuffer()
     qDebug() << Q_FUNC_INFO << "OpenGL enabled even though no support for it compiled in, this shouldn't have happened. Falling back to pixmap paint buffer.";
     return new QCPPaintBufferPixmap(viewport().size(), mBufferDevicePixelRatio);
 #endif
-  } else
+  } else if (mAsyncReplot)
+    return new QCPPaintBufferImage(viewport().size(), mBufferDevicePixelRatio);
+  else
     return new QCPPaintBufferPixmap(viewport().size(), mBufferDevicePixelRatio);
 }
 
@@ -15919,6 +17854,56 @@ bool QCustomPlot::hasInvalidatedPaintBuffers()
   return false;
 }
 
+/*! \internal
+
+  Used by \ref replot if the \ref QCP::phDirtyLayers plotting hint is set. Returns for each paint
+  buffer whether it needs to be redrawn.
+
+  A buffer is dirty if it is invalidated (see \ref setupPaintBuffers), if its layer was marked
+  with \ref QCPLayer::markDirty, or if the \ref QCPLayerable::contentVersion of one of the
+  layerables on its layer changed since the last replot. If the viewport or the geometry of any
+  layout element changed, all buffers are dirty, since almost every layerable depends on it.
+
+  The current state is remembered as drawn, so calling this method again without any changes in
+  between returns no dirty buffers.
+*/
+QVector<bool> QCustomPlot::dirtyPaintBuffers()
+{
+  QVector<QRect> layoutRects;
+  layoutRects.append(mViewport);
+  foreach (QCPLayoutElement *element, mPlotLayout->elements(true))
+  {
+    if (element)
+      layoutRects << element->outerRect() << element->rect();
+    else
+      layoutRects << QRect() << QRect();
+  }
+  const bool layoutChanged = layoutRects != mDrawnLayoutRects;
+  mDrawnLayoutRects.swap(layoutRects);
+  
+  QVector<bool> dirty(mPaintBuffers.size(), layoutChanged);
+  foreach (QCPLayer *layer, mLayers)
+  {
+    const int bufferIndex = mPaintBuffers.indexOf(layer->mPaintBuffer.toStrongRef());
+    if (bufferIndex < 0)
+      continue;
+    bool layerDirty = layer->mDirty || mPaintBuffers.at(bufferIndex)->invalidated();
+    layer->mDirty = false;
+    foreach (QCPLayerable *child, layer->children())
+    {
+      const quint64 version = child->contentVersion();
+      if (version != child->mDrawnContentVersion)
+      {
+        child->mDrawnContentVersion = version;
+        layerDirty = true;
+      }
+    }
+    if (layerDirty)
+      dirty[bufferIndex] = true;
+  }
+  return dirty;
+}
+
 /*! \internal
 
   When \ref setOpenGl is set to true, this method is used to initialize OpenGL (create a context,
@@ -15999,6 +17984,221 @@ void QCustomPlot::freeOpenGl()
 #endif
 }
 
+/*! \internal
+  
+  Holds one asynchronous replot while it is rasterized by the worker threads: the recorded layers
+  of each paint buffer and the images they are played back into. The workers only access this
+  object, never the plot itself (apart from posting the completion).
+*/
+class QCPAsyncReplotFrame
+{
+public:
+  QCPAsyncReplotFrame() : plot(nullptr), devicePixelRatio(1.0), immediateRefresh(false), workerTime(0), profiler(nullptr), profilerFrame(0) {}
+  
+  QCustomPlot *plot;
+  QSize size;
+  double devicePixelRatio;
+  bool immediateRefresh; // whether finishAsyncReplot repaints the widget immediately, see QCustomPlot::RefreshPriority
+  QVector<QPicture> pictures; // recorded layers, one per paint buffer
+  QVector<QImage> images; // rasterized pictures, one per paint buffer
+  QVector<int> buffers; // indices of the paint buffers that are redrawn in this frame
+  QAtomicInt remaining; // number of buffers not rasterized yet
+  QSemaphore finished; // released once per rasterized buffer
+  QElapsedTimer timer;
+  double workerTime;
+  QCPReplotProfiler *profiler; // nullptr if the frame isn't profiled
+  int profilerFrame;
+  QVector<qint64> workerStart, workerEnd; // profiler timestamps, one per paint buffer
+  QVector<Qt::HANDLE> workerThreads;
+};
+
+/*! \internal
+  
+  Rasterizes one paint buffer of a \ref QCPAsyncReplotFrame in the global thread pool. The task
+  finishing the last buffer of the frame posts \ref QCustomPlot::finishAsyncReplot to the GUI
+  thread.
+*/
+class QCPAsyncReplotTask : public QRunnable
+{
+public:
+  QCPAsyncReplotTask(const QSharedPointer<QCPAsyncReplotFrame> &frame, int index) :
+    mFrame(frame), mIndex(index) {}
+  virtual void run() Q_DECL_OVERRIDE
+  {
+    QCPAsyncReplotFrame *frame = mFrame.data();
+    if (frame->profiler)
+    {
+      frame->workerStart[mIndex] = frame->profiler->timestamp();
+      frame->workerThreads[mIndex] = QThread::currentThreadId();
+    }
+    QImage &image = frame->images[mIndex];
+    const QSize pixelSize = frame->size*frame->devicePixelRatio;
+    if (image.size() != pixelSize || image.format() != QImage::Format_ARGB32_Premultiplied) // can't reuse the image of an earlier frame
+      image = QImage(pixelSize, QImage::Format_ARGB32_Premultiplied);
+#ifdef QCP_DEVICEPIXELRATIO_SUPPORTED
+    image.setDevicePixelRatio(frame->devicePixelRatio);
+#endif
+    image.fill(Qt::transparent);
+    {
+      QPainter painter(&image);
+      painter.drawPicture(0, 0, frame->pictures.at(mIndex));
+    }
+    if (frame->profiler)
+      frame->workerEnd[mIndex] = frame->profiler->timestamp();
+    if (!frame->remaining.deref()) // last buffer of this frame
+    {
+      frame->workerTime = frame->timer.nsecsElapsed()*1e-6;
+      QMetaObject::invokeMethod(frame->plot, "finishAsyncReplot", Qt::QueuedConnection);
+    }
+    frame->finished.release();
+  }
+private:
+  QSharedPointer<QCPAsyncReplotFrame> mFrame;
+  int mIndex;
+};
+
+/*! \internal
+  
+  Called by \ref replot instead of drawing the layers into the paint buffers, if \ref
+  setAsyncReplot is enabled.
+
+  The layers of each paint buffer are drawn into a QPicture with a painter in \ref
+  QCPPainter::pmNoCaching mode (pixmaps must not be painted outside the GUI thread). The painters
+  declare the replay device pixel ratio, so cached tick labels and scatter sprites are still
+  recorded, as images (see \ref QCPLabelCache and \ref QCPScatterStyle::drawShapes).
+  This is the only step that accesses plottables, axes and items. The pictures are then rasterized
+  by one \ref QCPAsyncReplotTask per paint buffer in the global QThreadPool, reusing the images
+  of the previously displayed frame if possible.
+
+  If the \ref QCP::phDirtyLayers plotting hint is set, only the dirty paint buffers (\ref
+  dirtyPaintBuffers) are recorded and rasterized. If there are none, no frame is started at all.
+  
+  \a refreshPriority is the one passed to \ref replot. It is kept with the frame so \ref
+  finishAsyncReplot repaints or updates the widget like a synchronous replot would.
+
+  \see finishAsyncReplot
+*/
+void QCustomPlot::startAsyncReplot(QCustomPlot::RefreshPriority refreshPriority)
+{
+  QCPReplotProfiler::Scope scope(mProfiler, "QCustomPlot::startAsyncReplot", QCPReplotProfiler::pcBuffers);
+  QVector<bool> dirty(mPaintBuffers.size(), true);
+  if (mPlottingHints.testFlag(QCP::phDirtyLayers))
+  {
+    dirty = dirtyPaintBuffers();
+    if (!dirty.contains(true))
+      return;
+  }
+  
+  QSharedPointer<QCPAsyncReplotFrame> frame(new QCPAsyncReplotFrame);
+  frame->plot = this;
+  frame->size = viewport().size();
+  frame->devicePixelRatio = mBufferDevicePixelRatio;
+  frame->immediateRefresh = (refreshPriority == rpRefreshHint && mPlottingHints.testFlag(QCP::phImmediateRefresh)) || refreshPriority == rpImmediateRefresh;
+  frame->pictures.resize(mPaintBuffers.size());
+  frame->images.swap(mAsyncSpareImages);
+  frame->images.resize(mPaintBuffers.size());
+  if (mProfiler->enabled())
+  {
+    frame->profiler = mProfiler;
+    frame->profilerFrame = mProfiler->mFrameNumber;
+    frame->workerStart.resize(mPaintBuffers.size());
+    frame->workerEnd.resize(mPaintBuffers.size());
+    frame->workerThreads.resize(mPaintBuffers.size());
+  }
+  
+  // record the layers, grouped by their paint buffer:
+  QVector<QCPPainter*> painters(mPaintBuffers.size(), nullptr);
+  foreach (QCPLayer *layer, mLayers)
+  {
+    const int bufferIndex = mPaintBuffers.indexOf(layer->mPaintBuffer.toStrongRef());
+    if (bufferIndex < 0)
+    {
+      qDebug() << Q_FUNC_INFO << "no valid paint buffer associated with layer" << layer->name();
+      continue;
+    }
+    if (!dirty.at(bufferIndex))
+      continue;
+    if (!painters.at(bufferIndex))
+    {
+      painters[bufferIndex] = new QCPPainter(&frame->pictures[bufferIndex]);
+      painters[bufferIndex]->setMode(QCPPainter::pmNoCaching);
+      painters[bufferIndex]->setReplayDevicePixelRatio(frame->devicePixelRatio);
+    }
+    layer->draw(painters.at(bufferIndex));
+  }
+  qDeleteAll(painters); // ends recording
+  
+  for (int i=0; i<dirty.size(); ++i)
+  {
+    if (dirty.at(i))
+      frame->buffers.append(i);
+  }
+  frame->remaining = frame->buffers.size();
+  frame->timer.start();
+  mAsyncFrame = frame;
+  foreach (int bufferIndex, frame->buffers)
+    QThreadPool::globalInstance()->start(new QCPAsyncReplotTask(frame, bufferIndex));
+}
+
+/*! \internal
+  
+  Called on the GUI thread when all paint buffers of the frame started by \ref startAsyncReplot
+  are rasterized. Exchanges the images of the redrawn paint buffers with the displayed ones (keeping
+  the latter for the next frame), repaints or updates the widget according to the refresh priority
+  of the \ref replot call (see \ref RefreshPriority) and emits \ref asyncReplotFinished. If the
+  viewport or the paint buffers changed in the meantime, the frame is discarded.
+
+  If \ref replot was called while the frame was rendering, the follow-up frame is started here.
+*/
+void QCustomPlot::finishAsyncReplot()
+{
+  QSharedPointer<QCPAsyncReplotFrame> frame = mAsyncFrame;
+  if (!frame)
+    return;
+  mAsyncFrame.clear();
+  
+  if (frame->size == viewport().size() && qFuzzyCompare(frame->devicePixelRatio, mBufferDevicePixelRatio) && frame->images.size() == mPaintBuffers.size())
+  {
+    foreach (int i, frame->buffers)
+    {
+      if (QCPPaintBufferImage *buffer = dynamic_cast<QCPPaintBufferImage*>(mPaintBuffers.at(i).data()))
+      {
+        buffer->swapImage(frame->images[i]);
+        buffer->setInvalidated(false);
+      }
+    }
+    mAsyncSpareImages.swap(frame->images);
+    if (frame->immediateRefresh)
+      repaint();
+    else
+      update();
+  } else
+  {
+    // the frame is discarded, so the buffers it would have updated must be redrawn by the next one:
+    foreach (QSharedPointer<QCPAbstractPaintBuffer> buffer, mPaintBuffers)
+      buffer->setInvalidated();
+    mAsyncReplotPending = true;
+  }
+  
+  if (frame->profiler)
+  {
+    foreach (int i, frame->buffers)
+      mProfiler->addWorkerEvent(frame->profilerFrame, QString(QLatin1String("rasterize paint buffer %1")).arg(i), frame->workerThreads.at(i), frame->workerStart.at(i), frame->workerEnd.at(i));
+  }
+  mReplotWorkerTime = frame->workerTime;
+  if (!qFuzzyIsNull(mReplotWorkerTimeAverage))
+    mReplotWorkerTimeAverage = mReplotWorkerTimeAverage*0.9 + mReplotWorkerTime*0.1;
+  else
+    mReplotWorkerTimeAverage = mReplotWorkerTime;
+  
+  emit asyncReplotFinished();
+  if (mAsyncReplotPending)
+  {
+    mAsyncReplotPending = false;
+    replot();
+  }
+}
+
 /*! \internal
   
   This method is used by \ref QCPAxisRect::removeAxis to report removed axes to the QCustomPlot
@@ -16502,6 +18702,38 @@ void QCustomPlot::toPainter(QCPPainter *painter, int width, int height)
 /* modified 2022-11-06T12:45:56, size 25408 */
 
 
+/*! \internal
+  
+  Returns \a rgb with all components (including alpha) multiplied with \a alpha/255, as required
+  for QImage::Format_ARGB32_Premultiplied.
+*/
+static inline QRgb qcpPremultiplyAlpha(QRgb rgb, unsigned char alpha)
+{
+  return qRgba(qRed(rgb)*alpha/255, qGreen(rgb)*alpha/255, qBlue(rgb)*alpha/255, qAlpha(rgb)*alpha/255);
+}
+
+#ifdef QCP_SSE2
+/*! \internal
+  
+  Does the same as \ref qcpPremultiplyAlpha for the four pixels at \a pixels, with their alpha
+  values taken from \a alpha every \a alphaStride bytes. The channels are multiplied in 16 bit
+  lanes and divided by 255 with a multiply-high by 0x8081 and a shift by 7, which is exact for all
+  products of two bytes.
+*/
+static inline void qcpPremultiplyAlpha4(QRgb *pixels, const unsigned char *alpha, int alphaStride)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i divide255 = _mm_set1_epi16(short(0x8081));
+  const short a0 = alpha[0], a1 = alpha[alphaStride], a2 = alpha[2*alphaStride], a3 = alpha[3*alphaStride];
+  const __m128i rgba = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels));
+  __m128i low = _mm_mullo_epi16(_mm_unpacklo_epi8(rgba, zero), _mm_set_epi16(a1, a1, a1, a1, a0, a0, a0, a0));
+  __m128i high = _mm_mullo_epi16(_mm_unpackhi_epi8(rgba, zero), _mm_set_epi16(a3, a3, a3, a3, a2, a2, a2, a2));
+  low = _mm_srli_epi16(_mm_mulhi_epu16(low, divide255), 7);
+  high = _mm_srli_epi16(_mm_mulhi_epu16(high, divide255), 7);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels), _mm_packus_epi16(low, high));
+}
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////// QCPColorGradient
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -16724,8 +18956,22 @@ void QCPColorGradient::colorize(const double *data, const QCPRange &range, QRgb
   
   const bool skipNanCheck = mNanHandling == nhNone;
   const double posToIndexFactor = !logarithmic ? (mLevelCount-1)/range.size() : (mLevelCount-1)/qLn(range.upper/range.lower);
+#ifdef QCP_SSE2
+  const bool simd = !mPeriodic;
+#endif
   for (int i=0; i<n; ++i)
   {
+#ifdef QCP_SSE2
+    if (simd)
+    {
+      if (!logarithmic)
+        i += colorizeLinearSimd(data+dataIndexFactor*i, range, posToIndexFactor, scanLine+i, n-i, dataIndexFactor, skipNanCheck); // stops before NaN pairs and the odd last value, which are handled below
+      else
+        i += colorizeLogarithmicSimd(data+dataIndexFactor*i, range, posToIndexFactor, scanLine+i, n-i, dataIndexFactor, skipNanCheck);
+      if (i >= n)
+        break;
+    }
+#endif
     const double value = data[dataIndexFactor*i];
     if (skipNanCheck || !std::isnan(value))
     {
@@ -16780,47 +19026,32 @@ void QCPColorGradient::colorize(const double *data, const unsigned char *alpha,
     qDebug() << Q_FUNC_INFO << "null pointer given as scanLine";
     return;
   }
-  if (mColorBufferInvalidated)
-    updateColorBuffer();
+  colorize(data, range, scanLine, n, dataIndexFactor, logarithmic);
   
+  // premultiply the colors with the cell alpha, NaN cells keep the color given by the NaN handling:
   const bool skipNanCheck = mNanHandling == nhNone;
-  const double posToIndexFactor = !logarithmic ? (mLevelCount-1)/range.size() : (mLevelCount-1)/qLn(range.upper/range.lower);
-  for (int i=0; i<n; ++i)
+  int i = 0;
+#ifdef QCP_SSE2
+  for (; i+3<n; i+=4)
   {
-    const double value = data[dataIndexFactor*i];
-    if (skipNanCheck || !std::isnan(value))
+    if (skipNanCheck || !(std::isnan(data[dataIndexFactor*i]) || std::isnan(data[dataIndexFactor*(i+1)]) || std::isnan(data[dataIndexFactor*(i+2)]) || std::isnan(data[dataIndexFactor*(i+3)])))
     {
-      qint64 index = qint64((!logarithmic ? value-range.lower : qLn(value/range.lower)) * posToIndexFactor);
-      if (!mPeriodic)
-      {
-        index = qBound(qint64(0), index, qint64(mLevelCount-1));
-      } else
-      {
-        index %= mLevelCount;
-        if (index < 0)
-          index += mLevelCount;
-      }
-      if (alpha[dataIndexFactor*i] == 255)
-      {
-        scanLine[i] = mColorBuffer.at(index);
-      } else
-      {
-        const QRgb rgb = mColorBuffer.at(index);
-        const float alphaF = alpha[dataIndexFactor*i]/255.0f;
-        scanLine[i] = qRgba(int(qRed(rgb)*alphaF), int(qGreen(rgb)*alphaF), int(qBlue(rgb)*alphaF), int(qAlpha(rgb)*alphaF)); // also multiply r,g,b with alpha, to conform to Format_ARGB32_Premultiplied
-      }
+      qcpPremultiplyAlpha4(scanLine+i, alpha+dataIndexFactor*i, dataIndexFactor);
     } else
     {
-      switch(mNanHandling)
+      for (int k=i; k<i+4; ++k)
       {
-      case nhLowestColor: scanLine[i] = mColorBuffer.first(); break;
-      case nhHighestColor: scanLine[i] = mColorBuffer.last(); break;
-      case nhTransparent: scanLine[i] = qRgba(0, 0, 0, 0); break;
-      case nhNanColor: scanLine[i] = mNanColor.rgba(); break;
-      case nhNone: break; // shouldn't happen
+        if (alpha[dataIndexFactor*k] != 255 && !std::isnan(data[dataIndexFactor*k]))
+          scanLine[k] = qcpPremultiplyAlpha(scanLine[k], alpha[dataIndexFactor*k]);
       }
     }
   }
+#endif
+  for (; i<n; ++i)
+  {
+    if (alpha[dataIndexFactor*i] != 255 && (skipNanCheck || !std::isnan(data[dataIndexFactor*i])))
+      scanLine[i] = qcpPremultiplyAlpha(scanLine[i], alpha[dataIndexFactor*i]); // also multiply r,g,b with alpha, to conform to Format_ARGB32_Premultiplied
+  }
 }
 
 /*! \internal
@@ -17130,6 +19361,97 @@ void QCPColorGradient::updateColorBuffer()
   }
   mColorBufferInvalidated = false;
 }
+
+/*! \internal
+  
+  Colorizes the values in \a data with SSE2 for a linear, non-periodic gradient, two values at a
+  time: normalization, clamping to the color buffer and index conversion run in vector registers,
+  only the color buffer lookups are scalar. Stops at the first pair containing a NaN value (unless
+  \a skipNanCheck is true) or when fewer than two values are left, and returns the number of
+  values processed, so the caller can handle the remainder with the regular code path.
+  
+  The color buffer must be up to date. Returns 0 if the library wasn't compiled with SSE2 support.
+*/
+int QCPColorGradient::colorizeLinearSimd(const double *data, const QCPRange &range, double posToIndexFactor, QRgb *scanLine, int n, int dataIndexFactor, bool skipNanCheck) const
+{
+#ifdef QCP_SSE2
+  const QRgb *colors = mColorBuffer.constData();
+  const __m128d lower = _mm_set1_pd(range.lower);
+  const __m128d factor = _mm_set1_pd(posToIndexFactor);
+  const __m128d minIndex = _mm_setzero_pd();
+  const __m128d maxIndex = _mm_set1_pd(mLevelCount-1);
+  int i = 0;
+  for (; i+1<n; i+=2)
+  {
+    const __m128d value = _mm_set_pd(data[dataIndexFactor*(i+1)], data[dataIndexFactor*i]);
+    if (!skipNanCheck && _mm_movemask_pd(_mm_cmpunord_pd(value, value)) != 0)
+      break;
+    // clamping before the truncation gives the same index as truncating and clamping afterwards, without integer overflow for huge values:
+    const __m128d position = _mm_min_pd(_mm_max_pd(_mm_mul_pd(_mm_sub_pd(value, lower), factor), minIndex), maxIndex);
+    const __m128i index = _mm_cvttpd_epi32(position);
+    scanLine[i] = colors[_mm_cvtsi128_si32(index)];
+    scanLine[i+1] = colors[_mm_cvtsi128_si32(_mm_srli_si128(index, 4))];
+  }
+  return i;
+#else
+  Q_UNUSED(data)
+  Q_UNUSED(range)
+  Q_UNUSED(posToIndexFactor)
+  Q_UNUSED(scanLine)
+  Q_UNUSED(n)
+  Q_UNUSED(dataIndexFactor)
+  Q_UNUSED(skipNanCheck)
+  return 0;
+#endif
+}
+
+/*! \internal
+  
+  Colorizes the values in \a data with SSE2 for a logarithmic, non-periodic gradient. SSE2 has no
+  logarithm instruction, so the logarithms relative to \a range.lower are taken in blocks of 64
+  values into a local buffer, which is then colorized by \ref colorizeLinearSimd with a lower bound
+  of zero. This produces exactly the indices of the scalar code path. Values with a non-positive
+  ratio to \a range.lower have a NaN or infinite logarithm and end up at the lowest color, just
+  like in the scalar code path.
+  
+  Stops before the first NaN data value (unless \a skipNanCheck is true) or when fewer than two
+  values are left, and returns the number of values processed. Returns 0 if the library wasn't
+  compiled with SSE2 support.
+*/
+int QCPColorGradient::colorizeLogarithmicSimd(const double *data, const QCPRange &range, double posToIndexFactor, QRgb *scanLine, int n, int dataIndexFactor, bool skipNanCheck) const
+{
+#ifdef QCP_SSE2
+  const int blockSize = 64;
+  double logValues[blockSize];
+  int i = 0;
+  while (i+1 < n)
+  {
+    int count = 0;
+    for (; count<blockSize && i+count<n; ++count)
+    {
+      const double value = data[dataIndexFactor*(i+count)];
+      if (!skipNanCheck && std::isnan(value))
+        break;
+      logValues[count] = qLn(value/range.lower);
+    }
+    // remaining NaNs stem from invalid ratios, which the clamping in colorizeLinearSimd maps to index 0:
+    const int processed = colorizeLinearSimd(logValues, QCPRange(), posToIndexFactor, scanLine+i, count, 1, true);
+    i += processed;
+    if (processed < blockSize) // reached a NaN data value or the end of the data
+      break;
+  }
+  return i;
+#else
+  Q_UNUSED(data)
+  Q_UNUSED(range)
+  Q_UNUSED(posToIndexFactor)
+  Q_UNUSED(scanLine)
+  Q_UNUSED(n)
+  Q_UNUSED(dataIndexFactor)
+  Q_UNUSED(skipNanCheck)
+  return 0;
+#endif
+}
 /* end of 'src/colorgradient.cpp' */
 
 
@@ -18056,6 +20378,7 @@ void QCPAxisRect::setBackground(const QPixmap &pm)
 {
   mBackgroundPixmap = pm;
   mScaledBackgroundPixmap = QPixmap();
+  markDirty();
 }
 
 /*! \overload
@@ -18074,6 +20397,7 @@ void QCPAxisRect::setBackground(const QPixmap &pm)
 void QCPAxisRect::setBackground(const QBrush &brush)
 {
   mBackgroundBrush = brush;
+  markDirty();
 }
 
 /*! \overload
@@ -18089,6 +20413,7 @@ void QCPAxisRect::setBackground(const QPixmap &pm, bool scaled, Qt::AspectRatioM
   mScaledBackgroundPixmap = QPixmap();
   mBackgroundScaled = scaled;
   mBackgroundScaledMode = mode;
+  markDirty();
 }
 
 /*!
@@ -18104,6 +20429,7 @@ void QCPAxisRect::setBackground(const QPixmap &pm, bool scaled, Qt::AspectRatioM
 void QCPAxisRect::setBackgroundScaled(bool scaled)
 {
   mBackgroundScaled = scaled;
+  markDirty();
 }
 
 /*!
@@ -18114,6 +20440,7 @@ void QCPAxisRect::setBackgroundScaled(bool scaled)
 void QCPAxisRect::setBackgroundScaledMode(Qt::AspectRatioMode mode)
 {
   mBackgroundScaledMode = mode;
+  markDirty();
 }
 
 /*!
@@ -18771,6 +21098,7 @@ QCPAbstractLegendItem::QCPAbstractLegendItem(QCPLegend *parent) :
 void QCPAbstractLegendItem::setFont(const QFont &font)
 {
   mFont = font;
+  markDirty();
 }
 
 /*!
@@ -18781,6 +21109,7 @@ void QCPAbstractLegendItem::setFont(const QFont &font)
 void QCPAbstractLegendItem::setTextColor(const QColor &color)
 {
   mTextColor = color;
+  markDirty();
 }
 
 /*!
@@ -18792,6 +21121,7 @@ void QCPAbstractLegendItem::setTextColor(const QColor &color)
 void QCPAbstractLegendItem::setSelectedFont(const QFont &font)
 {
   mSelectedFont = font;
+  markDirty();
 }
 
 /*!
@@ -18803,6 +21133,7 @@ void QCPAbstractLegendItem::setSelectedFont(const QFont &font)
 void QCPAbstractLegendItem::setSelectedTextColor(const QColor &color)
 {
   mSelectedTextColor = color;
+  markDirty();
 }
 
 /*!
@@ -18834,6 +21165,7 @@ void QCPAbstractLegendItem::setSelected(bool selected)
     mSelected = selected;
     emit selectionChanged(mSelected);
   }
+  markDirty();
 }
 
 /* inherits documentation from base class */
@@ -18930,6 +21262,18 @@ QCPPlottableLegendItem::QCPPlottableLegendItem(QCPLegend *parent, QCPAbstractPlo
   setAntialiased(false);
 }
 
+/*!
+  Returns a value that changes whenever the properties of this legend item or of the associated
+  plottable (e.g. its name or pen) change. Data changes of the plottable are ignored, since the
+  legend icon doesn't show data.
+  
+  \seebaseclassmethod
+*/
+quint64 QCPPlottableLegendItem::contentVersion() const
+{
+  return qcpCombineVersions(QCPLayerable::contentVersion(), mPlottable->propertyVersion());
+}
+
 /*! \internal
   
   Returns the pen that shall be used to draw the icon border, taking into account the selection
@@ -19129,6 +21473,7 @@ QCPLegend::SelectableParts QCPLegend::selectedParts() const
 void QCPLegend::setBorderPen(const QPen &pen)
 {
   mBorderPen = pen;
+  markDirty();
 }
 
 /*!
@@ -19137,6 +21482,7 @@ void QCPLegend::setBorderPen(const QPen &pen)
 void QCPLegend::setBrush(const QBrush &brush)
 {
   mBrush = brush;
+  markDirty();
 }
 
 /*!
@@ -19156,6 +21502,7 @@ void QCPLegend::setFont(const QFont &font)
     if (item(i))
       item(i)->setFont(mFont);
   }
+  markDirty();
 }
 
 /*!
@@ -19175,6 +21522,7 @@ void QCPLegend::setTextColor(const QColor &color)
     if (item(i))
       item(i)->setTextColor(color);
   }
+  markDirty();
 }
 
 /*!
@@ -19184,6 +21532,7 @@ void QCPLegend::setTextColor(const QColor &color)
 void QCPLegend::setIconSize(const QSize &size)
 {
   mIconSize = size;
+  markDirty();
 }
 
 /*! \overload
@@ -19192,6 +21541,7 @@ void QCPLegend::setIconSize(int width, int height)
 {
   mIconSize.setWidth(width);
   mIconSize.setHeight(height);
+  markDirty();
 }
 
 /*!
@@ -19202,6 +21552,7 @@ void QCPLegend::setIconSize(int width, int height)
 void QCPLegend::setIconTextPadding(int padding)
 {
   mIconTextPadding = padding;
+  markDirty();
 }
 
 /*!
@@ -19213,6 +21564,7 @@ void QCPLegend::setIconTextPadding(int padding)
 void QCPLegend::setIconBorderPen(const QPen &pen)
 {
   mIconBorderPen = pen;
+  markDirty();
 }
 
 /*!
@@ -19278,6 +21630,7 @@ void QCPLegend::setSelectedParts(const SelectableParts &selected)
     mSelectedParts = newSelected;
     emit selectionChanged(mSelectedParts);
   }
+  markDirty();
 }
 
 /*!
@@ -19289,6 +21642,7 @@ void QCPLegend::setSelectedParts(const SelectableParts &selected)
 void QCPLegend::setSelectedBorderPen(const QPen &pen)
 {
   mSelectedBorderPen = pen;
+  markDirty();
 }
 
 /*!
@@ -19299,6 +21653,7 @@ void QCPLegend::setSelectedBorderPen(const QPen &pen)
 void QCPLegend::setSelectedIconBorderPen(const QPen &pen)
 {
   mSelectedIconBorderPen = pen;
+  markDirty();
 }
 
 /*!
@@ -19310,6 +21665,7 @@ void QCPLegend::setSelectedIconBorderPen(const QPen &pen)
 void QCPLegend::setSelectedBrush(const QBrush &brush)
 {
   mSelectedBrush = brush;
+  markDirty();
 }
 
 /*!
@@ -19327,6 +21683,7 @@ void QCPLegend::setSelectedFont(const QFont &font)
     if (item(i))
       item(i)->setSelectedFont(font);
   }
+  markDirty();
 }
 
 /*!
@@ -19344,6 +21701,7 @@ void QCPLegend::setSelectedTextColor(const QColor &color)
     if (item(i))
       item(i)->setSelectedTextColor(color);
   }
+  markDirty();
 }
 
 /*!
@@ -19797,6 +22155,7 @@ QCPTextElement::QCPTextElement(QCustomPlot *parentPlot, const QString &text, con
 void QCPTextElement::setText(const QString &text)
 {
   mText = text;
+  markDirty();
 }
 
 /*!
@@ -19822,6 +22181,7 @@ void QCPTextElement::setText(const QString &text)
 void QCPTextElement::setTextFlags(int flags)
 {
   mTextFlags = flags;
+  markDirty();
 }
 
 /*!
@@ -19832,6 +22192,7 @@ void QCPTextElement::setTextFlags(int flags)
 void QCPTextElement::setFont(const QFont &font)
 {
   mFont = font;
+  markDirty();
 }
 
 /*!
@@ -19842,6 +22203,7 @@ void QCPTextElement::setFont(const QFont &font)
 void QCPTextElement::setTextColor(const QColor &color)
 {
   mTextColor = color;
+  markDirty();
 }
 
 /*!
@@ -19852,6 +22214,7 @@ void QCPTextElement::setTextColor(const QColor &color)
 void QCPTextElement::setSelectedFont(const QFont &font)
 {
   mSelectedFont = font;
+  markDirty();
 }
 
 /*!
@@ -19862,6 +22225,7 @@ void QCPTextElement::setSelectedFont(const QFont &font)
 void QCPTextElement::setSelectedTextColor(const QColor &color)
 {
   mSelectedTextColor = color;
+  markDirty();
 }
 
 /*!
@@ -19893,6 +22257,7 @@ void QCPTextElement::setSelected(bool selected)
     mSelected = selected;
     emit selectionChanged(mSelected);
   }
+  markDirty();
 }
 
 /* inherits documentation from base class */
@@ -20232,6 +22597,7 @@ void QCPColorScale::setType(QCPAxis::AxisType type)
     connect(mColorAxis.data(), SIGNAL(scaleTypeChanged(QCPAxis::ScaleType)), this, SLOT(setDataScaleType(QCPAxis::ScaleType)));
     mAxisRect.data()->setRangeDragAxes(QList<QCPAxis*>() << mColorAxis.data());
   }
+  markDirty();
 }
 
 /*!
@@ -20252,6 +22618,7 @@ void QCPColorScale::setDataRange(const QCPRange &dataRange)
       mColorAxis.data()->setRange(mDataRange);
     emit dataRangeChanged(mDataRange);
   }
+  markDirty();
 }
 
 /*!
@@ -20284,6 +22651,7 @@ void QCPColorScale::setDataScaleType(QCPAxis::ScaleType scaleType)
       setDataRange(mDataRange.sanitizedForLogScale());
     emit dataScaleTypeChanged(mDataScaleType);
   }
+  markDirty();
 }
 
 /*!
@@ -20302,6 +22670,7 @@ void QCPColorScale::setGradient(const QCPColorGradient &gradient)
       mAxisRect.data()->mGradientImageInvalidated = true;
     emit gradientChanged(mGradient);
   }
+  markDirty();
 }
 
 /*!
@@ -20317,6 +22686,7 @@ void QCPColorScale::setLabel(const QString &str)
   }
   
   mColorAxis.data()->setLabel(str);
+  markDirty();
 }
 
 /*!
@@ -20326,6 +22696,7 @@ void QCPColorScale::setLabel(const QString &str)
 void QCPColorScale::setBarWidth(int width)
 {
   mBarWidth = width;
+  markDirty();
 }
 
 /*!
@@ -20353,6 +22724,7 @@ void QCPColorScale::setRangeDrag(bool enabled)
     mAxisRect.data()->setRangeDrag({});
 #endif
   }
+  markDirty();
 }
 
 /*!
@@ -20380,6 +22752,7 @@ void QCPColorScale::setRangeZoom(bool enabled)
     mAxisRect.data()->setRangeZoom({});
 #endif
   }
+  markDirty();
 }
 
 /*!
@@ -20811,6 +23184,214 @@ QCPGraphData::QCPGraphData(double key, double value) :
 }
 
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPGraphColumnData
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPGraphColumnData
+  \brief Holds the data points of a QCPGraph as separate key and value arrays
+  
+  \ref QCPGraphDataContainer stores a graph's data points as an array of \ref QCPGraphData structs.
+  Applications which already hold their samples in separate key and value arrays would have to
+  copy them into such an array, doubling the memory use. QCPGraphColumnData instead references the
+  existing arrays and is passed to the graph with \ref QCPGraph::setColumnData:
+  
+  \li \ref setData shares two QVector<double> via Qt's implicit sharing, so no data is copied as
+  long as neither side modifies its vector.
+  \li \ref setRawData adopts two plain arrays, e.g. buffers of an acquisition driver or a file
+  mapped with QFile::map. The arrays aren't copied and not owned by this object, so they must stay
+  valid (and unchanged, except as announced by \ref markModified) for as long as they are set.
+  
+  The keys must be sorted ascending. Since the arrays are used as they are, they are neither sorted
+  nor checked. Gaps may be created with NaN values, like for regular graph data.
+  
+  The graph transforms the columns to pixels in batches, see \ref QCPAxis::coordsToPixels. When
+  samples are appended to preallocated external arrays, call \ref setRawData again with the new
+  size. After modifying values in place, call \ref markModified.
+*/
+
+/* start documentation of inline functions */
+
+/*! \fn bool QCPGraphColumnData::isRawData() const
+  
+  Returns whether the columns are external arrays adopted with \ref setRawData, as opposed to
+  vectors shared via \ref setData.
+*/
+
+/*! \fn quint64 QCPGraphColumnData::version() const
+  
+  Returns a number that changes whenever the columns are replaced, resized or marked modified (\ref
+  markModified). Graphs report it as part of their \ref QCPAbstractPlottable::dataVersion.
+*/
+
+/*! \fn void QCPGraphColumnData::markModified()
+  
+  Announces that the values in the columns were changed in place, so graphs using this object are
+  redrawn if the \ref QCP::phDirtyLayers plotting hint is set.
+*/
+
+/* end documentation of inline functions */
+
+/*!
+  Constructs empty column data.
+*/
+QCPGraphColumnData::QCPGraphColumnData() :
+  mKeys(nullptr),
+  mValues(nullptr),
+  mSize(0),
+  mVersion(0)
+{
+}
+
+/*!
+  Constructs column data sharing \a keys and \a values, see \ref setData.
+*/
+QCPGraphColumnData::QCPGraphColumnData(const QVector<double> &keys, const QVector<double> &values) :
+  mKeys(nullptr),
+  mValues(nullptr),
+  mSize(0),
+  mVersion(0)
+{
+  setData(keys, values);
+}
+
+/*!
+  Uses \a keys and \a values as columns. The vectors are implicitly shared, not copied. The provided
+  vectors should have equal length. Else, the number of data points will be the size of the
+  smallest vector.
+  
+  \see setRawData
+*/
+void QCPGraphColumnData::setData(const QVector<double> &keys, const QVector<double> &values)
+{
+  if (keys.size() != values.size())
+    qDebug() << Q_FUNC_INFO << "keys and values have different sizes:" << keys.size() << values.size();
+  mKeyVector = keys;
+  mValueVector = values;
+  mKeys = mKeyVector.constData();
+  mValues = mValueVector.constData();
+  mSize = qMin(keys.size(), values.size());
+  ++mVersion;
+}
+
+/*!
+  Adopts the arrays \a keys and \a values, each holding \a size entries, as columns without
+  copying them. The caller keeps ownership and must keep the arrays valid until other data is set
+  or this object is destroyed.
+  
+  \see setData
+*/
+void QCPGraphColumnData::setRawData(const double *keys, const double *values, int size)
+{
+  mKeyVector.clear();
+  mValueVector.clear();
+  mKeys = keys;
+  mValues = values;
+  mSize = keys && values ? qMax(0, size) : 0;
+  ++mVersion;
+}
+
+/*!
+  Removes the columns. Adopted raw arrays are released to the caller, shared vectors are
+  dereferenced.
+*/
+void QCPGraphColumnData::clear()
+{
+  setRawData(nullptr, nullptr, 0);
+}
+
+/*!
+  Returns the index of the data point with a key that is equal to, just below or just above \a
+  key. If \a expandedRange is true, the data point just below \a key will be considered,
+  otherwise the one just above. This has the same semantics as \ref QCPDataContainer::findBegin.
+  
+  \see findEnd
+*/
+int QCPGraphColumnData::findBegin(double key, bool expandedRange) const
+{
+  int index = int(std::lower_bound(mKeys, mKeys+mSize, key)-mKeys);
+  if (expandedRange && index > 0)
+    --index;
+  return index;
+}
+
+/*!
+  Returns the index after the data point with a key that is equal to, just above or just below \a
+  key. If \a expandedRange is true, the data point just above \a key will be considered,
+  otherwise the one just below. This has the same semantics as \ref QCPDataContainer::findEnd.
+  
+  \see findBegin
+*/
+int QCPGraphColumnData::findEnd(double key, bool expandedRange) const
+{
+  int index = int(std::upper_bound(mKeys, mKeys+mSize, key)-mKeys);
+  if (expandedRange && index < mSize)
+    ++index;
+  return index;
+}
+
+/*!
+  Returns the range encompassed by the keys of all data points with non-NaN values. Since the keys
+  are sorted, only the first and last such key within the sign domain \a signDomain are looked up.
+  
+  \see QCPDataContainer::keyRange
+*/
+QCPRange QCPGraphColumnData::keyRange(bool &foundRange, QCP::SignDomain signDomain) const
+{
+  int begin = 0;
+  int end = mSize;
+  if (signDomain == QCP::sdNegative)
+    end = int(std::lower_bound(mKeys, mKeys+mSize, 0.0)-mKeys);
+  else if (signDomain == QCP::sdPositive)
+    begin = int(std::upper_bound(mKeys, mKeys+mSize, 0.0)-mKeys);
+  while (begin < end && qIsNaN(mValues[begin]))
+    ++begin;
+  while (end > begin && qIsNaN(mValues[end-1]))
+    --end;
+  foundRange = begin < end;
+  return foundRange ? QCPRange(mKeys[begin], mKeys[end-1]) : QCPRange();
+}
+
+/*!
+  Returns the range encompassed by the values of all data points, optionally restricted to data
+  points with keys inside \a inKeyRange (if it isn't a default-constructed QCPRange). Only values in
+  the sign domain \a signDomain are considered.
+  
+  \see QCPDataContainer::valueRange
+*/
+QCPRange QCPGraphColumnData::valueRange(bool &foundRange, QCP::SignDomain signDomain, const QCPRange &inKeyRange) const
+{
+  int begin = 0;
+  int end = mSize;
+  if (inKeyRange != QCPRange())
+  {
+    begin = findBegin(inKeyRange.lower, false);
+    end = findEnd(inKeyRange.upper, false);
+  }
+  QCPRange range;
+  bool haveLower = false;
+  bool haveUpper = false;
+  for (int i=begin; i<end; ++i)
+  {
+    const double current = mValues[i];
+    if (!std::isfinite(current) || (signDomain == QCP::sdNegative && current >= 0) || (signDomain == QCP::sdPositive && current <= 0))
+      continue;
+    if (current < range.lower || !haveLower)
+    {
+      range.lower = current;
+      haveLower = true;
+    }
+    if (current > range.upper || !haveUpper)
+    {
+      range.upper = current;
+      haveUpper = true;
+    }
+  }
+  foundRange = haveLower && haveUpper;
+  return range;
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////// QCPGraph
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -20849,6 +23430,11 @@ QCPGraphData::QCPGraphData(double key, double value) :
   By default, a normal fill towards the zero-value-line will be drawn. To set up a channel fill
   between this graph and another one, call \ref setChannelFillGraph with the other graph as
   parameter.
+  
+  \section qcpgraph-columns Column data
+  
+  If the samples are already held in separate key and value arrays, they can be drawn without
+  copying them into the data container, see \ref setColumnData and \ref QCPGraphColumnData.
 
   \see QCustomPlot::addGraph, QCustomPlot::graph
 */
@@ -20862,6 +23448,14 @@ QCPGraphData::QCPGraphData(double key, double value) :
   regular \ref setData or \ref addData methods.
 */
 
+/*! \fn QSharedPointer<QCPGraphColumnData> QCPGraph::columnData() const
+  
+  Returns the column data drawn instead of the data container, or a null pointer if the data
+  container is drawn.
+  
+  \see setColumnData
+*/
+
 /* end of documentation of inline functions */
 
 /*!
@@ -20880,7 +23474,8 @@ QCPGraph::QCPGraph(QCPAxis *keyAxis, QCPAxis *valueAxis) :
   QCPAbstractPlottable1D<QCPGraphData>(keyAxis, valueAxis),
   mLineStyle{},
   mScatterSkip{},
-  mAdaptiveSampling{}
+  mAdaptiveSampling{},
+  mLineCacheVersion(0)
 {
   // special handling for QCPGraphs to maintain the simple graph interface:
   mParentPlot->registerGraph(this);
@@ -20916,6 +23511,7 @@ QCPGraph::~QCPGraph()
 void QCPGraph::setData(QSharedPointer<QCPGraphDataContainer> data)
 {
   mDataContainer = data;
+  markDirty();
 }
 
 /*! \overload
@@ -20933,6 +23529,36 @@ void QCPGraph::setData(const QVector<double> &keys, const QVector<double> &value
 {
   mDataContainer->clear();
   addData(keys, values, alreadySorted);
+  markDirty();
+}
+
+/*!
+  Makes the graph draw the data points in \a columnData instead of its data container. Pass a null
+  pointer to draw the data container again.
+  
+  \ref QCPGraphColumnData keeps keys and values in separate arrays, which may also be adopted from
+  external memory without copying. Use it if the samples are already available column-wise, e.g.
+  from an acquisition stack or a memory mapped file, to avoid holding a second copy of all samples
+  as \ref QCPGraphData.
+  
+  While column data is set, the graph
+  \li transforms the visible data points to pixels in batches (see \ref QCPAxis::coordsToPixels)
+  and, with adaptive sampling, reduces them to the first, last, minimum and maximum data point per
+  key pixel,
+  \li reports the key and value ranges of the columns,
+  \li can only be selected as a whole: any selection highlights all data points.
+  
+  The data container (\ref data) is left untouched. The \ref QCPPlottableInterface1D methods
+  refer to the column data, so items and plottables that access the graph's data through this
+  interface, like \ref QCPItemTracer, \ref QCPErrorBars or the channel fill of another graph (\ref
+  setChannelFillGraph), work with it.
+  
+  Since a QSharedPointer is used, multiple graphs may share the same column data.
+*/
+void QCPGraph::setColumnData(QSharedPointer<QCPGraphColumnData> columnData)
+{
+  mColumnData = columnData;
+  markDirty();
 }
 
 /*!
@@ -20944,6 +23570,7 @@ void QCPGraph::setData(const QVector<double> &keys, const QVector<double> &value
 void QCPGraph::setLineStyle(LineStyle ls)
 {
   mLineStyle = ls;
+  markDirty();
 }
 
 /*!
@@ -20955,6 +23582,7 @@ void QCPGraph::setLineStyle(LineStyle ls)
 void QCPGraph::setScatterStyle(const QCPScatterStyle &style)
 {
   mScatterStyle = style;
+  markDirty();
 }
 
 /*!
@@ -20971,6 +23599,7 @@ void QCPGraph::setScatterStyle(const QCPScatterStyle &style)
 void QCPGraph::setScatterSkip(int skip)
 {
   mScatterSkip = qMax(0, skip);
+  markDirty();
 }
 
 /*!
@@ -21000,6 +23629,7 @@ void QCPGraph::setChannelFillGraph(QCPGraph *targetGraph)
   }
   
   mChannelFillGraph = targetGraph;
+  markDirty();
 }
 
 /*!
@@ -21032,10 +23662,16 @@ void QCPGraph::setChannelFillGraph(QCPGraph *targetGraph)
   sampling off. For example, when saving the plot to disk. This can be achieved by setting \a
   enabled to false before issuing a command like \ref QCustomPlot::savePng, and setting \a enabled
   back to true afterwards.
+  
+  The adaptive sampling itself still visits every visible data point. For graphs with millions of
+  points, enable the level-of-detail index of the data container (\ref
+  QCPDataContainer::setLevelOfDetailEnabled, e.g. via <tt>data()->setLevelOfDetailEnabled(true)</tt>),
+  so the cost of adaptive sampling only depends on the pixel width of the key axis.
 */
 void QCPGraph::setAdaptiveSampling(bool enabled)
 {
   mAdaptiveSampling = enabled;
+  markDirty();
 }
 
 /*! \overload
@@ -21091,13 +23727,19 @@ void QCPGraph::addData(double key, double value)
 */
 double QCPGraph::selectTest(const QPointF &pos, bool onlySelectable, QVariant *details) const
 {
-  if ((onlySelectable && mSelectable == QCP::stNone) || mDataContainer->isEmpty())
+  if ((onlySelectable && mSelectable == QCP::stNone) || (mColumnData ? mColumnData->isEmpty() : mDataContainer->isEmpty()))
     return -1;
   if (!mKeyAxis || !mValueAxis)
     return -1;
   
   if (mKeyAxis.data()->axisRect()->rect().contains(pos.toPoint()) || mParentPlot->interactions().testFlag(QCP::iSelectPlottablesBeyondAxisRect))
   {
+    if (mColumnData) // column data can only be selected as a whole
+    {
+      if (details)
+        details->setValue(QCPDataSelection(QCPDataRange(0, mColumnData->size())));
+      return columnPointDistance(pos);
+    }
     QCPGraphDataContainer::const_iterator closestDataPoint = mDataContainer->constEnd();
     double result = pointDistance(pos, closestDataPoint);
     if (details)
@@ -21110,15 +23752,135 @@ double QCPGraph::selectTest(const QPointF &pos, bool onlySelectable, QVariant *d
     return -1;
 }
 
+/*!
+  Returns the number of data points of the column data if set (see \ref setColumnData), otherwise
+  of the data container.
+  
+  \seebaseclassmethod
+*/
+int QCPGraph::dataCount() const
+{
+  if (mColumnData)
+    return mColumnData->size();
+  return QCPAbstractPlottable1D<QCPGraphData>::dataCount();
+}
+
+/* inherits documentation from base class */
+double QCPGraph::dataMainKey(int index) const
+{
+  if (!mColumnData)
+    return QCPAbstractPlottable1D<QCPGraphData>::dataMainKey(index);
+  if (index >= 0 && index < mColumnData->size())
+    return mColumnData->keys()[index];
+  qDebug() << Q_FUNC_INFO << "Index out of bounds" << index;
+  return 0;
+}
+
+/* inherits documentation from base class */
+double QCPGraph::dataSortKey(int index) const
+{
+  if (!mColumnData)
+    return QCPAbstractPlottable1D<QCPGraphData>::dataSortKey(index);
+  return dataMainKey(index);
+}
+
+/* inherits documentation from base class */
+double QCPGraph::dataMainValue(int index) const
+{
+  if (!mColumnData)
+    return QCPAbstractPlottable1D<QCPGraphData>::dataMainValue(index);
+  if (index >= 0 && index < mColumnData->size())
+    return mColumnData->values()[index];
+  qDebug() << Q_FUNC_INFO << "Index out of bounds" << index;
+  return 0;
+}
+
+/* inherits documentation from base class */
+QCPRange QCPGraph::dataValueRange(int index) const
+{
+  if (!mColumnData)
+    return QCPAbstractPlottable1D<QCPGraphData>::dataValueRange(index);
+  const double value = dataMainValue(index);
+  return QCPRange(value, value);
+}
+
+/* inherits documentation from base class */
+QPointF QCPGraph::dataPixelPosition(int index) const
+{
+  if (!mColumnData)
+    return QCPAbstractPlottable1D<QCPGraphData>::dataPixelPosition(index);
+  if (index >= 0 && index < mColumnData->size())
+    return coordsToPixels(mColumnData->keys()[index], mColumnData->values()[index]);
+  qDebug() << Q_FUNC_INFO << "Index out of bounds" << index;
+  return QPointF();
+}
+
+/*!
+  Since column data can only be selected as a whole (see \ref setColumnData), the returned
+  selection contains either all data points or none, depending on whether any data point lies
+  inside \a rect.
+  
+  \seebaseclassmethod
+*/
+QCPDataSelection QCPGraph::selectTestRect(const QRectF &rect, bool onlySelectable) const
+{
+  if (!mColumnData)
+    return QCPAbstractPlottable1D<QCPGraphData>::selectTestRect(rect, onlySelectable);
+  
+  QCPDataSelection result;
+  if ((onlySelectable && mSelectable == QCP::stNone) || mColumnData->isEmpty())
+    return result;
+  if (!mKeyAxis || !mValueAxis)
+    return result;
+  
+  // convert rect given in pixels to ranges given in plot coordinates:
+  double key1, value1, key2, value2;
+  pixelsToCoords(rect.topLeft(), key1, value1);
+  pixelsToCoords(rect.bottomRight(), key2, value2);
+  const QCPRange keyRange(key1, key2); // QCPRange normalizes internally so we don't have to care about whether key1 < key2
+  const QCPRange valueRange(value1, value2);
+  
+  const int end = mColumnData->findEnd(keyRange.upper, false);
+  for (int i=mColumnData->findBegin(keyRange.lower, false); i<end; ++i)
+  {
+    if (valueRange.contains(mColumnData->values()[i]) && keyRange.contains(mColumnData->keys()[i]))
+    {
+      result.addDataRange(QCPDataRange(0, mColumnData->size()));
+      break;
+    }
+  }
+  return result;
+}
+
+/* inherits documentation from base class */
+int QCPGraph::findBegin(double sortKey, bool expandedRange) const
+{
+  if (mColumnData)
+    return mColumnData->findBegin(sortKey, expandedRange);
+  return QCPAbstractPlottable1D<QCPGraphData>::findBegin(sortKey, expandedRange);
+}
+
+/* inherits documentation from base class */
+int QCPGraph::findEnd(double sortKey, bool expandedRange) const
+{
+  if (mColumnData)
+    return mColumnData->findEnd(sortKey, expandedRange);
+  return QCPAbstractPlottable1D<QCPGraphData>::findEnd(sortKey, expandedRange);
+}
+
 /* inherits documentation from base class */
 QCPRange QCPGraph::getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain) const
 {
+  if (mColumnData)
+    return mColumnData->keyRange(foundRange, inSignDomain);
   return mDataContainer->keyRange(foundRange, inSignDomain);
 }
 
 /* inherits documentation from base class */
 QCPRange QCPGraph::getValueRange(bool &foundRange, QCP::SignDomain inSignDomain, const QCPRange &inKeyRange) const
 {
+  if (mColumnData)
+    return mColumnData->valueRange(foundRange, inSignDomain, inKeyRange);
   return mDataContainer->valueRange(foundRange, inSignDomain, inKeyRange);
 }
 
@@ -21126,21 +23888,28 @@ QCPRange QCPGraph::getValueRange(bool &foundRange, QCP::SignDomain inSignDomain,
 void QCPGraph::draw(QCPPainter *painter)
 {
   if (!mKeyAxis || !mValueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return; }
-  if (mKeyAxis.data()->range().size() <= 0 || mDataContainer->isEmpty()) return;
+  if (mKeyAxis.data()->range().size() <= 0 || (mColumnData ? mColumnData->isEmpty() : mDataContainer->isEmpty())) return;
   if (mLineStyle == lsNone && mScatterStyle.isNone()) return;
   
   QVector<QPointF> lines, scatters; // line and (if necessary) scatter pixel coordinates will be stored here while iterating over segments
   
   // loop over and draw segments of unselected/selected data:
   QList<QCPDataRange> selectedSegments, unselectedSegments, allSegments;
-  getDataSegments(selectedSegments, unselectedSegments);
+  if (mColumnData) // column data can only be selected as a whole
+  {
+    if (selected())
+      selectedSegments << QCPDataRange(0, mColumnData->size());
+    else
+      unselectedSegments << QCPDataRange(0, mColumnData->size());
+  } else
+    getDataSegments(selectedSegments, unselectedSegments);
   allSegments << unselectedSegments << selectedSegments;
   for (int i=0; i<allSegments.size(); ++i)
   {
     bool isSelectedSegment = i >= unselectedSegments.size();
     // get line pixel points appropriate to line style:
     QCPDataRange lineDataRange = isSelectedSegment ? allSegments.at(i) : allSegments.at(i).adjusted(-1, 1); // unselected segments extend lines to bordering selected data point (safe to exceed total data bounds in first/last segment, getLines takes care)
-    getLines(&lines, lineDataRange);
+    lines = getCachedLines(lineDataRange);
     
     // check data validity if flag set:
 #ifdef QCUSTOMPLOT_CHECK_DATA
@@ -21185,8 +23954,8 @@ void QCPGraph::draw(QCPPainter *painter)
     }
   }
   
-  // draw other selection decoration that isn't just line/scatter pens and brushes:
-  if (mSelectionDecorator)
+  // draw other selection decoration that isn't just line/scatter pens and brushes (it refers to indices of the data container):
+  if (mSelectionDecorator && !mColumnData)
     mSelectionDecorator->drawDecoration(painter, selection());
 }
 
@@ -21225,6 +23994,19 @@ void QCPGraph::drawLegendIcon(QCPPainter *painter, const QRectF &rect) const
   }
 }
 
+/*!
+  Returns the version of the data container, combined with the version of the column data if set
+  (see \ref setColumnData).
+  
+  \seebaseclassmethod
+*/
+quint64 QCPGraph::dataVersion() const
+{
+  if (mColumnData)
+    return qcpCombineVersions(mDataContainer->version(), mColumnData->version());
+  return mDataContainer->version();
+}
+
 /*! \internal
 
   This method retrieves an optimized set of data points via \ref getOptimizedLineData, and branches
@@ -21242,24 +24024,35 @@ void QCPGraph::drawLegendIcon(QCPPainter *painter, const QRectF &rect) const
   a correspondingly trimmed data range will be used. This takes the burden off the user of this
   function to check for valid indices in \a dataRange, e.g. when extending ranges coming from \ref
   getDataSegments.
+  
+  If column data is set (\ref setColumnData), the points are taken from the columns. Unsampled
+  columns are transformed to \ref lsLine pixels directly, see \ref getColumnPixels.
 
   \see getScatters
 */
 void QCPGraph::getLines(QVector<QPointF> *lines, const QCPDataRange &dataRange) const
 {
   if (!lines) return;
-  QCPGraphDataContainer::const_iterator begin, end;
-  getVisibleDataBounds(begin, end, dataRange);
-  if (begin == end)
+  QVector<QCPGraphData> lineData;
+  if (mColumnData)
   {
-    lines->clear();
-    return;
+    if (mLineStyle == lsLine && getColumnPixels(lines, dataRange))
+      return;
+    if (mLineStyle != lsNone)
+      getOptimizedColumnData(&lineData, dataRange, 1);
+  } else
+  {
+    QCPGraphDataContainer::const_iterator begin, end;
+    getVisibleDataBounds(begin, end, dataRange);
+    if (begin == end)
+    {
+      lines->clear();
+      return;
+    }
+    if (mLineStyle != lsNone)
+      getOptimizedLineData(&lineData, begin, end);
   }
   
-  QVector<QCPGraphData> lineData;
-  if (mLineStyle != lsNone)
-    getOptimizedLineData(&lineData, begin, end);
-  
   if (mKeyAxis->rangeReversed() != (mKeyAxis->orientation() == Qt::Vertical)) // make sure key pixels are sorted ascending in lineData (significantly simplifies following processing)
     std::reverse(lineData.begin(), lineData.end());
 
@@ -21274,6 +24067,73 @@ void QCPGraph::getLines(QVector<QPointF> *lines, const QCPDataRange &dataRange)
   }
 }
 
+/*! \internal
+  
+  Returns the line pixel points of \a dataRange like \ref getLines, but keeps them until the graph,
+  its data, its axes or the axis rect geometry change (see \ref lineCacheVersion). Repeated calls
+  for the same data range, e.g. the graph redrawing its layer because another layerable on it
+  changed, or a graph filling a channel to this one (see \ref setChannelFillGraph), then don't
+  process the data again.
+  
+  The returned vector shares its data with the cache. \ref drawFill uses this to also keep the fill
+  polygons built from it.
+  
+  When data is appended and the key axis range is scrolled, the cache is rebuilt rather than
+  extended: the pixels of all points move, and with adaptive sampling the points per pixel column
+  are chosen relative to the visible key range, so the old points can't be reused by translating
+  them. Only the newly visible data would be saved, while translating the old points costs about
+  as much as \ref getLines for the whole visible range. Unchanged data and ranges (e.g. replots
+  caused by other layerables or by the channel fill partner) hit the cache.
+*/
+QVector<QPointF> QCPGraph::getCachedLines(const QCPDataRange &dataRange) const
+{
+  const QCPDataRange range = dataRange.bounded(QCPDataRange(0, dataCount())); // getLines clamps to the data bounds anyway, this makes equivalent ranges share an entry
+  const quint64 version = lineCacheVersion();
+  if (mLineCacheVersion != version)
+  {
+    mLineCache.clear();
+    mLineCacheVersion = version;
+  }
+  for (int i=0; i<mLineCache.size(); ++i)
+  {
+    if (mLineCache.at(i).dataRange == range)
+      return mLineCache.at(i).lines;
+  }
+  
+  if (mLineCache.size() >= 8) // many selected segments, keep the cache small
+    mLineCache.remove(0);
+  LineCache entry;
+  entry.dataRange = range;
+  getLines(&entry.lines, range);
+  entry.fillValid = false;
+  entry.fillVersion = 0;
+  mLineCache.append(entry);
+  return entry.lines;
+}
+
+/*! \internal
+  
+  Returns a value that changes whenever the line pixel points returned by \ref getLines may change,
+  i.e. when the \ref contentVersion changes or the axis rects of the key or value axis are moved or
+  resized.
+  
+  \see getCachedLines
+*/
+quint64 QCPGraph::lineCacheVersion() const
+{
+  quint64 version = contentVersion();
+  if (mKeyAxis && mValueAxis)
+  {
+    const QRect rects[2] = {mKeyAxis.data()->axisRect()->rect(), mValueAxis.data()->axisRect()->rect()};
+    for (int i=0; i<2; ++i)
+    {
+      version = qcpCombineVersions(version, (quint64(quint32(rects[i].left())) << 32) | quint32(rects[i].top()));
+      version = qcpCombineVersions(version, (quint64(quint32(rects[i].width())) << 32) | quint32(rects[i].height()));
+    }
+  }
+  return version;
+}
+
 /*! \internal
 
   This method retrieves an optimized set of data points via \ref getOptimizedScatterData and then
@@ -21285,6 +24145,8 @@ void QCPGraph::getLines(QVector<QPointF> *lines, const QCPDataRange &dataRange)
   a correspondingly trimmed data range will be used. This takes the burden off the user of this
   function to check for valid indices in \a dataRange, e.g. when extending ranges coming from \ref
   getDataSegments.
+  
+  Data points with NaN values are left out of \a scatters.
 */
 void QCPGraph::getScatters(QVector<QPointF> *scatters, const QCPDataRange &dataRange) const
 {
@@ -21292,43 +24154,44 @@ void QCPGraph::getScatters(QVector<QPointF> *scatters, const QCPDataRange &dataR
   QCPAxis *keyAxis = mKeyAxis.data();
   QCPAxis *valueAxis = mValueAxis.data();
   if (!keyAxis || !valueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; scatters->clear(); return; }
+  const bool keyVertical = keyAxis->orientation() == Qt::Vertical;
   
-  QCPGraphDataContainer::const_iterator begin, end;
-  getVisibleDataBounds(begin, end, dataRange);
-  if (begin == end)
-  {
-    scatters->clear();
-    return;
-  }
-  
-  QVector<QCPGraphData> data;
-  getOptimizedScatterData(&data, begin, end);
-  
-  if (mKeyAxis->rangeReversed() != (mKeyAxis->orientation() == Qt::Vertical)) // make sure key pixels are sorted ascending in data (significantly simplifies following processing)
-    std::reverse(data.begin(), data.end());
-  
-  scatters->resize(data.size());
-  if (keyAxis->orientation() == Qt::Vertical)
+  const bool columnPixels = mColumnData && mScatterSkip == 0 && getColumnPixels(scatters, dataRange); // unsampled columns are transformed to pixels directly
+  if (!columnPixels)
   {
-    for (int i=0; i<data.size(); ++i)
+    QVector<QCPGraphData> data;
+    if (mColumnData)
+      getOptimizedColumnData(&data, dataRange, mScatterSkip+1);
+    else
     {
-      if (!qIsNaN(data.at(i).value))
+      QCPGraphDataContainer::const_iterator begin, end;
+      getVisibleDataBounds(begin, end, dataRange);
+      if (begin == end)
       {
-        (*scatters)[i].setX(valueAxis->coordToPixel(data.at(i).value));
-        (*scatters)[i].setY(keyAxis->coordToPixel(data.at(i).key));
+        scatters->clear();
+        return;
       }
+      getOptimizedScatterData(&data, begin, end);
     }
-  } else
+    
+    if (mKeyAxis->rangeReversed() != keyVertical) // make sure key pixels are sorted ascending in data (significantly simplifies following processing)
+      std::reverse(data.begin(), data.end());
+    
+    scatters->resize(data.size());
+    if (!data.isEmpty())
+      qcpTransformPoints(QCPAxisPixelTransform(keyAxis), QCPAxisPixelTransform(valueAxis), keyVertical, &data.constData()->key, &data.constData()->value,
+                         int(sizeof(QCPGraphData)/sizeof(double)), scatters->data(), data.size());
+  }
+  
+  // remove points of NaN values, their value pixel coordinate is NaN as well:
+  int count = 0;
+  for (int i=0; i<scatters->size(); ++i)
   {
-    for (int i=0; i<data.size(); ++i)
-    {
-      if (!qIsNaN(data.at(i).value))
-      {
-        (*scatters)[i].setX(keyAxis->coordToPixel(data.at(i).key));
-        (*scatters)[i].setY(valueAxis->coordToPixel(data.at(i).value));
-      }
-    }
+    const QPointF &point = scatters->at(i);
+    if (!qIsNaN(keyVertical ? point.x() : point.y()))
+      (*scatters)[count++] = point;
   }
+  scatters->resize(count);
 }
 
 /*! \internal
@@ -21348,24 +24211,13 @@ QVector<QPointF> QCPGraph::dataToLines(const QVector<QCPGraphData> &data) const
   QCPAxis *valueAxis = mValueAxis.data();
   if (!keyAxis || !valueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return result; }
 
+  if (data.isEmpty())
+    return result;
   result.resize(data.size());
   
-  // transform data points to pixels:
-  if (keyAxis->orientation() == Qt::Vertical)
-  {
-    for (int i=0; i<data.size(); ++i)
-    {
-      result[i].setX(valueAxis->coordToPixel(data.at(i).value));
-      result[i].setY(keyAxis->coordToPixel(data.at(i).key));
-    }
-  } else // key axis is horizontal
-  {
-    for (int i=0; i<data.size(); ++i)
-    {
-      result[i].setX(keyAxis->coordToPixel(data.at(i).key));
-      result[i].setY(valueAxis->coordToPixel(data.at(i).value));
-    }
-  }
+  // transform data points to pixels, in batches with the axis transforms evaluated once:
+  qcpTransformPoints(QCPAxisPixelTransform(keyAxis), QCPAxisPixelTransform(valueAxis), keyAxis->orientation() == Qt::Vertical, &data.constData()->key, &data.constData()->value,
+                     int(sizeof(QCPGraphData)/sizeof(double)), result.data(), data.size());
   return result;
 }
 
@@ -21599,6 +24451,10 @@ QVector<QPointF> QCPGraph::dataToImpulseLines(const QVector<QCPGraphData> &data)
   getChannelFillPolygon.
   
   Pass the points of this graph's line as \a lines, in pixel coordinates.
+  
+  If \a lines were obtained from \ref getCachedLines, the fill polygons are kept with them and
+  reused as long as neither this graph nor the channel fill graph changed, see \ref
+  getFillPolygons.
 
   \see drawLinePlot, drawImpulsePlot, drawScatterPlot
 */
@@ -21608,25 +24464,32 @@ void QCPGraph::drawFill(QCPPainter *painter, QVector<QPointF> *lines) const
   if (painter->brush().style() == Qt::NoBrush || painter->brush().color().alpha() == 0) return;
   
   applyFillAntialiasingHint(painter);
-  const QVector<QCPDataRange> segments = getNonNanSegments(lines, keyAxis()->orientation());
-  if (!mChannelFillGraph)
+  // find the cache entry lines were taken from (they share their data, see getCachedLines):
+  LineCache *cache = nullptr;
+  if (mLineCacheVersion == lineCacheVersion())
   {
-    // draw base fill under graph, fill goes all the way to the zero-value-line:
-    foreach (QCPDataRange segment, segments)
-      painter->drawPolygon(getFillPolygon(lines, segment));
-  } else
+    for (int i=0; i<mLineCache.size(); ++i)
+    {
+      if (mLineCache.at(i).lines.constData() == lines->constData() && mLineCache.at(i).lines.size() == lines->size())
+        cache = &mLineCache[i];
+    }
+  }
+  const quint64 fillVersion = mChannelFillGraph ? qcpCombineVersions(quint64(quintptr(mChannelFillGraph.data())), mChannelFillGraph.data()->lineCacheVersion()) : 0;
+  if (!cache || !cache->fillValid || cache->fillVersion != fillVersion)
   {
-    // draw fill between this graph and mChannelFillGraph:
-    QVector<QPointF> otherLines;
-    mChannelFillGraph->getLines(&otherLines, QCPDataRange(0, mChannelFillGraph->dataCount()));
-    if (!otherLines.isEmpty())
+    const QVector<QPolygonF> polygons = getFillPolygons(lines);
+    if (!cache)
     {
-      QVector<QCPDataRange> otherSegments = getNonNanSegments(&otherLines, mChannelFillGraph->keyAxis()->orientation());
-      QVector<QPair<QCPDataRange, QCPDataRange> > segmentPairs = getOverlappingSegments(segments, lines, otherSegments, &otherLines);
-      for (int i=0; i<segmentPairs.size(); ++i)
-        painter->drawPolygon(getChannelFillPolygon(lines, segmentPairs.at(i).first, &otherLines, segmentPairs.at(i).second));
+      foreach (const QPolygonF &polygon, polygons)
+        painter->drawPolygon(polygon);
+      return;
     }
+    cache->fillPolygons = polygons;
+    cache->fillVersion = fillVersion;
+    cache->fillValid = true;
   }
+  foreach (const QPolygonF &polygon, cache->fillPolygons)
+    painter->drawPolygon(polygon);
 }
 
 /*! \internal
@@ -21640,8 +24503,7 @@ void QCPGraph::drawScatterPlot(QCPPainter *painter, const QVector<QPointF> &scat
 {
   applyScattersAntialiasingHint(painter);
   style.applyTo(painter, mPen);
-  foreach (const QPointF &scatter, scatters)
-    style.drawShape(painter, scatter.x(), scatter.y());
+  style.drawShapes(painter, scatters, mParentPlot->plottingHints().testFlag(QCP::phCacheScatters));
 }
 
 /*!  \internal
@@ -21689,7 +24551,9 @@ void QCPGraph::drawImpulsePlot(QCPPainter *painter, const QVector<QPointF> &line
   further by \a begin and \a end, e.g. to only plot a certain segment of the data (see \ref
   getDataSegments).
 
-  This method is used by \ref getLines to retrieve the basic working set of data.
+  This method is used by \ref getLines to retrieve the basic working set of data. If the data
+  container has its level-of-detail index enabled, the adaptive sampling is delegated to \ref
+  getLevelOfDetailLineData.
 
   \see getOptimizedScatterData
 */
@@ -21710,7 +24574,10 @@ void QCPGraph::getOptimizedLineData(QVector<QCPGraphData> *lineData, const QCPGr
       maxCount = int(2*keyPixelSpan+2);
   }
   
-  if (mAdaptiveSampling && dataCount >= maxCount) // use adaptive sampling only if there are at least two points per pixel on average
+  if (mAdaptiveSampling && dataCount >= maxCount && mDataContainer->levelOfDetailEnabled()) // same clusters as below, but intervals are found by binary search and their value spans by the level-of-detail index
+  {
+    getLevelOfDetailLineData(lineData, begin, end);
+  } else if (mAdaptiveSampling && dataCount >= maxCount) // use adaptive sampling only if there are at least two points per pixel on average
   {
     QCPGraphDataContainer::const_iterator it = begin;
     double minValue = it->value;
@@ -21781,7 +24648,9 @@ void QCPGraph::getOptimizedLineData(QVector<QCPGraphData> *lineData, const QCPGr
   further by \a begin and \a end, e.g. to only plot a certain segment of the data (see \ref
   getDataSegments).
 
-  This method is used by \ref getScatters to retrieve the basic working set of data.
+  This method is used by \ref getScatters to retrieve the basic working set of data. If the data
+  container has its level-of-detail index enabled and no scatter skip is set, the adaptive sampling
+  is delegated to \ref getLevelOfDetailScatterData.
 
   \see getOptimizedLineData
 */
@@ -21810,7 +24679,10 @@ void QCPGraph::getOptimizedScatterData(QVector<QCPGraphData> *scatterData, QCPGr
     maxCount = 2*keyPixelSpan+2;
   }
   
-  if (mAdaptiveSampling && dataCount >= maxCount) // use adaptive sampling only if there are at least two points per pixel on average
+  if (mAdaptiveSampling && dataCount >= maxCount && !doScatterSkip && mDataContainer->levelOfDetailEnabled()) // the level-of-detail index can't honor the scatter skip, so only use it without
+  {
+    getLevelOfDetailScatterData(scatterData, begin, end);
+  } else if (mAdaptiveSampling && dataCount >= maxCount) // use adaptive sampling only if there are at least two points per pixel on average
   {
     double valueMaxRange = valueAxis->range().upper;
     double valueMinRange = valueAxis->range().lower;
@@ -21957,6 +24829,128 @@ void QCPGraph::getOptimizedScatterData(QVector<QCPGraphData> *scatterData, QCPGr
   }
 }
 
+/*! \internal
+
+  Adaptive sampling of \ref getOptimizedLineData for data containers with an enabled
+  level-of-detail index (see \ref QCPDataContainer::setLevelOfDetailEnabled). The output is the
+  same as the one of the regular algorithm, but instead of visiting every data point, the end of
+  each pixel interval is found by a binary search on the keys and the value span of the interval is
+  taken from \ref QCPDataContainer::valueExtremes. The cost is thus proportional to the number of
+  pixel intervals (times a logarithmic factor) rather than to the number of data points in
+  [\a begin, \a end).
+
+  \see getLevelOfDetailScatterData
+*/
+void QCPGraph::getLevelOfDetailLineData(QVector<QCPGraphData> *lineData, const QCPGraphDataContainer::const_iterator &begin, const QCPGraphDataContainer::const_iterator &end) const
+{
+  QCPAxis *keyAxis = mKeyAxis.data();
+  const QCPGraphDataContainer::const_iterator dataBegin = mDataContainer->constBegin();
+  int reversedFactor = keyAxis->pixelOrientation(); // is used to calculate keyEpsilon pixel into the correct direction
+  int reversedRound = reversedFactor==-1 ? 1 : 0; // is used to switch between floor (normal) and ceil (reversed) rounding of currentIntervalStartKey
+  double currentIntervalStartKey = keyAxis->pixelToCoord(int(keyAxis->coordToPixel(begin->key)+reversedRound));
+  double lastIntervalEndKey = currentIntervalStartKey;
+  double keyEpsilon = qAbs(currentIntervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(currentIntervalStartKey)+1.0*reversedFactor)); // interval of one pixel on screen when mapped to plot key coordinates
+  bool keyEpsilonVariable = keyAxis->scaleType() == QCPAxis::stLogarithmic; // indicates whether keyEpsilon needs to be updated after every interval (for log axes)
+  QCPGraphDataContainer::const_iterator it = begin;
+  while (it != end)
+  {
+    // first data point that is no longer within the pixel interval starting at it:
+    QCPGraphDataContainer::const_iterator intervalEnd = std::lower_bound(it+1, end, QCPGraphData::fromSortKey(currentIntervalStartKey+keyEpsilon), qcpLessThanSortKey<QCPGraphData>);
+    if (intervalEnd-it >= 2) // pixel has multiple data points, consolidate them to a cluster
+    {
+      double minValue = it->value;
+      double maxValue = it->value;
+      if (!qIsNaN(it->value)) // the regular algorithm starts the value span at the first point, so a leading NaN spans the whole cluster
+      {
+        const QCPGraphDataContainer::LodBucket extremes = mDataContainer->valueExtremes(int(it-dataBegin), int(intervalEnd-dataBegin));
+        minValue = extremes.minValue;
+        maxValue = extremes.maxValue;
+      }
+      if (lastIntervalEndKey < currentIntervalStartKey-keyEpsilon) // last point is further away, so first point of this cluster must be at a real data point
+        lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.2, it->value));
+      lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.25, minValue));
+      lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.75, maxValue));
+      if (intervalEnd != end && intervalEnd->key > currentIntervalStartKey+keyEpsilon*2) // new pixel started further away from previous cluster, so make sure the last point of the cluster is at a real data point
+        lineData->append(QCPGraphData(currentIntervalStartKey+keyEpsilon*0.8, (intervalEnd-1)->value));
+    } else
+      lineData->append(QCPGraphData(it->key, it->value));
+    if (intervalEnd == end)
+      break;
+    lastIntervalEndKey = (intervalEnd-1)->key;
+    it = intervalEnd;
+    currentIntervalStartKey = keyAxis->pixelToCoord(int(keyAxis->coordToPixel(it->key)+reversedRound));
+    if (keyEpsilonVariable)
+      keyEpsilon = qAbs(currentIntervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(currentIntervalStartKey)+1.0*reversedFactor));
+  }
+}
+
+/*! \internal
+
+  Adaptive sampling of \ref getOptimizedScatterData for data containers with an enabled
+  level-of-detail index. Like \ref getLevelOfDetailLineData, pixel intervals are found by binary
+  search and their value span is taken from \ref QCPDataContainer::valueExtremes. Within an
+  interval, every n-th data point is output by index, where n depends on the visible pixel span of
+  the interval's values just like in the regular algorithm, plus the data points holding the
+  interval's minimum and maximum value. Only points inside the visible value range are output.
+
+  This method does not support a scatter skip (\ref setScatterSkip).
+*/
+void QCPGraph::getLevelOfDetailScatterData(QVector<QCPGraphData> *scatterData, const QCPGraphDataContainer::const_iterator &begin, const QCPGraphDataContainer::const_iterator &end) const
+{
+  QCPAxis *keyAxis = mKeyAxis.data();
+  QCPAxis *valueAxis = mValueAxis.data();
+  const QCPGraphDataContainer::const_iterator dataBegin = mDataContainer->constBegin();
+  double valueMaxRange = valueAxis->range().upper;
+  double valueMinRange = valueAxis->range().lower;
+  int reversedFactor = keyAxis->pixelOrientation(); // is used to calculate keyEpsilon pixel into the correct direction
+  int reversedRound = reversedFactor==-1 ? 1 : 0; // is used to switch between floor (normal) and ceil (reversed) rounding of currentIntervalStartKey
+  double currentIntervalStartKey = keyAxis->pixelToCoord(int(keyAxis->coordToPixel(begin->key)+reversedRound));
+  double keyEpsilon = qAbs(currentIntervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(currentIntervalStartKey)+1.0*reversedFactor)); // interval of one pixel on screen when mapped to plot key coordinates
+  bool keyEpsilonVariable = keyAxis->scaleType() == QCPAxis::stLogarithmic; // indicates whether keyEpsilon needs to be updated after every interval (for log axes)
+  QCPGraphDataContainer::const_iterator it = begin;
+  while (it != end)
+  {
+    // first data point that is no longer within the pixel interval starting at it:
+    QCPGraphDataContainer::const_iterator intervalEnd = std::lower_bound(it+1, end, QCPGraphData::fromSortKey(currentIntervalStartKey+keyEpsilon), qcpLessThanSortKey<QCPGraphData>);
+    const int intervalDataCount = int(intervalEnd-it);
+    if (intervalDataCount >= 2) // pixel has multiple data points, consolidate them to a cluster
+    {
+      const int intervalBeginIndex = int(it-dataBegin);
+      const int intervalEndIndex = int(intervalEnd-dataBegin);
+      const QCPGraphDataContainer::LodBucket extremes = mDataContainer->valueExtremes(intervalBeginIndex, intervalEndIndex);
+      // value span of the cluster within the visible value range, determines how many points are needed to cover it:
+      const double minValue = qMax(extremes.minValue, valueMinRange);
+      const double maxValue = qMin(extremes.maxValue, valueMaxRange);
+      const double valuePixelSpan = minValue < maxValue ? qAbs(valueAxis->coordToPixel(minValue)-valueAxis->coordToPixel(maxValue)) : 0;
+      const int dataModulo = valuePixelSpan > 0 ? qMax(1, qMin(intervalDataCount, qRound(intervalDataCount/(valuePixelSpan/4.0)))) : intervalDataCount; // approximately every 4 value pixels one data point on average
+      for (int index = intervalBeginIndex; index < intervalEndIndex; index += dataModulo)
+      {
+        const QCPGraphData &point = *(dataBegin+index);
+        if (point.value > valueMinRange && point.value < valueMaxRange)
+          scatterData->append(point);
+      }
+      // make sure the extremes of the cluster are visible, unless they were already output above:
+      const int extremeIndices[2] = {extremes.minIndex, extremes.maxIndex};
+      for (int i=0; i<2; ++i)
+      {
+        const int index = extremeIndices[i];
+        if (index < 0 || (index-intervalBeginIndex) % dataModulo == 0 || (i == 1 && index == extremeIndices[0]))
+          continue;
+        const QCPGraphData &point = *(dataBegin+index);
+        if (point.value > valueMinRange && point.value < valueMaxRange)
+          scatterData->append(point);
+      }
+    } else if (it->value > valueMinRange && it->value < valueMaxRange)
+      scatterData->append(*it);
+    if (intervalEnd == end)
+      break;
+    it = intervalEnd;
+    currentIntervalStartKey = keyAxis->pixelToCoord(int(keyAxis->coordToPixel(it->key)+reversedRound));
+    if (keyEpsilonVariable)
+      keyEpsilon = qAbs(currentIntervalStartKey-keyAxis->pixelToCoord(keyAxis->coordToPixel(currentIntervalStartKey)+1.0*reversedFactor));
+  }
+}
+
 /*!
   This method outputs the currently visible data range via \a begin and \a end. The returned range
   will also never exceed \a rangeRestriction.
@@ -21985,6 +24979,144 @@ void QCPGraph::getVisibleDataBounds(QCPGraphDataContainer::const_iterator &begin
   }
 }
 
+/*! \internal
+  
+  Like \ref getVisibleDataBounds, but outputs the indices of the visible data points of the column
+  data (\ref setColumnData) via \a begin and \a end.
+*/
+void QCPGraph::getVisibleColumnBounds(int &begin, int &end, const QCPDataRange &rangeRestriction) const
+{
+  begin = end = 0;
+  QCPAxis *keyAxis = mKeyAxis.data();
+  if (!keyAxis) { qDebug() << Q_FUNC_INFO << "invalid key axis"; return; }
+  if (rangeRestriction.isEmpty())
+    return;
+  const QCPDataRange visibleRange(mColumnData->findBegin(keyAxis->range().lower), mColumnData->findEnd(keyAxis->range().upper));
+  const QCPDataRange bounded = visibleRange.bounded(rangeRestriction.bounded(QCPDataRange(0, mColumnData->size())));
+  begin = bounded.begin();
+  end = bounded.end();
+}
+
+/*! \internal
+  
+  Transforms the visible column data points within \a dataRange to pixels and returns them in \a
+  pixels, sorted ascending by key pixel. The keys and values are read straight from the columns and
+  transformed in batches (two points per SSE2 instruction on linear axes), without an intermediate
+  \ref QCPGraphData copy.
+  
+  Returns false without touching \a pixels if adaptive sampling is enabled and there are at least
+  two points per key pixel on average. The points must then be reduced with \ref
+  getOptimizedColumnData first.
+*/
+bool QCPGraph::getColumnPixels(QVector<QPointF> *pixels, const QCPDataRange &dataRange) const
+{
+  QCPAxis *keyAxis = mKeyAxis.data();
+  QCPAxis *valueAxis = mValueAxis.data();
+  if (!keyAxis || !valueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; pixels->clear(); return true; }
+  
+  int begin, end;
+  getVisibleColumnBounds(begin, end, dataRange);
+  const double *keys = mColumnData->keys();
+  const double *values = mColumnData->values();
+  const QCPAxisPixelTransform keyTransform(keyAxis);
+  if (mAdaptiveSampling && begin < end && end-begin >= 2*qAbs(keyTransform.map(keys[begin])-keyTransform.map(keys[end-1]))+2)
+    return false;
+  
+  const bool keyVertical = keyAxis->orientation() == Qt::Vertical;
+  pixels->resize(end-begin);
+  qcpTransformPoints(keyTransform, QCPAxisPixelTransform(valueAxis), keyVertical, keys+begin, values+begin, 1, pixels->data(), end-begin);
+  if (keyAxis->rangeReversed() != keyVertical) // make sure key pixels are sorted ascending
+    std::reverse(pixels->begin(), pixels->end());
+  return true;
+}
+
+/*! \internal
+  
+  Appends the data points \a first, \a minIndex, \a maxIndex and \a last of the columns \a keys and
+  \a values to \a data in ascending index order, each index only once.
+*/
+static inline void qcpAppendColumnCluster(QVector<QCPGraphData> *data, const double *keys, const double *values, int first, int minIndex, int maxIndex, int last)
+{
+  const int indices[4] = {first, qMin(minIndex, maxIndex), qMax(minIndex, maxIndex), last};
+  int previous = -1;
+  for (int i=0; i<4; ++i)
+  {
+    if (indices[i] != previous)
+    {
+      data->append(QCPGraphData(keys[indices[i]], values[indices[i]]));
+      previous = indices[i];
+    }
+  }
+}
+
+/*! \internal
+  
+  Returns via \a data the visible data points of the column data within \a dataRange, taking only
+  every \a modulo-th data point into account (counted from index 0, as the scatter skip of \ref
+  getOptimizedScatterData).
+  
+  If \ref setAdaptiveSampling is enabled and there are at least two points per key pixel on
+  average, the points of each key pixel are reduced to the first, last, minimum and maximum value
+  among them, which are real data points. A line through them covers the same pixels as a line
+  through all points. For scatter plots, this keeps the outline of dense data clouds. The key
+  pixels are computed in batches with \ref qcpTransformCoords.
+*/
+void QCPGraph::getOptimizedColumnData(QVector<QCPGraphData> *data, const QCPDataRange &dataRange, int modulo) const
+{
+  if (!data) return;
+  QCPAxis *keyAxis = mKeyAxis.data();
+  if (!keyAxis) { qDebug() << Q_FUNC_INFO << "invalid key axis"; return; }
+  
+  int begin, end;
+  getVisibleColumnBounds(begin, end, dataRange);
+  begin += (modulo-begin%modulo)%modulo; // advance to first non-skipped data point
+  if (begin >= end) return;
+  const double *keys = mColumnData->keys();
+  const double *values = mColumnData->values();
+  const QCPAxisPixelTransform keyTransform(keyAxis);
+  const int dataCount = (end-begin+modulo-1)/modulo;
+  
+  if (!mAdaptiveSampling || dataCount < 2*qAbs(keyTransform.map(keys[begin])-keyTransform.map(keys[end-1]))+2) // transfer points one-to-one
+  {
+    data->reserve(dataCount);
+    for (int i=begin; i<end; i+=modulo)
+      data->append(QCPGraphData(keys[i], values[i]));
+    return;
+  }
+  
+  const int blockSize = 256;
+  double keyPixels[blockSize];
+  int blockBegin = 0;
+  int blockEnd = 0;
+  double intervalPixel = 0;
+  int first = -1, minIndex = -1, maxIndex = -1, last = -1;
+  for (int i=begin; i<end; i+=modulo)
+  {
+    if (i >= blockEnd) // transform the key pixels of the next block of columns at once
+    {
+      blockBegin = i;
+      blockEnd = qMin(end, i+blockSize);
+      qcpTransformCoords(keyTransform, keys+blockBegin, keyPixels, blockEnd-blockBegin);
+    }
+    const double pixel = std::floor(keyPixels[i-blockBegin]);
+    if (first < 0 || pixel != intervalPixel) // new pixel interval started
+    {
+      if (first >= 0)
+        qcpAppendColumnCluster(data, keys, values, first, minIndex, maxIndex, last);
+      intervalPixel = pixel;
+      first = minIndex = maxIndex = i;
+    } else
+    {
+      if (values[i] < values[minIndex] || qIsNaN(values[minIndex]))
+        minIndex = i;
+      if (values[i] > values[maxIndex] || qIsNaN(values[maxIndex]))
+        maxIndex = i;
+    }
+    last = i;
+  }
+  qcpAppendColumnCluster(data, keys, values, first, minIndex, maxIndex, last);
+}
+
 /*!  \internal
   
   This method goes through the passed points in \a lineData and returns a list of the segments
@@ -22193,6 +25325,123 @@ QPointF QCPGraph::getFillBasePoint(QPointF matchingDataPoint) const
   return result;
 }
 
+/*! \internal
+  
+  Returns whether \a point lies on the inner side of the \a edge (0: left, 1: right, 2: top, 3:
+  bottom) of \a rect. Used by \ref qcpClipPolygon.
+*/
+static inline bool qcpInsideClipEdge(const QPointF &point, const QRectF &rect, int edge)
+{
+  switch (edge)
+  {
+    case 0: return point.x() >= rect.left();
+    case 1: return point.x() <= rect.right();
+    case 2: return point.y() >= rect.top();
+    default: return point.y() <= rect.bottom();
+  }
+}
+
+/*! \internal
+  
+  Returns the intersection of the line through \a a and \a b with the \a edge of \a rect, see \ref
+  qcpInsideClipEdge. \a a and \a b must lie on different sides of the edge.
+*/
+static inline QPointF qcpClipEdgeIntersection(const QPointF &a, const QPointF &b, const QRectF &rect, int edge)
+{
+  if (edge < 2)
+  {
+    const double x = edge == 0 ? rect.left() : rect.right();
+    return QPointF(x, a.y()+(x-a.x())/(b.x()-a.x())*(b.y()-a.y()));
+  } else
+  {
+    const double y = edge == 2 ? rect.top() : rect.bottom();
+    return QPointF(a.x()+(y-a.y())/(b.y()-a.y())*(b.x()-a.x()), y);
+  }
+}
+
+/*! \internal
+  
+  Clips \a polygon to \a rect in pixel coordinates (Sutherland-Hodgman). The area of the result
+  within \a rect is the same as that of \a polygon, so it can be filled instead of \a polygon under
+  a clip region inside \a rect. Concave polygons may produce zero-width connections along the rect
+  borders, which don't change the filled area.
+  
+  This keeps fill polygons of data far outside the visible value range, which can reach millions of
+  pixels, from reaching the paint engine.
+*/
+static QPolygonF qcpClipPolygon(const QPolygonF &polygon, const QRectF &rect)
+{
+  if (polygon.size() < 3 || rect.contains(polygon.boundingRect()))
+    return polygon;
+  QPolygonF input(polygon), output;
+  for (int edge=0; edge<4 && !input.isEmpty(); ++edge)
+  {
+    output.clear();
+    output.reserve(input.size()+4);
+    QPointF previous = input.last();
+    bool previousInside = qcpInsideClipEdge(previous, rect, edge);
+    for (int i=0; i<input.size(); ++i)
+    {
+      const QPointF &current = input.at(i);
+      const bool currentInside = qcpInsideClipEdge(current, rect, edge);
+      if (currentInside != previousInside)
+        output.append(qcpClipEdgeIntersection(previous, current, rect, edge));
+      if (currentInside)
+        output.append(current);
+      previous = current;
+      previousInside = currentInside;
+    }
+    qSwap(input, output);
+  }
+  return input;
+}
+
+/*! \internal
+  
+  Returns the polygons of the fill below (or, if \ref setChannelFillGraph is set, next to) the
+  line given by \a lines in pixel coordinates. This uses \ref getFillPolygon or \ref
+  getChannelFillPolygon, and is called by \ref drawFill.
+  
+  In order to handle NaN Data points correctly (the fill needs to be split into disjoint areas),
+  this method first determines a list of non-NaN segments with \ref getNonNanSegments, on which to
+  operate. In the channel fill case, \ref getOverlappingSegments is used to consolidate the non-NaN
+  segments of the two involved graphs, before passing the overlapping pairs to \ref
+  getChannelFillPolygon. The lines of the channel fill graph are taken from its \ref
+  getCachedLines "line cache", so they are usually shared with its own drawing.
+  
+  The polygons are clipped to the \ref clipRect (with a small margin for antialiasing) in pixel
+  coordinates.
+*/
+QVector<QPolygonF> QCPGraph::getFillPolygons(const QVector<QPointF> *lines) const
+{
+  QVector<QPolygonF> result;
+  const QRectF clip = QRectF(clipRect()).adjusted(-2, -2, 2, 2);
+  const QVector<QCPDataRange> segments = getNonNanSegments(lines, keyAxis()->orientation());
+  if (!mChannelFillGraph)
+  {
+    // fill goes all the way to the zero-value-line:
+    foreach (QCPDataRange segment, segments)
+      result.append(qcpClipPolygon(getFillPolygon(lines, segment), clip));
+  } else
+  {
+    // fill between this graph and mChannelFillGraph:
+    const QVector<QPointF> otherLines = mChannelFillGraph.data()->getCachedLines(QCPDataRange(0, mChannelFillGraph.data()->dataCount()));
+    if (!otherLines.isEmpty())
+    {
+      QVector<QCPDataRange> otherSegments = getNonNanSegments(&otherLines, mChannelFillGraph->keyAxis()->orientation());
+      QVector<QPair<QCPDataRange, QCPDataRange> > segmentPairs = getOverlappingSegments(segments, lines, otherSegments, &otherLines);
+      for (int i=0; i<segmentPairs.size(); ++i)
+        result.append(qcpClipPolygon(getChannelFillPolygon(lines, segmentPairs.at(i).first, &otherLines, segmentPairs.at(i).second), clip));
+    }
+  }
+  for (int i=result.size()-1; i>=0; --i)
+  {
+    if (result.at(i).size() < 3)
+      result.remove(i);
+  }
+  return result;
+}
+
 /*! \internal
   
   Returns the polygon needed for drawing normal fills between this graph and the key axis.
@@ -22339,73 +25588,62 @@ const QPolygonF QCPGraph::getChannelFillPolygon(const QVector<QPointF> *thisData
   return QPolygonF(thisSegmentData);
 }
 
+/*! \internal
+  
+  Comparators for binary searches by the x or y coordinate of ascending pixel points, see \ref
+  QCPGraph::findIndexBelowX and the related methods.
+*/
+static inline bool qcpPointXLess(const QPointF &point, double x) { return point.x() < x; }
+static inline bool qcpXPointLess(double x, const QPointF &point) { return x < point.x(); }
+static inline bool qcpPointYLess(const QPointF &point, double y) { return point.y() < y; }
+static inline bool qcpYPointLess(double y, const QPointF &point) { return y < point.y(); }
+
 /*! \internal
   
   Finds the smallest index of \a data, whose points x value is just above \a x. Assumes x values in
   \a data points are ordered ascending, as is ensured by \ref getLines/\ref getScatters if the key
-  axis is horizontal.
+  axis is horizontal, and uses a binary search.
 
   Used to calculate the channel fill polygon, see \ref getChannelFillPolygon.
 */
 int QCPGraph::findIndexAboveX(const QVector<QPointF> *data, double x) const
 {
-  for (int i=data->size()-1; i>=0; --i)
-  {
-    if (data->at(i).x() < x)
-    {
-      if (i<data->size()-1)
-        return i+1;
-      else
-        return data->size()-1;
-    }
-  }
-  return -1;
+  const int lowerBound = int(std::lower_bound(data->constBegin(), data->constEnd(), x, qcpPointXLess)-data->constBegin()); // first point not below x
+  if (lowerBound == 0)
+    return -1;
+  return qMin(lowerBound, data->size()-1);
 }
 
 /*! \internal
   
   Finds the highest index of \a data, whose points x value is just below \a x. Assumes x values in
   \a data points are ordered ascending, as is ensured by \ref getLines/\ref getScatters if the key
-  axis is horizontal.
+  axis is horizontal, and uses a binary search.
   
   Used to calculate the channel fill polygon, see \ref getChannelFillPolygon.
 */
 int QCPGraph::findIndexBelowX(const QVector<QPointF> *data, double x) const
 {
-  for (int i=0; i<data->size(); ++i)
-  {
-    if (data->at(i).x() > x)
-    {
-      if (i>0)
-        return i-1;
-      else
-        return 0;
-    }
-  }
-  return -1;
+  const int upperBound = int(std::upper_bound(data->constBegin(), data->constEnd(), x, qcpXPointLess)-data->constBegin()); // first point above x
+  if (upperBound == data->size())
+    return -1;
+  return qMax(0, upperBound-1);
 }
 
 /*! \internal
   
   Finds the smallest index of \a data, whose points y value is just above \a y. Assumes y values in
   \a data points are ordered ascending, as is ensured by \ref getLines/\ref getScatters if the key
-  axis is vertical.
+  axis is vertical, and uses a binary search.
   
   Used to calculate the channel fill polygon, see \ref getChannelFillPolygon.
 */
 int QCPGraph::findIndexAboveY(const QVector<QPointF> *data, double y) const
 {
-  for (int i=data->size()-1; i>=0; --i)
-  {
-    if (data->at(i).y() < y)
-    {
-      if (i<data->size()-1)
-        return i+1;
-      else
-        return data->size()-1;
-    }
-  }
-  return -1;
+  const int lowerBound = int(std::lower_bound(data->constBegin(), data->constEnd(), y, qcpPointYLess)-data->constBegin()); // first point not below y
+  if (lowerBound == 0)
+    return -1;
+  return qMin(lowerBound, data->size()-1);
 }
 
 /*! \internal
@@ -22416,6 +25654,11 @@ int QCPGraph::findIndexAboveY(const QVector<QPointF> *data, double y) const
   the graph has a line representation, the returned distance may be smaller than the distance to
   the \a closestData point, since the distance to the graph line is also taken into account.
   
+  For graphs with many data points, the data points near \a pixelPoint are found with the pixel
+  index (see \ref QCPAbstractPlottable1D::pixelIndex) instead of scanning the key range around it.
+  Data points further away than the selection tolerance are then not considered, so distances
+  larger than the selection tolerance aren't exact.
+  
   If either the graph has no data or if the line style is \ref lsNone and the scatter style's shape
   is \ref QCPScatterStyle::ssNone (i.e. there is no visual representation of the graph), returns -1.0.
 */
@@ -22427,33 +25670,89 @@ double QCPGraph::pointDistance(const QPointF &pixelPoint, QCPGraphDataContainer:
   if (mLineStyle == lsNone && mScatterStyle.isNone())
     return -1.0;
   
-  // calculate minimum distances to graph data points and find closestData iterator:
+  // calculate minimum distances to graph data points within the selection tolerance, using the pixel index if there is one:
+  const double tolerance = mParentPlot->selectionTolerance();
+  double minDistSqr = (std::numeric_limits<double>::max)();
+  int closestIndex = -1;
+  const bool indexed = findClosestIndexedPoint(pixelPoint, tolerance, closestIndex, minDistSqr);
+  if (closestIndex >= 0)
+    closestData = mDataContainer->constBegin()+closestIndex;
+    
+  // calculate distance to graph line if there is one (if so, will probably be smaller than distance to closest data point):
+  if (mLineStyle != lsNone)
+  {
+    // line displayed, calculate distance to line segments:
+    const QVector<QPointF> lineData = getCachedLines(QCPDataRange(0, dataCount())); // don't limit data range further since with sharp data spikes, line segments may be closer to test point than segments with closer key coordinate
+    QCPVector2D p(pixelPoint);
+    const int step = mLineStyle==lsImpulse ? 2 : 1; // impulse plot differs from other line styles in that the lineData points are only pairwise connected
+    for (int i=0; i<lineData.size()-1; i+=step)
+    {
+      const double currentDistSqr = p.distanceSquaredToLine(lineData.at(i), lineData.at(i+1));
+      if (currentDistSqr < minDistSqr)
+        minDistSqr = currentDistSqr;
+    }
+  }
+  
+  // without pixel index, or if only the line is within the selection tolerance, find closestData in the key range around pos:
+  if (!indexed || (closestIndex < 0 && minDistSqr < tolerance*tolerance))
+  {
+    // determine which key range comes into question, taking selection tolerance around pos into account:
+    double posKeyMin, posKeyMax, dummy;
+    pixelsToCoords(pixelPoint-QPointF(tolerance, tolerance), posKeyMin, dummy);
+    pixelsToCoords(pixelPoint+QPointF(tolerance, tolerance), posKeyMax, dummy);
+    if (posKeyMin > posKeyMax)
+      qSwap(posKeyMin, posKeyMax);
+    // iterate over found data points and then choose the one with the shortest distance to pos:
+    double closestDistSqr = (std::numeric_limits<double>::max)();
+    QCPGraphDataContainer::const_iterator begin = mDataContainer->findBegin(posKeyMin, true);
+    QCPGraphDataContainer::const_iterator end = mDataContainer->findEnd(posKeyMax, true);
+    for (QCPGraphDataContainer::const_iterator it=begin; it!=end; ++it)
+    {
+      const double currentDistSqr = QCPVector2D(coordsToPixels(it->key, it->value)-pixelPoint).lengthSquared();
+      if (currentDistSqr < closestDistSqr)
+      {
+        closestDistSqr = currentDistSqr;
+        closestData = it;
+      }
+    }
+    minDistSqr = qMin(minDistSqr, closestDistSqr);
+  }
+  
+  return qSqrt(minDistSqr);
+}
+
+/*! \internal
+  
+  Like \ref pointDistance, but for the column data (\ref setColumnData). Since column data can only
+  be selected as a whole, no closest data point is returned.
+*/
+double QCPGraph::columnPointDistance(const QPointF &pixelPoint) const
+{
+  if (mColumnData->isEmpty())
+    return -1.0;
+  if (mLineStyle == lsNone && mScatterStyle.isNone())
+    return -1.0;
+  
+  // calculate minimum distance to the data points in the key range around pos that comes into question:
   double minDistSqr = (std::numeric_limits<double>::max)();
-  // determine which key range comes into question, taking selection tolerance around pos into account:
   double posKeyMin, posKeyMax, dummy;
   pixelsToCoords(pixelPoint-QPointF(mParentPlot->selectionTolerance(), mParentPlot->selectionTolerance()), posKeyMin, dummy);
   pixelsToCoords(pixelPoint+QPointF(mParentPlot->selectionTolerance(), mParentPlot->selectionTolerance()), posKeyMax, dummy);
   if (posKeyMin > posKeyMax)
     qSwap(posKeyMin, posKeyMax);
-  // iterate over found data points and then choose the one with the shortest distance to pos:
-  QCPGraphDataContainer::const_iterator begin = mDataContainer->findBegin(posKeyMin, true);
-  QCPGraphDataContainer::const_iterator end = mDataContainer->findEnd(posKeyMax, true);
-  for (QCPGraphDataContainer::const_iterator it=begin; it!=end; ++it)
+  const int end = mColumnData->findEnd(posKeyMax, true);
+  for (int i=mColumnData->findBegin(posKeyMin, true); i<end; ++i)
   {
-    const double currentDistSqr = QCPVector2D(coordsToPixels(it->key, it->value)-pixelPoint).lengthSquared();
+    const double currentDistSqr = QCPVector2D(coordsToPixels(mColumnData->keys()[i], mColumnData->values()[i])-pixelPoint).lengthSquared();
     if (currentDistSqr < minDistSqr)
-    {
       minDistSqr = currentDistSqr;
-      closestData = it;
-    }
   }
-    
-  // calculate distance to graph line if there is one (if so, will probably be smaller than distance to closest data point):
+  
+  // calculate distance to graph line if there is one:
   if (mLineStyle != lsNone)
   {
-    // line displayed, calculate distance to line segments:
     QVector<QPointF> lineData;
-    getLines(&lineData, QCPDataRange(0, dataCount())); // don't limit data range further since with sharp data spikes, line segments may be closer to test point than segments with closer key coordinate
+    getLines(&lineData, QCPDataRange(0, mColumnData->size()));
     QCPVector2D p(pixelPoint);
     const int step = mLineStyle==lsImpulse ? 2 : 1; // impulse plot differs from other line styles in that the lineData points are only pairwise connected
     for (int i=0; i<lineData.size()-1; i+=step)
@@ -22471,24 +25770,203 @@ double QCPGraph::pointDistance(const QPointF &pixelPoint, QCPGraphDataContainer:
   
   Finds the highest index of \a data, whose points y value is just below \a y. Assumes y values in
   \a data points are ordered ascending, as is ensured by \ref getLines/\ref getScatters if the key
-  axis is vertical.
+  axis is vertical, and uses a binary search.
 
   Used to calculate the channel fill polygon, see \ref getChannelFillPolygon.
 */
 int QCPGraph::findIndexBelowY(const QVector<QPointF> *data, double y) const
 {
-  for (int i=0; i<data->size(); ++i)
+  const int upperBound = int(std::upper_bound(data->constBegin(), data->constEnd(), y, qcpYPointLess)-data->constBegin()); // first point above y
+  if (upperBound == data->size())
+    return -1;
+  return qMax(0, upperBound-1);
+}
+
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 3, 0)
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPGraphDataStream
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPGraphDataStream
+  \brief Feeds data points from an acquisition thread into a QCPGraph without locking
+
+  Calling \ref QCPGraph::addData for every sample requires all samples to be passed to the GUI
+  thread one by one. QCPGraphDataStream instead provides a bounded single-producer/single-consumer
+  ring buffer: one acquisition thread writes samples with \ref push, and the GUI thread moves
+  everything written so far into the graph's data container in one sorted append by calling \ref
+  drain, typically once per frame:
+  
+  \code
+  QCPGraphDataStream *stream = new QCPGraphDataStream(customPlot->graph(0));
+  stream->setRetentionWindow(8); // keep the last 8 key units
+  connect(customPlot, SIGNAL(beforeReplot()), stream, SLOT(drain()));
+  // in the acquisition thread:
+  stream->push(key, value);
+  \endcode
+  
+  Neither side ever blocks. If the producer is faster than the consumer and the buffer is full,
+  new samples are dropped and counted (see \ref droppedCount), so the acquisition thread never
+  waits for the GUI.
+  
+  The keys must be pushed in ascending order, since \ref drain appends them with \a alreadySorted
+  set to true.
+  
+  The stream is a child of the graph it feeds. Stop the producer before the graph (and with it the
+  stream) is deleted.
+*/
+
+/* start documentation of inline functions */
+
+/*! \fn int QCPGraphDataStream::capacity() const
+  
+  Returns the maximum number of samples that can be pushed before \ref drain must be called. It is
+  the capacity passed to the constructor, rounded up to the next power of two.
+*/
+
+/*! \fn quint32 QCPGraphDataStream::droppedCount() const
+  
+  Returns the number of samples that were rejected by \ref push because the buffer was full. May
+  be called from any thread.
+*/
+
+/* end documentation of inline functions */
+
+/*!
+  Creates a stream feeding \a graph, with room for \a capacity samples between two calls to \ref
+  drain. The stream becomes a child of \a graph.
+*/
+QCPGraphDataStream::QCPGraphDataStream(QCPGraph *graph, int capacity) :
+  QObject(graph),
+  mGraph(graph),
+  mCapacity(2),
+  mRetentionWindow(0),
+  mBuffer(nullptr),
+  mMask(0),
+  mHead(0),
+  mCachedTail(0),
+  mDroppedCount(0),
+  mTail(0)
+{
+  while (mCapacity < capacity && mCapacity < (1<<30)) // power of two, so ring positions are a simple mask of the running counters
+    mCapacity *= 2;
+  mMask = quint32(mCapacity-1);
+  mBuffer = new QCPGraphData[mCapacity];
+}
+
+QCPGraphDataStream::~QCPGraphDataStream()
+{
+  delete[] mBuffer;
+}
+
+/*!
+  Returns the number of samples that were pushed but not yet drained into the graph.
+*/
+int QCPGraphDataStream::pendingCount() const
+{
+  return int(mHead.loadAcquire()-mTail.loadAcquire());
+}
+
+/*!
+  Sets the key span of data that is kept in the graph. After each \ref drain, data points with keys
+  smaller than the last key minus \a keySpan are removed with \ref QCPDataContainer::removeBefore,
+  which only moves the start of the container and thus is constant time on average.
+  
+  Set \a keySpan to zero (the default) to keep all data.
+*/
+void QCPGraphDataStream::setRetentionWindow(double keySpan)
+{
+  mRetentionWindow = keySpan;
+}
+
+/*!
+  Appends a sample with \a key and \a value to the stream. This method is meant to be called from
+  a single producer thread and never blocks.
+  
+  Returns false if the buffer is full, in which case the sample is dropped and counted in \ref
+  droppedCount.
+*/
+bool QCPGraphDataStream::push(double key, double value)
+{
+  const quint32 head = mHead.loadAcquire();
+  if (head-mCachedTail > mMask) // looks full, refresh the consumer position (only touches the consumer's cache line when needed)
   {
-    if (data->at(i).y() > y)
+    mCachedTail = mTail.loadAcquire();
+    if (head-mCachedTail > mMask)
     {
-      if (i>0)
-        return i-1;
-      else
-        return 0;
+      mDroppedCount.fetchAndAddRelaxed(1);
+      return false;
     }
   }
-  return -1;
+  mBuffer[head & mMask] = QCPGraphData(key, value);
+  mHead.storeRelease(head+1); // publishes the written sample to the consumer
+  return true;
+}
+
+/*! \overload
+  
+  Appends \a count samples from \a data with a single publication to the consumer. Samples that
+  don't fit into the buffer are dropped.
+  
+  Returns the number of samples that were appended.
+*/
+int QCPGraphDataStream::push(const QCPGraphData *data, int count)
+{
+  if (!data || count <= 0)
+    return 0;
+  const quint32 head = mHead.loadAcquire();
+  if (quint32(mCapacity)-(head-mCachedTail) < quint32(count))
+    mCachedTail = mTail.loadAcquire();
+  const int space = mCapacity-int(head-mCachedTail);
+  const int n = qMin(count, space);
+  if (n < count)
+    mDroppedCount.fetchAndAddRelaxed(quint32(count-n));
+  if (n <= 0)
+    return 0;
+  const int first = int(head & mMask);
+  const int firstCount = qMin(n, mCapacity-first); // the rest wraps around to the start of the buffer
+  std::copy(data, data+firstCount, mBuffer+first);
+  std::copy(data+firstCount, data+n, mBuffer);
+  mHead.storeRelease(head+quint32(n));
+  return n;
+}
+
+/*!
+  Moves all samples pushed so far into the data container of the graph, using one sorted append
+  (\ref QCPDataContainer::add with \a alreadySorted set to true), and applies the retention window
+  (\ref setRetentionWindow). Must be called from the thread the graph lives in, typically by
+  connecting it to \ref QCustomPlot::beforeReplot.
+  
+  Returns the number of samples that were drained. If the graph was deleted, pending samples are
+  discarded.
+*/
+int QCPGraphDataStream::drain()
+{
+  const quint32 tail = mTail.loadAcquire();
+  const quint32 head = mHead.loadAcquire();
+  const int count = int(head-tail);
+  if (count <= 0)
+    return 0;
+  if (!mGraph)
+  {
+    mTail.storeRelease(head);
+    return 0;
+  }
+  
+  mDrainBuffer.resize(count);
+  const int first = int(tail & mMask);
+  const int firstCount = qMin(count, mCapacity-first);
+  std::copy(mBuffer+first, mBuffer+first+firstCount, mDrainBuffer.begin());
+  std::copy(mBuffer, mBuffer+(count-firstCount), mDrainBuffer.begin()+firstCount);
+  mTail.storeRelease(head); // the producer may reuse the slots from here on
+  
+  QSharedPointer<QCPGraphDataContainer> data = mGraph->data();
+  data->add(mDrainBuffer, true);
+  if (mRetentionWindow > 0 && !data->isEmpty())
+    data->removeBefore((data->constEnd()-1)->key-mRetentionWindow);
+  return count;
 }
+#endif
 /* end of 'src/plottables/plottable-graph.cpp' */
 
 
@@ -22686,6 +26164,7 @@ QCPCurve::~QCPCurve()
 void QCPCurve::setData(QSharedPointer<QCPCurveDataContainer> data)
 {
   mDataContainer = data;
+  markDirty();
 }
 
 /*! \overload
@@ -22703,6 +26182,7 @@ void QCPCurve::setData(const QVector<double> &t, const QVector<double> &keys, co
 {
   mDataContainer->clear();
   addData(t, keys, values, alreadySorted);
+  markDirty();
 }
 
 
@@ -22721,6 +26201,7 @@ void QCPCurve::setData(const QVector<double> &keys, const QVector<double> &value
 {
   mDataContainer->clear();
   addData(keys, values);
+  markDirty();
 }
 
 /*!
@@ -22733,6 +26214,7 @@ void QCPCurve::setData(const QVector<double> &keys, const QVector<double> &value
 void QCPCurve::setScatterStyle(const QCPScatterStyle &style)
 {
   mScatterStyle = style;
+  markDirty();
 }
 
 /*!
@@ -22749,6 +26231,7 @@ void QCPCurve::setScatterStyle(const QCPScatterStyle &style)
 void QCPCurve::setScatterSkip(int skip)
 {
   mScatterSkip = qMax(0, skip);
+  markDirty();
 }
 
 /*!
@@ -22761,6 +26244,7 @@ void QCPCurve::setScatterSkip(int skip)
 void QCPCurve::setLineStyle(QCPCurve::LineStyle style)
 {
   mLineStyle = style;
+  markDirty();
 }
 
 /*! \overload
@@ -23032,9 +26516,7 @@ void QCPCurve::drawScatterPlot(QCPPainter *painter, const QVector<QPointF> &poin
   // draw scatter point symbols:
   applyScattersAntialiasingHint(painter);
   style.applyTo(painter, mPen);
-  foreach (const QPointF &point, points)
-    if (!qIsNaN(point.x()) && !qIsNaN(point.y()))
-      style.drawShape(painter,  point);
+  style.drawShapes(painter, points, mParentPlot->plottingHints().testFlag(QCP::phCacheScatters));
 }
 
 /*! \internal
@@ -23898,6 +27380,11 @@ void QCPCurve::getTraverseCornerPoints(int prevRegion, int currentRegion, double
   if the curve has a line representation, the returned distance may be smaller than the distance to
   the \a closestData point, since the distance to the curve line is also taken into account.
   
+  For curves with many data points, only the data points and line segments near \a pixelPoint are
+  looked at, found with the pixel index (see \ref QCPAbstractPlottable1D::pixelIndex and \ref
+  indexedLineDistance). Anything further away than the selection tolerance is then not considered,
+  so distances larger than the selection tolerance aren't exact.
+  
   If either the curve has no data or if the line style is \ref lsNone and the scatter style's shape
   is \ref QCPScatterStyle::ssNone (i.e. there is no visual representation of the curve), returns
   -1.0.
@@ -23917,8 +27404,21 @@ double QCPCurve::pointDistance(const QPointF &pixelPoint, QCPCurveDataContainer:
     return QCPVector2D(dataPoint-pixelPoint).length();
   }
   
-  // calculate minimum distances to curve data points and find closestData iterator:
+  // with a pixel index, only look at the data points and line segments within the selection tolerance:
+  const double tolerance = mParentPlot->selectionTolerance();
   double minDistSqr = (std::numeric_limits<double>::max)();
+  int closestIndex = -1;
+  if (findClosestIndexedPoint(pixelPoint, tolerance, closestIndex, minDistSqr) &&
+      (mLineStyle == lsNone || indexedLineDistance(pixelPoint, tolerance, minDistSqr)) &&
+      (closestIndex >= 0 || minDistSqr >= tolerance*tolerance)) // if only the line is within the tolerance, closestData is searched among all data points below
+  {
+    if (closestIndex >= 0)
+      closestData = mDataContainer->constBegin()+closestIndex;
+    return qSqrt(minDistSqr);
+  }
+  
+  // calculate minimum distances to curve data points and find closestData iterator:
+  minDistSqr = (std::numeric_limits<double>::max)();
   // iterate over found data points and then choose the one with the shortest distance to pos:
   QCPCurveDataContainer::const_iterator begin = mDataContainer->constBegin();
   QCPCurveDataContainer::const_iterator end = mDataContainer->constEnd();
@@ -23947,6 +27447,51 @@ double QCPCurve::pointDistance(const QPointF &pixelPoint, QCPCurveDataContainer:
   
   return qSqrt(minDistSqr);
 }
+
+/*! \internal
+  
+  Lowers \a minDistSqr to the squared pixel distance of \a pixelPoint to the curve line, if the
+  line comes closer. Only line segments which may be closer than \a maxDistance are looked at:
+  short segments are found through their end points in the pixel index cells around \a pixelPoint,
+  long ones are listed by the index separately (see \ref QCPDataPixelIndex::longSegments).
+  
+  Returns false without changing \a minDistSqr if there is no pixel index or it doesn't cover the
+  area around \a pixelPoint, in which case \ref getCurveLines must be used instead.
+*/
+bool QCPCurve::indexedLineDistance(const QPointF &pixelPoint, double maxDistance, double &minDistSqr) const
+{
+  const QCPDataPixelIndex *index = pixelIndex();
+  if (!index)
+    return false;
+  const double searchDistance = maxDistance+index->segmentThreshold()*0.5;
+  const QRectF searchRect(pixelPoint.x()-searchDistance, pixelPoint.y()-searchDistance, 2*searchDistance, 2*searchDistance);
+  if (!index->covers(searchRect))
+    return false;
+  
+  // segment i connects the data points i and i+1, so each data point found ends two segments:
+  QVector<int> segments;
+  index->findCandidates(searchRect, nullptr, &segments);
+  const int endPointCount = segments.size();
+  for (int i=0; i<endPointCount; ++i)
+    segments.append(segments.at(i)-1);
+  segments << index->longSegments();
+  
+  const QCPVector2D p(pixelPoint);
+  const int segmentCount = mDataContainer->size()-1;
+  for (int i=0; i<segments.size(); ++i)
+  {
+    const int segment = segments.at(i);
+    if (segment < 0 || segment >= segmentCount)
+      continue;
+    QCPCurveDataContainer::const_iterator it = mDataContainer->constBegin()+segment;
+    const QPointF start = coordsToPixels(it->key, it->value);
+    ++it;
+    const double currentDistSqr = p.distanceSquaredToLine(start, coordsToPixels(it->key, it->value));
+    if (currentDistSqr < minDistSqr) // also skips segments to NaN values, which aren't drawn
+      minDistSqr = currentDistSqr;
+  }
+  return true;
+}
 /* end of 'src/plottables/plottable-curve.cpp' */
 
 
@@ -24481,6 +28026,7 @@ QCPBars::~QCPBars()
 void QCPBars::setData(QSharedPointer<QCPBarsDataContainer> data)
 {
   mDataContainer = data;
+  markDirty();
 }
 
 /*! \overload
@@ -24498,6 +28044,7 @@ void QCPBars::setData(const QVector<double> &keys, const QVector<double> &values
 {
   mDataContainer->clear();
   addData(keys, values, alreadySorted);
+  markDirty();
 }
 
 /*!
@@ -24509,6 +28056,7 @@ void QCPBars::setData(const QVector<double> &keys, const QVector<double> &values
 void QCPBars::setWidth(double width)
 {
   mWidth = width;
+  markDirty();
 }
 
 /*!
@@ -24522,6 +28070,7 @@ void QCPBars::setWidth(double width)
 void QCPBars::setWidthType(QCPBars::WidthType widthType)
 {
   mWidthType = widthType;
+  markDirty();
 }
 
 /*!
@@ -24539,6 +28088,7 @@ void QCPBars::setBarsGroup(QCPBarsGroup *barsGroup)
   // register at new group:
   if (mBarsGroup)
     mBarsGroup->registerBars(this);
+  markDirty();
 }
 
 /*!
@@ -24556,6 +28106,7 @@ void QCPBars::setBarsGroup(QCPBarsGroup *barsGroup)
 void QCPBars::setBaseValue(double baseValue)
 {
   mBaseValue = baseValue;
+  markDirty();
 }
 
 /*!
@@ -24566,6 +28117,7 @@ void QCPBars::setBaseValue(double baseValue)
 void QCPBars::setStackingGap(double pixels)
 {
   mStackingGap = pixels;
+  markDirty();
 }
 
 /*! \overload
@@ -24851,6 +28403,7 @@ void QCPBars::draw(QCPPainter *painter)
   QList<QCPDataRange> selectedSegments, unselectedSegments, allSegments;
   getDataSegments(selectedSegments, unselectedSegments);
   allSegments << unselectedSegments << selectedSegments;
+  QVector<QRectF> barRects;
   for (int i=0; i<allSegments.size(); ++i)
   {
     bool isSelectedSegment = i >= unselectedSegments.size();
@@ -24860,6 +28413,9 @@ void QCPBars::draw(QCPPainter *painter)
     if (begin == end)
       continue;
     
+    // collect the bars of the segment, they all share the same pen and brush:
+    barRects.clear();
+    barRects.reserve(int(end-begin));
     for (QCPBarsDataContainer::const_iterator it=begin; it!=end; ++it)
     {
       // check data validity if flag set:
@@ -24867,19 +28423,20 @@ void QCPBars::draw(QCPPainter *painter)
       if (QCP::isInvalidData(it->key, it->value))
         qDebug() << Q_FUNC_INFO << "Data point at" << it->key << "of drawn range invalid." << "Plottable name:" << name();
 #endif
-      // draw bar:
-      if (isSelectedSegment && mSelectionDecorator)
-      {
-        mSelectionDecorator->applyBrush(painter);
-        mSelectionDecorator->applyPen(painter);
-      } else
-      {
-        painter->setBrush(mBrush);
-        painter->setPen(mPen);
-      }
-      applyDefaultAntialiasingHint(painter);
-      painter->drawPolygon(getBarRect(it->key, it->value));
+      barRects.append(getBarRect(it->key, it->value));
     }
+    // draw bars:
+    if (isSelectedSegment && mSelectionDecorator)
+    {
+      mSelectionDecorator->applyBrush(painter);
+      mSelectionDecorator->applyPen(painter);
+    } else
+    {
+      painter->setBrush(mBrush);
+      painter->setPen(mPen);
+    }
+    applyDefaultAntialiasingHint(painter);
+    painter->drawRects(barRects);
   }
   
   // draw other selection decoration that isn't just line/scatter pens and brushes:
@@ -25357,6 +28914,7 @@ QCPStatisticalBox::QCPStatisticalBox(QCPAxis *keyAxis, QCPAxis *valueAxis) :
 void QCPStatisticalBox::setData(QSharedPointer<QCPStatisticalBoxDataContainer> data)
 {
   mDataContainer = data;
+  markDirty();
 }
 /*! \overload
   
@@ -25373,6 +28931,7 @@ void QCPStatisticalBox::setData(const QVector<double> &keys, const QVector<doubl
 {
   mDataContainer->clear();
   addData(keys, minimum, lowerQuartile, median, upperQuartile, maximum, alreadySorted);
+  markDirty();
 }
 
 /*!
@@ -25383,6 +28942,7 @@ void QCPStatisticalBox::setData(const QVector<double> &keys, const QVector<doubl
 void QCPStatisticalBox::setWidth(double width)
 {
   mWidth = width;
+  markDirty();
 }
 
 /*!
@@ -25396,6 +28956,7 @@ void QCPStatisticalBox::setWidth(double width)
 void QCPStatisticalBox::setWhiskerWidth(double width)
 {
   mWhiskerWidth = width;
+  markDirty();
 }
 
 /*!
@@ -25412,6 +28973,7 @@ void QCPStatisticalBox::setWhiskerWidth(double width)
 void QCPStatisticalBox::setWhiskerPen(const QPen &pen)
 {
   mWhiskerPen = pen;
+  markDirty();
 }
 
 /*!
@@ -25426,6 +28988,7 @@ void QCPStatisticalBox::setWhiskerPen(const QPen &pen)
 void QCPStatisticalBox::setWhiskerBarPen(const QPen &pen)
 {
   mWhiskerBarPen = pen;
+  markDirty();
 }
 
 /*!
@@ -25437,6 +29000,7 @@ void QCPStatisticalBox::setWhiskerBarPen(const QPen &pen)
 void QCPStatisticalBox::setWhiskerAntialiased(bool enabled)
 {
   mWhiskerAntialiased = enabled;
+  markDirty();
 }
 
 /*!
@@ -25445,6 +29009,7 @@ void QCPStatisticalBox::setWhiskerAntialiased(bool enabled)
 void QCPStatisticalBox::setMedianPen(const QPen &pen)
 {
   mMedianPen = pen;
+  markDirty();
 }
 
 /*!
@@ -25456,6 +29021,7 @@ void QCPStatisticalBox::setMedianPen(const QPen &pen)
 void QCPStatisticalBox::setOutlierStyle(const QCPScatterStyle &style)
 {
   mOutlierStyle = style;
+  markDirty();
 }
 
 /*! \overload
@@ -25853,7 +29419,9 @@ QCPColorMapData::QCPColorMapData(int keySize, int valueSize, const QCPRange &key
   mIsEmpty(true),
   mData(nullptr),
   mAlpha(nullptr),
-  mDataModified(true)
+  mDataModified(true),
+  mCellsModified(false),
+  mVersion(0)
 {
   setSize(keySize, valueSize);
   fill(0);
@@ -25874,7 +29442,9 @@ QCPColorMapData::QCPColorMapData(const QCPColorMapData &other) :
   mIsEmpty(true),
   mData(nullptr),
   mAlpha(nullptr),
-  mDataModified(true)
+  mDataModified(true),
+  mCellsModified(false),
+  mVersion(0)
 {
   *this = other;
 }
@@ -25903,6 +29473,7 @@ QCPColorMapData &QCPColorMapData::operator=(const QCPColorMapData &other)
     }
     mDataBounds = other.mDataBounds;
     mDataModified = true;
+    ++mVersion;
   }
   return *this;
 }
@@ -25982,7 +29553,11 @@ void QCPColorMapData::setSize(int keySize, int valueSize)
     if (mAlpha) // if we had an alpha map, recreate it with new size
       createAlpha();
     
+    mModifiedValueRows = QVector<bool>(mValueSize, false);
+    mModifiedKeyColumns = QVector<bool>(mKeySize, false);
+    mCellsModified = false;
     mDataModified = true;
+    ++mVersion;
   }
 }
 
@@ -26045,6 +29620,7 @@ void QCPColorMapData::setRange(const QCPRange &keyRange, const QCPRange &valueRa
 void QCPColorMapData::setKeyRange(const QCPRange &keyRange)
 {
   mKeyRange = keyRange;
+  ++mVersion;
 }
 
 /*!
@@ -26060,6 +29636,7 @@ void QCPColorMapData::setKeyRange(const QCPRange &keyRange)
 void QCPColorMapData::setValueRange(const QCPRange &valueRange)
 {
   mValueRange = valueRange;
+  ++mVersion;
 }
 
 /*!
@@ -26085,7 +29662,7 @@ void QCPColorMapData::setData(double key, double value, double z)
       mDataBounds.lower = z;
     if (z > mDataBounds.upper)
       mDataBounds.upper = z;
-     mDataModified = true;
+    markCellModified(keyCell, valueCell);
   }
 }
 
@@ -26109,7 +29686,7 @@ void QCPColorMapData::setCell(int keyIndex, int valueIndex, double z)
       mDataBounds.lower = z;
     if (z > mDataBounds.upper)
       mDataBounds.upper = z;
-     mDataModified = true;
+    markCellModified(keyIndex, valueIndex);
   } else
     qDebug() << Q_FUNC_INFO << "index out of bounds:" << keyIndex << valueIndex;
 }
@@ -26136,7 +29713,7 @@ void QCPColorMapData::setAlpha(int keyIndex, int valueIndex, unsigned char alpha
     if (mAlpha || createAlpha())
     {
       mAlpha[valueIndex*mKeySize + keyIndex] = alpha;
-      mDataModified = true;
+      markCellModified(keyIndex, valueIndex);
     }
   } else
     qDebug() << Q_FUNC_INFO << "index out of bounds:" << keyIndex << valueIndex;
@@ -26194,6 +29771,7 @@ void QCPColorMapData::clearAlpha()
     delete[] mAlpha;
     mAlpha = nullptr;
     mDataModified = true;
+    ++mVersion;
   }
 }
 
@@ -26206,6 +29784,7 @@ void QCPColorMapData::fill(double z)
   memset(mData, z, dataCount*sizeof(*mData));
   mDataBounds = QCPRange(z, z);
   mDataModified = true;
+  ++mVersion;
 }
 
 /*!
@@ -26224,6 +29803,7 @@ void QCPColorMapData::fillAlpha(unsigned char alpha)
     const int dataCount = mValueSize*mKeySize;
     memset(mAlpha, alpha, dataCount*sizeof(*mAlpha));
     mDataModified = true;
+    ++mVersion;
   }
 }
 
@@ -26313,6 +29893,36 @@ bool QCPColorMapData::createAlpha(bool initializeOpaque)
   }
 }
 
+/*! \internal
+  
+  Flags the value row and key column of the cell at \a keyIndex and \a valueIndex as modified, so
+  \ref QCPColorMap::updateMapImage only needs to colorize the scanlines containing modified cells
+  instead of the whole map. Operations that touch all cells set \a mDataModified instead.
+*/
+void QCPColorMapData::markCellModified(int keyIndex, int valueIndex)
+{
+  mModifiedValueRows[valueIndex] = true;
+  mModifiedKeyColumns[keyIndex] = true;
+  mCellsModified = true;
+  ++mVersion;
+}
+
+/*! \internal
+  
+  Resets all modification flags, called by \ref QCPColorMap::updateMapImage once the map image is
+  up to date.
+*/
+void QCPColorMapData::clearModified()
+{
+  mDataModified = false;
+  if (mCellsModified)
+  {
+    mModifiedValueRows.fill(false);
+    mModifiedKeyColumns.fill(false);
+    mCellsModified = false;
+  }
+}
+
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////// QCPColorMap
@@ -26477,6 +30087,7 @@ void QCPColorMap::setData(QCPColorMapData *data, bool copy)
     mMapData = data;
   }
   mMapImageInvalidated = true;
+  markDirty();
 }
 
 /*!
@@ -26499,6 +30110,7 @@ void QCPColorMap::setDataRange(const QCPRange &dataRange)
     mMapImageInvalidated = true;
     emit dataRangeChanged(mDataRange);
   }
+  markDirty();
 }
 
 /*!
@@ -26516,6 +30128,7 @@ void QCPColorMap::setDataScaleType(QCPAxis::ScaleType scaleType)
     if (mDataScaleType == QCPAxis::stLogarithmic)
       setDataRange(mDataRange.sanitizedForLogScale());
   }
+  markDirty();
 }
 
 /*!
@@ -26537,6 +30150,7 @@ void QCPColorMap::setGradient(const QCPColorGradient &gradient)
     mMapImageInvalidated = true;
     emit gradientChanged(mGradient);
   }
+  markDirty();
 }
 
 /*!
@@ -26549,6 +30163,7 @@ void QCPColorMap::setInterpolate(bool enabled)
 {
   mInterpolate = enabled;
   mMapImageInvalidated = true; // because oversampling factors might need to change
+  markDirty();
 }
 
 /*!
@@ -26565,6 +30180,7 @@ void QCPColorMap::setInterpolate(bool enabled)
 void QCPColorMap::setTightBoundary(bool enabled)
 {
   mTightBoundary = enabled;
+  markDirty();
 }
 
 /*!
@@ -26605,6 +30221,7 @@ void QCPColorMap::setColorScale(QCPColorScale *colorScale)
     connect(mColorScale.data(), SIGNAL(gradientChanged(QCPColorGradient)), this, SLOT(setGradient(QCPColorGradient)));
     connect(mColorScale.data(), SIGNAL(dataScaleTypeChanged(QCPAxis::ScaleType)), this, SLOT(setDataScaleType(QCPAxis::ScaleType)));
   }
+  markDirty();
 }
 
 /*!
@@ -26737,6 +30354,83 @@ QCPRange QCPColorMap::getValueRange(bool &foundRange, QCP::SignDomain inSignDoma
   return result;
 }
 
+/*!
+  Returns a value that changes whenever the cells, alpha values, size or range of the \ref
+  data of this color map change.
+  
+  \seebaseclassmethod
+*/
+quint64 QCPColorMap::dataVersion() const
+{
+  return mMapData->mVersion;
+}
+
+/*! \internal
+  
+  Colorizes scanlines of a color map image, see \ref QCPColorMap::updateMapImage. One instance
+  describes the whole image, \ref run colorizes a subset of its scanlines and may be called from
+  several threads at once for disjoint subsets.
+*/
+struct QCPColorMapColorizeJob
+{
+  QCPColorGradient *gradient; // color buffer must be up to date, so concurrent colorize calls only read it
+  const double *data;
+  const unsigned char *alpha;
+  QCPRange range;
+  bool logarithmic;
+  int lineCount, rowCount; // scanlines and pixels per scanline of the undersampled image
+  int lineStride, cellStride; // data index offset between consecutive scanlines and consecutive pixels
+  uchar *bits;
+  qptrdiff bytesPerLine;
+  uchar *scaledBits; // oversampled image, nullptr if no oversampling is needed
+  qptrdiff scaledBytesPerLine;
+  int lineFactor, pixelFactor; // oversampling factors in scanline and pixel direction
+  
+  void run(const int *lines, int count) const
+  {
+    for (int i=0; i<count; ++i)
+    {
+      const int line = lines[i];
+      const int imageLine = lineCount-1-line; // invert scanline index because QImage counts scanlines from top, but our vertical index counts from bottom (mathematical coordinate system)
+      QRgb *pixels = reinterpret_cast<QRgb*>(bits+imageLine*bytesPerLine);
+      if (alpha)
+        gradient->colorize(data+line*lineStride, alpha+line*lineStride, range, pixels, rowCount, cellStride, logarithmic);
+      else
+        gradient->colorize(data+line*lineStride, range, pixels, rowCount, cellStride, logarithmic);
+      if (scaledBits) // replicate pixels and scanline by the oversampling factors (same result as QImage::scaled with Qt::FastTransformation)
+      {
+        QRgb *scaled = reinterpret_cast<QRgb*>(scaledBits+imageLine*lineFactor*scaledBytesPerLine);
+        for (int x=0; x<rowCount; ++x)
+          std::fill(scaled+x*pixelFactor, scaled+(x+1)*pixelFactor, pixels[x]);
+        for (int k=1; k<lineFactor; ++k)
+          memcpy(scaledBits+(imageLine*lineFactor+k)*scaledBytesPerLine, scaled, sizeof(QRgb)*size_t(rowCount*pixelFactor));
+      }
+    }
+  }
+};
+
+/*! \internal
+  
+  Runs a part of a \ref QCPColorMapColorizeJob in the global thread pool and releases \a done when
+  finished.
+*/
+class QCPColorMapColorizeTask : public QRunnable
+{
+public:
+  QCPColorMapColorizeTask(const QCPColorMapColorizeJob *job, const int *lines, int count, QSemaphore *done) :
+    mJob(job), mLines(lines), mCount(count), mDone(done) {}
+  virtual void run() Q_DECL_OVERRIDE
+  {
+    mJob->run(mLines, mCount);
+    mDone->release();
+  }
+private:
+  const QCPColorMapColorizeJob *mJob;
+  const int *mLines;
+  int mCount;
+  QSemaphore *mDone;
+};
+
 /*! \internal
   
   Updates the internal map image buffer by going through the internal \ref QCPColorMapData and
@@ -26746,6 +30440,12 @@ QCPRange QCPColorMap::getValueRange(bool &foundRange, QCP::SignDomain inSignDoma
   has been invalidated for a different reason (e.g. a change of the data range with \ref
   setDataRange).
   
+  If only single cells were modified (\ref QCPColorMapData::setCell, \ref QCPColorMapData::setData,
+  \ref QCPColorMapData::setAlpha) and the image is otherwise still valid, only the scanlines
+  containing those cells are colorized again. Large updates are split into blocks of scanlines
+  which are colorized in parallel on the global QThreadPool, the calling thread takes part in the
+  work.
+  
   If the map cell count is low, the image created will be oversampled in order to avoid a
   QPainter::drawImage bug which makes inner pixel boundaries jitter when stretch-drawing images
   without smooth transform enabled. Accordingly, oversampling isn't performed if \ref
@@ -26762,12 +30462,18 @@ void QCPColorMap::updateMapImage()
   const int valueSize = mMapData->valueSize();
   int keyOversamplingFactor = mInterpolate ? 1 : int(1.0+100.0/double(keySize)); // make mMapImage have at least size 100, factor becomes 1 if size > 200 or interpolation is on
   int valueOversamplingFactor = mInterpolate ? 1 : int(1.0+100.0/double(valueSize)); // make mMapImage have at least size 100, factor becomes 1 if size > 200 or interpolation is on
+  bool imageRecreated = false; // if an image buffer is new, all scanlines need to be colorized
   
   // resize mMapImage to correct dimensions including possible oversampling factors, according to key/value axes orientation:
   if (keyAxis->orientation() == Qt::Horizontal && (mMapImage.width() != keySize*keyOversamplingFactor || mMapImage.height() != valueSize*valueOversamplingFactor))
+  {
     mMapImage = QImage(QSize(keySize*keyOversamplingFactor, valueSize*valueOversamplingFactor), format);
-  else if (keyAxis->orientation() == Qt::Vertical && (mMapImage.width() != valueSize*valueOversamplingFactor || mMapImage.height() != keySize*keyOversamplingFactor))
+    imageRecreated = true;
+  } else if (keyAxis->orientation() == Qt::Vertical && (mMapImage.width() != valueSize*valueOversamplingFactor || mMapImage.height() != keySize*keyOversamplingFactor))
+  {
     mMapImage = QImage(QSize(valueSize*valueOversamplingFactor, keySize*keyOversamplingFactor), format);
+    imageRecreated = true;
+  }
   
   if (mMapImage.isNull())
   {
@@ -26781,50 +30487,79 @@ void QCPColorMap::updateMapImage()
     {
       // resize undersampled map image to actual key/value cell sizes:
       if (keyAxis->orientation() == Qt::Horizontal && (mUndersampledMapImage.width() != keySize || mUndersampledMapImage.height() != valueSize))
+      {
         mUndersampledMapImage = QImage(QSize(keySize, valueSize), format);
-      else if (keyAxis->orientation() == Qt::Vertical && (mUndersampledMapImage.width() != valueSize || mUndersampledMapImage.height() != keySize))
+        imageRecreated = true;
+      } else if (keyAxis->orientation() == Qt::Vertical && (mUndersampledMapImage.width() != valueSize || mUndersampledMapImage.height() != keySize))
+      {
         mUndersampledMapImage = QImage(QSize(valueSize, keySize), format);
+        imageRecreated = true;
+      }
       localMapImage = &mUndersampledMapImage; // make the colorization run on the undersampled image
     } else if (!mUndersampledMapImage.isNull())
       mUndersampledMapImage = QImage(); // don't need oversampling mechanism anymore (map size has changed) but mUndersampledMapImage still has nonzero size, free it
     
-    const double *rawData = mMapData->mData;
-    const unsigned char *rawAlpha = mMapData->mAlpha;
-    if (keyAxis->orientation() == Qt::Horizontal)
-    {
-      const int lineCount = valueSize;
-      const int rowCount = keySize;
-      for (int line=0; line<lineCount; ++line)
-      {
-        QRgb* pixels = reinterpret_cast<QRgb*>(localMapImage->scanLine(lineCount-1-line)); // invert scanline index because QImage counts scanlines from top, but our vertical index counts from bottom (mathematical coordinate system)
-        if (rawAlpha)
-          mGradient.colorize(rawData+line*rowCount, rawAlpha+line*rowCount, mDataRange, pixels, rowCount, 1, mDataScaleType==QCPAxis::stLogarithmic);
-        else
-          mGradient.colorize(rawData+line*rowCount, mDataRange, pixels, rowCount, 1, mDataScaleType==QCPAxis::stLogarithmic);
-      }
-    } else // keyAxis->orientation() == Qt::Vertical
+    const bool horizontal = keyAxis->orientation() == Qt::Horizontal;
+    QCPColorMapColorizeJob job;
+    job.gradient = &mGradient;
+    job.data = mMapData->mData;
+    job.alpha = mMapData->mAlpha;
+    job.range = mDataRange;
+    job.logarithmic = mDataScaleType==QCPAxis::stLogarithmic;
+    job.lineCount = horizontal ? valueSize : keySize;
+    job.rowCount = horizontal ? keySize : valueSize;
+    job.lineStride = horizontal ? keySize : 1;
+    job.cellStride = horizontal ? 1 : keySize;
+    job.bits = localMapImage->bits();
+    job.bytesPerLine = localMapImage->bytesPerLine();
+    job.scaledBits = localMapImage != &mMapImage ? mMapImage.bits() : nullptr;
+    job.scaledBytesPerLine = mMapImage.bytesPerLine();
+    job.lineFactor = horizontal ? valueOversamplingFactor : keyOversamplingFactor;
+    job.pixelFactor = horizontal ? keyOversamplingFactor : valueOversamplingFactor;
+    
+    // collect the scanlines that need to be colorized, i.e. all of them unless only single cells were modified:
+    const bool updateAll = imageRecreated || mMapImageInvalidated || mMapData->mDataModified;
+    const QVector<bool> &modifiedLines = horizontal ? mMapData->mModifiedValueRows : mMapData->mModifiedKeyColumns;
+    QVector<int> lines;
+    lines.reserve(updateAll ? job.lineCount : 16);
+    for (int line=0; line<job.lineCount; ++line)
     {
-      const int lineCount = keySize;
-      const int rowCount = valueSize;
-      for (int line=0; line<lineCount; ++line)
-      {
-        QRgb* pixels = reinterpret_cast<QRgb*>(localMapImage->scanLine(lineCount-1-line)); // invert scanline index because QImage counts scanlines from top, but our vertical index counts from bottom (mathematical coordinate system)
-        if (rawAlpha)
-          mGradient.colorize(rawData+line, rawAlpha+line, mDataRange, pixels, rowCount, lineCount, mDataScaleType==QCPAxis::stLogarithmic);
-        else
-          mGradient.colorize(rawData+line, mDataRange, pixels, rowCount, lineCount, mDataScaleType==QCPAxis::stLogarithmic);
-      }
+      if (updateAll || modifiedLines.at(line))
+        lines.append(line);
     }
     
-    if (keyOversamplingFactor > 1 || valueOversamplingFactor > 1)
-    {
-      if (keyAxis->orientation() == Qt::Horizontal)
-        mMapImage = mUndersampledMapImage.scaled(keySize*keyOversamplingFactor, valueSize*valueOversamplingFactor, Qt::IgnoreAspectRatio, Qt::FastTransformation);
-      else
-        mMapImage = mUndersampledMapImage.scaled(valueSize*valueOversamplingFactor, keySize*keyOversamplingFactor, Qt::IgnoreAspectRatio, Qt::FastTransformation);
+    if (!lines.isEmpty())
+    {
+      // the first scanline is colorized here, which also brings the gradient's color buffer up to date before other threads read it:
+      job.run(lines.constData(), 1);
+      const int remaining = lines.size()-1;
+      QThreadPool *pool = QThreadPool::globalInstance();
+      const int cellsPerTask = 65536; // below that, dispatching costs more than it saves
+      const int taskCount = int(qMin(qint64(pool->maxThreadCount()), qint64(remaining)*job.rowCount/cellsPerTask));
+      if (taskCount > 1)
+      {
+        const int linesPerTask = (remaining+taskCount-1)/taskCount;
+        QSemaphore done;
+        int started = 0;
+        int first = 1;
+        for (; first+linesPerTask < lines.size(); first+=linesPerTask) // the last block is left for this thread
+        {
+          QCPColorMapColorizeTask *task = new QCPColorMapColorizeTask(&job, lines.constData()+first, linesPerTask, &done);
+          if (pool->tryStart(task))
+            ++started;
+          else // pool is busy, don't wait for it
+          {
+            delete task;
+            job.run(lines.constData()+first, linesPerTask);
+          }
+        }
+        job.run(lines.constData()+first, lines.size()-first);
+        done.acquire(started);
+      } else
+        job.run(lines.constData()+1, remaining);
     }
   }
-  mMapData->mDataModified = false;
+  mMapData->clearModified();
   mMapImageInvalidated = false;
 }
 
@@ -26835,7 +30570,7 @@ void QCPColorMap::draw(QCPPainter *painter)
   if (!mKeyAxis || !mValueAxis) return;
   applyDefaultAntialiasingHint(painter);
   
-  if (mMapData->mDataModified || mMapImageInvalidated)
+  if (mMapData->mDataModified || mMapData->mCellsModified || mMapImageInvalidated)
     updateMapImage();
   
   // use buffer if painting vectorized (PDF):
@@ -27021,6 +30756,185 @@ QCPFinancialData::QCPFinancialData(double key, double open, double high, double
 }
 
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////// QCPFinancialAggregator
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/*! \class QCPFinancialAggregator
+  \brief Incrementally aggregates a tick stream into OHLC data of several timeframes
+  
+  Where \ref QCPFinancial::timeSeriesToOhlc converts a complete time series in one go, this class
+  keeps the OHLC data of several timeframes (by default 1 second, 1 minute, 5 minutes and 1 hour)
+  up to date while ticks arrive. Each call of \ref addTick either extends the open candle of each
+  timeframe or appends a new one, which takes constant time per timeframe. The raw ticks themselves
+  are not stored.
+  
+  The bins are the same as those of \ref QCPFinancial::timeSeriesToOhlc with the same bin size and
+  offset, i.e. a candle at key \a k covers the times from \a k minus half the timeframe up to \a k
+  plus half the timeframe.
+  
+  Pass the aggregator to \ref QCPFinancial::setAggregator. At every replot the financial then shows
+  the candles of the timeframe that suits the visible key range (see \ref timeframeIndex), so
+  zooming out across a long history only ever draws a limited number of candles. The data
+  containers of the individual timeframes are available via \ref data.
+  
+  Ticks are expected to arrive mostly in chronological order. A late tick that belongs to an earlier
+  candle only extends that candle's high and low, since its position relative to the other ticks
+  of the candle is unknown.
+*/
+
+/*!
+  Constructs an aggregator with the timeframes 1, 60, 300 and 3600, i.e. 1 second, 1 minute, 5
+  minutes and 1 hour if the tick times are given in seconds.
+*/
+QCPFinancialAggregator::QCPFinancialAggregator() :
+  mTimeframeOffset(0),
+  mMinimumCandleWidth(3),
+  mLastTickTime(-std::numeric_limits<double>::infinity())
+{
+  mTimeframes << 1 << 60 << 300 << 3600;
+  for (int i=0; i<mTimeframes.size(); ++i)
+    mData.append(QSharedPointer<QCPFinancialDataContainer>(new QCPFinancialDataContainer));
+}
+
+/*!
+  Constructs an aggregator with the bin sizes \a timeframes, given in the same unit as the tick
+  times. Non-positive timeframes are ignored, the rest is sorted from finest to coarsest.
+  
+  \a timeframeOffset defines the phase of the bins, like the \a timeBinOffset parameter of \ref
+  QCPFinancial::timeSeriesToOhlc.
+*/
+QCPFinancialAggregator::QCPFinancialAggregator(const QVector<double> &timeframes, double timeframeOffset) :
+  mTimeframeOffset(timeframeOffset),
+  mMinimumCandleWidth(3),
+  mLastTickTime(-std::numeric_limits<double>::infinity())
+{
+  foreach (double timeframe, timeframes)
+  {
+    if (timeframe > 0)
+      mTimeframes.append(timeframe);
+  }
+  std::sort(mTimeframes.begin(), mTimeframes.end());
+  for (int i=0; i<mTimeframes.size(); ++i)
+    mData.append(QSharedPointer<QCPFinancialDataContainer>(new QCPFinancialDataContainer));
+}
+
+/*!
+  Returns the data container holding the candles of the timeframe with index \a timeframeIndex in
+  \ref timeframes. If the index is out of bounds, returns a null pointer.
+  
+  The containers are updated in place by \ref addTick, so they can also be shown directly with \ref
+  QCPFinancial::setData.
+*/
+QSharedPointer<QCPFinancialDataContainer> QCPFinancialAggregator::data(int timeframeIndex) const
+{
+  if (timeframeIndex >= 0 && timeframeIndex < mData.size())
+    return mData.at(timeframeIndex);
+  qDebug() << Q_FUNC_INFO << "Index out of bounds" << timeframeIndex;
+  return QSharedPointer<QCPFinancialDataContainer>();
+}
+
+/*!
+  Sets the width in pixels that candles of the chosen timeframe should at least have, see \ref
+  timeframeIndex. The default is 3 pixels.
+*/
+void QCPFinancialAggregator::setMinimumCandleWidth(double pixels)
+{
+  mMinimumCandleWidth = pixels;
+}
+
+/*!
+  Adds a tick with the specified \a value at \a time to the candles of all timeframes.
+  
+  If \a time is in the bin of the last candle of a timeframe, that candle is extended: its close is
+  set to \a value, and its high and low are extended if necessary. If \a time lies beyond it, a new
+  candle is appended. Both take constant time.
+  
+  \see addTicks
+*/
+void QCPFinancialAggregator::addTick(double time, double value)
+{
+  if (qIsNaN(time) || qIsNaN(value))
+    return;
+  
+  const bool inOrder = time >= mLastTickTime;
+  if (inOrder)
+    mLastTickTime = time;
+  for (int i=0; i<mTimeframes.size(); ++i)
+  {
+    QCPFinancialDataContainer *data = mData.at(i).data();
+    const double timeframe = mTimeframes.at(i);
+    const double binKey = mTimeframeOffset+qFloor((time-mTimeframeOffset)/timeframe+0.5)*timeframe;
+    if (data->isEmpty() || binKey > (data->constEnd()-1)->key)
+    {
+      data->add(QCPFinancialData(binKey, value, value, value, value)); // appending is constant time
+      continue;
+    }
+    
+    int index = data->size()-1;
+    if (binKey < (data->constEnd()-1)->key) // late tick, look up the candle it belongs to
+    {
+      QCPFinancialDataContainer::const_iterator it = data->findBegin(binKey, false);
+      if (it == data->constEnd() || it->key != binKey)
+      {
+        data->add(QCPFinancialData(binKey, value, value, value, value));
+        continue;
+      }
+      index = int(it-data->constBegin());
+    }
+    QCPFinancialDataContainer::iterator candle = data->begin()+index;
+    if (value > candle->high)
+      candle->high = value;
+    if (value < candle->low)
+      candle->low = value;
+    if (inOrder && index == data->size()-1)
+      candle->close = value;
+    data->invalidateLevelOfDetail(index); // also increases the container's version
+  }
+}
+
+/*! \overload
+  
+  Adds the ticks with the values \a value at the times \a time. The provided vectors should have
+  equal length. Else, the number of added ticks will be the size of the smallest vector.
+*/
+void QCPFinancialAggregator::addTicks(const QVector<double> &time, const QVector<double> &value)
+{
+  const int count = qMin(time.size(), value.size());
+  for (int i=0; i<count; ++i)
+    addTick(time.at(i), value.at(i));
+}
+
+/*!
+  Removes the candles of all timeframes.
+*/
+void QCPFinancialAggregator::clear()
+{
+  for (int i=0; i<mData.size(); ++i)
+    mData.at(i)->clear();
+  mLastTickTime = -std::numeric_limits<double>::infinity();
+}
+
+/*!
+  Returns the index of the timeframe that suits showing the key range \a keyRange on \a pixelLength
+  pixels. This is the finest timeframe whose candles are at least \ref setMinimumCandleWidth
+  "minimumCandleWidth" pixels wide. If even the candles of the coarsest timeframe are narrower, the
+  coarsest timeframe is returned.
+  
+  Returns -1 if the aggregator has no timeframes.
+*/
+int QCPFinancialAggregator::timeframeIndex(const QCPRange &keyRange, double pixelLength) const
+{
+  if (mTimeframes.isEmpty())
+    return -1;
+  for (int i=0; i<mTimeframes.size(); ++i)
+  {
+    if (pixelLength*mTimeframes.at(i) >= mMinimumCandleWidth*keyRange.size())
+      return i;
+  }
+  return mTimeframes.size()-1;
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 //////////////////// QCPFinancial
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -27040,6 +30954,10 @@ QCPFinancialData::QCPFinancialData(double key, double open, double high, double
   convenience function \ref timeSeriesToOhlc to generate binned OHLC-data which can then be passed
   to \ref setData.
 
+  If the values arrive as a stream of ticks, a \ref QCPFinancialAggregator can bin them
+  incrementally into several timeframes at once. Set it with \ref setAggregator, and the financial
+  shows the timeframe that suits the visible key range.
+
   The width of the OHLC bars/candlesticks can be controlled with \ref setWidth and \ref
   setWidthType. A typical choice is to set the width type to \ref wtPlotCoords (the default) and
   the width to (or slightly less than) one time bin interval width.
@@ -27104,7 +31022,8 @@ QCPFinancial::QCPFinancial(QCPAxis *keyAxis, QCPAxis *valueAxis) :
   mBrushPositive(QBrush(QColor(50, 160, 0))),
   mBrushNegative(QBrush(QColor(180, 0, 15))),
   mPenPositive(QPen(QColor(40, 150, 0))),
-  mPenNegative(QPen(QColor(170, 5, 5)))
+  mPenNegative(QPen(QColor(170, 5, 5))),
+  mTimeframeIndex(-1)
 {
   mSelectionDecorator->setBrush(QBrush(QColor(160, 160, 255)));
 }
@@ -27130,7 +31049,10 @@ QCPFinancial::~QCPFinancial()
 */
 void QCPFinancial::setData(QSharedPointer<QCPFinancialDataContainer> data)
 {
+  if (mAggregator)
+    setAggregator(QSharedPointer<QCPFinancialAggregator>());
   mDataContainer = data;
+  markDirty();
 }
 
 /*! \overload
@@ -27146,8 +31068,14 @@ void QCPFinancial::setData(QSharedPointer<QCPFinancialDataContainer> data)
 */
 void QCPFinancial::setData(const QVector<double> &keys, const QVector<double> &open, const QVector<double> &high, const QVector<double> &low, const QVector<double> &close, bool alreadySorted)
 {
+  if (mAggregator) // don't overwrite the candles of the aggregator, it may be shared with other financials
+  {
+    setAggregator(QSharedPointer<QCPFinancialAggregator>());
+    mDataContainer = QSharedPointer<QCPFinancialDataContainer>(new QCPFinancialDataContainer);
+  }
   mDataContainer->clear();
   addData(keys, open, high, low, close, alreadySorted);
+  markDirty();
 }
 
 /*!
@@ -27156,6 +31084,7 @@ void QCPFinancial::setData(const QVector<double> &keys, const QVector<double> &o
 void QCPFinancial::setChartStyle(QCPFinancial::ChartStyle style)
 {
   mChartStyle = style;
+  markDirty();
 }
 
 /*!
@@ -27166,6 +31095,7 @@ void QCPFinancial::setChartStyle(QCPFinancial::ChartStyle style)
 void QCPFinancial::setWidth(double width)
 {
   mWidth = width;
+  markDirty();
 }
 
 /*!
@@ -27179,6 +31109,7 @@ void QCPFinancial::setWidth(double width)
 void QCPFinancial::setWidthType(QCPFinancial::WidthType widthType)
 {
   mWidthType = widthType;
+  markDirty();
 }
 
 /*!
@@ -27193,6 +31124,7 @@ void QCPFinancial::setWidthType(QCPFinancial::WidthType widthType)
 void QCPFinancial::setTwoColored(bool twoColored)
 {
   mTwoColored = twoColored;
+  markDirty();
 }
 
 /*!
@@ -27207,6 +31139,7 @@ void QCPFinancial::setTwoColored(bool twoColored)
 void QCPFinancial::setBrushPositive(const QBrush &brush)
 {
   mBrushPositive = brush;
+  markDirty();
 }
 
 /*!
@@ -27221,6 +31154,7 @@ void QCPFinancial::setBrushPositive(const QBrush &brush)
 void QCPFinancial::setBrushNegative(const QBrush &brush)
 {
   mBrushNegative = brush;
+  markDirty();
 }
 
 /*!
@@ -27235,6 +31169,7 @@ void QCPFinancial::setBrushNegative(const QBrush &brush)
 void QCPFinancial::setPenPositive(const QPen &pen)
 {
   mPenPositive = pen;
+  markDirty();
 }
 
 /*!
@@ -27249,6 +31184,62 @@ void QCPFinancial::setPenPositive(const QPen &pen)
 void QCPFinancial::setPenNegative(const QPen &pen)
 {
   mPenNegative = pen;
+  markDirty();
+}
+
+/*!
+  Makes this financial show the candles of \a aggregator, see \ref QCPFinancialAggregator.
+  
+  Whenever the key axis range changes and after each layout pass of a replot, the financial picks
+  the timeframe of the aggregator that suits the current key axis range (see \ref
+  QCPFinancialAggregator::timeframeIndex) and uses its data container as its own (see \ref data).
+  This happens outside of \ref draw, so the selection can be cleared when the timeframe changes
+  (it refers to the data points of the previous timeframe) without emitting \ref selectionChanged
+  while painting. With the width type \ref wtPlotCoords, the bars are drawn wider by the ratio of
+  the shown timeframe to the finest timeframe. The value returned by \ref width stays the one
+  passed to \ref setWidth, so set it relative to the finest timeframe, e.g. to 0.8 times the first
+  entry of \ref QCPFinancialAggregator::timeframes.
+  
+  Since a QSharedPointer is used, multiple QCPFinancials may share the same aggregator. Pass a null
+  pointer to detach the aggregator. The data container of the last shown timeframe is kept then.
+  Calling \ref setData also detaches the aggregator.
+  
+  \see timeframe
+*/
+void QCPFinancial::setAggregator(QSharedPointer<QCPFinancialAggregator> aggregator)
+{
+  if (mAggregator && !aggregator)
+  {
+    if (mKeyAxis)
+      disconnect(mKeyAxis.data(), SIGNAL(rangeChanged(QCPRange)), this, SLOT(updateTimeframe()));
+    disconnect(mParentPlot, SIGNAL(afterLayout()), this, SLOT(updateTimeframe()));
+  } else if (!mAggregator && aggregator)
+  {
+    if (mKeyAxis)
+      connect(mKeyAxis.data(), SIGNAL(rangeChanged(QCPRange)), this, SLOT(updateTimeframe()));
+    connect(mParentPlot, SIGNAL(afterLayout()), this, SLOT(updateTimeframe())); // catches axis rect resizes
+  }
+  
+  mAggregator = aggregator;
+  mTimeframeIndex = -1;
+  if (mAggregator && !mAggregator->timeframes().isEmpty())
+  {
+    mTimeframeIndex = 0;
+    mDataContainer = mAggregator->data(0);
+    updateTimeframe();
+  }
+  markDirty();
+}
+
+/*!
+  Returns the timeframe of the \ref setAggregator "aggregator" that is currently shown, or 0 if no
+  aggregator is set.
+*/
+double QCPFinancial::timeframe() const
+{
+  if (mAggregator && mTimeframeIndex >= 0 && mTimeframeIndex < mAggregator->timeframes().size())
+    return mAggregator->timeframes().at(mTimeframeIndex);
+  return 0;
 }
 
 /*! \overload
@@ -27374,10 +31365,11 @@ QCPRange QCPFinancial::getKeyRange(bool &foundRange, QCP::SignDomain inSignDomai
   // determine exact range by including width of bars/flags:
   if (foundRange)
   {
-    if (inSignDomain != QCP::sdPositive || range.lower-mWidth*0.5 > 0)
-      range.lower -= mWidth*0.5;
-    if (inSignDomain != QCP::sdNegative || range.upper+mWidth*0.5 < 0)
-      range.upper += mWidth*0.5;
+    const double halfWidth = scaledWidth()*0.5;
+    if (inSignDomain != QCP::sdPositive || range.lower-halfWidth > 0)
+      range.lower -= halfWidth;
+    if (inSignDomain != QCP::sdNegative || range.upper+halfWidth < 0)
+      range.upper += halfWidth;
   }
   return range;
 }
@@ -27535,9 +31527,55 @@ void QCPFinancial::drawLegendIcon(QCPPainter *painter, const QRectF &rect) const
   }
 }
 
+/*! \internal
+  
+  Switches the data container to the timeframe of the \ref setAggregator "aggregator" that suits
+  the current key axis range, and clears the selection if the timeframe changed.
+  
+  Connected to the key axis \ref QCPAxis::rangeChanged and the \ref QCustomPlot::afterLayout
+  signals while an aggregator is set, so the timeframe follows zooming and resizing. It must not be
+  called from \ref draw, because changing the selection emits \ref selectionChanged.
+*/
+void QCPFinancial::updateTimeframe()
+{
+  if (!mAggregator || !mKeyAxis)
+    return;
+  QCPAxis *keyAxis = mKeyAxis.data();
+  const double pixelLength = keyAxis->orientation() == Qt::Horizontal ? keyAxis->axisRect()->width() : keyAxis->axisRect()->height();
+  const int index = mAggregator->timeframeIndex(keyAxis->range(), pixelLength);
+  if (index < 0 || (index == mTimeframeIndex && mDataContainer == mAggregator->data(index)))
+    return;
+  
+  mTimeframeIndex = index;
+  mDataContainer = mAggregator->data(index);
+  if (!mSelection.isEmpty())
+    setSelection(QCPDataSelection());
+  markDirty();
+}
+
+/*! \internal
+  
+  Returns the bar width (\ref setWidth) in the units of the width type. With the width type \ref
+  wtPlotCoords and an \ref setAggregator "aggregator" set, the width is scaled by the ratio of the
+  shown timeframe to the finest timeframe, so the bars keep their gaps when zooming out.
+*/
+double QCPFinancial::scaledWidth() const
+{
+  if (mWidthType == wtPlotCoords && mAggregator && mTimeframeIndex > 0)
+  {
+    const QVector<double> timeframes = mAggregator->timeframes();
+    if (mTimeframeIndex < timeframes.size() && timeframes.first() > 0)
+      return mWidth*timeframes.at(mTimeframeIndex)/timeframes.first();
+  }
+  return mWidth;
+}
+
 /*! \internal
   
   Draws the data from \a begin to \a end-1 as OHLC bars with the provided \a painter.
+  
+  The lines of all bars sharing a pen are collected and drawn with a single QPainter::drawLines
+  call. Bars narrower than a pixel are merged per pixel column, see \ref getPixelColumnData.
 
   This method is a helper function for \ref draw. It is used when the chart style is \ref csOhlc.
 */
@@ -27547,54 +31585,54 @@ void QCPFinancial::drawOhlcPlot(QCPPainter *painter, const QCPFinancialDataConta
   QCPAxis *valueAxis = mValueAxis.data();
   if (!keyAxis || !valueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return; }
   
-  if (keyAxis->orientation() == Qt::Horizontal)
-  {
-    for (QCPFinancialDataContainer::const_iterator it = begin; it != end; ++it)
+  const QVector<QCPFinancialData> bars = getPixelColumnData(begin, end);
+  const bool twoColored = mTwoColored && !(isSelected && mSelectionDecorator);
+  QVector<QLineF> lines[2]; // index 0 holds the positive (or single-colored) bars, index 1 the negative bars
+  lines[0].reserve(bars.size()*3);
+  if (twoColored)
+    lines[1].reserve(bars.size()*3);
+  for (int i=0; i<bars.size(); ++i)
+  {
+    const QCPFinancialData &bar = bars.at(i);
+    QVector<QLineF> &barLines = lines[twoColored && bar.close < bar.open ? 1 : 0];
+    double keyPixel = keyAxis->coordToPixel(bar.key);
+    double openPixel = valueAxis->coordToPixel(bar.open);
+    double closePixel = valueAxis->coordToPixel(bar.close);
+    double pixelWidth = getPixelWidth(bar.key, keyPixel); // sign of this makes sure open/close are on correct sides
+    if (keyAxis->orientation() == Qt::Horizontal)
     {
-      if (isSelected && mSelectionDecorator)
-        mSelectionDecorator->applyPen(painter);
-      else if (mTwoColored)
-        painter->setPen(it->close >= it->open ? mPenPositive : mPenNegative);
-      else
-        painter->setPen(mPen);
-      double keyPixel = keyAxis->coordToPixel(it->key);
-      double openPixel = valueAxis->coordToPixel(it->open);
-      double closePixel = valueAxis->coordToPixel(it->close);
-      // draw backbone:
-      painter->drawLine(QPointF(keyPixel, valueAxis->coordToPixel(it->high)), QPointF(keyPixel, valueAxis->coordToPixel(it->low)));
-      // draw open:
-      double pixelWidth = getPixelWidth(it->key, keyPixel); // sign of this makes sure open/close are on correct sides
-      painter->drawLine(QPointF(keyPixel-pixelWidth, openPixel), QPointF(keyPixel, openPixel));
-      // draw close:
-      painter->drawLine(QPointF(keyPixel, closePixel), QPointF(keyPixel+pixelWidth, closePixel));
-    }
-  } else
-  {
-    for (QCPFinancialDataContainer::const_iterator it = begin; it != end; ++it)
+      barLines.append(QLineF(keyPixel, valueAxis->coordToPixel(bar.high), keyPixel, valueAxis->coordToPixel(bar.low))); // backbone
+      barLines.append(QLineF(keyPixel-pixelWidth, openPixel, keyPixel, openPixel)); // open
+      barLines.append(QLineF(keyPixel, closePixel, keyPixel+pixelWidth, closePixel)); // close
+    } else
     {
-      if (isSelected && mSelectionDecorator)
-        mSelectionDecorator->applyPen(painter);
-      else if (mTwoColored)
-        painter->setPen(it->close >= it->open ? mPenPositive : mPenNegative);
-      else
-        painter->setPen(mPen);
-      double keyPixel = keyAxis->coordToPixel(it->key);
-      double openPixel = valueAxis->coordToPixel(it->open);
-      double closePixel = valueAxis->coordToPixel(it->close);
-      // draw backbone:
-      painter->drawLine(QPointF(valueAxis->coordToPixel(it->high), keyPixel), QPointF(valueAxis->coordToPixel(it->low), keyPixel));
-      // draw open:
-      double pixelWidth = getPixelWidth(it->key, keyPixel); // sign of this makes sure open/close are on correct sides
-      painter->drawLine(QPointF(openPixel, keyPixel-pixelWidth), QPointF(openPixel, keyPixel));
-      // draw close:
-      painter->drawLine(QPointF(closePixel, keyPixel), QPointF(closePixel, keyPixel+pixelWidth));
+      barLines.append(QLineF(valueAxis->coordToPixel(bar.high), keyPixel, valueAxis->coordToPixel(bar.low), keyPixel)); // backbone
+      barLines.append(QLineF(openPixel, keyPixel-pixelWidth, openPixel, keyPixel)); // open
+      barLines.append(QLineF(closePixel, keyPixel, closePixel, keyPixel+pixelWidth)); // close
     }
   }
+  
+  for (int i=0; i<2; ++i)
+  {
+    if (lines[i].isEmpty())
+      continue;
+    if (isSelected && mSelectionDecorator)
+      mSelectionDecorator->applyPen(painter);
+    else if (twoColored)
+      painter->setPen(i == 0 ? mPenPositive : mPenNegative);
+    else
+      painter->setPen(mPen);
+    painter->drawLines(lines[i]);
+  }
 }
 
 /*! \internal
   
   Draws the data from \a begin to \a end-1 as Candlesticks with the provided \a painter.
+  
+  The wicks of all candlesticks sharing a pen and brush are drawn with a single
+  QPainter::drawLines call, their open-close boxes with a single QPainter::drawRects call.
+  Candlesticks narrower than a pixel are merged per pixel column, see \ref getPixelColumnData.
 
   This method is a helper function for \ref draw. It is used when the chart style is \ref csCandlestick.
 */
@@ -27604,62 +31642,61 @@ void QCPFinancial::drawCandlestickPlot(QCPPainter *painter, const QCPFinancialDa
   QCPAxis *valueAxis = mValueAxis.data();
   if (!keyAxis || !valueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return; }
   
-  if (keyAxis->orientation() == Qt::Horizontal)
-  {
-    for (QCPFinancialDataContainer::const_iterator it = begin; it != end; ++it)
+  const QVector<QCPFinancialData> candles = getPixelColumnData(begin, end);
+  const bool twoColored = mTwoColored && !(isSelected && mSelectionDecorator);
+  QVector<QLineF> wicks[2]; // index 0 holds the positive (or single-colored) candles, index 1 the negative candles
+  QVector<QRectF> boxes[2];
+  wicks[0].reserve(candles.size()*2);
+  boxes[0].reserve(candles.size());
+  if (twoColored)
+  {
+    wicks[1].reserve(candles.size()*2);
+    boxes[1].reserve(candles.size());
+  }
+  for (int i=0; i<candles.size(); ++i)
+  {
+    const QCPFinancialData &candle = candles.at(i);
+    const int group = twoColored && candle.close < candle.open ? 1 : 0;
+    double keyPixel = keyAxis->coordToPixel(candle.key);
+    double openPixel = valueAxis->coordToPixel(candle.open);
+    double closePixel = valueAxis->coordToPixel(candle.close);
+    double highPixel = valueAxis->coordToPixel(candle.high);
+    double lowPixel = valueAxis->coordToPixel(candle.low);
+    double upperBoxPixel = valueAxis->coordToPixel(qMax(candle.open, candle.close));
+    double lowerBoxPixel = valueAxis->coordToPixel(qMin(candle.open, candle.close));
+    double pixelWidth = getPixelWidth(candle.key, keyPixel);
+    if (keyAxis->orientation() == Qt::Horizontal)
     {
-      if (isSelected && mSelectionDecorator)
-      {
-        mSelectionDecorator->applyPen(painter);
-        mSelectionDecorator->applyBrush(painter);
-      } else if (mTwoColored)
-      {
-        painter->setPen(it->close >= it->open ? mPenPositive : mPenNegative);
-        painter->setBrush(it->close >= it->open ? mBrushPositive : mBrushNegative);
-      } else
-      {
-        painter->setPen(mPen);
-        painter->setBrush(mBrush);
-      }
-      double keyPixel = keyAxis->coordToPixel(it->key);
-      double openPixel = valueAxis->coordToPixel(it->open);
-      double closePixel = valueAxis->coordToPixel(it->close);
-      // draw high:
-      painter->drawLine(QPointF(keyPixel, valueAxis->coordToPixel(it->high)), QPointF(keyPixel, valueAxis->coordToPixel(qMax(it->open, it->close))));
-      // draw low:
-      painter->drawLine(QPointF(keyPixel, valueAxis->coordToPixel(it->low)), QPointF(keyPixel, valueAxis->coordToPixel(qMin(it->open, it->close))));
-      // draw open-close box:
-      double pixelWidth = getPixelWidth(it->key, keyPixel);
-      painter->drawRect(QRectF(QPointF(keyPixel-pixelWidth, closePixel), QPointF(keyPixel+pixelWidth, openPixel)));
+      wicks[group].append(QLineF(keyPixel, highPixel, keyPixel, upperBoxPixel)); // high
+      wicks[group].append(QLineF(keyPixel, lowPixel, keyPixel, lowerBoxPixel)); // low
+      boxes[group].append(QRectF(QPointF(keyPixel-pixelWidth, closePixel), QPointF(keyPixel+pixelWidth, openPixel)));
+    } else // keyAxis->orientation() == Qt::Vertical
+    {
+      wicks[group].append(QLineF(highPixel, keyPixel, upperBoxPixel, keyPixel)); // high
+      wicks[group].append(QLineF(lowPixel, keyPixel, lowerBoxPixel, keyPixel)); // low
+      boxes[group].append(QRectF(QPointF(closePixel, keyPixel-pixelWidth), QPointF(openPixel, keyPixel+pixelWidth)));
     }
-  } else // keyAxis->orientation() == Qt::Vertical
+  }
+  
+  for (int i=0; i<2; ++i)
   {
-    for (QCPFinancialDataContainer::const_iterator it = begin; it != end; ++it)
+    if (boxes[i].isEmpty())
+      continue;
+    if (isSelected && mSelectionDecorator)
     {
-      if (isSelected && mSelectionDecorator)
-      {
-        mSelectionDecorator->applyPen(painter);
-        mSelectionDecorator->applyBrush(painter);
-      } else if (mTwoColored)
-      {
-        painter->setPen(it->close >= it->open ? mPenPositive : mPenNegative);
-        painter->setBrush(it->close >= it->open ? mBrushPositive : mBrushNegative);
-      } else
-      {
-        painter->setPen(mPen);
-        painter->setBrush(mBrush);
-      }
-      double keyPixel = keyAxis->coordToPixel(it->key);
-      double openPixel = valueAxis->coordToPixel(it->open);
-      double closePixel = valueAxis->coordToPixel(it->close);
-      // draw high:
-      painter->drawLine(QPointF(valueAxis->coordToPixel(it->high), keyPixel), QPointF(valueAxis->coordToPixel(qMax(it->open, it->close)), keyPixel));
-      // draw low:
-      painter->drawLine(QPointF(valueAxis->coordToPixel(it->low), keyPixel), QPointF(valueAxis->coordToPixel(qMin(it->open, it->close)), keyPixel));
-      // draw open-close box:
-      double pixelWidth = getPixelWidth(it->key, keyPixel);
-      painter->drawRect(QRectF(QPointF(closePixel, keyPixel-pixelWidth), QPointF(openPixel, keyPixel+pixelWidth)));
+      mSelectionDecorator->applyPen(painter);
+      mSelectionDecorator->applyBrush(painter);
+    } else if (twoColored)
+    {
+      painter->setPen(i == 0 ? mPenPositive : mPenNegative);
+      painter->setBrush(i == 0 ? mBrushPositive : mBrushNegative);
+    } else
+    {
+      painter->setPen(mPen);
+      painter->setBrush(mBrush);
     }
+    painter->drawLines(wicks[i]);
+    painter->drawRects(boxes[i]);
   }
 }
 
@@ -27683,7 +31720,7 @@ double QCPFinancial::getPixelWidth(double key, double keyPixel) const
     case wtAbsolute:
     {
       if (mKeyAxis)
-        result = mWidth*0.5*mKeyAxis.data()->pixelOrientation();
+        result = scaledWidth()*0.5*mKeyAxis.data()->pixelOrientation();
       break;
     }
     case wtAxisRectRatio:
@@ -27691,9 +31728,9 @@ double QCPFinancial::getPixelWidth(double key, double keyPixel) const
       if (mKeyAxis && mKeyAxis.data()->axisRect())
       {
         if (mKeyAxis.data()->orientation() == Qt::Horizontal)
-          result = mKeyAxis.data()->axisRect()->width()*mWidth*0.5*mKeyAxis.data()->pixelOrientation();
+          result = mKeyAxis.data()->axisRect()->width()*scaledWidth()*0.5*mKeyAxis.data()->pixelOrientation();
         else
-          result = mKeyAxis.data()->axisRect()->height()*mWidth*0.5*mKeyAxis.data()->pixelOrientation();
+          result = mKeyAxis.data()->axisRect()->height()*scaledWidth()*0.5*mKeyAxis.data()->pixelOrientation();
       } else
         qDebug() << Q_FUNC_INFO << "No key axis or axis rect defined";
       break;
@@ -27701,7 +31738,7 @@ double QCPFinancial::getPixelWidth(double key, double keyPixel) const
     case wtPlotCoords:
     {
       if (mKeyAxis)
-        result = mKeyAxis.data()->coordToPixel(key+mWidth*0.5)-keyPixel;
+        result = mKeyAxis.data()->coordToPixel(key+scaledWidth()*0.5)-keyPixel;
       else
         qDebug() << Q_FUNC_INFO << "No key axis defined";
       break;
@@ -27710,6 +31747,47 @@ double QCPFinancial::getPixelWidth(double key, double keyPixel) const
   return result;
 }
 
+/*! \internal
+  
+  Returns the data from \a begin to \a end-1 the way it is drawn by \ref drawOhlcPlot and \ref
+  drawCandlestickPlot.
+  
+  Consecutive data points whose OHLC bars/candlesticks are narrower than a pixel and whose keys fall
+  into the same pixel column are merged into one data point, similar to the adaptive sampling of
+  \ref QCPGraph: It has the key and open value of the first, the close value of the last, and the
+  highest high and lowest low value of the merged data points. This is the same binning that \ref
+  timeSeriesToOhlc performs, so the merged data point represents the whole column. Wider bars are
+  returned unchanged.
+*/
+QVector<QCPFinancialData> QCPFinancial::getPixelColumnData(const QCPFinancialDataContainer::const_iterator &begin, const QCPFinancialDataContainer::const_iterator &end) const
+{
+  QVector<QCPFinancialData> result;
+  QCPAxis *keyAxis = mKeyAxis.data();
+  if (!keyAxis) { qDebug() << Q_FUNC_INFO << "invalid key axis"; return result; }
+  
+  int lastColumn = 0;
+  bool lastMergeable = false; // whether the last data point in result is narrower than a pixel
+  for (QCPFinancialDataContainer::const_iterator it=begin; it!=end; ++it)
+  {
+    const double keyPixel = keyAxis->coordToPixel(it->key);
+    const bool mergeable = qAbs(getPixelWidth(it->key, keyPixel)) < 0.5 && !qIsNaN(keyPixel);
+    const int column = mergeable ? qFloor(keyPixel) : 0;
+    if (mergeable && lastMergeable && column == lastColumn)
+    {
+      QCPFinancialData &merged = result.last();
+      merged.close = it->close;
+      if (it->high > merged.high)
+        merged.high = it->high;
+      if (it->low < merged.low)
+        merged.low = it->low;
+    } else
+      result.append(*it);
+    lastColumn = column;
+    lastMergeable = mergeable;
+  }
+  return result;
+}
+
 /*! \internal
 
   This method is a helper function for \ref selectTest. It is used to test for selection when the
@@ -27772,6 +31850,7 @@ double QCPFinancial::candlestickSelectTest(const QPointF &pos, const QCPFinancia
   QCPAxis *valueAxis = mValueAxis.data();
   if (!keyAxis || !valueAxis) { qDebug() << Q_FUNC_INFO << "invalid key or value axis"; return -1; }
 
+  const double halfWidth = scaledWidth()*0.5;
   double minDistSqr = (std::numeric_limits<double>::max)();
   if (keyAxis->orientation() == Qt::Horizontal)
   {
@@ -27779,7 +31858,7 @@ double QCPFinancial::candlestickSelectTest(const QPointF &pos, const QCPFinancia
     {
       double currentDistSqr;
       // determine whether pos is in open-close-box:
-      QCPRange boxKeyRange(it->key-mWidth*0.5, it->key+mWidth*0.5);
+      QCPRange boxKeyRange(it->key-halfWidth, it->key+halfWidth);
       QCPRange boxValueRange(it->close, it->open);
       double posKey, posValue;
       pixelsToCoords(pos, posKey, posValue);
@@ -27806,7 +31885,7 @@ double QCPFinancial::candlestickSelectTest(const QPointF &pos, const QCPFinancia
     {
       double currentDistSqr;
       // determine whether pos is in open-close-box:
-      QCPRange boxKeyRange(it->key-mWidth*0.5, it->key+mWidth*0.5);
+      QCPRange boxKeyRange(it->key-halfWidth, it->key+halfWidth);
       QCPRange boxValueRange(it->close, it->open);
       double posKey, posValue;
       pixelsToCoords(pos, posKey, posValue);
@@ -27854,8 +31933,8 @@ void QCPFinancial::getVisibleDataBounds(QCPFinancialDataContainer::const_iterato
     end = mDataContainer->constEnd();
     return;
   }
-  begin = mDataContainer->findBegin(mKeyAxis.data()->range().lower-mWidth*0.5); // subtract half width of ohlc/candlestick to include partially visible data points
-  end = mDataContainer->findEnd(mKeyAxis.data()->range().upper+mWidth*0.5); // add half width of ohlc/candlestick to include partially visible data points
+  begin = mDataContainer->findBegin(mKeyAxis.data()->range().lower-scaledWidth()*0.5); // subtract half width of ohlc/candlestick to include partially visible data points
+  end = mDataContainer->findEnd(mKeyAxis.data()->range().upper+scaledWidth()*0.5); // add half width of ohlc/candlestick to include partially visible data points
 }
 
 /*!  \internal
@@ -27872,7 +31951,7 @@ QRectF QCPFinancial::selectionHitBox(QCPFinancialDataContainer::const_iterator i
   double keyPixel = keyAxis->coordToPixel(it->key);
   double highPixel = valueAxis->coordToPixel(it->high);
   double lowPixel = valueAxis->coordToPixel(it->low);
-  double keyWidthPixels = keyPixel-keyAxis->coordToPixel(it->key-mWidth*0.5);
+  double keyWidthPixels = keyPixel-keyAxis->coordToPixel(it->key-scaledWidth()*0.5);
   if (keyAxis->orientation() == Qt::Horizontal)
     return QRectF(keyPixel-keyWidthPixels, highPixel, keyWidthPixels*2, lowPixel-highPixel).normalized();
   else
@@ -28025,6 +32104,7 @@ QCPErrorBars::~QCPErrorBars()
 void QCPErrorBars::setData(QSharedPointer<QCPErrorBarsDataContainer> data)
 {
   mDataContainer = data;
+  markDirty();
 }
 
 /*! \overload
@@ -28040,6 +32120,7 @@ void QCPErrorBars::setData(const QVector<double> &error)
 {
   mDataContainer->clear();
   addData(error);
+  markDirty();
 }
 
 /*! \overload
@@ -28056,6 +32137,7 @@ void QCPErrorBars::setData(const QVector<double> &errorMinus, const QVector<doub
 {
   mDataContainer->clear();
   addData(errorMinus, errorPlus);
+  markDirty();
 }
 
 /*!
@@ -28088,6 +32170,7 @@ void QCPErrorBars::setDataPlottable(QCPAbstractPlottable *plottable)
   }
   
   mDataPlottable = plottable;
+  markDirty();
 }
 
 /*!
@@ -28097,6 +32180,7 @@ void QCPErrorBars::setDataPlottable(QCPAbstractPlottable *plottable)
 void QCPErrorBars::setErrorType(ErrorType type)
 {
   mErrorType = type;
+  markDirty();
 }
 
 /*!
@@ -28106,6 +32190,7 @@ void QCPErrorBars::setErrorType(ErrorType type)
 void QCPErrorBars::setWhiskerWidth(double pixels)
 {
   mWhiskerWidth = pixels;
+  markDirty();
 }
 
 /*!
@@ -28116,6 +32201,7 @@ void QCPErrorBars::setWhiskerWidth(double pixels)
 void QCPErrorBars::setSymbolGap(double pixels)
 {
   mSymbolGap = pixels;
+  markDirty();
 }
 
 /*! \overload
@@ -28130,6 +32216,7 @@ void QCPErrorBars::setSymbolGap(double pixels)
 void QCPErrorBars::addData(const QVector<double> &error)
 {
   addData(error, error);
+  markDirty();
 }
 
 /*! \overload
@@ -28150,6 +32237,7 @@ void QCPErrorBars::addData(const QVector<double> &errorMinus, const QVector<doub
   mDataContainer->reserve(n);
   for (int i=0; i<n; ++i)
     mDataContainer->append(QCPErrorBarsData(errorMinus.at(i), errorPlus.at(i)));
+  markDirty();
 }
 
 /*! \overload
@@ -28164,6 +32252,7 @@ void QCPErrorBars::addData(const QVector<double> &errorMinus, const QVector<doub
 void QCPErrorBars::addData(double error)
 {
   mDataContainer->append(QCPErrorBarsData(error));
+  markDirty();
 }
 
 /*! \overload
@@ -28179,6 +32268,7 @@ void QCPErrorBars::addData(double error)
 void QCPErrorBars::addData(double errorMinus, double errorPlus)
 {
   mDataContainer->append(QCPErrorBarsData(errorMinus, errorPlus));
+  markDirty();
 }
 
 /* inherits documentation from base class */
@@ -28355,6 +32445,18 @@ double QCPErrorBars::selectTest(const QPointF &pos, bool onlySelectable, QVarian
     return -1;
 }
 
+/*!
+  Returns the data version of the plottable this error bars plottable is attached to (\ref
+  setDataPlottable). Changes of the error data itself through \ref setData and \ref addData call
+  \ref markDirty, after modifying the error data in-place via \ref data call it manually.
+  
+  \seebaseclassmethod
+*/
+quint64 QCPErrorBars::dataVersion() const
+{
+  return mDataPlottable ? mDataPlottable->dataVersion() : 0;
+}
+
 /* inherits documentation from base class */
 void QCPErrorBars::draw(QCPPainter *painter)
 {
@@ -28894,6 +32996,7 @@ QCPItemStraightLine::~QCPItemStraightLine()
 void QCPItemStraightLine::setPen(const QPen &pen)
 {
   mPen = pen;
+  markDirty();
 }
 
 /*!
@@ -28904,6 +33007,7 @@ void QCPItemStraightLine::setPen(const QPen &pen)
 void QCPItemStraightLine::setSelectedPen(const QPen &pen)
 {
   mSelectedPen = pen;
+  markDirty();
 }
 
 /* inherits documentation from base class */
@@ -29077,6 +33181,7 @@ QCPItemLine::~QCPItemLine()
 void QCPItemLine::setPen(const QPen &pen)
 {
   mPen = pen;
+  markDirty();
 }
 
 /*!
@@ -29087,6 +33192,7 @@ void QCPItemLine::setPen(const QPen &pen)
 void QCPItemLine::setSelectedPen(const QPen &pen)
 {
   mSelectedPen = pen;
+  markDirty();
 }
 
 /*!
@@ -29100,6 +33206,7 @@ void QCPItemLine::setSelectedPen(const QPen &pen)
 void QCPItemLine::setHead(const QCPLineEnding &head)
 {
   mHead = head;
+  markDirty();
 }
 
 /*!
@@ -29113,6 +33220,7 @@ void QCPItemLine::setHead(const QCPLineEnding &head)
 void QCPItemLine::setTail(const QCPLineEnding &tail)
 {
   mTail = tail;
+  markDirty();
 }
 
 /* inherits documentation from base class */
@@ -29319,6 +33427,7 @@ QCPItemCurve::~QCPItemCurve()
 void QCPItemCurve::setPen(const QPen &pen)
 {
   mPen = pen;
+  markDirty();
 }
 
 /*!
@@ -29329,6 +33438,7 @@ void QCPItemCurve::setPen(const QPen &pen)
 void QCPItemCurve::setSelectedPen(const QPen &pen)
 {
   mSelectedPen = pen;
+  markDirty();
 }
 
 /*!
@@ -29342,6 +33452,7 @@ void QCPItemCurve::setSelectedPen(const QPen &pen)
 void QCPItemCurve::setHead(const QCPLineEnding &head)
 {
   mHead = head;
+  markDirty();
 }
 
 /*!
@@ -29355,6 +33466,7 @@ void QCPItemCurve::setHead(const QCPLineEnding &head)
 void QCPItemCurve::setTail(const QCPLineEnding &tail)
 {
   mTail = tail;
+  markDirty();
 }
 
 /* inherits documentation from base class */
@@ -29483,6 +33595,7 @@ QCPItemRect::~QCPItemRect()
 void QCPItemRect::setPen(const QPen &pen)
 {
   mPen = pen;
+  markDirty();
 }
 
 /*!
@@ -29493,6 +33606,7 @@ void QCPItemRect::setPen(const QPen &pen)
 void QCPItemRect::setSelectedPen(const QPen &pen)
 {
   mSelectedPen = pen;
+  markDirty();
 }
 
 /*!
@@ -29504,6 +33618,7 @@ void QCPItemRect::setSelectedPen(const QPen &pen)
 void QCPItemRect::setBrush(const QBrush &brush)
 {
   mBrush = brush;
+  markDirty();
 }
 
 /*!
@@ -29515,6 +33630,7 @@ void QCPItemRect::setBrush(const QBrush &brush)
 void QCPItemRect::setSelectedBrush(const QBrush &brush)
 {
   mSelectedBrush = brush;
+  markDirty();
 }
 
 /* inherits documentation from base class */
@@ -29650,6 +33766,7 @@ QCPItemText::~QCPItemText()
 void QCPItemText::setColor(const QColor &color)
 {
   mColor = color;
+  markDirty();
 }
 
 /*!
@@ -29658,6 +33775,7 @@ void QCPItemText::setColor(const QColor &color)
 void QCPItemText::setSelectedColor(const QColor &color)
 {
   mSelectedColor = color;
+  markDirty();
 }
 
 /*!
@@ -29669,6 +33787,7 @@ void QCPItemText::setSelectedColor(const QColor &color)
 void QCPItemText::setPen(const QPen &pen)
 {
   mPen = pen;
+  markDirty();
 }
 
 /*!
@@ -29680,6 +33799,7 @@ void QCPItemText::setPen(const QPen &pen)
 void QCPItemText::setSelectedPen(const QPen &pen)
 {
   mSelectedPen = pen;
+  markDirty();
 }
 
 /*!
@@ -29691,6 +33811,7 @@ void QCPItemText::setSelectedPen(const QPen &pen)
 void QCPItemText::setBrush(const QBrush &brush)
 {
   mBrush = brush;
+  markDirty();
 }
 
 /*!
@@ -29702,6 +33823,7 @@ void QCPItemText::setBrush(const QBrush &brush)
 void QCPItemText::setSelectedBrush(const QBrush &brush)
 {
   mSelectedBrush = brush;
+  markDirty();
 }
 
 /*!
@@ -29712,6 +33834,7 @@ void QCPItemText::setSelectedBrush(const QBrush &brush)
 void QCPItemText::setFont(const QFont &font)
 {
   mFont = font;
+  markDirty();
 }
 
 /*!
@@ -29722,6 +33845,7 @@ void QCPItemText::setFont(const QFont &font)
 void QCPItemText::setSelectedFont(const QFont &font)
 {
   mSelectedFont = font;
+  markDirty();
 }
 
 /*!
@@ -29733,6 +33857,7 @@ void QCPItemText::setSelectedFont(const QFont &font)
 void QCPItemText::setText(const QString &text)
 {
   mText = text;
+  markDirty();
 }
 
 /*!
@@ -29750,6 +33875,7 @@ void QCPItemText::setText(const QString &text)
 void QCPItemText::setPositionAlignment(Qt::Alignment alignment)
 {
   mPositionAlignment = alignment;
+  markDirty();
 }
 
 /*!
@@ -29758,6 +33884,7 @@ void QCPItemText::setPositionAlignment(Qt::Alignment alignment)
 void QCPItemText::setTextAlignment(Qt::Alignment alignment)
 {
   mTextAlignment = alignment;
+  markDirty();
 }
 
 /*!
@@ -29767,6 +33894,7 @@ void QCPItemText::setTextAlignment(Qt::Alignment alignment)
 void QCPItemText::setRotation(double degrees)
 {
   mRotation = degrees;
+  markDirty();
 }
 
 /*!
@@ -29776,6 +33904,7 @@ void QCPItemText::setRotation(double degrees)
 void QCPItemText::setPadding(const QMargins &padding)
 {
   mPadding = padding;
+  markDirty();
 }
 
 /* inherits documentation from base class */
@@ -29991,6 +34120,7 @@ QCPItemEllipse::~QCPItemEllipse()
 void QCPItemEllipse::setPen(const QPen &pen)
 {
   mPen = pen;
+  markDirty();
 }
 
 /*!
@@ -30001,6 +34131,7 @@ void QCPItemEllipse::setPen(const QPen &pen)
 void QCPItemEllipse::setSelectedPen(const QPen &pen)
 {
   mSelectedPen = pen;
+  markDirty();
 }
 
 /*!
@@ -30012,6 +34143,7 @@ void QCPItemEllipse::setSelectedPen(const QPen &pen)
 void QCPItemEllipse::setBrush(const QBrush &brush)
 {
   mBrush = brush;
+  markDirty();
 }
 
 /*!
@@ -30023,6 +34155,7 @@ void QCPItemEllipse::setBrush(const QBrush &brush)
 void QCPItemEllipse::setSelectedBrush(const QBrush &brush)
 {
   mSelectedBrush = brush;
+  markDirty();
 }
 
 /* inherits documentation from base class */
@@ -30186,6 +34319,7 @@ void QCPItemPixmap::setPixmap(const QPixmap &pixmap)
   mScaledPixmapInvalidated = true;
   if (mPixmap.isNull())
     qDebug() << Q_FUNC_INFO << "pixmap is null";
+  markDirty();
 }
 
 /*!
@@ -30198,6 +34332,7 @@ void QCPItemPixmap::setScaled(bool scaled, Qt::AspectRatioMode aspectRatioMode,
   mAspectRatioMode = aspectRatioMode;
   mTransformationMode = transformationMode;
   mScaledPixmapInvalidated = true;
+  markDirty();
 }
 
 /*!
@@ -30208,6 +34343,7 @@ void QCPItemPixmap::setScaled(bool scaled, Qt::AspectRatioMode aspectRatioMode,
 void QCPItemPixmap::setPen(const QPen &pen)
 {
   mPen = pen;
+  markDirty();
 }
 
 /*!
@@ -30218,6 +34354,7 @@ void QCPItemPixmap::setPen(const QPen &pen)
 void QCPItemPixmap::setSelectedPen(const QPen &pen)
 {
   mSelectedPen = pen;
+  markDirty();
 }
 
 /* inherits documentation from base class */
@@ -30466,6 +34603,7 @@ QCPItemTracer::~QCPItemTracer()
 void QCPItemTracer::setPen(const QPen &pen)
 {
   mPen = pen;
+  markDirty();
 }
 
 /*!
@@ -30476,6 +34614,7 @@ void QCPItemTracer::setPen(const QPen &pen)
 void QCPItemTracer::setSelectedPen(const QPen &pen)
 {
   mSelectedPen = pen;
+  markDirty();
 }
 
 /*!
@@ -30486,6 +34625,7 @@ void QCPItemTracer::setSelectedPen(const QPen &pen)
 void QCPItemTracer::setBrush(const QBrush &brush)
 {
   mBrush = brush;
+  markDirty();
 }
 
 /*!
@@ -30496,6 +34636,7 @@ void QCPItemTracer::setBrush(const QBrush &brush)
 void QCPItemTracer::setSelectedBrush(const QBrush &brush)
 {
   mSelectedBrush = brush;
+  markDirty();
 }
 
 /*!
@@ -30505,6 +34646,7 @@ void QCPItemTracer::setSelectedBrush(const QBrush &brush)
 void QCPItemTracer::setSize(double size)
 {
   mSize = size;
+  markDirty();
 }
 
 /*!
@@ -30516,6 +34658,7 @@ void QCPItemTracer::setSize(double size)
 void QCPItemTracer::setStyle(QCPItemTracer::TracerStyle style)
 {
   mStyle = style;
+  markDirty();
 }
 
 /*!
@@ -30544,6 +34687,7 @@ void QCPItemTracer::setGraph(QCPGraph *graph)
   {
     mGraph = nullptr;
   }
+  markDirty();
 }
 
 /*!
@@ -30558,6 +34702,7 @@ void QCPItemTracer::setGraph(QCPGraph *graph)
 void QCPItemTracer::setGraphKey(double key)
 {
   mGraphKey = key;
+  markDirty();
 }
 
 /*!
@@ -30574,6 +34719,7 @@ void QCPItemTracer::setGraphKey(double key)
 void QCPItemTracer::setInterpolating(bool enabled)
 {
   mInterpolating = enabled;
+  markDirty();
 }
 
 /* inherits documentation from base class */
@@ -30633,6 +34779,20 @@ double QCPItemTracer::selectTest(const QPointF &pos, bool onlySelectable, QVaria
   return -1;
 }
 
+/*!
+  Returns a value that also changes whenever the graph this tracer is attached to (\ref setGraph)
+  changes, since the tracer position follows its data.
+  
+  \seebaseclassmethod
+*/
+quint64 QCPItemTracer::contentVersion() const
+{
+  quint64 version = QCPAbstractItem::contentVersion();
+  if (mGraph && mParentPlot->hasPlottable(mGraph))
+    version = qcpCombineVersions(version, mGraph->contentVersion());
+  return version;
+}
+
 /* inherits documentation from base class */
 void QCPItemTracer::draw(QCPPainter *painter)
 {
@@ -30698,43 +34858,45 @@ void QCPItemTracer::updatePosition()
   {
     if (mParentPlot->hasPlottable(mGraph))
     {
-      if (mGraph->data()->size() > 1)
+      // access the data through the 1d interface, which also covers column data (see QCPGraph::setColumnData):
+      const int count = mGraph->dataCount();
+      if (count > 1)
       {
-        QCPGraphDataContainer::const_iterator first = mGraph->data()->constBegin();
-        QCPGraphDataContainer::const_iterator last = mGraph->data()->constEnd()-1;
-        if (mGraphKey <= first->key)
-          position->setCoords(first->key, first->value);
-        else if (mGraphKey >= last->key)
-          position->setCoords(last->key, last->value);
+        const int last = count-1;
+        if (mGraphKey <= mGraph->dataMainKey(0))
+          position->setCoords(mGraph->dataMainKey(0), mGraph->dataMainValue(0));
+        else if (mGraphKey >= mGraph->dataMainKey(last))
+          position->setCoords(mGraph->dataMainKey(last), mGraph->dataMainValue(last));
         else
         {
-          QCPGraphDataContainer::const_iterator it = mGraph->data()->findBegin(mGraphKey);
-          if (it != mGraph->data()->constEnd()) // mGraphKey is not exactly on last iterator, but somewhere between iterators
+          const int index = mGraph->findBegin(mGraphKey);
+          if (index < last) // mGraphKey is not exactly on last data point, but somewhere between data points
           {
-            QCPGraphDataContainer::const_iterator prevIt = it;
-            ++it; // won't advance to constEnd because we handled that case (mGraphKey >= last->key) before
+            const double prevKey = mGraph->dataMainKey(index);
+            const double prevValue = mGraph->dataMainValue(index);
+            const double nextKey = mGraph->dataMainKey(index+1);
+            const double nextValue = mGraph->dataMainValue(index+1);
             if (mInterpolating)
             {
-              // interpolate between iterators around mGraphKey:
+              // interpolate between data points around mGraphKey:
               double slope = 0;
-              if (!qFuzzyCompare(double(it->key), double(prevIt->key)))
-                slope = (it->value-prevIt->value)/(it->key-prevIt->key);
-              position->setCoords(mGraphKey, (mGraphKey-prevIt->key)*slope+prevIt->value);
+              if (!qFuzzyCompare(nextKey, prevKey))
+                slope = (nextValue-prevValue)/(nextKey-prevKey);
+              position->setCoords(mGraphKey, (mGraphKey-prevKey)*slope+prevValue);
             } else
             {
-              // find iterator with key closest to mGraphKey:
-              if (mGraphKey < (prevIt->key+it->key)*0.5)
-                position->setCoords(prevIt->key, prevIt->value);
+              // find data point with key closest to mGraphKey:
+              if (mGraphKey < (prevKey+nextKey)*0.5)
+                position->setCoords(prevKey, prevValue);
               else
-                position->setCoords(it->key, it->value);
+                position->setCoords(nextKey, nextValue);
             }
-          } else // mGraphKey is exactly on last iterator (should actually be caught when comparing first/last keys, but this is a failsafe for fp uncertainty)
-            position->setCoords(it->key, it->value);
+          } else // mGraphKey is exactly on last data point (should actually be caught when comparing first/last keys, but this is a failsafe for fp uncertainty)
+            position->setCoords(mGraph->dataMainKey(last), mGraph->dataMainValue(last));
         }
-      } else if (mGraph->data()->size() == 1)
+      } else if (count == 1)
       {
-        QCPGraphDataContainer::const_iterator it = mGraph->data()->constBegin();
-        position->setCoords(it->key, it->value);
+        position->setCoords(mGraph->dataMainKey(0), mGraph->dataMainValue(0));
       } else
         qDebug() << Q_FUNC_INFO << "graph has no data";
     } else
@@ -30828,6 +34990,7 @@ QCPItemBracket::~QCPItemBracket()
 void QCPItemBracket::setPen(const QPen &pen)
 {
   mPen = pen;
+  markDirty();
 }
 
 /*!
@@ -30838,6 +35001,7 @@ void QCPItemBracket::setPen(const QPen &pen)
 void QCPItemBracket::setSelectedPen(const QPen &pen)
 {
   mSelectedPen = pen;
+  markDirty();
 }
 
 /*!
@@ -30851,6 +35015,7 @@ void QCPItemBracket::setSelectedPen(const QPen &pen)
 void QCPItemBracket::setLength(double length)
 {
   mLength = length;
+  markDirty();
 }
 
 /*!
@@ -30861,6 +35026,7 @@ void QCPItemBracket::setLength(double length)
 void QCPItemBracket::setStyle(QCPItemBracket::BracketStyle style)
 {
   mStyle = style;
+  markDirty();
 }
 
 /* inherits documentation from base class */
@@ -31218,16 +35384,19 @@ int QCPPolarAxisRadial::labelPadding() const
 void QCPPolarAxisRadial::setRangeDrag(bool enabled)
 {
   mRangeDrag = enabled;
+  markDirty();
 }
 
 void QCPPolarAxisRadial::setRangeZoom(bool enabled)
 {
   mRangeZoom = enabled;
+  markDirty();
 }
 
 void QCPPolarAxisRadial::setRangeZoomFactor(double factor)
 {
   mRangeZoomFactor = factor;
+  markDirty();
 }
 
 /*!
@@ -31254,6 +35423,7 @@ void QCPPolarAxisRadial::setScaleType(QCPPolarAxisRadial::ScaleType type)
     //mCachedMarginValid = false;
     emit scaleTypeChanged(mScaleType);
   }
+  markDirty();
 }
 
 /*!
@@ -31280,6 +35450,7 @@ void QCPPolarAxisRadial::setRange(const QCPRange &range)
   }
   emit rangeChanged(mRange);
   emit rangeChanged(mRange, oldRange);
+  markDirty();
 }
 
 /*!
@@ -31323,6 +35494,7 @@ void QCPPolarAxisRadial::setSelectedParts(const SelectableParts &selected)
     mSelectedParts = selected;
     emit selectionChanged(mSelectedParts);
   }
+  markDirty();
 }
 
 /*!
@@ -31352,6 +35524,7 @@ void QCPPolarAxisRadial::setRange(double lower, double upper)
   }
   emit rangeChanged(mRange);
   emit rangeChanged(mRange, oldRange);
+  markDirty();
 }
 
 /*!
@@ -31373,6 +35546,7 @@ void QCPPolarAxisRadial::setRange(double position, double size, Qt::AlignmentFla
     setRange(position-size, position);
   else // alignment == Qt::AlignCenter
     setRange(position-size/2.0, position+size/2.0);
+  markDirty();
 }
 
 /*!
@@ -31395,6 +35569,7 @@ void QCPPolarAxisRadial::setRangeLower(double lower)
   }
   emit rangeChanged(mRange);
   emit rangeChanged(mRange, oldRange);
+  markDirty();
 }
 
 /*!
@@ -31417,6 +35592,7 @@ void QCPPolarAxisRadial::setRangeUpper(double upper)
   }
   emit rangeChanged(mRange);
   emit rangeChanged(mRange, oldRange);
+  markDirty();
 }
 
 /*!
@@ -31431,16 +35607,19 @@ void QCPPolarAxisRadial::setRangeUpper(double upper)
 void QCPPolarAxisRadial::setRangeReversed(bool reversed)
 {
   mRangeReversed = reversed;
+  markDirty();
 }
 
 void QCPPolarAxisRadial::setAngle(double degrees)
 {
   mAngle = degrees;
+  markDirty();
 }
 
 void QCPPolarAxisRadial::setAngleReference(AngleReference reference)
 {
   mAngleReference = reference;
+  markDirty();
 }
 
 /*!
@@ -31463,6 +35642,7 @@ void QCPPolarAxisRadial::setTicker(QSharedPointer<QCPAxisTicker> ticker)
   else
     qDebug() << Q_FUNC_INFO << "can not set 0 as axis ticker";
   // no need to invalidate margin cache here because produced tick labels are checked for changes in setupTickVector
+  markDirty();
 }
 
 /*!
@@ -31480,6 +35660,7 @@ void QCPPolarAxisRadial::setTicks(bool show)
     mTicks = show;
     //mCachedMarginValid = false;
   }
+  markDirty();
 }
 
 /*!
@@ -31494,6 +35675,7 @@ void QCPPolarAxisRadial::setTickLabels(bool show)
     if (!mTickLabels)
       mTickVectorLabels.clear();
   }
+  markDirty();
 }
 
 /*!
@@ -31503,6 +35685,7 @@ void QCPPolarAxisRadial::setTickLabels(bool show)
 void QCPPolarAxisRadial::setTickLabelPadding(int padding)
 {
   mLabelPainter.setPadding(padding);
+  markDirty();
 }
 
 /*!
@@ -31517,6 +35700,7 @@ void QCPPolarAxisRadial::setTickLabelFont(const QFont &font)
     mTickLabelFont = font;
     //mCachedMarginValid = false;
   }
+  markDirty();
 }
 
 /*!
@@ -31527,6 +35711,7 @@ void QCPPolarAxisRadial::setTickLabelFont(const QFont &font)
 void QCPPolarAxisRadial::setTickLabelColor(const QColor &color)
 {
   mTickLabelColor = color;
+  markDirty();
 }
 
 /*!
@@ -31541,6 +35726,7 @@ void QCPPolarAxisRadial::setTickLabelColor(const QColor &color)
 void QCPPolarAxisRadial::setTickLabelRotation(double degrees)
 {
   mLabelPainter.setRotation(degrees);
+  markDirty();
 }
 
 void QCPPolarAxisRadial::setTickLabelMode(LabelMode mode)
@@ -31550,6 +35736,7 @@ void QCPPolarAxisRadial::setTickLabelMode(LabelMode mode)
     case lmUpright: mLabelPainter.setAnchorMode(QCPLabelPainterPrivate::amSkewedUpright); break;
     case lmRotated: mLabelPainter.setAnchorMode(QCPLabelPainterPrivate::amSkewedRotated); break;
   }
+  markDirty();
 }
 
 /*!
@@ -31630,6 +35817,7 @@ void QCPPolarAxisRadial::setNumberFormat(const QString &formatCode)
   }
   mLabelPainter.setSubstituteExponent(mNumberBeautifulPowers);
   mLabelPainter.setMultiplicationSymbol(mNumberMultiplyCross ? QCPLabelPainterPrivate::SymbolCross : QCPLabelPainterPrivate::SymbolDot);
+  markDirty();
 }
 
 /*!
@@ -31644,6 +35832,7 @@ void QCPPolarAxisRadial::setNumberPrecision(int precision)
     mNumberPrecision = precision;
     //mCachedMarginValid = false;
   }
+  markDirty();
 }
 
 /*!
@@ -31658,6 +35847,7 @@ void QCPPolarAxisRadial::setTickLength(int inside, int outside)
 {
   setTickLengthIn(inside);
   setTickLengthOut(outside);
+  markDirty();
 }
 
 /*!
@@ -31672,6 +35862,7 @@ void QCPPolarAxisRadial::setTickLengthIn(int inside)
   {
     mTickLengthIn = inside;
   }
+  markDirty();
 }
 
 /*!
@@ -31688,6 +35879,7 @@ void QCPPolarAxisRadial::setTickLengthOut(int outside)
     mTickLengthOut = outside;
     //mCachedMarginValid = false; // only outside tick length can change margin
   }
+  markDirty();
 }
 
 /*!
@@ -31704,6 +35896,7 @@ void QCPPolarAxisRadial::setSubTicks(bool show)
     mSubTicks = show;
     //mCachedMarginValid = false;
   }
+  markDirty();
 }
 
 /*!
@@ -31718,6 +35911,7 @@ void QCPPolarAxisRadial::setSubTickLength(int inside, int outside)
 {
   setSubTickLengthIn(inside);
   setSubTickLengthOut(outside);
+  markDirty();
 }
 
 /*!
@@ -31732,6 +35926,7 @@ void QCPPolarAxisRadial::setSubTickLengthIn(int inside)
   {
     mSubTickLengthIn = inside;
   }
+  markDirty();
 }
 
 /*!
@@ -31748,6 +35943,7 @@ void QCPPolarAxisRadial::setSubTickLengthOut(int outside)
     mSubTickLengthOut = outside;
     //mCachedMarginValid = false; // only outside tick length can change margin
   }
+  markDirty();
 }
 
 /*!
@@ -31758,6 +35954,7 @@ void QCPPolarAxisRadial::setSubTickLengthOut(int outside)
 void QCPPolarAxisRadial::setBasePen(const QPen &pen)
 {
   mBasePen = pen;
+  markDirty();
 }
 
 /*!
@@ -31768,6 +35965,7 @@ void QCPPolarAxisRadial::setBasePen(const QPen &pen)
 void QCPPolarAxisRadial::setTickPen(const QPen &pen)
 {
   mTickPen = pen;
+  markDirty();
 }
 
 /*!
@@ -31778,6 +35976,7 @@ void QCPPolarAxisRadial::setTickPen(const QPen &pen)
 void QCPPolarAxisRadial::setSubTickPen(const QPen &pen)
 {
   mSubTickPen = pen;
+  markDirty();
 }
 
 /*!
@@ -31792,6 +35991,7 @@ void QCPPolarAxisRadial::setLabelFont(const QFont &font)
     mLabelFont = font;
     //mCachedMarginValid = false;
   }
+  markDirty();
 }
 
 /*!
@@ -31802,6 +36002,7 @@ void QCPPolarAxisRadial::setLabelFont(const QFont &font)
 void QCPPolarAxisRadial::setLabelColor(const QColor &color)
 {
   mLabelColor = color;
+  markDirty();
 }
 
 /*!
@@ -31815,6 +36016,7 @@ void QCPPolarAxisRadial::setLabel(const QString &str)
     mLabel = str;
     //mCachedMarginValid = false;
   }
+  markDirty();
 }
 
 /*!
@@ -31829,6 +36031,7 @@ void QCPPolarAxisRadial::setLabelPadding(int padding)
     mLabelPadding = padding;
     //mCachedMarginValid = false;
   }
+  markDirty();
 }
 
 /*!
@@ -31843,6 +36046,7 @@ void QCPPolarAxisRadial::setSelectedTickLabelFont(const QFont &font)
     mSelectedTickLabelFont = font;
     // don't set mCachedMarginValid to false here because margin calculation is always done with non-selected fonts
   }
+  markDirty();
 }
 
 /*!
@@ -31854,6 +36058,7 @@ void QCPPolarAxisRadial::setSelectedLabelFont(const QFont &font)
 {
   mSelectedLabelFont = font;
   // don't set mCachedMarginValid to false here because margin calculation is always done with non-selected fonts
+  markDirty();
 }
 
 /*!
@@ -31867,6 +36072,7 @@ void QCPPolarAxisRadial::setSelectedTickLabelColor(const QColor &color)
   {
     mSelectedTickLabelColor = color;
   }
+  markDirty();
 }
 
 /*!
@@ -31877,6 +36083,7 @@ void QCPPolarAxisRadial::setSelectedTickLabelColor(const QColor &color)
 void QCPPolarAxisRadial::setSelectedLabelColor(const QColor &color)
 {
   mSelectedLabelColor = color;
+  markDirty();
 }
 
 /*!
@@ -31887,6 +36094,7 @@ void QCPPolarAxisRadial::setSelectedLabelColor(const QColor &color)
 void QCPPolarAxisRadial::setSelectedBasePen(const QPen &pen)
 {
   mSelectedBasePen = pen;
+  markDirty();
 }
 
 /*!
@@ -31897,6 +36105,7 @@ void QCPPolarAxisRadial::setSelectedBasePen(const QPen &pen)
 void QCPPolarAxisRadial::setSelectedTickPen(const QPen &pen)
 {
   mSelectedTickPen = pen;
+  markDirty();
 }
 
 /*!
@@ -31907,6 +36116,7 @@ void QCPPolarAxisRadial::setSelectedTickPen(const QPen &pen)
 void QCPPolarAxisRadial::setSelectedSubTickPen(const QPen &pen)
 {
   mSelectedSubTickPen = pen;
+  markDirty();
 }
 
 /*!
@@ -31930,6 +36140,7 @@ void QCPPolarAxisRadial::moveRange(double diff)
   }
   emit rangeChanged(mRange);
   emit rangeChanged(mRange, oldRange);
+  markDirty();
 }
 
 /*!
@@ -31944,6 +36155,7 @@ void QCPPolarAxisRadial::moveRange(double diff)
 void QCPPolarAxisRadial::scaleRange(double factor)
 {
   scaleRange(factor, range().center());
+  markDirty();
 }
 
 /*! \overload
@@ -31979,6 +36191,7 @@ void QCPPolarAxisRadial::scaleRange(double factor, double center)
   }
   emit rangeChanged(mRange);
   emit rangeChanged(mRange, oldRange);
+  markDirty();
 }
 
 /*!
@@ -32642,7 +36855,6 @@ QCPPolarAxisAngular::QCPPolarAxisAngular(QCustomPlot *parentPlot) :
   setTickLabelMode(lmUpright);
   mLabelPainter.setAnchorReferenceType(QCPLabelPainterPrivate::artNormal);
   mLabelPainter.setAbbreviateDecimalPowers(false);
-  mLabelPainter.setCacheSize(24); // so we can cache up to 15-degree intervals, polar angular axis uses a bit larger cache than normal axes
   
   setMinimumSize(50, 50);
   setMinimumMargins(QMargins(30, 30, 30, 30));
@@ -32813,6 +37025,7 @@ void QCPPolarAxisAngular::moveRange(double diff)
   mRange.upper += diff;
   emit rangeChanged(mRange);
   emit rangeChanged(mRange, oldRange);
+  markDirty();
 }
 
 /*!
@@ -32827,6 +37040,7 @@ void QCPPolarAxisAngular::moveRange(double diff)
 void QCPPolarAxisAngular::scaleRange(double factor)
 {
   scaleRange(factor, range().center());
+  markDirty();
 }
 
 /*! \overload
@@ -32848,6 +37062,7 @@ void QCPPolarAxisAngular::scaleRange(double factor, double center)
     mRange = newRange.sanitizedForLinScale();
   emit rangeChanged(mRange);
   emit rangeChanged(mRange, oldRange);
+  markDirty();
 }
 
 /*!
@@ -33121,6 +37336,7 @@ void QCPPolarAxisAngular::setBackground(const QPixmap &pm)
 {
   mBackgroundPixmap = pm;
   mScaledBackgroundPixmap = QPixmap();
+  markDirty();
 }
 
 /*! \overload
@@ -33139,6 +37355,7 @@ void QCPPolarAxisAngular::setBackground(const QPixmap &pm)
 void QCPPolarAxisAngular::setBackground(const QBrush &brush)
 {
   mBackgroundBrush = brush;
+  markDirty();
 }
 
 /*! \overload
@@ -33154,6 +37371,7 @@ void QCPPolarAxisAngular::setBackground(const QPixmap &pm, bool scaled, Qt::Aspe
   mScaledBackgroundPixmap = QPixmap();
   mBackgroundScaled = scaled;
   mBackgroundScaledMode = mode;
+  markDirty();
 }
 
 /*!
@@ -33169,6 +37387,7 @@ void QCPPolarAxisAngular::setBackground(const QPixmap &pm, bool scaled, Qt::Aspe
 void QCPPolarAxisAngular::setBackgroundScaled(bool scaled)
 {
   mBackgroundScaled = scaled;
+  markDirty();
 }
 
 /*!
@@ -33179,21 +37398,25 @@ void QCPPolarAxisAngular::setBackgroundScaled(bool scaled)
 void QCPPolarAxisAngular::setBackgroundScaledMode(Qt::AspectRatioMode mode)
 {
   mBackgroundScaledMode = mode;
+  markDirty();
 }
 
 void QCPPolarAxisAngular::setRangeDrag(bool enabled)
 {
   mRangeDrag = enabled;
+  markDirty();
 }
 
 void QCPPolarAxisAngular::setRangeZoom(bool enabled)
 {
   mRangeZoom = enabled;
+  markDirty();
 }
 
 void QCPPolarAxisAngular::setRangeZoomFactor(double factor)
 {
   mRangeZoomFactor = factor;
+  markDirty();
 }
 
 
@@ -33220,6 +37443,7 @@ void QCPPolarAxisAngular::setRange(const QCPRange &range)
   mRange = range.sanitizedForLinScale();
   emit rangeChanged(mRange);
   emit rangeChanged(mRange, oldRange);
+  markDirty();
 }
 
 /*!
@@ -33263,6 +37487,7 @@ void QCPPolarAxisAngular::setSelectedParts(const SelectableParts &selected)
     mSelectedParts = selected;
     emit selectionChanged(mSelectedParts);
   }
+  markDirty();
 }
 
 /*!
@@ -33286,6 +37511,7 @@ void QCPPolarAxisAngular::setRange(double lower, double upper)
   mRange = mRange.sanitizedForLinScale();
   emit rangeChanged(mRange);
   emit rangeChanged(mRange, oldRange);
+  markDirty();
 }
 
 /*!
@@ -33307,6 +37533,7 @@ void QCPPolarAxisAngular::setRange(double position, double size, Qt::AlignmentFl
     setRange(position-size, position);
   else // alignment == Qt::AlignCenter
     setRange(position-size/2.0, position+size/2.0);
+  markDirty();
 }
 
 /*!
@@ -33323,6 +37550,7 @@ void QCPPolarAxisAngular::setRangeLower(double lower)
   mRange = mRange.sanitizedForLinScale();
   emit rangeChanged(mRange);
   emit rangeChanged(mRange, oldRange);
+  markDirty();
 }
 
 /*!
@@ -33339,6 +37567,7 @@ void QCPPolarAxisAngular::setRangeUpper(double upper)
   mRange = mRange.sanitizedForLinScale();
   emit rangeChanged(mRange);
   emit rangeChanged(mRange, oldRange);
+  markDirty();
 }
 
 /*!
@@ -33353,12 +37582,14 @@ void QCPPolarAxisAngular::setRangeUpper(double upper)
 void QCPPolarAxisAngular::setRangeReversed(bool reversed)
 {
   mRangeReversed = reversed;
+  markDirty();
 }
 
 void QCPPolarAxisAngular::setAngle(double degrees)
 {
   mAngle = degrees;
   mAngleRad = mAngle/180.0*M_PI;
+  markDirty();
 }
 
 /*!
@@ -33381,6 +37612,7 @@ void QCPPolarAxisAngular::setTicker(QSharedPointer<QCPAxisTicker> ticker)
   else
     qDebug() << Q_FUNC_INFO << "can not set 0 as axis ticker";
   // no need to invalidate margin cache here because produced tick labels are checked for changes in setupTickVector
+  markDirty();
 }
 
 /*!
@@ -33398,6 +37630,7 @@ void QCPPolarAxisAngular::setTicks(bool show)
     mTicks = show;
     //mCachedMarginValid = false;
   }
+  markDirty();
 }
 
 /*!
@@ -33412,6 +37645,7 @@ void QCPPolarAxisAngular::setTickLabels(bool show)
     if (!mTickLabels)
       mTickVectorLabels.clear();
   }
+  markDirty();
 }
 
 /*!
@@ -33421,6 +37655,7 @@ void QCPPolarAxisAngular::setTickLabels(bool show)
 void QCPPolarAxisAngular::setTickLabelPadding(int padding)
 {
   mLabelPainter.setPadding(padding);
+  markDirty();
 }
 
 /*!
@@ -33431,6 +37666,7 @@ void QCPPolarAxisAngular::setTickLabelPadding(int padding)
 void QCPPolarAxisAngular::setTickLabelFont(const QFont &font)
 {
   mTickLabelFont = font;
+  markDirty();
 }
 
 /*!
@@ -33441,6 +37677,7 @@ void QCPPolarAxisAngular::setTickLabelFont(const QFont &font)
 void QCPPolarAxisAngular::setTickLabelColor(const QColor &color)
 {
   mTickLabelColor = color;
+  markDirty();
 }
 
 /*!
@@ -33455,6 +37692,7 @@ void QCPPolarAxisAngular::setTickLabelColor(const QColor &color)
 void QCPPolarAxisAngular::setTickLabelRotation(double degrees)
 {
   mLabelPainter.setRotation(degrees);
+  markDirty();
 }
 
 void QCPPolarAxisAngular::setTickLabelMode(LabelMode mode)
@@ -33464,6 +37702,7 @@ void QCPPolarAxisAngular::setTickLabelMode(LabelMode mode)
     case lmUpright: mLabelPainter.setAnchorMode(QCPLabelPainterPrivate::amSkewedUpright); break;
     case lmRotated: mLabelPainter.setAnchorMode(QCPLabelPainterPrivate::amSkewedRotated); break;
   }
+  markDirty();
 }
 
 /*!
@@ -33544,6 +37783,7 @@ void QCPPolarAxisAngular::setNumberFormat(const QString &formatCode)
   }
   mLabelPainter.setSubstituteExponent(mNumberBeautifulPowers);
   mLabelPainter.setMultiplicationSymbol(mNumberMultiplyCross ? QCPLabelPainterPrivate::SymbolCross : QCPLabelPainterPrivate::SymbolDot);
+  markDirty();
 }
 
 /*!
@@ -33558,6 +37798,7 @@ void QCPPolarAxisAngular::setNumberPrecision(int precision)
     mNumberPrecision = precision;
     //mCachedMarginValid = false;
   }
+  markDirty();
 }
 
 /*!
@@ -33572,6 +37813,7 @@ void QCPPolarAxisAngular::setTickLength(int inside, int outside)
 {
   setTickLengthIn(inside);
   setTickLengthOut(outside);
+  markDirty();
 }
 
 /*!
@@ -33586,6 +37828,7 @@ void QCPPolarAxisAngular::setTickLengthIn(int inside)
   {
     mTickLengthIn = inside;
   }
+  markDirty();
 }
 
 /*!
@@ -33602,6 +37845,7 @@ void QCPPolarAxisAngular::setTickLengthOut(int outside)
     mTickLengthOut = outside;
     //mCachedMarginValid = false; // only outside tick length can change margin
   }
+  markDirty();
 }
 
 /*!
@@ -33618,6 +37862,7 @@ void QCPPolarAxisAngular::setSubTicks(bool show)
     mSubTicks = show;
     //mCachedMarginValid = false;
   }
+  markDirty();
 }
 
 /*!
@@ -33632,6 +37877,7 @@ void QCPPolarAxisAngular::setSubTickLength(int inside, int outside)
 {
   setSubTickLengthIn(inside);
   setSubTickLengthOut(outside);
+  markDirty();
 }
 
 /*!
@@ -33646,6 +37892,7 @@ void QCPPolarAxisAngular::setSubTickLengthIn(int inside)
   {
     mSubTickLengthIn = inside;
   }
+  markDirty();
 }
 
 /*!
@@ -33662,6 +37909,7 @@ void QCPPolarAxisAngular::setSubTickLengthOut(int outside)
     mSubTickLengthOut = outside;
     //mCachedMarginValid = false; // only outside tick length can change margin
   }
+  markDirty();
 }
 
 /*!
@@ -33672,6 +37920,7 @@ void QCPPolarAxisAngular::setSubTickLengthOut(int outside)
 void QCPPolarAxisAngular::setBasePen(const QPen &pen)
 {
   mBasePen = pen;
+  markDirty();
 }
 
 /*!
@@ -33682,6 +37931,7 @@ void QCPPolarAxisAngular::setBasePen(const QPen &pen)
 void QCPPolarAxisAngular::setTickPen(const QPen &pen)
 {
   mTickPen = pen;
+  markDirty();
 }
 
 /*!
@@ -33692,6 +37942,7 @@ void QCPPolarAxisAngular::setTickPen(const QPen &pen)
 void QCPPolarAxisAngular::setSubTickPen(const QPen &pen)
 {
   mSubTickPen = pen;
+  markDirty();
 }
 
 /*!
@@ -33706,6 +37957,7 @@ void QCPPolarAxisAngular::setLabelFont(const QFont &font)
     mLabelFont = font;
     //mCachedMarginValid = false;
   }
+  markDirty();
 }
 
 /*!
@@ -33716,6 +37968,7 @@ void QCPPolarAxisAngular::setLabelFont(const QFont &font)
 void QCPPolarAxisAngular::setLabelColor(const QColor &color)
 {
   mLabelColor = color;
+  markDirty();
 }
 
 /*!
@@ -33729,6 +37982,7 @@ void QCPPolarAxisAngular::setLabel(const QString &str)
     mLabel = str;
     //mCachedMarginValid = false;
   }
+  markDirty();
 }
 
 /*!
@@ -33743,6 +37997,7 @@ void QCPPolarAxisAngular::setLabelPadding(int padding)
     mLabelPadding = padding;
     //mCachedMarginValid = false;
   }
+  markDirty();
 }
 
 /*!
@@ -33757,6 +38012,7 @@ void QCPPolarAxisAngular::setSelectedTickLabelFont(const QFont &font)
     mSelectedTickLabelFont = font;
     // don't set mCachedMarginValid to false here because margin calculation is always done with non-selected fonts
   }
+  markDirty();
 }
 
 /*!
@@ -33768,6 +38024,7 @@ void QCPPolarAxisAngular::setSelectedLabelFont(const QFont &font)
 {
   mSelectedLabelFont = font;
   // don't set mCachedMarginValid to false here because margin calculation is always done with non-selected fonts
+  markDirty();
 }
 
 /*!
@@ -33781,6 +38038,7 @@ void QCPPolarAxisAngular::setSelectedTickLabelColor(const QColor &color)
   {
     mSelectedTickLabelColor = color;
   }
+  markDirty();
 }
 
 /*!
@@ -33791,6 +38049,7 @@ void QCPPolarAxisAngular::setSelectedTickLabelColor(const QColor &color)
 void QCPPolarAxisAngular::setSelectedLabelColor(const QColor &color)
 {
   mSelectedLabelColor = color;
+  markDirty();
 }
 
 /*!
@@ -33801,6 +38060,7 @@ void QCPPolarAxisAngular::setSelectedLabelColor(const QColor &color)
 void QCPPolarAxisAngular::setSelectedBasePen(const QPen &pen)
 {
   mSelectedBasePen = pen;
+  markDirty();
 }
 
 /*!
@@ -33811,6 +38071,7 @@ void QCPPolarAxisAngular::setSelectedBasePen(const QPen &pen)
 void QCPPolarAxisAngular::setSelectedTickPen(const QPen &pen)
 {
   mSelectedTickPen = pen;
+  markDirty();
 }
 
 /*!
@@ -33821,6 +38082,7 @@ void QCPPolarAxisAngular::setSelectedTickPen(const QPen &pen)
 void QCPPolarAxisAngular::setSelectedSubTickPen(const QPen &pen)
 {
   mSelectedSubTickPen = pen;
+  markDirty();
 }
 
 /*! \internal
@@ -34203,16 +38465,19 @@ QCPPolarGrid::QCPPolarGrid(QCPPolarAxisAngular *parentAxis) :
 void QCPPolarGrid::setRadialAxis(QCPPolarAxisRadial *axis)
 {
   mRadialAxis = axis;
+  markDirty();
 }
 
 void QCPPolarGrid::setType(GridTypes type)
 {
   mType = type;
+  markDirty();
 }
 
 void QCPPolarGrid::setSubGridType(GridTypes type)
 {
   mSubGridType = type;
+  markDirty();
 }
 
 /*!
@@ -34221,6 +38486,7 @@ void QCPPolarGrid::setSubGridType(GridTypes type)
 void QCPPolarGrid::setAntialiasedSubGrid(bool enabled)
 {
   mAntialiasedSubGrid = enabled;
+  markDirty();
 }
 
 /*!
@@ -34229,6 +38495,7 @@ void QCPPolarGrid::setAntialiasedSubGrid(bool enabled)
 void QCPPolarGrid::setAntialiasedZeroLine(bool enabled)
 {
   mAntialiasedZeroLine = enabled;
+  markDirty();
 }
 
 /*!
@@ -34237,6 +38504,7 @@ void QCPPolarGrid::setAntialiasedZeroLine(bool enabled)
 void QCPPolarGrid::setAngularPen(const QPen &pen)
 {
   mAngularPen = pen;
+  markDirty();
 }
 
 /*!
@@ -34245,21 +38513,39 @@ void QCPPolarGrid::setAngularPen(const QPen &pen)
 void QCPPolarGrid::setAngularSubGridPen(const QPen &pen)
 {
   mAngularSubGridPen = pen;
+  markDirty();
 }
 
 void QCPPolarGrid::setRadialPen(const QPen &pen)
 {
   mRadialPen = pen;
+  markDirty();
 }
 
 void QCPPolarGrid::setRadialSubGridPen(const QPen &pen)
 {
   mRadialSubGridPen = pen;
+  markDirty();
 }
 
 void QCPPolarGrid::setRadialZeroLinePen(const QPen &pen)
 {
   mRadialZeroLinePen = pen;
+  markDirty();
+}
+
+/*!
+  Returns a value that changes whenever the properties of this grid, of its angular parent axis or
+  of its radial axis change.
+  
+  \seebaseclassmethod
+*/
+quint64 QCPPolarGrid::contentVersion() const
+{
+  quint64 version = qcpCombineVersions(QCPLayerable::contentVersion(), mParentAxis->contentVersion());
+  if (mRadialAxis)
+    version = qcpCombineVersions(version, mRadialAxis->contentVersion());
+  return version;
 }
 
 /*! \internal
@@ -34497,6 +38783,7 @@ QCPPolarGraph::~QCPPolarGraph()
 void QCPPolarGraph::setName(const QString &name)
 {
   mName = name;
+  markDirty();
 }
 
 /*!
@@ -34508,6 +38795,7 @@ void QCPPolarGraph::setName(const QString &name)
 void QCPPolarGraph::setAntialiasedFill(bool enabled)
 {
   mAntialiasedFill = enabled;
+  markDirty();
 }
 
 /*!
@@ -34519,6 +38807,7 @@ void QCPPolarGraph::setAntialiasedFill(bool enabled)
 void QCPPolarGraph::setAntialiasedScatters(bool enabled)
 {
   mAntialiasedScatters = enabled;
+  markDirty();
 }
 
 /*!
@@ -34532,6 +38821,7 @@ void QCPPolarGraph::setAntialiasedScatters(bool enabled)
 void QCPPolarGraph::setPen(const QPen &pen)
 {
   mPen = pen;
+  markDirty();
 }
 
 /*!
@@ -34546,11 +38836,13 @@ void QCPPolarGraph::setPen(const QPen &pen)
 void QCPPolarGraph::setBrush(const QBrush &brush)
 {
   mBrush = brush;
+  markDirty();
 }
 
 void QCPPolarGraph::setPeriodic(bool enabled)
 {
   mPeriodic = enabled;
+  markDirty();
 }
 
 /*!
@@ -34567,6 +38859,7 @@ void QCPPolarGraph::setPeriodic(bool enabled)
 void QCPPolarGraph::setKeyAxis(QCPPolarAxisAngular *axis)
 {
   mKeyAxis = axis;
+  markDirty();
 }
 
 /*!
@@ -34583,6 +38876,7 @@ void QCPPolarGraph::setKeyAxis(QCPPolarAxisAngular *axis)
 void QCPPolarGraph::setValueAxis(QCPPolarAxisRadial *axis)
 {
   mValueAxis = axis;
+  markDirty();
 }
 
 /*!
@@ -34638,6 +38932,7 @@ void QCPPolarGraph::setSelection(QCPDataSelection selection)
     emit selectionChanged(selected());
     emit selectionChanged(mSelection);
   }
+  markDirty();
 }
 
 /*! \overload
@@ -34658,6 +38953,7 @@ void QCPPolarGraph::setSelection(QCPDataSelection selection)
 void QCPPolarGraph::setData(QSharedPointer<QCPGraphDataContainer> data)
 {
   mDataContainer = data;
+  markDirty();
 }
 
 /*! \overload
@@ -34675,6 +38971,7 @@ void QCPPolarGraph::setData(const QVector<double> &keys, const QVector<double> &
 {
   mDataContainer->clear();
   addData(keys, values, alreadySorted);
+  markDirty();
 }
 
 /*!
@@ -34686,6 +38983,7 @@ void QCPPolarGraph::setData(const QVector<double> &keys, const QVector<double> &
 void QCPPolarGraph::setLineStyle(LineStyle ls)
 {
   mLineStyle = ls;
+  markDirty();
 }
 
 /*!
@@ -34697,6 +38995,7 @@ void QCPPolarGraph::setLineStyle(LineStyle ls)
 void QCPPolarGraph::setScatterStyle(const QCPScatterStyle &style)
 {
   mScatterStyle = style;
+  markDirty();
 }
 
 void QCPPolarGraph::addData(const QVector<double> &keys, const QVector<double> &values, bool alreadySorted)
@@ -34748,6 +39047,7 @@ void QCPPolarGraph::setSelectionDecorator(QCPSelectionDecorator *decorator)
     delete mSelectionDecorator;
     mSelectionDecorator = 0;
   }
+  markDirty();
 }
 */
 
@@ -34956,6 +39256,22 @@ QCPRange QCPPolarGraph::getValueRange(bool &foundRange, QCP::SignDomain inSignDo
   return mDataContainer->valueRange(foundRange, inSignDomain, inKeyRange);
 }
 
+/*!
+  Returns a value that changes whenever the properties, the data or the key or value axis of this
+  polar graph change.
+  
+  \seebaseclassmethod
+*/
+quint64 QCPPolarGraph::contentVersion() const
+{
+  quint64 version = qcpCombineVersions(QCPLayerable::contentVersion(), mDataContainer->version());
+  if (mKeyAxis)
+    version = qcpCombineVersions(version, mKeyAxis->contentVersion());
+  if (mValueAxis)
+    version = qcpCombineVersions(version, mValueAxis->contentVersion());
+  return version;
+}
+
 /* inherits documentation from base class */
 QRect QCPPolarGraph::clipRect() const
 {
@@ -35136,8 +39452,7 @@ void QCPPolarGraph::drawScatterPlot(QCPPainter *painter, const QVector<QPointF>
 {
   applyScattersAntialiasingHint(painter);
   style.applyTo(painter, mPen);
-  for (int i=0; i<scatters.size(); ++i)
-    style.drawShape(painter, scatters.at(i).x(), scatters.at(i).y());
+  style.drawShapes(painter, scatters, mParentPlot->plottingHints().testFlag(QCP::phCacheScatters));
 }
 
 void QCPPolarGraph::drawLegendIcon(QCPPainter *painter, const QRectF &rect) const
@@ -69,6 +69,7 @@
 #include <qmath.h>
 #include <limits>
 #include <algorithm>
+#include <iterator>
 #ifdef QCP_OPENGL_FBO
 #  include <QtGui/QOpenGLContext>
 #  if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
@@ -99,6 +100,9 @@
 #if QT_VERSION >= QT_VERSION_CHECK(4, 8, 0)
 #  include <QtCore/QElapsedTimer>
 #endif
+#if QT_VERSION >= QT_VERSION_CHECK(5, 3, 0)
+#  include <QtCore/QAtomicInteger>
+#endif
 # if QT_VERSION >= QT_VERSION_CHECK(5, 2, 0)
 #  include <QtCore/QTimeZone>
 #endif
@@ -127,6 +131,9 @@ class QCPPolarAxisRadial;
 class QCPPolarAxisAngular;
 class QCPPolarGrid;
 class QCPPolarGraph;
+class QCPAsyncReplotFrame;
+class QCPReplotProfiler;
+class QCPProfilerOverlay;
 
 /* including file 'src/global.h'            */
 /* modified 2022-11-06T12:45:57, size 18102 */
@@ -267,7 +274,11 @@ enum PlottingHint { phNone              = 0x000 ///< <tt>0x000</tt> No hints are
                                                 ///<                joins, thus is most effective for pen sizes larger than 1. It is only used for solid line pens.
                     ,phImmediateRefresh = 0x002 ///< <tt>0x002</tt> causes an immediate repaint() instead of a soft update() when QCustomPlot::replot() is called with parameter \ref QCustomPlot::rpRefreshHint.
                                                 ///<                This is set by default to prevent the plot from freezing on fast consecutive replots (e.g. user drags ranges with mouse).
-                    ,phCacheLabels      = 0x004 ///< <tt>0x004</tt> axis (tick) labels will be cached as pixmaps, increasing replot performance.
+                    ,phCacheLabels      = 0x004 ///< <tt>0x004</tt> axis (tick) labels will be cached as images in the shared \ref QCPLabelCache, increasing replot performance. This includes recording an asynchronous replot (\ref QCustomPlot::setAsyncReplot).
+                    ,phDirtyLayers      = 0x008 ///< <tt>0x008</tt> \ref QCustomPlot::replot only redraws the paint buffers of layers whose layerables changed since the last replot.
+                                                ///<                Changes that aren't detected automatically must be announced with \ref QCPLayerable::markDirty, see \ref QCustomPlot::replot.
+                    ,phCacheScatters    = 0x010 ///< <tt>0x010</tt> scatter shapes of graphs, curves and polar graphs are rasterized once as sprites and blitted to all points, also when recording an asynchronous replot (\ref QCustomPlot::setAsyncReplot), see \ref QCPScatterStyle::drawShapes.
+                                                ///<                This greatly increases replot performance for many scatter points. Scatters are then aligned to device pixels.
                   };
 Q_DECLARE_FLAGS(PlottingHints, PlottingHint)
 
@@ -535,11 +546,13 @@ public:
   // getters:
   bool antialiasing() const { return testRenderHint(QPainter::Antialiasing); }
   PainterModes modes() const { return mModes; }
+  double replayDevicePixelRatio() const { return mReplayDevicePixelRatio; }
 
   // setters:
   void setAntialiasing(bool enabled);
   void setMode(PainterMode mode, bool enabled=true);
   void setModes(PainterModes modes);
+  void setReplayDevicePixelRatio(double ratio);
 
   // methods hiding non-virtual base class functions (QPainter bug workarounds):
   bool begin(QPaintDevice *device);
@@ -558,6 +571,7 @@ protected:
   // property members:
   PainterModes mModes;
   bool mIsAntialiasing;
+  double mReplayDevicePixelRatio;
   
   // non-property members:
   QStack<bool> mAntialiasingStack;
@@ -626,6 +640,29 @@ protected:
 };
 
 
+class QCP_LIB_DECL QCPPaintBufferImage : public QCPAbstractPaintBuffer
+{
+public:
+  explicit QCPPaintBufferImage(const QSize &size, double devicePixelRatio);
+  virtual ~QCPPaintBufferImage() Q_DECL_OVERRIDE;
+  
+  // reimplemented virtual methods:
+  virtual QCPPainter *startPainting() Q_DECL_OVERRIDE;
+  virtual void draw(QCPPainter *painter) const Q_DECL_OVERRIDE;
+  void clear(const QColor &color) Q_DECL_OVERRIDE;
+  
+  // non-virtual methods:
+  void swapImage(QImage &image);
+  
+protected:
+  // non-property members:
+  QImage mBuffer;
+  
+  // reimplemented virtual methods:
+  virtual void reallocateBuffer() Q_DECL_OVERRIDE;
+};
+
+
 #ifdef QCP_OPENGL_PBUFFER
 class QCP_LIB_DECL QCPPaintBufferGlPbuffer : public QCPAbstractPaintBuffer
 {
@@ -721,6 +758,7 @@ public:
   
   // non-virtual methods:
   void replot();
+  void markDirty();
   
 protected:
   // property members:
@@ -733,6 +771,7 @@ protected:
   
   // non-property members:
   QWeakPointer<QCPAbstractPaintBuffer> mPaintBuffer;
+  bool mDirty;
   
   // non-virtual methods:
   void draw(QCPPainter *painter);
@@ -777,9 +816,12 @@ public:
   
   // introduced virtual methods:
   virtual double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details=nullptr) const;
+  virtual quint64 contentVersion() const;
 
   // non-property methods:
   bool realVisibility() const;
+  void markDirty();
+  quint64 propertyVersion() const { return mPropertyVersion; }
   
 signals:
   void layerChanged(QCPLayer *newLayer);
@@ -792,6 +834,10 @@ protected:
   QCPLayer *mLayer;
   bool mAntialiased;
   
+  // non-property members:
+  quint64 mPropertyVersion;
+  quint64 mDrawnContentVersion;
+  
   // introduced virtual methods:
   virtual void parentPlotInitialized(QCustomPlot *parentPlot);
   virtual QCP::Interaction selectionCategory() const;
@@ -1201,6 +1247,187 @@ protected:
 /* end of 'src/selectionrect.h' */
 
 
+/* including file 'src/profiler.h'         */
+
+class QCP_LIB_DECL QCPProfilerOverlay : public QCPLayerable
+{
+  Q_OBJECT
+public:
+  explicit QCPProfilerOverlay(QCPReplotProfiler *profiler);
+  virtual ~QCPProfilerOverlay() Q_DECL_OVERRIDE;
+  
+  // getters:
+  QCPReplotProfiler *profiler() const { return mProfiler; }
+  int entryCount() const { return mEntryCount; }
+  QFont font() const { return mFont; }
+  
+  // setters:
+  void setEntryCount(int count);
+  void setFont(const QFont &font);
+  
+  // reimplemented virtual methods:
+  virtual quint64 contentVersion() const Q_DECL_OVERRIDE;
+  
+protected:
+  // property members:
+  QCPReplotProfiler *mProfiler;
+  int mEntryCount;
+  QFont mFont;
+  
+  // non-property members:
+  int mStatisticsFrame;
+  QStringList mStatisticsLines;
+  
+  // reimplemented virtual methods:
+  virtual void applyDefaultAntialiasingHint(QCPPainter *painter) const Q_DECL_OVERRIDE;
+  virtual void draw(QCPPainter *painter) Q_DECL_OVERRIDE;
+};
+
+
+class QCP_LIB_DECL QCPReplotProfiler
+{
+public:
+  /*!
+    Defines the stage of the replot pipeline an event belongs to. The category is exported as the
+    "cat" field of the trace events, see \ref toChromeTrace.
+  */
+  enum Category { pcReplot     ///< A complete \ref QCustomPlot::replot. This is the root event of each frame
+                  ,pcLayout    ///< \ref QCustomPlot::updateLayout and its layout phases
+                  ,pcTicks     ///< Tick generation of an axis (\ref QCPAxisTicker::generate)
+                  ,pcBuffers   ///< Setting up the paint buffers (\ref QCustomPlot::setupPaintBuffers)
+                  ,pcLayer     ///< Drawing all layerables of one layer
+                  ,pcLayerable ///< Drawing one layerable (plottable, axis, grid, item, legend,...)
+                  ,pcLabels    ///< Rendering the tick labels and the label of an axis
+                  ,pcComposite ///< Drawing the paint buffers on the widget surface in \ref QCustomPlot::paintEvent
+                  ,pcWorker    ///< Rasterizing one paint buffer in a worker thread (see \ref QCustomPlot::setAsyncReplot)
+                  ,pcUser      ///< Events recorded by custom code with a \ref Scope
+                };
+  
+  /*!
+    One timed section of the replot pipeline, see \ref frame.
+  */
+  struct Event
+  {
+    QString name;
+    Category category;
+    int depth;        ///< nesting level of the event in its thread, 0 for root events
+    int thread;       ///< 0 for the GUI thread, 1 and up for the worker threads
+    qint64 start;     ///< start time in nanoseconds since the profiler was created
+    qint64 duration;  ///< in nanoseconds, -1 while the event is still open
+  };
+  
+  /*!
+    The events of one name and category, accumulated over several frames, see \ref statistics.
+    All times are in milliseconds.
+  */
+  struct Statistics
+  {
+    QString name;
+    Category category;
+    int count;        ///< number of events
+    double total;     ///< sum of the event durations
+    double self;      ///< sum of the event durations minus the durations of their child events
+    double maximum;   ///< longest single event
+  };
+  
+  /*!
+    Records one event of a \ref QCPReplotProfiler for the lifetime of the scope object. If \a
+    profiler is \c nullptr or not enabled, constructing and destroying the scope costs a pointer
+    and a flag check.
+  */
+  class Scope
+  {
+  public:
+    Scope(QCPReplotProfiler *profiler, const char *name, Category category=pcUser) :
+      mProfiler(profiler && profiler->mEnabled ? profiler : nullptr),
+      mHandle(mProfiler ? mProfiler->begin(QLatin1String(name), category) : -1)
+    {}
+    Scope(QCPReplotProfiler *profiler, const QCPLayerable *layerable, Category category=pcLayerable) :
+      mProfiler(profiler && profiler->mEnabled ? profiler : nullptr),
+      mHandle(mProfiler ? mProfiler->begin(eventName(layerable), category) : -1)
+    {}
+    Scope(QCPReplotProfiler *profiler, const QCPLayer *layer) :
+      mProfiler(profiler && profiler->mEnabled ? profiler : nullptr),
+      mHandle(mProfiler ? mProfiler->begin(eventName(layer), pcLayer) : -1)
+    {}
+    ~Scope() { if (mProfiler) mProfiler->end(mHandle); }
+    
+  private:
+    QCPReplotProfiler *mProfiler;
+    qint64 mHandle;
+    
+    Q_DISABLE_COPY(Scope)
+  };
+  
+  explicit QCPReplotProfiler(QCustomPlot *parentPlot);
+  ~QCPReplotProfiler();
+  
+  // getters:
+  QCustomPlot *parentPlot() const { return mParentPlot; }
+  bool enabled() const { return mEnabled; }
+  int frameCapacity() const { return mFrameCapacity; }
+  bool overlayVisible() const { return !mOverlay.isNull(); }
+  QCPProfilerOverlay *overlay() const { return mOverlay.data(); }
+  
+  // setters:
+  void setEnabled(bool enabled);
+  void setFrameCapacity(int frames);
+  void setOverlayVisible(bool visible);
+  
+  // non-property methods:
+  qint64 begin(const QString &name, Category category=pcUser);
+  void end(qint64 handle);
+  void clear();
+  int frameCount() const;
+  QVector<Event> frame(int index) const;
+  QVector<Event> lastFrame() const;
+  QVector<double> frameTimes() const;
+  QList<Statistics> statistics(int frames=0) const;
+  QByteArray toChromeTrace() const;
+  bool saveChromeTrace(const QString &fileName) const;
+  static QString categoryName(Category category);
+  
+protected:
+  struct Frame
+  {
+    int number;
+    QVector<Event> events;
+  };
+  
+  // property members:
+  QCustomPlot *mParentPlot;
+  bool mEnabled;
+  int mFrameCapacity;
+  QPointer<QCPProfilerOverlay> mOverlay;
+  
+  // non-property members:
+  QElapsedTimer mClock;
+  QList<Frame> mFrames;
+  int mFrameNumber;
+  bool mFrameOpen;
+  int mDepth;
+  QVector<Qt::HANDLE> mWorkerThreads;
+  
+  // non-property methods:
+  qint64 timestamp() const { return mClock.nsecsElapsed(); }
+  qint64 beginFrame();
+  void endFrame(qint64 handle);
+  void addWorkerEvent(int frameNumber, const QString &name, Qt::HANDLE thread, qint64 start, qint64 end);
+  static QString eventName(const QCPLayerable *layerable);
+  static QString eventName(const QCPLayer *layer);
+  
+private:
+  Q_DISABLE_COPY(QCPReplotProfiler)
+  
+  friend class QCustomPlot;
+  friend class QCPProfilerOverlay;
+  friend class QCPAsyncReplotTask;
+};
+Q_DECLARE_TYPEINFO(QCPReplotProfiler::Event, Q_MOVABLE_TYPE);
+
+/* end of 'src/profiler.h' */
+
+
 /* including file 'src/layout.h'            */
 /* modified 2022-11-06T12:45:56, size 14279 */
 
@@ -1589,6 +1816,59 @@ Q_DECLARE_METATYPE(QCPLineEnding::EndingStyle)
 /* including file 'src/axis/labelpainter.h' */
 /* modified 2022-11-06T12:45:56, size 7086  */
 
+class QCP_LIB_DECL QCPLabelCache
+{
+public:
+  /*!
+    A rasterized label. \a offset is the distance from the label anchor to the top left corner of
+    \a image, so drawing the image at the anchor position plus \a offset places the label
+    correctly. \a pixmap is converted from \a image when the label is first drawn on a raster
+    device, see \ref draw.
+  */
+  struct Label
+  {
+    QPointF offset;
+    QImage image;
+    QPixmap pixmap;
+  };
+  /*!
+    Usage counters of the cache, see \ref statistics.
+  */
+  struct Statistics
+  {
+    qint64 hits;
+    qint64 misses;
+    int labelCount;
+    int totalCost; ///< in kilobytes
+  };
+  
+  static QCPLabelCache *instance();
+  
+  // getters:
+  int maximumCost() const { return mLabels.maxCost(); }
+  Statistics statistics() const;
+  
+  // setters:
+  void setMaximumCost(int kilobytes);
+  
+  // non-property methods:
+  static bool supports(const QCPPainter *painter);
+  bool find(const QByteArray &key, Label *label, bool countStatistics=true);
+  void insert(const QByteArray &key, const Label &label);
+  void draw(QCPPainter *painter, const QPointF &pos, const QByteArray &key, const Label &label);
+  void clear();
+  void resetStatistics();
+  
+private:
+  QCPLabelCache();
+  
+  QCache<QByteArray, Label> mLabels;
+  qint64 mHits, mMisses;
+  
+  Q_DISABLE_COPY(QCPLabelCache)
+};
+
+
 class QCPLabelPainterPrivate
 {
   Q_GADGET
@@ -1639,7 +1919,6 @@ public:
   void setSubstituteExponent(bool enabled);
   void setMultiplicationSymbol(QChar symbol);
   void setAbbreviateDecimalPowers(bool enabled);
-  void setCacheSize(int labelCount);
   
   // getters:
   AnchorMode anchorMode() const { return mAnchorMode; }
@@ -1653,7 +1932,6 @@ public:
   bool substituteExponent() const { return mSubstituteExponent; }
   QChar multiplicationSymbol() const { return mMultiplicationSymbol; }
   bool abbreviateDecimalPowers() const { return mAbbreviateDecimalPowers; }
-  int cacheSize() const;
   
   //virtual int size() const;
   
@@ -1666,11 +1944,6 @@ public:
   static const QChar SymbolCross;
   
 protected:
-  struct CachedLabel
-  {
-    QPoint offset;
-    QPixmap pixmap;
-  };
   struct LabelData
   {
     AnchorSide side;
@@ -1698,14 +1971,13 @@ protected:
   bool mAbbreviateDecimalPowers;
   // non-property members:
   QCustomPlot *mParentPlot;
-  QByteArray mLabelParameterHash; // to determine whether mLabelCache needs to be cleared due to changed parameters
-  QCache<QString, CachedLabel> mLabelCache;
+  QByteArray mLabelParameterHash; // key prefix of the labels in QCPLabelCache, cleared by setters that invalidate it
   QRect mAxisSelectionBox, mTickLabelsSelectionBox, mLabelSelectionBox;
   int mLetterCapHeight, mLetterDescent;
   
   // introduced virtual methods:
   virtual void drawLabelMaybeCached(QCPPainter *painter, const QFont &font, const QColor &color, const QPointF &pos, AnchorSide side, double rotation, const QString &text);
-  virtual QByteArray generateLabelParameterHash() const; // TODO: get rid of this in favor of invalidation flag upon setters?
+  virtual QByteArray generateLabelParameterHash() const;
 
   // non-virtual methods:
   QPointF getAnchorPos(const QPointF &tickPos);
@@ -1713,7 +1985,7 @@ protected:
   LabelData getTickLabelData(const QFont &font, const QColor &color, double rotation, AnchorSide side, const QString &text) const;
   void applyAnchorTransform(LabelData &labelData) const;
   //void getMaxTickLabelSize(const QFont &font, const QString &text, QSize *tickLabelsSize) const;
-  CachedLabel *createCachedLabel(const LabelData &labelData) const;
+  QCPLabelCache::Label createCachedLabel(const LabelData &labelData) const;
   QByteArray cacheKey(const QString &text, const QColor &color, double rotation, AnchorSide side) const;
   AnchorSide skewedAnchorSide(const QPointF &tickPos, double sideExpandHorz, double sideExpandVert) const;
   AnchorSide rotationCorrectedSide(AnchorSide side, double rotation) const;
@@ -2096,6 +2368,9 @@ public:
   void setSubGridPen(const QPen &pen);
   void setZeroLinePen(const QPen &pen);
   
+  // reimplemented virtual methods:
+  virtual quint64 contentVersion() const Q_DECL_OVERRIDE;
+  
 protected:
   // property members:
   bool mSubGridVisible;
@@ -2313,8 +2588,10 @@ public:
   void scaleRange(double factor, double center);
   void setScaleRatio(const QCPAxis *otherAxis, double ratio=1.0);
   void rescale(bool onlyVisiblePlottables=false);
+  void prewarmTickLabels(const QVector<double> &values=QVector<double>());
   double pixelToCoord(double value) const;
   double coordToPixel(double value) const;
+  void coordsToPixels(const double *coords, double *pixels, int count) const;
   SelectablePart getPartAt(const QPointF &pos) const;
   QList<QCPAbstractPlottable*> plottables() const;
   QList<QCPGraph*> graphs() const;
@@ -2431,6 +2708,7 @@ public:
   virtual void draw(QCPPainter *painter);
   virtual int size();
   void clearCache();
+  void prewarmCache(const QVector<QString> &texts);
   
   QRect axisSelectionBox() const { return mAxisSelectionBox; }
   QRect tickLabelsSelectionBox() const { return mTickLabelsSelectionBox; }
@@ -2463,11 +2741,6 @@ public:
   QVector<QString> tickLabels;
   
 protected:
-  struct CachedLabel
-  {
-    QPointF offset;
-    QPixmap pixmap;
-  };
   struct TickLabelData
   {
     QString basePart, expPart, suffixPart;
@@ -2475,11 +2748,11 @@ protected:
     QFont baseFont, expFont;
   };
   QCustomPlot *mParentPlot;
-  QByteArray mLabelParameterHash; // to determine whether mLabelCache needs to be cleared due to changed parameters
-  QCache<QString, CachedLabel> mLabelCache;
+  QByteArray mLabelParameterHash; // key prefix of the labels of this axis in QCPLabelCache
   QRect mAxisSelectionBox, mTickLabelsSelectionBox, mLabelSelectionBox;
   
   virtual QByteArray generateLabelParameterHash() const;
+  virtual QCPLabelCache::Label createCachedLabel(const QFont &font, const QColor &color, const QString &text) const;
   
   virtual void placeTickLabel(QCPPainter *painter, double position, int distanceToAxis, const QString &text, QSize *tickLabelsSize);
   virtual void drawTickLabel(QCPPainter *painter, double x, double y, const TickLabelData &labelData) const;
@@ -2577,6 +2850,7 @@ public:
   void applyTo(QCPPainter *painter, const QPen &defaultPen) const;
   void drawShape(QCPPainter *painter, const QPointF &pos) const;
   void drawShape(QCPPainter *painter, double x, double y) const;
+  void drawShapes(QCPPainter *painter, const QVector<QPointF> &points, bool cached=true) const;
 
 protected:
   // property members:
@@ -2589,6 +2863,10 @@ protected:
   
   // non-property members:
   bool mPenDefined;
+  
+  // non-property methods:
+  bool drawSprites(QCPPainter *painter, const QVector<QPointF> &points) const;
+  QImage spriteImage(const QPen &pen, const QBrush &brush, bool antialiased, double extent, double devicePixelRatio, QPixmap *pixmap) const;
 };
 Q_DECLARE_TYPEINFO(QCPScatterStyle, Q_MOVABLE_TYPE);
 Q_DECLARE_OPERATORS_FOR_FLAGS(QCPScatterStyle::ScatterProperties)
@@ -2609,22 +2887,136 @@ Q_DECLARE_METATYPE(QCPScatterStyle::ScatterShape)
 template <class DataType>
 inline bool qcpLessThanSortKey(const DataType &a, const DataType &b) { return a.sortKey() < b.sortKey(); }
 
+/*! \class QCPDataContainerIterator
+  \brief The random access iterator of QCPDataContainer
+
+  QCPDataContainer stores its data points in blocks of \ref blockSize data points (see the detailed
+  description of QCPDataContainer). The iterator points to a data point inside a block and moves to
+  the neighbouring block when it leaves a full one, so stepping through the data costs one pointer
+  comparison per step. Random access (e.g. in binary searches) computes the block from the offset.
+
+  Use it through the typedefs QCPDataContainer::const_iterator and QCPDataContainer::iterator.
+*/
+template <class DataType, class ValueType, class BlockType>
+class QCPDataContainerIterator
+{
+public:
+  typedef std::random_access_iterator_tag iterator_category;
+  typedef DataType value_type;
+  typedef qptrdiff difference_type;
+  typedef ValueType *pointer;
+  typedef ValueType &reference;
+  enum { blockShift = 14                ///< log2 of \ref blockSize
+         ,blockSize = 1<<blockShift     ///< number of data points per storage block of QCPDataContainer
+       };
+  
+  QCPDataContainerIterator() : mBlock(nullptr), mFirst(nullptr), mCurrent(nullptr), mBlockEnd(nullptr) {}
+  QCPDataContainerIterator(BlockType *block, int offset) { setBlock(block); mCurrent = mFirst+offset; }
+  template <class OtherValueType, class OtherBlockType>
+  QCPDataContainerIterator(const QCPDataContainerIterator<DataType, OtherValueType, OtherBlockType> &other) :
+    mBlock(other.mBlock), mFirst(other.mFirst), mCurrent(other.mCurrent), mBlockEnd(other.mBlockEnd) {}
+  
+  reference operator*() const { return *mCurrent; }
+  pointer operator->() const { return mCurrent; }
+  reference operator[](difference_type n) const { return *(*this+n); }
+  
+  QCPDataContainerIterator &operator++()
+  {
+    if (++mCurrent == mBlockEnd) // left a full block, continue at the start of the next one
+    {
+      setBlock(mBlock+1);
+      mCurrent = mFirst;
+    }
+    return *this;
+  }
+  QCPDataContainerIterator &operator--()
+  {
+    if (mCurrent == mFirst) // blocks before the last one are always full
+    {
+      setBlock(mBlock-1);
+      mCurrent = mFirst+blockSize;
+    }
+    --mCurrent;
+    return *this;
+  }
+  QCPDataContainerIterator operator++(int) { QCPDataContainerIterator result(*this); ++*this; return result; }
+  QCPDataContainerIterator operator--(int) { QCPDataContainerIterator result(*this); --*this; return result; }
+  QCPDataContainerIterator &operator+=(difference_type n)
+  {
+    const difference_type offset = (mCurrent-mFirst)+n;
+    if (offset >= 0 && offset < blockSize)
+    {
+      mCurrent = mFirst+offset;
+    } else
+    {
+      const difference_type blockOffset = offset >= 0 ? offset/blockSize : -((blockSize-1-offset)/blockSize); // rounded towards negative infinity
+      setBlock(mBlock+blockOffset);
+      mCurrent = mFirst+(offset-blockOffset*blockSize);
+    }
+    return *this;
+  }
+  QCPDataContainerIterator &operator-=(difference_type n) { return *this += -n; }
+  
+  friend QCPDataContainerIterator operator+(QCPDataContainerIterator it, difference_type n) { return it += n; }
+  friend QCPDataContainerIterator operator+(difference_type n, QCPDataContainerIterator it) { return it += n; }
+  friend QCPDataContainerIterator operator-(QCPDataContainerIterator it, difference_type n) { return it -= n; }
+  friend difference_type operator-(const QCPDataContainerIterator &a, const QCPDataContainerIterator &b)
+  { return (a.mBlock-b.mBlock)*difference_type(blockSize)+(a.mCurrent-a.mFirst)-(b.mCurrent-b.mFirst); }
+  friend bool operator==(const QCPDataContainerIterator &a, const QCPDataContainerIterator &b) { return a.mCurrent == b.mCurrent; }
+  friend bool operator!=(const QCPDataContainerIterator &a, const QCPDataContainerIterator &b) { return a.mCurrent != b.mCurrent; }
+  friend bool operator<(const QCPDataContainerIterator &a, const QCPDataContainerIterator &b) { return a.mBlock == b.mBlock ? a.mCurrent < b.mCurrent : a.mBlock < b.mBlock; }
+  friend bool operator>(const QCPDataContainerIterator &a, const QCPDataContainerIterator &b) { return b < a; }
+  friend bool operator<=(const QCPDataContainerIterator &a, const QCPDataContainerIterator &b) { return !(b < a); }
+  friend bool operator>=(const QCPDataContainerIterator &a, const QCPDataContainerIterator &b) { return !(a < b); }
+  
+private:
+  BlockType *mBlock;
+  ValueType *mFirst, *mCurrent, *mBlockEnd; // mBlockEnd is zero for the last, partially filled block, so it is never reached
+  
+  void setBlock(BlockType *block)
+  {
+    mBlock = block;
+    mFirst = blockData(*block);
+    mBlockEnd = block->size() == blockSize ? mFirst+blockSize : nullptr;
+  }
+  static const DataType *blockData(const QVector<DataType> &block) { return block.constData(); }
+  static DataType *blockData(QVector<DataType> &block) { return block.data(); }
+  
+  template <class, class, class> friend class QCPDataContainerIterator;
+};
+
 template <class DataType>
 class QCPDataContainer // no QCP_LIB_DECL, template class ends up in header (cpp included below)
 {
 public:
-  typedef typename QVector<DataType>::const_iterator const_iterator;
-  typedef typename QVector<DataType>::iterator iterator;
+  typedef QCPDataContainerIterator<DataType, const DataType, const QVector<DataType> > const_iterator;
+  typedef QCPDataContainerIterator<DataType, DataType, QVector<DataType> > iterator;
+  
+  /*!
+    Aggregate of a contiguous index range of data points, as stored in the level-of-detail index
+    (see \ref setLevelOfDetailEnabled). \a minIndex and \a maxIndex are -1 if the range contains no
+    non-NaN value.
+  */
+  struct LodBucket
+  {
+    double minValue;
+    double maxValue;
+    int minIndex;
+    int maxIndex;
+  };
   
   QCPDataContainer();
   
   // getters:
-  int size() const { return mData.size()-mPreallocSize; }
+  int size() const { return endPosition()-mPreallocSize; }
   bool isEmpty() const { return size() == 0; }
   bool autoSqueeze() const { return mAutoSqueeze; }
+  bool levelOfDetailEnabled() const { return mLevelOfDetailEnabled; }
+  quint64 version() const { return mVersion; }
   
   // setters:
   void setAutoSqueeze(bool enabled);
+  void setLevelOfDetailEnabled(bool enabled);
   
   // non-virtual methods:
   void set(const QCPDataContainer<DataType> &data);
@@ -2640,10 +3032,10 @@ public:
   void sort();
   void squeeze(bool preAllocation=true, bool postAllocation=true);
   
-  const_iterator constBegin() const { return mData.constBegin()+mPreallocSize; }
-  const_iterator constEnd() const { return mData.constEnd(); }
-  iterator begin() { return mData.begin()+mPreallocSize; }
-  iterator end() { return mData.end(); }
+  const_iterator constBegin() const { return positionIterator(mPreallocSize); }
+  const_iterator constEnd() const { return positionIterator(endPosition()); }
+  iterator begin() { ++mVersion; return mutableBegin(); }
+  iterator end() { ++mVersion; return mutableEnd(); }
   const_iterator findBegin(double sortKey, bool expandedRange=true) const;
   const_iterator findEnd(double sortKey, bool expandedRange=true) const;
   const_iterator at(int index) const { return constBegin()+qBound(0, index, size()); }
@@ -2651,19 +3043,45 @@ public:
   QCPRange valueRange(bool &foundRange, QCP::SignDomain signDomain=QCP::sdBoth, const QCPRange &inKeyRange=QCPRange());
   QCPDataRange dataRange() const { return QCPDataRange(0, size()); }
   void limitIteratorsToDataRange(const_iterator &begin, const_iterator &end, const QCPDataRange &dataRange) const;
+  void invalidateLevelOfDetail(int fromIndex=0);
+  LodBucket valueExtremes(int beginIndex, int endIndex) const;
   
 protected:
+  enum { lodBaseSize = 32   ///< number of data points aggregated by one bucket of the finest level
+         ,lodFanout = 8     ///< number of buckets of one level aggregated by one bucket of the next coarser level
+         ,blockShift = const_iterator::blockShift
+         ,blockSize = const_iterator::blockSize
+       };
+  
   // property members:
   bool mAutoSqueeze;
+  bool mLevelOfDetailEnabled;
   
   // non-property memebers:
-  QVector<DataType> mData;
-  int mPreallocSize;
-  int mPreallocIteration;
+  QVector<QVector<DataType> > mBlocks; // position p is at offset p%blockSize of block p/blockSize; the last block is never full, blocks before mPreallocSize are freed
+  int mPreallocSize; // position of the first data point
+  quint64 mVersion;
+  mutable QVector<QVector<LodBucket> > mLodLevels; // bucket boundaries are positions in mBlocks, including the preallocation
+  mutable int mLodValidSize; // position up to which mLodLevels is up to date
   
   // non-virtual methods:
+  int endPosition() const { return int((mBlocks.size()-1)<<blockShift)+int(mBlocks.last().size()); }
+  const_iterator positionIterator(int position) const { return const_iterator(mBlocks.constData()+(position>>blockShift), position&(blockSize-1)); }
+  iterator mutablePositionIterator(int position) { return iterator(mBlocks.data()+(position>>blockShift), position&(blockSize-1)); }
+  iterator mutableBegin() { return mutablePositionIterator(mPreallocSize); }
+  iterator mutableEnd() { return mutablePositionIterator(endPosition()); }
+  template <class InputIterator>
+  void appendData(InputIterator first, InputIterator last);
+  void truncate(int position);
+  void allocateBlocks(int position);
+  void releaseBlocks();
   void preallocateGrow(int minimumPreallocSize);
   void performAutoSqueeze();
+  void updateLevelOfDetail() const;
+  void lodValueRange(int beginIndex, int endIndex, QCP::SignDomain signDomain, QCPRange &range, bool &haveLower, bool &haveUpper) const;
+  void lodBucketValueRange(int level, int bucketIndex, QCP::SignDomain signDomain, bool lower, bool upper, QCPRange &range, bool &haveLower, bool &haveUpper) const;
+  static void mergeLodBucket(LodBucket &target, const LodBucket &source);
+  static void extendValueRange(double lower, double upper, QCP::SignDomain signDomain, QCPRange &range, bool &haveLower, bool &haveUpper);
 };
 
 
@@ -2689,6 +3107,15 @@ protected:
   specifying that added data is already itself sorted by key, if he can guarantee that this is the
   case (see for example \ref add(const QVector<DataType> &data, bool alreadySorted)).
 
+  Internally, the data points are stored in blocks of a fixed number of data points (16384), so the
+  container never reallocates and copies all of its data at once. Appending only ever grows the
+  last block, which makes it constant time even in the worst case, and long-running recordings
+  don't see hitches when the data outgrows its allocation. \ref removeBefore frees every block that
+  no longer holds data points, and merging data in between existing keys only moves the data
+  points behind the insertion point. The iterators are random access iterators that step from
+  block to block, so binary searches like \ref findBegin and \ref findEnd work across blocks. Unlike
+  with a QVector, the data points of a container are not contiguous in memory.
+
   The data can be accessed with the provided const iterators (\ref constBegin, \ref constEnd). If
   it is necessary to alter existing data in-place, the non-const iterators can be used (\ref begin,
   \ref end). Changing data members that are not the sort key (for most data types called \a key) is
@@ -2702,6 +3129,18 @@ protected:
   sort. Failing to do so can not be detected by the container efficiently and will cause both
   rendering artifacts and potential data loss.
 
+  For very large data sets, an optional level-of-detail index can be enabled with \ref
+  setLevelOfDetailEnabled. It is a hierarchy of buckets holding the minimum and maximum value (and
+  their indices) of fixed-size index ranges; the first and last point of a bucket are the data
+  points at its boundaries. \ref valueExtremes uses it to return the value span of any index range
+  in logarithmic time, which allows \ref QCPGraph to do adaptive sampling with a cost proportional
+  to the pixel width of the key axis instead of the number of data points. \ref valueRange uses it
+  the same way, so rescaling the value axis doesn't visit every data point either. Buckets are
+  aligned to the positions in the internal storage, so appending data only updates the last
+  buckets of each level and \ref removeBefore (which just grows the preallocation) keeps the index
+  valid. Other modifications through the container interface invalidate the index from the first
+  affected data point on. It is rebuilt lazily the next time it is queried.
+
   Implementing one-dimensional plottables that make use of a \ref QCPDataContainer<T> is usually
   done by subclassing from \ref QCPAbstractPlottable1D "QCPAbstractPlottable1D<T>", which
   introduces an according \a mDataContainer member and some convenience methods.
@@ -2769,6 +3208,12 @@ protected:
   You can manipulate the data points in-place through the non-const iterators, but great care must
   be taken when manipulating the sort key of a data point, see \ref sort, or the detailed
   description of this class.
+  
+  Since the data may be changed through the returned iterator, this increases the \ref version, so
+  plottables using this container redraw with the changed data on the next replot. If the
+  level-of-detail index is enabled (\ref setLevelOfDetailEnabled), call \ref
+  invalidateLevelOfDetail after changing values in-place. To only read data points, use the const
+  iterators (\ref constBegin, \ref constEnd).
 */
 
 /*! \fn QCPDataContainer::iterator QCPDataContainer<DataType>::end() const
@@ -2778,6 +3223,8 @@ protected:
   You can manipulate the data points in-place through the non-const iterators, but great care must
   be taken when manipulating the sort key of a data point, see \ref sort, or the detailed
   description of this class.
+  
+  Like \ref begin, this increases the \ref version.
 */
 
 /*! \fn QCPDataContainer::const_iterator QCPDataContainer<DataType>::at(int index) const
@@ -2790,6 +3237,17 @@ protected:
   dataselection-accessing "data selection page" for an example.
 */
 
+/*! \fn quint64 QCPDataContainer<DataType>::version() const
+
+  Returns a counter that is increased whenever data points are added, removed or changed through
+  the interface of this container, including every call of the non-const \ref begin and \ref end.
+  Plottables report it via \ref QCPAbstractPlottable::dataVersion, so the \ref QCP::phDirtyLayers
+  plotting hint only redraws layers whose data changed, and cached geometry like the lines of \ref
+  QCPGraph is rebuilt.
+
+  \see invalidateLevelOfDetail
+*/
+
 /*! \fn QCPDataRange QCPDataContainer::dataRange() const
 
   Returns a \ref QCPDataRange encompassing the entire data set of this container. This means the
@@ -2805,8 +3263,11 @@ protected:
 template <class DataType>
 QCPDataContainer<DataType>::QCPDataContainer() :
   mAutoSqueeze(true),
+  mLevelOfDetailEnabled(false),
+  mBlocks(1),
   mPreallocSize(0),
-  mPreallocIteration(0)
+  mVersion(0),
+  mLodValidSize(0)
 {
 }
 
@@ -2829,6 +3290,22 @@ void QCPDataContainer<DataType>::setAutoSqueeze(bool enabled)
   }
 }
 
+/*!
+  Sets whether this container maintains a level-of-detail index of its values, see the detailed
+  description of this class. The index needs roughly 3% of the memory of \ref QCPGraphData points
+  and is built the first time \ref valueExtremes is called. Disabling it frees the index.
+
+  The index can't detect value changes done in-place through the non-const iterators (\ref begin,
+  \ref end). Call \ref invalidateLevelOfDetail after such changes.
+*/
+template <class DataType>
+void QCPDataContainer<DataType>::setLevelOfDetailEnabled(bool enabled)
+{
+  mLevelOfDetailEnabled = enabled;
+  mLodLevels.clear();
+  mLodValidSize = 0;
+}
+
 /*! \overload
   
   Replaces the current data in this container with the provided \a data.
@@ -2854,9 +3331,8 @@ void QCPDataContainer<DataType>::set(const QCPDataContainer<DataType> &data)
 template <class DataType>
 void QCPDataContainer<DataType>::set(const QVector<DataType> &data, bool alreadySorted)
 {
-  mData = data;
-  mPreallocSize = 0;
-  mPreallocIteration = 0;
+  clear();
+  appendData(data.constBegin(), data.constEnd());
   if (!alreadySorted)
     sort();
 }
@@ -2880,14 +3356,20 @@ void QCPDataContainer<DataType>::add(const QCPDataContainer<DataType> &data)
   {
     if (mPreallocSize < n)
       preallocateGrow(n);
+    allocateBlocks(mPreallocSize-n);
     mPreallocSize -= n;
-    std::copy(data.constBegin(), data.constEnd(), begin());
+    std::copy(data.constBegin(), data.constEnd(), mutableBegin());
+    invalidateLevelOfDetail();
   } else // don't need to prepend, so append and merge if necessary
   {
-    mData.resize(mData.size()+n);
-    std::copy(data.constBegin(), data.constEnd(), end()-n);
+    appendData(data.constBegin(), data.constEnd());
+    ++mVersion;
     if (oldSize > 0 && !qcpLessThanSortKey<DataType>(*(constEnd()-n-1), *(constEnd()-n))) // if appended range keys aren't all greater than existing ones, merge the two partitions
-      std::inplace_merge(begin(), end()-n, end(), qcpLessThanSortKey<DataType>);
+    {
+      QCPDataContainer<DataType>::iterator mergeBegin = std::upper_bound(mutableBegin(), mutableEnd()-n, *(mutableEnd()-n), qcpLessThanSortKey<DataType>); // data points before it stay in place
+      invalidateLevelOfDetail(int(mergeBegin-mutableBegin()));
+      std::inplace_merge(mergeBegin, mutableEnd()-n, mutableEnd(), qcpLessThanSortKey<DataType>);
+    }
   }
 }
 
@@ -2917,16 +3399,22 @@ void QCPDataContainer<DataType>::add(const QVector<DataType> &data, bool already
   {
     if (mPreallocSize < n)
       preallocateGrow(n);
+    allocateBlocks(mPreallocSize-n);
     mPreallocSize -= n;
-    std::copy(data.constBegin(), data.constEnd(), begin());
+    std::copy(data.constBegin(), data.constEnd(), mutableBegin());
+    invalidateLevelOfDetail();
   } else // don't need to prepend, so append and then sort and merge if necessary
   {
-    mData.resize(mData.size()+n);
-    std::copy(data.constBegin(), data.constEnd(), end()-n);
+    appendData(data.constBegin(), data.constEnd());
+    ++mVersion;
     if (!alreadySorted) // sort appended subrange if it wasn't already sorted
-      std::sort(end()-n, end(), qcpLessThanSortKey<DataType>);
+      std::sort(mutableEnd()-n, mutableEnd(), qcpLessThanSortKey<DataType>);
     if (oldSize > 0 && !qcpLessThanSortKey<DataType>(*(constEnd()-n-1), *(constEnd()-n))) // if appended range keys aren't all greater than existing ones, merge the two partitions
-      std::inplace_merge(begin(), end()-n, end(), qcpLessThanSortKey<DataType>);
+    {
+      QCPDataContainer<DataType>::iterator mergeBegin = std::upper_bound(mutableBegin(), mutableEnd()-n, *(mutableEnd()-n), qcpLessThanSortKey<DataType>); // data points before it stay in place
+      invalidateLevelOfDetail(int(mergeBegin-mutableBegin()));
+      std::inplace_merge(mergeBegin, mutableEnd()-n, mutableEnd(), qcpLessThanSortKey<DataType>);
+    }
   }
 }
 
@@ -2939,19 +3427,25 @@ void QCPDataContainer<DataType>::add(const QVector<DataType> &data, bool already
 template <class DataType>
 void QCPDataContainer<DataType>::add(const DataType &data)
 {
-  if (isEmpty() || !qcpLessThanSortKey<DataType>(data, *(constEnd()-1))) // quickly handle appends if new data key is greater or equal to existing ones
+  const DataType dataPoint(data); // data may refer to a data point of this container, which appending may move
+  if (isEmpty() || !qcpLessThanSortKey<DataType>(dataPoint, *(constEnd()-1))) // quickly handle appends if new data key is greater or equal to existing ones
   {
-    mData.append(data);
-  } else if (qcpLessThanSortKey<DataType>(data, *constBegin()))  // quickly handle prepends using preallocated space
+    appendData(&dataPoint, &dataPoint+1);
+    ++mVersion;
+  } else if (qcpLessThanSortKey<DataType>(dataPoint, *constBegin()))  // quickly handle prepends using preallocated space
   {
     if (mPreallocSize < 1)
       preallocateGrow(1);
+    allocateBlocks(mPreallocSize-1);
     --mPreallocSize;
-    *begin() = data;
+    *mutableBegin() = dataPoint;
+    invalidateLevelOfDetail();
   } else // handle inserts, maintaining sorted keys
   {
-    QCPDataContainer<DataType>::iterator insertionPoint = std::lower_bound(begin(), end(), data, qcpLessThanSortKey<DataType>);
-    mData.insert(insertionPoint, data);
+    const int index = int(std::lower_bound(constBegin(), constEnd(), dataPoint, qcpLessThanSortKey<DataType>)-constBegin());
+    invalidateLevelOfDetail(index);
+    appendData(&dataPoint, &dataPoint+1);
+    std::rotate(mutableBegin()+index, mutableEnd()-1, mutableEnd()); // move the appended data point to the insertion point
   }
 }
 
@@ -2963,9 +3457,14 @@ void QCPDataContainer<DataType>::add(const DataType &data)
 template <class DataType>
 void QCPDataContainer<DataType>::removeBefore(double sortKey)
 {
-  QCPDataContainer<DataType>::iterator it = begin();
-  QCPDataContainer<DataType>::iterator itEnd = std::lower_bound(begin(), end(), DataType::fromSortKey(sortKey), qcpLessThanSortKey<DataType>);
-  mPreallocSize += int(itEnd-it); // don't actually delete, just add it to the preallocated block (if it gets too large, squeeze will take care of it)
+  QCPDataContainer<DataType>::const_iterator it = constBegin();
+  QCPDataContainer<DataType>::const_iterator itEnd = std::lower_bound(constBegin(), constEnd(), DataType::fromSortKey(sortKey), qcpLessThanSortKey<DataType>);
+  mPreallocSize += int(itEnd-it); // don't move the data, just add it to the preallocation and free the blocks left without data points
+  if (itEnd != it)
+  {
+    ++mVersion;
+    releaseBlocks();
+  }
   if (mAutoSqueeze)
     performAutoSqueeze();
 }
@@ -2978,9 +3477,10 @@ void QCPDataContainer<DataType>::removeBefore(double sortKey)
 template <class DataType>
 void QCPDataContainer<DataType>::removeAfter(double sortKey)
 {
-  QCPDataContainer<DataType>::iterator it = std::upper_bound(begin(), end(), DataType::fromSortKey(sortKey), qcpLessThanSortKey<DataType>);
-  QCPDataContainer<DataType>::iterator itEnd = end();
-  mData.erase(it, itEnd); // typically adds it to the postallocated block
+  QCPDataContainer<DataType>::const_iterator it = std::upper_bound(constBegin(), constEnd(), DataType::fromSortKey(sortKey), qcpLessThanSortKey<DataType>);
+  const int index = int(it-constBegin());
+  invalidateLevelOfDetail(index);
+  truncate(mPreallocSize+index); // typically adds it to the postallocated part of the last block
   if (mAutoSqueeze)
     performAutoSqueeze();
 }
@@ -2998,9 +3498,15 @@ void QCPDataContainer<DataType>::remove(double sortKeyFrom, double sortKeyTo)
   if (sortKeyFrom >= sortKeyTo || isEmpty())
     return;
   
-  QCPDataContainer<DataType>::iterator it = std::lower_bound(begin(), end(), DataType::fromSortKey(sortKeyFrom), qcpLessThanSortKey<DataType>);
-  QCPDataContainer<DataType>::iterator itEnd = std::upper_bound(it, end(), DataType::fromSortKey(sortKeyTo), qcpLessThanSortKey<DataType>);
-  mData.erase(it, itEnd);
+  QCPDataContainer<DataType>::iterator it = std::lower_bound(mutableBegin(), mutableEnd(), DataType::fromSortKey(sortKeyFrom), qcpLessThanSortKey<DataType>);
+  QCPDataContainer<DataType>::iterator itEnd = std::upper_bound(it, mutableEnd(), DataType::fromSortKey(sortKeyTo), qcpLessThanSortKey<DataType>);
+  if (itEnd != it)
+  {
+    const int removed = int(itEnd-it);
+    invalidateLevelOfDetail(int(it-mutableBegin()));
+    std::copy(itEnd, mutableEnd(), it);
+    truncate(endPosition()-removed);
+  }
   if (mAutoSqueeze)
     performAutoSqueeze();
 }
@@ -3017,13 +3523,20 @@ void QCPDataContainer<DataType>::remove(double sortKeyFrom, double sortKeyTo)
 template <class DataType>
 void QCPDataContainer<DataType>::remove(double sortKey)
 {
-  QCPDataContainer::iterator it = std::lower_bound(begin(), end(), DataType::fromSortKey(sortKey), qcpLessThanSortKey<DataType>);
-  if (it != end() && it->sortKey() == sortKey)
+  QCPDataContainer::iterator it = std::lower_bound(mutableBegin(), mutableEnd(), DataType::fromSortKey(sortKey), qcpLessThanSortKey<DataType>);
+  if (it != mutableEnd() && it->sortKey() == sortKey)
   {
-    if (it == begin())
-      ++mPreallocSize; // don't actually delete, just add it to the preallocated block (if it gets too large, squeeze will take care of it)
-    else
-      mData.erase(it);
+    if (it == mutableBegin())
+    {
+      ++mPreallocSize; // don't actually delete, just add it to the preallocation (if it gets too large, squeeze will take care of it)
+      ++mVersion;
+      releaseBlocks();
+    } else
+    {
+      invalidateLevelOfDetail(int(it-mutableBegin()));
+      std::copy(it+1, mutableEnd(), it);
+      truncate(endPosition()-1);
+    }
   }
   if (mAutoSqueeze)
     performAutoSqueeze();
@@ -3037,9 +3550,10 @@ void QCPDataContainer<DataType>::remove(double sortKey)
 template <class DataType>
 void QCPDataContainer<DataType>::clear()
 {
-  mData.clear();
-  mPreallocIteration = 0;
+  mBlocks.clear();
+  mBlocks.append(QVector<DataType>());
   mPreallocSize = 0;
+  invalidateLevelOfDetail();
 }
 
 /*!
@@ -3056,7 +3570,8 @@ void QCPDataContainer<DataType>::clear()
 template <class DataType>
 void QCPDataContainer<DataType>::sort()
 {
-  std::sort(begin(), end(), qcpLessThanSortKey<DataType>);
+  std::sort(mutableBegin(), mutableEnd(), qcpLessThanSortKey<DataType>);
+  invalidateLevelOfDetail();
 }
 
 /*!
@@ -3068,22 +3583,53 @@ void QCPDataContainer<DataType>::sort()
   
   The parameters \a preAllocation and \a postAllocation control whether pre- and/or post allocation
   should be freed, respectively.
+
+  The blocks of the preallocation are freed as soon as they hold no data points anymore, squeezing
+  the preallocation just drops them from the list of blocks. The data points themselves aren't
+  moved, so up to one block of preallocation may remain. Squeezing the postallocation releases
+  the unused capacity of the last block.
 */
 template <class DataType>
 void QCPDataContainer<DataType>::squeeze(bool preAllocation, bool postAllocation)
 {
   if (preAllocation)
   {
-    if (mPreallocSize > 0)
+    const int blocks = mPreallocSize>>blockShift;
+    if (blocks > 0)
     {
-      std::copy(begin(), end(), mData.begin());
-      mData.resize(size());
-      mPreallocSize = 0;
+      const int removedPositions = blocks<<blockShift;
+      mBlocks.remove(0, blocks);
+      mPreallocSize -= removedPositions;
+      // level-of-detail buckets are aligned to positions, drop the ones of the removed blocks and move
+      // the positions of the extremes. Levels with buckets larger than a block are rebuilt from the
+      // finer levels by updateLevelOfDetail:
+      int bucketSize = lodBaseSize;
+      for (int level=0; level<mLodLevels.size(); ++level)
+      {
+        if (blockSize % bucketSize != 0)
+        {
+          mLodLevels.resize(level);
+          break;
+        }
+        QVector<LodBucket> &buckets = mLodLevels[level];
+        buckets.remove(0, qMin(int(buckets.size()), removedPositions/bucketSize));
+        for (int i=0; i<buckets.size(); ++i)
+        {
+          if (buckets.at(i).minIndex >= 0)
+            buckets[i].minIndex -= removedPositions;
+          if (buckets.at(i).maxIndex >= 0)
+            buckets[i].maxIndex -= removedPositions;
+        }
+        bucketSize *= lodFanout;
+      }
+      mLodValidSize = qMax(0, mLodValidSize-removedPositions);
     }
-    mPreallocIteration = 0;
   }
   if (postAllocation)
-    mData.squeeze();
+  {
+    mBlocks.last().squeeze();
+    mBlocks.squeeze();
+  }
 }
 
 /*!
@@ -3108,7 +3654,7 @@ typename QCPDataContainer<DataType>::const_iterator QCPDataContainer<DataType>::
     return constEnd();
   
   QCPDataContainer<DataType>::const_iterator it = std::lower_bound(constBegin(), constEnd(), DataType::fromSortKey(sortKey), qcpLessThanSortKey<DataType>);
-  if (expandedRange && it != constBegin()) // also covers it == constEnd case, and we know --constEnd is valid because mData isn't empty
+  if (expandedRange && it != constBegin()) // also covers it == constEnd case, and we know --constEnd is valid because the container isn't empty
     --it;
   return it;
 }
@@ -3278,6 +3824,11 @@ QCPRange QCPDataContainer<DataType>::keyRange(bool &foundRange, QCP::SignDomain
   relevant e.g. for logarithmic plots which can mathematically only display one sign domain at a
   time.
 
+  If the level-of-detail index is enabled (\ref setLevelOfDetailEnabled) and the sort key is the
+  main key, the range is composed of precomputed buckets in logarithmic time. Buckets whose extremes
+  are infinite or lie outside \a signDomain are resolved by descending to their finer buckets, so
+  data that mostly straddles the sign boundary of \a signDomain is still visited point by point.
+
   \see keyRange
 */
 template <class DataType>
@@ -3300,7 +3851,10 @@ QCPRange QCPDataContainer<DataType>::valueRange(bool &foundRange, QCP::SignDomai
     itBegin = findBegin(inKeyRange.lower, false);
     itEnd = findEnd(inKeyRange.upper, false);
   }
-  if (signDomain == QCP::sdBoth) // range may be anywhere
+  if (mLevelOfDetailEnabled && (DataType::sortKeyIsMainKey() || !restrictKeyRange)) // key range is the contiguous index range [itBegin, itEnd), compose it from the level-of-detail index
+  {
+    lodValueRange(int(itBegin-constBegin()), int(itEnd-constBegin()), signDomain, range, haveLower, haveUpper);
+  } else if (signDomain == QCP::sdBoth) // range may be anywhere
   {
     for (QCPDataContainer<DataType>::const_iterator it = itBegin; it != itEnd; ++it)
     {
@@ -3377,11 +3931,158 @@ void QCPDataContainer<DataType>::limitIteratorsToDataRange(const_iterator &begin
   end = constBegin()+iteratorRange.end();
 }
 
+/*!
+  Marks the level-of-detail index as outdated for all data points with index \a fromIndex and
+  above. The container calls this itself whenever data is inserted or removed through its
+  interface. Call it manually after changing data values in-place through the non-const iterators.
+
+  This also increases the \ref version of the container, so plottables using it are redrawn even
+  if the level-of-detail index is disabled.
+
+  \see setLevelOfDetailEnabled
+*/
+template <class DataType>
+void QCPDataContainer<DataType>::invalidateLevelOfDetail(int fromIndex)
+{
+  const int position = qMax(0, fromIndex)+mPreallocSize;
+  if (position < mLodValidSize)
+    mLodValidSize = position;
+  ++mVersion;
+}
+
+/*!
+  Returns the minimum and maximum value (see the \a valueRange requirement of the DataType) of the
+  data points with indices from \a beginIndex up to but excluding \a endIndex, together with the
+  indices of the data points they were found at. NaN values are ignored.
+
+  If the level-of-detail index is enabled (\ref setLevelOfDetailEnabled), the range is composed of
+  the largest precomputed buckets that fit inside it, so the cost grows only logarithmically with
+  the length of the range. Otherwise all data points in the range are visited.
+*/
+template <class DataType>
+typename QCPDataContainer<DataType>::LodBucket QCPDataContainer<DataType>::valueExtremes(int beginIndex, int endIndex) const
+{
+  LodBucket result;
+  result.minValue = (std::numeric_limits<double>::max)();
+  result.maxValue = -(std::numeric_limits<double>::max)();
+  result.minIndex = -1;
+  result.maxIndex = -1;
+  beginIndex = qMax(0, beginIndex)+mPreallocSize; // bucket boundaries are positions in mBlocks
+  endIndex = qMin(size(), endIndex)+mPreallocSize;
+  if (mLevelOfDetailEnabled)
+    updateLevelOfDetail();
+  
+  int i = beginIndex;
+  while (i < endIndex)
+  {
+    // find the coarsest bucket that starts at i and ends inside the range:
+    int level = -1;
+    int bucketSize = lodBaseSize;
+    while (mLevelOfDetailEnabled && level+1 < mLodLevels.size() && i % bucketSize == 0 && i+bucketSize <= endIndex)
+    {
+      ++level;
+      bucketSize *= lodFanout;
+    }
+    if (level >= 0)
+    {
+      bucketSize /= lodFanout;
+      mergeLodBucket(result, mLodLevels.at(level).at(i/bucketSize));
+      i += bucketSize;
+    } else
+    {
+      const QCPRange range = positionIterator(i)->valueRange();
+      if (!qIsNaN(range.lower) && range.lower < result.minValue)
+      {
+        result.minValue = range.lower;
+        result.minIndex = i;
+      }
+      if (!qIsNaN(range.upper) && range.upper > result.maxValue)
+      {
+        result.maxValue = range.upper;
+        result.maxIndex = i;
+      }
+      ++i;
+    }
+  }
+  if (result.minIndex >= 0)
+    result.minIndex -= mPreallocSize;
+  if (result.maxIndex >= 0)
+    result.maxIndex -= mPreallocSize;
+  return result;
+}
+
 /*! \internal
   
-  Increases the preallocation pool to have a size of at least \a minimumPreallocSize. Depending on
-  the preallocation history, the container will grow by more than requested, to speed up future
-  consecutive size increases.
+  Appends the data points from \a first up to \a last to the end of the storage, without sorting.
+  Only the last block grows, and a new block is started whenever it is full. The capacity of a
+  block grows by doubling up to \ref blockSize data points, so small containers don't occupy a full
+  block.
+*/
+template <class DataType>
+template <class InputIterator>
+void QCPDataContainer<DataType>::appendData(InputIterator first, InputIterator last)
+{
+  while (first != last)
+  {
+    QVector<DataType> &block = mBlocks.last();
+    const int oldSize = int(block.size());
+    const int count = int(qMin<qptrdiff>(last-first, blockSize-oldSize));
+    if (block.capacity() < oldSize+count)
+      block.reserve(qMin(int(blockSize), qMax(2*oldSize, oldSize+count)));
+    block.resize(oldSize+count);
+    std::copy(first, first+count, block.begin()+oldSize);
+    first += count;
+    if (oldSize+count == blockSize) // keep the last block partially filled, so the end iterator has a block to point into
+      mBlocks.append(QVector<DataType>());
+  }
+}
+
+/*! \internal
+  
+  Removes all positions from \a position on, i.e. the data points behind it. Blocks completely
+  behind \a position are freed, the capacity of the new last block is kept as postallocation.
+*/
+template <class DataType>
+void QCPDataContainer<DataType>::truncate(int position)
+{
+  mBlocks.resize((position>>blockShift)+1);
+  mBlocks.last().resize(position&(blockSize-1));
+}
+
+/*! \internal
+  
+  Allocates the blocks of the preallocation from \a position up to the first data point, so data
+  points can be prepended there. \a position must not be smaller than zero, see \ref
+  preallocateGrow.
+*/
+template <class DataType>
+void QCPDataContainer<DataType>::allocateBlocks(int position)
+{
+  for (int b=position>>blockShift; b<=(mPreallocSize-1)>>blockShift; ++b)
+  {
+    if (mBlocks.at(b).isEmpty())
+      mBlocks[b].resize(blockSize);
+  }
+}
+
+/*! \internal
+  
+  Frees the blocks that lie completely in the preallocation, i.e. before the first data point. They
+  stay in the list of blocks as empty vectors, so the positions of the data points don't change,
+  until \ref squeeze drops them.
+*/
+template <class DataType>
+void QCPDataContainer<DataType>::releaseBlocks()
+{
+  for (int b=(mPreallocSize>>blockShift)-1; b>=0 && !mBlocks.at(b).isEmpty(); --b) // blocks before an already freed one are freed, too
+    mBlocks[b] = QVector<DataType>();
+}
+
+/*! \internal
+  
+  Increases the preallocation pool to have a size of at least \a minimumPreallocSize, by inserting
+  empty blocks in front of the existing ones. The new blocks are only allocated when data points
+  are prepended to them, see \ref allocateBlocks.
   
   if \a minimumPreallocSize is smaller than or equal to the current preallocation pool size, this
   method does nothing.
@@ -3392,50 +4093,245 @@ void QCPDataContainer<DataType>::preallocateGrow(int minimumPreallocSize)
   if (minimumPreallocSize <= mPreallocSize)
     return;
   
-  int newPreallocSize = minimumPreallocSize;
-  newPreallocSize += (1u<<qBound(4, mPreallocIteration+4, 15)) - 12; // do 4 up to 32768-12 preallocation, doubling in each intermediate iteration
-  ++mPreallocIteration;
-  
-  int sizeDifference = newPreallocSize-mPreallocSize;
-  mData.resize(mData.size()+sizeDifference);
-  std::copy_backward(mData.begin()+mPreallocSize, mData.end()-sizeDifference, mData.end());
-  mPreallocSize = newPreallocSize;
+  const int blocks = (minimumPreallocSize-mPreallocSize+blockSize-1)>>blockShift;
+  mBlocks.insert(0, blocks, QVector<DataType>());
+  mPreallocSize += blocks<<blockShift;
+  mLodValidSize = 0; // all positions moved, level-of-detail buckets no longer match
 }
 
 /*! \internal
   
-  This method decides, depending on the total allocation size and the size of the unused pre- and
-  postallocation pools, whether it is sensible to reduce the pools in order to free up unused
-  memory. It then possibly calls \ref squeeze to do the deallocation.
+  This method decides, depending on the number of freed blocks in the preallocation and the unused
+  capacity of the last block, whether it is sensible to call \ref squeeze.
   
   If \ref setAutoSqueeze is enabled, this method is called automatically each time data points are
   removed from the container (e.g. \ref remove).
   
-  \note when changing the decision parameters, care must be taken not to cause a back-and-forth
-  between squeezing and reallocation due to the growth strategy of the internal QVector and \ref
-  preallocateGrow. The hysteresis between allocation and deallocation should be made high enough
-  (at the expense of possibly larger unused memory from time to time).
+  The freed blocks before the first data point only occupy an entry in the list of blocks each,
+  but they keep the positions of the data points growing when data is continuously appended and
+  removed with \ref removeBefore. They are dropped once they outnumber the blocks holding data.
 */
 template <class DataType>
 void QCPDataContainer<DataType>::performAutoSqueeze()
 {
-  const int totalAlloc = mData.capacity();
-  const int postAllocSize = totalAlloc-mData.size();
-  const int usedSize = size();
-  bool shrinkPostAllocation = false;
-  bool shrinkPreAllocation = false;
-  if (totalAlloc > 650000) // if allocation is larger, shrink earlier with respect to total used size
+  const int freedBlocks = mPreallocSize>>blockShift;
+  const bool shrinkPreAllocation = freedBlocks > 0 && freedBlocks >= mBlocks.size()-freedBlocks;
+  const int lastBlockCapacity = int(mBlocks.last().capacity());
+  const int lastBlockSize = int(mBlocks.last().size());
+  const bool shrinkPostAllocation = lastBlockCapacity > 1000 && lastBlockCapacity-lastBlockSize > lastBlockSize*5; // below 1k points don't even bother
+  
+  if (shrinkPreAllocation || shrinkPostAllocation)
+    squeeze(shrinkPreAllocation, shrinkPostAllocation);
+}
+
+/*! \internal
+
+  Brings the level-of-detail index up to date. Buckets covering data points below the valid size
+  (see \ref invalidateLevelOfDetail) are kept, so after appending data only the last bucket of each
+  level and the new buckets are computed.
+
+  The buckets span all positions of \a mBlocks, including the preallocation. Buckets reaching into
+  the preallocation hold stale values (or none, if their block was freed), but queries only use
+  buckets that lie completely inside the requested range. Coarser levels dropped by \ref squeeze
+  are rebuilt completely from the finer levels.
+*/
+template <class DataType>
+void QCPDataContainer<DataType>::updateLevelOfDetail() const
+{
+  const int n = endPosition();
+  if (mLodValidSize == n && !mLodLevels.isEmpty() && mLodLevels.last().size() <= lodFanout)
+    return;
+  
+  LodBucket empty;
+  empty.minValue = (std::numeric_limits<double>::max)();
+  empty.maxValue = -(std::numeric_limits<double>::max)();
+  empty.minIndex = -1;
+  empty.maxIndex = -1;
+  
+  // finest level, aggregates data points:
+  if (mLodLevels.isEmpty())
+    mLodLevels.resize(1);
+  QVector<LodBucket> &baseLevel = mLodLevels[0];
+  int firstBucket = mLodValidSize/lodBaseSize; // partially filled bucket of the previous update is recomputed
+  const int firstAllocatedBucket = ((mPreallocSize>>blockShift)<<blockShift)/lodBaseSize; // buckets before it lie in freed blocks
+  baseLevel.resize((n+lodBaseSize-1)/lodBaseSize);
+  for (int b=firstBucket; b<baseLevel.size(); ++b)
   {
-    shrinkPostAllocation = postAllocSize > usedSize*1.5; // QVector grow strategy is 2^n for static data. Watch out not to oscillate!
-    shrinkPreAllocation = mPreallocSize*10 > usedSize;
-  } else if (totalAlloc > 1000) // below 10 MiB raw data be generous with preallocated memory, below 1k points don't even bother
+    LodBucket bucket = empty;
+    const int end = b < firstAllocatedBucket ? 0 : qMin(n, (b+1)*lodBaseSize);
+    const_iterator data = positionIterator(b*lodBaseSize);
+    for (int i=b*lodBaseSize; i<end; ++i, ++data)
+    {
+      const QCPRange range = data->valueRange();
+      if (!qIsNaN(range.lower) && range.lower < bucket.minValue)
+      {
+        bucket.minValue = range.lower;
+        bucket.minIndex = i;
+      }
+      if (!qIsNaN(range.upper) && range.upper > bucket.maxValue)
+      {
+        bucket.maxValue = range.upper;
+        bucket.maxIndex = i;
+      }
+    }
+    baseLevel[b] = bucket;
+  }
+  
+  // coarser levels, aggregate lodFanout buckets of the level below, until one bucket covers everything:
+  int level = 1;
+  while (mLodLevels.at(level-1).size() > lodFanout)
   {
-    shrinkPostAllocation = postAllocSize > usedSize*5;
-    shrinkPreAllocation = mPreallocSize > usedSize*1.5; // preallocation can grow into postallocation, so can be smaller
+    firstBucket /= lodFanout;
+    if (mLodLevels.size() <= level)
+    {
+      mLodLevels.resize(level+1);
+      firstBucket = 0; // new level, compute all of its buckets
+    }
+    const QVector<LodBucket> &finer = mLodLevels.at(level-1);
+    QVector<LodBucket> &coarser = mLodLevels[level];
+    coarser.resize((finer.size()+lodFanout-1)/lodFanout);
+    for (int b=firstBucket; b<coarser.size(); ++b)
+    {
+      LodBucket bucket = empty;
+      const int end = qMin(finer.size(), (b+1)*lodFanout);
+      for (int i=b*lodFanout; i<end; ++i)
+        mergeLodBucket(bucket, finer.at(i));
+      coarser[b] = bucket;
+    }
+    ++level;
   }
+  mLodLevels.resize(level);
+  mLodValidSize = n;
+}
+
+/*! \internal
+
+  Extends \a range by the value range of the data points with indices from \a beginIndex up to
+  but excluding \a endIndex, with the same rules as \ref valueRange. The index range is composed
+  of the largest level-of-detail buckets that fit inside it, like in \ref valueExtremes, and each
+  bucket is resolved by \ref lodBucketValueRange.
+*/
+template <class DataType>
+void QCPDataContainer<DataType>::lodValueRange(int beginIndex, int endIndex, QCP::SignDomain signDomain, QCPRange &range, bool &haveLower, bool &haveUpper) const
+{
+  beginIndex = qMax(0, beginIndex)+mPreallocSize;
+  endIndex = qMin(size(), endIndex)+mPreallocSize;
+  updateLevelOfDetail();
   
-  if (shrinkPreAllocation || shrinkPostAllocation)
-    squeeze(shrinkPreAllocation, shrinkPostAllocation);
+  int i = beginIndex;
+  while (i < endIndex)
+  {
+    // find the coarsest bucket that starts at i and ends inside the range:
+    int level = -1;
+    int bucketSize = lodBaseSize;
+    while (level+1 < mLodLevels.size() && i % bucketSize == 0 && i+bucketSize <= endIndex)
+    {
+      ++level;
+      bucketSize *= lodFanout;
+    }
+    if (level >= 0)
+    {
+      bucketSize /= lodFanout;
+      lodBucketValueRange(level, i/bucketSize, signDomain, true, true, range, haveLower, haveUpper);
+      i += bucketSize;
+    } else
+    {
+      const QCPRange current = positionIterator(i)->valueRange();
+      extendValueRange(current.lower, current.upper, signDomain, range, haveLower, haveUpper);
+      ++i;
+    }
+  }
+}
+
+/*! \internal
+
+  Extends the lower (if \a lower is true) and/or upper (if \a upper is true) bound of \a range by
+  the data points of the bucket \a bucketIndex of level-of-detail level \a level.
+
+  The bucket's minimum directly is the lower bound of its data points if it is finite and inside
+  \a signDomain. If it is outside of \a signDomain with no chance of other points being inside
+  (e.g. a minimum of zero or above for \ref QCP::sdNegative), the bucket doesn't contribute to the
+  lower bound. Otherwise, e.g. for a minimum of -Inf, the finer buckets (or the data points of the
+  finest level) are consulted. The upper bound is handled accordingly.
+*/
+template <class DataType>
+void QCPDataContainer<DataType>::lodBucketValueRange(int level, int bucketIndex, QCP::SignDomain signDomain, bool lower, bool upper, QCPRange &range, bool &haveLower, bool &haveUpper) const
+{
+  const LodBucket &bucket = mLodLevels.at(level).at(bucketIndex);
+  bool descendLower = false;
+  bool descendUpper = false;
+  if (lower && bucket.minIndex >= 0 && bucket.minValue < std::numeric_limits<double>::infinity() && !(signDomain == QCP::sdNegative && bucket.minValue >= 0))
+  {
+    if (std::isfinite(bucket.minValue) && (signDomain != QCP::sdPositive || bucket.minValue > 0))
+      extendValueRange(bucket.minValue, qQNaN(), signDomain, range, haveLower, haveUpper);
+    else
+      descendLower = true;
+  }
+  if (upper && bucket.maxIndex >= 0 && bucket.maxValue > -std::numeric_limits<double>::infinity() && !(signDomain == QCP::sdPositive && bucket.maxValue <= 0))
+  {
+    if (std::isfinite(bucket.maxValue) && (signDomain != QCP::sdNegative || bucket.maxValue < 0))
+      extendValueRange(qQNaN(), bucket.maxValue, signDomain, range, haveLower, haveUpper);
+    else
+      descendUpper = true;
+  }
+  if (!descendLower && !descendUpper)
+    return;
+  
+  if (level > 0)
+  {
+    const int end = qMin(mLodLevels.at(level-1).size(), (bucketIndex+1)*lodFanout);
+    for (int i=bucketIndex*lodFanout; i<end; ++i)
+      lodBucketValueRange(level-1, i, signDomain, descendLower, descendUpper, range, haveLower, haveUpper);
+  } else
+  {
+    const int end = qMin(endPosition(), (bucketIndex+1)*lodBaseSize);
+    const_iterator data = positionIterator(bucketIndex*lodBaseSize);
+    for (int i=bucketIndex*lodBaseSize; i<end; ++i, ++data)
+    {
+      const QCPRange current = data->valueRange();
+      extendValueRange(descendLower ? current.lower : qQNaN(), descendUpper ? current.upper : qQNaN(), signDomain, range, haveLower, haveUpper);
+    }
+  }
+}
+
+/*! \internal
+
+  Extends \a range to include \a lower and \a upper, following the rules of \ref valueRange: NaN
+  and infinite values as well as values outside of \a signDomain are ignored. \a haveLower and \a
+  haveUpper are set once the respective bound was assigned a value.
+*/
+template <class DataType>
+void QCPDataContainer<DataType>::extendValueRange(double lower, double upper, QCP::SignDomain signDomain, QCPRange &range, bool &haveLower, bool &haveUpper)
+{
+  if ((lower < range.lower || !haveLower) && !qIsNaN(lower) && std::isfinite(lower) && (signDomain == QCP::sdBoth || (signDomain == QCP::sdNegative ? lower < 0 : lower > 0)))
+  {
+    range.lower = lower;
+    haveLower = true;
+  }
+  if ((upper > range.upper || !haveUpper) && !qIsNaN(upper) && std::isfinite(upper) && (signDomain == QCP::sdBoth || (signDomain == QCP::sdNegative ? upper < 0 : upper > 0)))
+  {
+    range.upper = upper;
+    haveUpper = true;
+  }
+}
+
+/*! \internal
+
+  Merges \a source into \a target, keeping the indices of the extreme values.
+*/
+template <class DataType>
+void QCPDataContainer<DataType>::mergeLodBucket(LodBucket &target, const LodBucket &source)
+{
+  if (source.minIndex >= 0 && source.minValue < target.minValue)
+  {
+    target.minValue = source.minValue;
+    target.minIndex = source.minIndex;
+  }
+  if (source.maxIndex >= 0 && source.maxValue > target.maxValue)
+  {
+    target.maxValue = source.maxValue;
+    target.maxIndex = source.maxIndex;
+  }
 }
 
 
@@ -3541,6 +4437,10 @@ public:
   virtual QCPPlottableInterface1D *interface1D() { return nullptr; }
   virtual QCPRange getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain=QCP::sdBoth) const = 0;
   virtual QCPRange getValueRange(bool &foundRange, QCP::SignDomain inSignDomain=QCP::sdBoth, const QCPRange &inKeyRange=QCPRange()) const = 0;
+  virtual quint64 dataVersion() const { return 0; }
+  
+  // reimplemented virtual methods:
+  virtual quint64 contentVersion() const Q_DECL_OVERRIDE;
   
   // non-property methods:
   void coordsToPixels(double key, double value, double &x, double &y) const;
@@ -3737,6 +4637,7 @@ public:
   
   // reimplemented virtual methods:
   virtual double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details=nullptr) const Q_DECL_OVERRIDE = 0;
+  virtual quint64 contentVersion() const Q_DECL_OVERRIDE;
   
   // non-virtual methods:
   QList<QCPItemPosition*> positions() const { return mPositions; }
@@ -3801,6 +4702,7 @@ class QCP_LIB_DECL QCustomPlot : public QWidget
   Q_PROPERTY(bool noAntialiasingOnDrag READ noAntialiasingOnDrag WRITE setNoAntialiasingOnDrag)
   Q_PROPERTY(Qt::KeyboardModifier multiSelectModifier READ multiSelectModifier WRITE setMultiSelectModifier)
   Q_PROPERTY(bool openGl READ openGl WRITE setOpenGl)
+  Q_PROPERTY(bool asyncReplot READ asyncReplot WRITE setAsyncReplot)
   /// \endcond
 public:
   /*!
@@ -3846,6 +4748,7 @@ public:
   QCP::SelectionRectMode selectionRectMode() const { return mSelectionRectMode; }
   QCPSelectionRect *selectionRect() const { return mSelectionRect; }
   bool openGl() const { return mOpenGl; }
+  bool asyncReplot() const { return mAsyncReplot; }
   
   // setters:
   void setViewport(const QRect &rect);
@@ -3870,6 +4773,7 @@ public:
   void setSelectionRectMode(QCP::SelectionRectMode mode);
   void setSelectionRect(QCPSelectionRect *selectionRect);
   void setOpenGl(bool enabled, int multisampling=16);
+  void setAsyncReplot(bool enabled);
   
   // non-property methods:
   // plottable interface:
@@ -3940,6 +4844,9 @@ public:
   void toPainter(QCPPainter *painter, int width=0, int height=0);
   Q_SLOT void replot(QCustomPlot::RefreshPriority refreshPriority=QCustomPlot::rpRefreshHint);
   double replotTime(bool average=false) const;
+  double replotWorkerTime(bool average=false) const;
+  bool isRendering() const { return !mAsyncFrame.isNull(); }
+  QCPReplotProfiler *profiler() const { return mProfiler; }
   
   QCPAxis *xAxis, *yAxis, *xAxis2, *yAxis2;
   QCPLegend *legend;
@@ -3964,6 +4871,7 @@ signals:
   void beforeReplot();
   void afterLayout();
   void afterReplot();
+  void asyncReplotFinished();
   
 protected:
   // property members:
@@ -3990,6 +4898,7 @@ protected:
   QCP::SelectionRectMode mSelectionRectMode;
   QCPSelectionRect *mSelectionRect;
   bool mOpenGl;
+  bool mAsyncReplot;
   
   // non-property members:
   QList<QSharedPointer<QCPAbstractPaintBuffer> > mPaintBuffers;
@@ -4002,6 +4911,12 @@ protected:
   bool mReplotting;
   bool mReplotQueued;
   double mReplotTime, mReplotTimeAverage;
+  double mReplotWorkerTime, mReplotWorkerTimeAverage;
+  QCPReplotProfiler *mProfiler;
+  QSharedPointer<QCPAsyncReplotFrame> mAsyncFrame;
+  QVector<QImage> mAsyncSpareImages;
+  QVector<QRect> mDrawnLayoutRects;
+  bool mAsyncReplotPending;
   int mOpenGlMultisamples;
   QCP::AntialiasedElements mOpenGlAntialiasedElementsBackup;
   bool mOpenGlCacheLabelsBackup;
@@ -4042,8 +4957,11 @@ protected:
   void setupPaintBuffers();
   QCPAbstractPaintBuffer *createPaintBuffer();
   bool hasInvalidatedPaintBuffers();
+  QVector<bool> dirtyPaintBuffers();
   bool setupOpenGl();
   void freeOpenGl();
+  void startAsyncReplot(RefreshPriority refreshPriority);
+  Q_SLOT void finishAsyncReplot();
   
   friend class QCPLegend;
   friend class QCPAxis;
@@ -4157,6 +5075,45 @@ ItemType *QCustomPlot::itemAt(const QPointF &pos, bool onlySelectable) const
 /* including file 'src/plottable1d.h'       */
 /* modified 2022-11-06T12:45:56, size 25638 */
 
+class QCP_LIB_DECL QCPDataPixelIndex
+{
+public:
+  QCPDataPixelIndex();
+  
+  // getters:
+  bool isValid() const { return mValid; }
+  double cellSize() const { return mCellSize; }
+  double segmentThreshold() const { return 2*mCellSize; }
+  const QVector<int> &longSegments() const { return mLongSegments; }
+  
+  // non-property methods:
+  bool isUpToDate(quint64 dataVersion, const QCPAxis *keyAxis, const QCPAxis *valueAxis) const;
+  void clear();
+  void beginBuild(quint64 dataVersion, const QCPAxis *keyAxis, const QCPAxis *valueAxis, int dataCount);
+  void addPoint(const QPointF &pixel);
+  void endBuild();
+  bool covers(const QRectF &pixelRect) const;
+  void findCandidates(const QRectF &pixelRect, QVector<int> *inside, QVector<int> *border) const;
+  
+  static const int minimumDataCount = 10000;
+  
+protected:
+  // non-property members:
+  bool mValid;
+  quint64 mDataVersion, mKeyAxisVersion, mValueAxisVersion;
+  QRect mKeyAxisRect, mValueAxisRect, mViewport;
+  QRectF mBounds;
+  double mCellSize;
+  int mColumns, mRows;
+  QVector<int> mCellStart; // index into mIndices of the first data point of each cell, one more entry than cells
+  QVector<int> mIndices; // data point indices ordered by cell, ascending within each cell
+  QVector<int> mLongSegments; // segments (i, i+1) that can't be found through their end points in nearby cells
+  // build state:
+  QVector<int> mPointCells;
+  QPointF mLastPixel;
+  bool mLastFinite;
+};
+
 class QCPPlottableInterface1D
 {
 public:
@@ -4198,14 +5155,20 @@ public:
   // reimplemented virtual methods:
   virtual double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details=nullptr) const Q_DECL_OVERRIDE;
   virtual QCPPlottableInterface1D *interface1D() Q_DECL_OVERRIDE { return this; }
+  virtual quint64 dataVersion() const Q_DECL_OVERRIDE { return mDataContainer->version(); }
   
 protected:
   // property members:
   QSharedPointer<QCPDataContainer<DataType> > mDataContainer;
   
+  // non-property members:
+  mutable QCPDataPixelIndex mPixelIndex;
+  
   // helpers for subclasses:
   void getDataSegments(QList<QCPDataRange> &selectedSegments, QList<QCPDataRange> &unselectedSegments) const;
   void drawPolyline(QCPPainter *painter, const QVector<QPointF> &lineData) const;
+  const QCPDataPixelIndex *pixelIndex() const;
+  bool findClosestIndexedPoint(const QPointF &pixelPoint, double maxDistance, int &closestIndex, double &closestDistSqr) const;
 
 private:
   Q_DISABLE_COPY(QCPAbstractPlottable1D)
@@ -4515,6 +5478,9 @@ bool QCPAbstractPlottable1D<DataType>::sortKeyIsMainKey() const
   Implements a rect-selection algorithm assuming the data (accessed via the 1D data interface) is
   point-like. Most subclasses will want to reimplement this method again, to provide a more
   accurate hit test based on the true data visualization geometry.
+  
+  For large data sets, only the data points in the cells of the pixel index (\ref
+  QCPDataPixelIndex) touched by \a rect are tested, see \ref pixelIndex.
 
   \seebaseclassmethod
 */
@@ -4533,6 +5499,37 @@ QCPDataSelection QCPAbstractPlottable1D<DataType>::selectTestRect(const QRectF &
   pixelsToCoords(rect.bottomRight(), key2, value2);
   QCPRange keyRange(key1, key2); // QCPRange normalizes internally so we don't have to care about whether key1 < key2
   QCPRange valueRange(value1, value2);
+  
+  const QCPDataPixelIndex *index = pixelIndex();
+  if (index && index->covers(rect.normalized())) // only test the data points in the index cells touched by rect, cells completely inside rect need no test
+  {
+    QVector<int> inside, border;
+    index->findCandidates(rect.normalized(), &inside, &border);
+    // collect the contained data point indices, cost only depends on the number of candidates:
+    QVector<int> contained = inside;
+    contained.reserve(inside.size()+border.size());
+    for (int i=0; i<border.size(); ++i)
+    {
+      typename QCPDataContainer<DataType>::const_iterator it = mDataContainer->constBegin()+border.at(i);
+      if (valueRange.contains(it->mainValue()) && keyRange.contains(it->mainKey()))
+        contained.append(border.at(i));
+    }
+    std::sort(contained.begin(), contained.end());
+    contained.erase(std::unique(contained.begin(), contained.end()), contained.end());
+    // join consecutive contained data points to segments:
+    int i = 0;
+    while (i < contained.size())
+    {
+      const int segmentBegin = contained.at(i);
+      int segmentEnd = segmentBegin+1;
+      while (++i < contained.size() && contained.at(i) == segmentEnd)
+        ++segmentEnd;
+      result.addDataRange(QCPDataRange(segmentBegin, segmentEnd), false);
+    }
+    result.simplify();
+    return result;
+  }
+  
   typename QCPDataContainer<DataType>::const_iterator begin = mDataContainer->constBegin();
   typename QCPDataContainer<DataType>::const_iterator end = mDataContainer->constEnd();
   if (DataType::sortKeyIsMainKey()) // we can assume that data is sorted by main key, so can reduce the searched key interval:
@@ -4742,6 +5739,93 @@ void QCPAbstractPlottable1D<DataType>::drawPolyline(QCPPainter *painter, const Q
   }
 }
 
+/*! \internal
+  
+  Returns the pixel index of the data points, rebuilding it first if the data or one of the axes
+  changed since it was last built (see \ref QCPDataPixelIndex::isUpToDate). The data points are
+  transformed to pixels in blocks with \ref QCPAxis::coordsToPixels.
+  
+  Returns \c nullptr if the plottable has fewer than \ref QCPDataPixelIndex::minimumDataCount data
+  points, where scanning the data directly is faster than building an index, or if the axes are
+  invalid. Hit tests must then scan the data themselves.
+  
+  The index is built on the first hit test after a change, so plots that are never clicked or
+  hovered don't pay for it.
+  
+  \see findClosestIndexedPoint
+*/
+template <class DataType>
+const QCPDataPixelIndex *QCPAbstractPlottable1D<DataType>::pixelIndex() const
+{
+  QCPAxis *keyAxis = mKeyAxis.data();
+  QCPAxis *valueAxis = mValueAxis.data();
+  if (!keyAxis || !valueAxis || mDataContainer->size() < QCPDataPixelIndex::minimumDataCount)
+    return nullptr;
+  
+  if (!mPixelIndex.isUpToDate(mDataContainer->version(), keyAxis, valueAxis))
+  {
+    mPixelIndex.beginBuild(mDataContainer->version(), keyAxis, valueAxis, mDataContainer->size());
+    const int blockSize = 256;
+    double keyPixels[blockSize];
+    double valuePixels[blockSize];
+    const bool keyVertical = keyAxis->orientation() == Qt::Vertical;
+    typename QCPDataContainer<DataType>::const_iterator it = mDataContainer->constBegin();
+    const typename QCPDataContainer<DataType>::const_iterator itEnd = mDataContainer->constEnd();
+    while (it != itEnd)
+    {
+      const int count = qMin(blockSize, int(itEnd-it));
+      for (int i=0; i<count; ++i)
+      {
+        keyPixels[i] = (it+i)->mainKey();
+        valuePixels[i] = (it+i)->mainValue();
+      }
+      keyAxis->coordsToPixels(keyPixels, keyPixels, count);
+      valueAxis->coordsToPixels(valuePixels, valuePixels, count);
+      for (int i=0; i<count; ++i)
+        mPixelIndex.addPoint(keyVertical ? QPointF(valuePixels[i], keyPixels[i]) : QPointF(keyPixels[i], valuePixels[i]));
+      it += count;
+    }
+    mPixelIndex.endBuild();
+  }
+  return mPixelIndex.isValid() ? &mPixelIndex : nullptr;
+}
+
+/*! \internal
+  
+  Finds the data point closest to \a pixelPoint among the data points at most \a maxDistance
+  pixels away, by only looking at the cells of the pixel index around \a pixelPoint. The index of
+  the found data point is returned in \a closestIndex and its squared pixel distance in \a
+  closestDistSqr. If no data point is that close, \a closestIndex is -1 and \a closestDistSqr is
+  the square of \a maxDistance.
+  
+  Returns false if there is no pixel index (see \ref pixelIndex) or it doesn't cover the search
+  area. The caller must then scan the data itself.
+*/
+template <class DataType>
+bool QCPAbstractPlottable1D<DataType>::findClosestIndexedPoint(const QPointF &pixelPoint, double maxDistance, int &closestIndex, double &closestDistSqr) const
+{
+  const QCPDataPixelIndex *index = pixelIndex();
+  const QRectF searchRect(pixelPoint.x()-maxDistance, pixelPoint.y()-maxDistance, 2*maxDistance, 2*maxDistance);
+  if (!index || !index->covers(searchRect))
+    return false;
+  
+  QVector<int> candidates;
+  index->findCandidates(searchRect, nullptr, &candidates);
+  closestIndex = -1;
+  closestDistSqr = maxDistance*maxDistance;
+  for (int i=0; i<candidates.size(); ++i)
+  {
+    typename QCPDataContainer<DataType>::const_iterator it = mDataContainer->constBegin()+candidates.at(i);
+    const double currentDistSqr = QCPVector2D(coordsToPixels(it->mainKey(), it->mainValue())-pixelPoint).lengthSquared();
+    if (currentDistSqr < closestDistSqr || (currentDistSqr == closestDistSqr && candidates.at(i) < closestIndex))
+    {
+      closestDistSqr = currentDistSqr;
+      closestIndex = candidates.at(i);
+    }
+  }
+  return true;
+}
+
 
 /* end of 'src/plottable1d.h' */
 
@@ -4841,6 +5925,8 @@ protected:
   // non-virtual methods:
   bool stopsUseAlpha() const;
   void updateColorBuffer();
+  int colorizeLinearSimd(const double *data, const QCPRange &range, double posToIndexFactor, QRgb *scanLine, int n, int dataIndexFactor, bool skipNanCheck) const;
+  int colorizeLogarithmicSimd(const double *data, const QCPRange &range, double posToIndexFactor, QRgb *scanLine, int n, int dataIndexFactor, bool skipNanCheck) const;
 };
 Q_DECLARE_METATYPE(QCPColorGradient::ColorInterpolation)
 Q_DECLARE_METATYPE(QCPColorGradient::NanHandling)
@@ -5120,6 +6206,9 @@ public:
   // getters:
   QCPAbstractPlottable *plottable() { return mPlottable; }
   
+  // reimplemented virtual methods:
+  virtual quint64 contentVersion() const Q_DECL_OVERRIDE;
+  
 protected:
   // property members:
   QCPAbstractPlottable *mPlottable;
@@ -5491,6 +6580,43 @@ Q_DECLARE_TYPEINFO(QCPGraphData, Q_PRIMITIVE_TYPE);
 */
 typedef QCPDataContainer<QCPGraphData> QCPGraphDataContainer;
 
+class QCP_LIB_DECL QCPGraphColumnData
+{
+public:
+  QCPGraphColumnData();
+  QCPGraphColumnData(const QVector<double> &keys, const QVector<double> &values);
+  
+  // getters:
+  int size() const { return mSize; }
+  bool isEmpty() const { return mSize == 0; }
+  const double *keys() const { return mKeys; }
+  const double *values() const { return mValues; }
+  bool isRawData() const { return mKeyVector.isEmpty() && mSize > 0; }
+  quint64 version() const { return mVersion; }
+  
+  // setters:
+  void setData(const QVector<double> &keys, const QVector<double> &values);
+  void setRawData(const double *keys, const double *values, int size);
+  
+  // non-property methods:
+  void clear();
+  void markModified() { ++mVersion; }
+  int findBegin(double key, bool expandedRange=true) const;
+  int findEnd(double key, bool expandedRange=true) const;
+  QCPRange keyRange(bool &foundRange, QCP::SignDomain signDomain=QCP::sdBoth) const;
+  QCPRange valueRange(bool &foundRange, QCP::SignDomain signDomain=QCP::sdBoth, const QCPRange &inKeyRange=QCPRange()) const;
+  
+protected:
+  // non-property members:
+  QVector<double> mKeyVector, mValueVector; // shared with the caller of setData, empty for raw data
+  const double *mKeys, *mValues;
+  int mSize;
+  quint64 mVersion;
+  
+private:
+  Q_DISABLE_COPY(QCPGraphColumnData)
+};
+
 class QCP_LIB_DECL QCPGraph : public QCPAbstractPlottable1D<QCPGraphData>
 {
   Q_OBJECT
@@ -5527,10 +6653,12 @@ public:
   int scatterSkip() const { return mScatterSkip; }
   QCPGraph *channelFillGraph() const { return mChannelFillGraph.data(); }
   bool adaptiveSampling() const { return mAdaptiveSampling; }
+  QSharedPointer<QCPGraphColumnData> columnData() const { return mColumnData; }
   
   // setters:
   void setData(QSharedPointer<QCPGraphDataContainer> data);
   void setData(const QVector<double> &keys, const QVector<double> &values, bool alreadySorted=false);
+  void setColumnData(QSharedPointer<QCPGraphColumnData> columnData);
   void setLineStyle(LineStyle ls);
   void setScatterStyle(const QCPScatterStyle &style);
   void setScatterSkip(int skip);
@@ -5541,10 +6669,22 @@ public:
   void addData(const QVector<double> &keys, const QVector<double> &values, bool alreadySorted=false);
   void addData(double key, double value);
   
+  // virtual methods of 1d plottable interface:
+  virtual int dataCount() const Q_DECL_OVERRIDE;
+  virtual double dataMainKey(int index) const Q_DECL_OVERRIDE;
+  virtual double dataSortKey(int index) const Q_DECL_OVERRIDE;
+  virtual double dataMainValue(int index) const Q_DECL_OVERRIDE;
+  virtual QCPRange dataValueRange(int index) const Q_DECL_OVERRIDE;
+  virtual QPointF dataPixelPosition(int index) const Q_DECL_OVERRIDE;
+  virtual QCPDataSelection selectTestRect(const QRectF &rect, bool onlySelectable) const Q_DECL_OVERRIDE;
+  virtual int findBegin(double sortKey, bool expandedRange=true) const Q_DECL_OVERRIDE;
+  virtual int findEnd(double sortKey, bool expandedRange=true) const Q_DECL_OVERRIDE;
+  
   // reimplemented virtual methods:
   virtual double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details=nullptr) const Q_DECL_OVERRIDE;
   virtual QCPRange getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain=QCP::sdBoth) const Q_DECL_OVERRIDE;
   virtual QCPRange getValueRange(bool &foundRange, QCP::SignDomain inSignDomain=QCP::sdBoth, const QCPRange &inKeyRange=QCPRange()) const Q_DECL_OVERRIDE;
+  virtual quint64 dataVersion() const Q_DECL_OVERRIDE;
   
 protected:
   // property members:
@@ -5553,6 +6693,24 @@ protected:
   int mScatterSkip;
   QPointer<QCPGraph> mChannelFillGraph;
   bool mAdaptiveSampling;
+  QSharedPointer<QCPGraphColumnData> mColumnData;
+  
+  // non-property members:
+  /*!
+    Line pixel points of a data range, as returned by \ref getCachedLines, together with the fill
+    polygons built from them by \ref drawFill. \a fillVersion identifies the channel fill graph
+    state the polygons were built with.
+  */
+  struct LineCache
+  {
+    QCPDataRange dataRange;
+    QVector<QPointF> lines;
+    bool fillValid;
+    quint64 fillVersion;
+    QVector<QPolygonF> fillPolygons;
+  };
+  mutable QVector<LineCache> mLineCache;
+  mutable quint64 mLineCacheVersion;
   
   // reimplemented virtual methods:
   virtual void draw(QCPPainter *painter) Q_DECL_OVERRIDE;
@@ -5568,9 +6726,17 @@ protected:
   virtual void getOptimizedScatterData(QVector<QCPGraphData> *scatterData, QCPGraphDataContainer::const_iterator begin, QCPGraphDataContainer::const_iterator end) const;
   
   // non-virtual methods:
+  void getLevelOfDetailLineData(QVector<QCPGraphData> *lineData, const QCPGraphDataContainer::const_iterator &begin, const QCPGraphDataContainer::const_iterator &end) const;
+  void getLevelOfDetailScatterData(QVector<QCPGraphData> *scatterData, const QCPGraphDataContainer::const_iterator &begin, const QCPGraphDataContainer::const_iterator &end) const;
   void getVisibleDataBounds(QCPGraphDataContainer::const_iterator &begin, QCPGraphDataContainer::const_iterator &end, const QCPDataRange &rangeRestriction) const;
   void getLines(QVector<QPointF> *lines, const QCPDataRange &dataRange) const;
+  QVector<QPointF> getCachedLines(const QCPDataRange &dataRange) const;
+  quint64 lineCacheVersion() const;
   void getScatters(QVector<QPointF> *scatters, const QCPDataRange &dataRange) const;
+  void getVisibleColumnBounds(int &begin, int &end, const QCPDataRange &rangeRestriction) const;
+  bool getColumnPixels(QVector<QPointF> *pixels, const QCPDataRange &dataRange) const;
+  void getOptimizedColumnData(QVector<QCPGraphData> *data, const QCPDataRange &dataRange, int modulo) const;
+  double columnPointDistance(const QPointF &pixelPoint) const;
   QVector<QPointF> dataToLines(const QVector<QCPGraphData> &data) const;
   QVector<QPointF> dataToStepLeftLines(const QVector<QCPGraphData> &data) const;
   QVector<QPointF> dataToStepRightLines(const QVector<QCPGraphData> &data) const;
@@ -5582,6 +6748,7 @@ protected:
   QPointF getFillBasePoint(QPointF matchingDataPoint) const;
   const QPolygonF getFillPolygon(const QVector<QPointF> *lineData, QCPDataRange segment) const;
   const QPolygonF getChannelFillPolygon(const QVector<QPointF> *thisData, QCPDataRange thisSegment, const QVector<QPointF> *otherData, QCPDataRange otherSegment) const;
+  QVector<QPolygonF> getFillPolygons(const QVector<QPointF> *lines) const;
   int findIndexBelowX(const QVector<QPointF> *data, double x) const;
   int findIndexAboveX(const QVector<QPointF> *data, double x) const;
   int findIndexBelowY(const QVector<QPointF> *data, double y) const;
@@ -5593,6 +6760,55 @@ protected:
 };
 Q_DECLARE_METATYPE(QCPGraph::LineStyle)
 
+#if QT_VERSION >= QT_VERSION_CHECK(5, 3, 0)
+class QCP_LIB_DECL QCPGraphDataStream : public QObject
+{
+  Q_OBJECT
+public:
+  explicit QCPGraphDataStream(QCPGraph *graph, int capacity=262144);
+  virtual ~QCPGraphDataStream() Q_DECL_OVERRIDE;
+  
+  // getters:
+  QCPGraph *graph() const { return mGraph.data(); }
+  int capacity() const { return mCapacity; }
+  double retentionWindow() const { return mRetentionWindow; }
+  int pendingCount() const;
+  quint32 droppedCount() const { return mDroppedCount.loadAcquire(); }
+  
+  // setters:
+  void setRetentionWindow(double keySpan);
+  
+  // non-property methods (producer thread):
+  bool push(double key, double value);
+  int push(const QCPGraphData *data, int count);
+  
+public Q_SLOTS:
+  // consumer (GUI) thread:
+  int drain();
+  
+protected:
+  // property members:
+  QPointer<QCPGraph> mGraph;
+  int mCapacity;
+  double mRetentionWindow;
+  
+  // non-property members:
+  QCPGraphData *mBuffer;
+  quint32 mMask;
+  // written by the producer only:
+  QAtomicInteger<quint32> mHead;
+  quint32 mCachedTail;
+  QAtomicInteger<quint32> mDroppedCount;
+  char mProducerPadding[64]; // keeps producer and consumer counters on separate cache lines
+  // written by the consumer only:
+  QAtomicInteger<quint32> mTail;
+  QVector<QCPGraphData> mDrainBuffer;
+  
+private:
+  Q_DISABLE_COPY(QCPGraphDataStream)
+};
+#endif
+
 /* end of 'src/plottables/plottable-graph.h' */
 
 
@@ -5702,6 +6918,7 @@ protected:
   bool getTraverse(double prevKey, double prevValue, double key, double value, double keyMin, double valueMax, double keyMax, double valueMin, QPointF &crossA, QPointF &crossB) const;
   void getTraverseCornerPoints(int prevRegion, int currentRegion, double keyMin, double valueMax, double keyMax, double valueMin, QVector<QPointF> &beforeTraverse, QVector<QPointF> &afterTraverse) const;
   double pointDistance(const QPointF &pixelPoint, QCPCurveDataContainer::const_iterator &closestData) const;
+  bool indexedLineDistance(const QPointF &pixelPoint, double maxDistance, double &minDistSqr) const;
   
   friend class QCustomPlot;
   friend class QCPLegend;
@@ -6069,8 +7286,13 @@ protected:
   unsigned char *mAlpha;
   QCPRange mDataBounds;
   bool mDataModified;
+  bool mCellsModified;
+  QVector<bool> mModifiedValueRows, mModifiedKeyColumns;
+  quint64 mVersion;
   
   bool createAlpha(bool initializeOpaque=true);
+  void markCellModified(int keyIndex, int valueIndex);
+  void clearModified();
   
   friend class QCPColorMap;
 };
@@ -6117,6 +7339,7 @@ public:
   virtual double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details=nullptr) const Q_DECL_OVERRIDE;
   virtual QCPRange getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain=QCP::sdBoth) const Q_DECL_OVERRIDE;
   virtual QCPRange getValueRange(bool &foundRange, QCP::SignDomain inSignDomain=QCP::sdBoth, const QCPRange &inKeyRange=QCPRange()) const Q_DECL_OVERRIDE;
+  virtual quint64 dataVersion() const Q_DECL_OVERRIDE;
   
 signals:
   void dataRangeChanged(const QCPRange &newRange);
@@ -6186,6 +7409,41 @@ Q_DECLARE_TYPEINFO(QCPFinancialData, Q_PRIMITIVE_TYPE);
 */
 typedef QCPDataContainer<QCPFinancialData> QCPFinancialDataContainer;
 
+class QCP_LIB_DECL QCPFinancialAggregator
+{
+public:
+  QCPFinancialAggregator();
+  explicit QCPFinancialAggregator(const QVector<double> &timeframes, double timeframeOffset=0);
+  
+  // getters:
+  QVector<double> timeframes() const { return mTimeframes; }
+  double timeframeOffset() const { return mTimeframeOffset; }
+  double minimumCandleWidth() const { return mMinimumCandleWidth; }
+  QSharedPointer<QCPFinancialDataContainer> data(int timeframeIndex) const;
+  
+  // setters:
+  void setMinimumCandleWidth(double pixels);
+  
+  // non-property methods:
+  void addTick(double time, double value);
+  void addTicks(const QVector<double> &time, const QVector<double> &value);
+  void clear();
+  int timeframeIndex(const QCPRange &keyRange, double pixelLength) const;
+  
+protected:
+  // property members:
+  QVector<double> mTimeframes;
+  double mTimeframeOffset;
+  double mMinimumCandleWidth;
+  
+  // non-property members:
+  QVector<QSharedPointer<QCPFinancialDataContainer> > mData; // one container per timeframe
+  double mLastTickTime;
+  
+private:
+  Q_DISABLE_COPY(QCPFinancialAggregator)
+};
+
 class QCP_LIB_DECL QCPFinancial : public QCPAbstractPlottable1D<QCPFinancialData>
 {
   Q_OBJECT
@@ -6235,6 +7493,8 @@ public:
   QBrush brushNegative() const { return mBrushNegative; }
   QPen penPositive() const { return mPenPositive; }
   QPen penNegative() const { return mPenNegative; }
+  QSharedPointer<QCPFinancialAggregator> aggregator() const { return mAggregator; }
+  double timeframe() const;
   
   // setters:
   void setData(QSharedPointer<QCPFinancialDataContainer> data);
@@ -6247,6 +7507,7 @@ public:
   void setBrushNegative(const QBrush &brush);
   void setPenPositive(const QPen &pen);
   void setPenNegative(const QPen &pen);
+  void setAggregator(QSharedPointer<QCPFinancialAggregator> aggregator);
   
   // non-property methods:
   void addData(const QVector<double> &keys, const QVector<double> &open, const QVector<double> &high, const QVector<double> &low, const QVector<double> &close, bool alreadySorted=false);
@@ -6269,15 +7530,22 @@ protected:
   bool mTwoColored;
   QBrush mBrushPositive, mBrushNegative;
   QPen mPenPositive, mPenNegative;
+  QSharedPointer<QCPFinancialAggregator> mAggregator;
+  
+  // non-property members:
+  int mTimeframeIndex;
   
   // reimplemented virtual methods:
   virtual void draw(QCPPainter *painter) Q_DECL_OVERRIDE;
   virtual void drawLegendIcon(QCPPainter *painter, const QRectF &rect) const Q_DECL_OVERRIDE;
   
   // non-virtual methods:
+  Q_SLOT void updateTimeframe();
+  double scaledWidth() const;
   void drawOhlcPlot(QCPPainter *painter, const QCPFinancialDataContainer::const_iterator &begin, const QCPFinancialDataContainer::const_iterator &end, bool isSelected);
   void drawCandlestickPlot(QCPPainter *painter, const QCPFinancialDataContainer::const_iterator &begin, const QCPFinancialDataContainer::const_iterator &end, bool isSelected);
   double getPixelWidth(double key, double keyPixel) const;
+  QVector<QCPFinancialData> getPixelColumnData(const QCPFinancialDataContainer::const_iterator &begin, const QCPFinancialDataContainer::const_iterator &end) const;
   double ohlcSelectTest(const QPointF &pos, const QCPFinancialDataContainer::const_iterator &begin, const QCPFinancialDataContainer::const_iterator &end, QCPFinancialDataContainer::const_iterator &closestDataPoint) const;
   double candlestickSelectTest(const QPointF &pos, const QCPFinancialDataContainer::const_iterator &begin, const QCPFinancialDataContainer::const_iterator &end, QCPFinancialDataContainer::const_iterator &closestDataPoint) const;
   void getVisibleDataBounds(QCPFinancialDataContainer::const_iterator &begin, QCPFinancialDataContainer::const_iterator &end) const;
@@ -6385,6 +7653,7 @@ public:
   // reimplemented virtual methods:
   virtual double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details=nullptr) const Q_DECL_OVERRIDE;
   virtual QCPPlottableInterface1D *interface1D() Q_DECL_OVERRIDE { return this; }
+  virtual quint64 dataVersion() const Q_DECL_OVERRIDE;
   
 protected:
   // property members:
@@ -6905,6 +8174,7 @@ public:
 
   // reimplemented virtual methods:
   virtual double selectTest(const QPointF &pos, bool onlySelectable, QVariant *details=nullptr) const Q_DECL_OVERRIDE;
+  virtual quint64 contentVersion() const Q_DECL_OVERRIDE;
   
   // non-virtual methods:
   void updatePosition();
@@ -7573,6 +8843,9 @@ public:
   void setRadialSubGridPen(const QPen &pen);
   void setRadialZeroLinePen(const QPen &pen);
   
+  // reimplemented virtual methods:
+  virtual quint64 contentVersion() const Q_DECL_OVERRIDE;
+  
 protected:
   // property members:
   GridTypes mType;
@@ -7709,6 +8982,9 @@ public:
   virtual QCPRange getKeyRange(bool &foundRange, QCP::SignDomain inSignDomain=QCP::sdBoth) const;
   virtual QCPRange getValueRange(bool &foundRange, QCP::SignDomain inSignDomain=QCP::sdBoth, const QCPRange &inKeyRange=QCPRange()) const;
   
+  // reimplemented virtual methods:
+  virtual quint64 contentVersion() const Q_DECL_OVERRIDE;
+  
 signals:
   void selectionChanged(bool selected);
   void selectionChanged(const QCPDataSelection &selection);